@@ -66,6 +66,8 @@
 #include <strings.h>
 #include <time.h>
 #include <errno.h>
+#include <signal.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -110,6 +112,7 @@ PRAGMA_IGNORE_Wswitch_enum
 static rsRetVal doSubmitToActionQ(action_t *const pAction, wti_t *const pWti, smsg_t *);
 static rsRetVal doSubmitToActionQComplex(action_t *const pAction, wti_t *const pWti, smsg_t *);
 static rsRetVal doSubmitToActionQNotAllMark(action_t *const pAction, wti_t *const pWti, smsg_t *);
+static void actGroupDestruct(struct actGroup_s *pGroup);
 static void ATTR_NONNULL() actionSuspend(action_t *const pThis, wti_t *const pWti);
 static void ATTR_NONNULL() actionRetry(action_t *const pThis, wti_t *const pWti);
 
@@ -162,6 +165,7 @@ static struct cnfparamdescr cnfparamdescr[] = {
     {"type", eCmdHdlrString, CNFPARAM_REQUIRED}, /* legacy: actionname */
     {"action.errorfile", eCmdHdlrString, 0},
     {"action.errorfile.maxsize", eCmdHdlrInt, 0},
+    {"action.errorfile.buffersize", eCmdHdlrSize, 0},
     {"action.writeallmarkmessages", eCmdHdlrBinary, 0}, /* legacy: actionwriteallmarkmessages */
     {"action.execonlyeverynthtime", eCmdHdlrInt, 0}, /* legacy: actionexeconlyeverynthtime */
     {"action.execonlyeverynthtimetimeout", eCmdHdlrInt, 0}, /* legacy: actionexeconlyeverynthtimetimeout */
@@ -174,8 +178,17 @@ static struct cnfparamdescr cnfparamdescr[] = {
     {"action.reportsuspensioncontinuation", eCmdHdlrBinary, 0},
     {"action.resumeintervalmax", eCmdHdlrPositiveInt, 0},
     {"action.resumeinterval", eCmdHdlrInt, 0},
+    {"action.resumebackoff", eCmdHdlrGetWord, 0},
     {"action.externalstate.file", eCmdHdlrString, 0},
-    {"action.copymsg", eCmdHdlrBinary, 0}};
+    {"action.copymsg", eCmdHdlrBinary, 0},
+    {"action.async.maxinflight", eCmdHdlrPositiveInt, 0},
+    {"action.async.batchsize", eCmdHdlrNonNegInt, 0},
+    {"action.linger.timeout", eCmdHdlrNonNegInt, 0},
+    {"action.linger.messages", eCmdHdlrNonNegInt, 0},
+    {"action.linger.bytes", eCmdHdlrSize, 0},
+    {"action.group", eCmdHdlrGetWord, 0},
+    {"action.latency", eCmdHdlrBinary, 0},
+    {"action.latency.buckets", eCmdHdlrArray, 0}};
 static struct cnfparamblk pblk = {CNFPARAMBLK_VERSION, sizeof(cnfparamdescr) / sizeof(struct cnfparamdescr),
                                   cnfparamdescr};
 
@@ -294,6 +307,236 @@ static void freeWrkrDataTable(action_t *const pThis) {
     return;
 }
 
+/* Latency histograms (action.latency.*).
+ *
+ * For each message, the time from its reception to the end of its
+ * processing by the action (the commit, for transactional actions) is
+ * sorted into buckets with configurable upper bounds. The histogram has its
+ * own stats object "<action name>.latency" with the cumulative number of
+ * messages per bucket (le.<bound>), the count and sum of all latencies, and
+ * the maximum and the p50/p90/p99 values of the current stats interval.
+ * Percentiles are reported as the upper bound of the bucket they fall into,
+ * or as the maximum if that is above the last bound.
+ */
+#define ACT_LATENCY_MAX_BOUNDS 64
+static const int64_t actLatencyDfltBounds[] = {1,   2,    5,    10,   20,    50,    100,  200,
+                                               500, 1000, 2000, 5000, 10000, 30000, 60000};
+
+struct actLatency_s {
+    statsobj_t *stats;
+    int nBounds;
+    int64_t bounds[ACT_LATENCY_MAX_BOUNDS]; /* upper bounds in ms, strictly ascending */
+    intctr_t ctrBuckets[ACT_LATENCY_MAX_BOUNDS]; /* cumulative, like Prometheus' le buckets */
+    intctr_t ctrCount;
+    intctr_t ctrSum;
+    intctr_t ctrMax;
+    intctr_t ctrP50;
+    intctr_t ctrP90;
+    intctr_t ctrP99;
+    /* the current stats interval, reset when the stats are read */
+    uint64_t winCounts[ACT_LATENCY_MAX_BOUNDS + 1]; /* the last one is above all bounds */
+    uint64_t winTotal;
+    int64_t winMax;
+    pthread_mutex_t mut;
+};
+
+
+static struct actLatency_s *actionLatencyConstruct(void) {
+    struct actLatency_s *pLat;
+
+    if ((pLat = calloc(1, sizeof(struct actLatency_s))) == NULL) return NULL;
+    pLat->nBounds = sizeof(actLatencyDfltBounds) / sizeof(actLatencyDfltBounds[0]);
+    memcpy(pLat->bounds, actLatencyDfltBounds, sizeof(actLatencyDfltBounds));
+    pthread_mutex_init(&pLat->mut, NULL);
+    return pLat;
+}
+
+
+static void actionLatencyDestruct(struct actLatency_s *const pLat) {
+    if (pLat->stats != NULL) statsobj.Destruct(&pLat->stats);
+    pthread_mutex_destroy(&pLat->mut);
+    free(pLat);
+}
+
+
+/* set the bucket bounds from action.latency.buckets; keeps the defaults on error */
+static void ATTR_NONNULL() actionLatencySetBounds(action_t *const pAction, struct cnfarray *const ar) {
+    int64_t bounds[ACT_LATENCY_MAX_BOUNDS];
+    char *cstr;
+    char *end;
+    int i;
+
+    if (ar->nmemb < 1 || ar->nmemb > ACT_LATENCY_MAX_BOUNDS) {
+        LogError(0, RS_RET_PARAM_ERROR,
+                 "action.latency.buckets: must have 1 to %d bounds, has %d - "
+                 "using default buckets",
+                 ACT_LATENCY_MAX_BOUNDS, ar->nmemb);
+        return;
+    }
+    for (i = 0; i < ar->nmemb; ++i) {
+        cstr = es_str2cstr(ar->arr[i], NULL);
+        bounds[i] = (cstr == NULL) ? -1 : strtoll(cstr, &end, 10);
+        if (cstr == NULL || *end != '\0' || bounds[i] < 1 || (i > 0 && bounds[i] <= bounds[i - 1])) {
+            LogError(0, RS_RET_PARAM_ERROR,
+                     "action.latency.buckets: bound '%s' is invalid, bounds must "
+                     "be positive integers (ms) in ascending order - using default buckets",
+                     (cstr == NULL) ? "" : cstr);
+            free(cstr);
+            return;
+        }
+        free(cstr);
+    }
+    memcpy(pAction->pLatency->bounds, bounds, sizeof(int64_t) * ar->nmemb);
+    pAction->pLatency->nBounds = ar->nmemb;
+}
+
+
+/* the stats were read: begin a new interval */
+static void actionLatencyStatsRead(statsobj_t __attribute__((unused)) * ignore, void *ctx) {
+    struct actLatency_s *const pLat = (struct actLatency_s *)ctx;
+
+    pthread_mutex_lock(&pLat->mut);
+    memset(pLat->winCounts, 0, sizeof(pLat->winCounts));
+    pLat->winTotal = 0;
+    pLat->winMax = 0;
+    pLat->ctrMax = 0;
+    pLat->ctrP50 = 0;
+    pLat->ctrP90 = 0;
+    pLat->ctrP99 = 0;
+    pthread_mutex_unlock(&pLat->mut);
+}
+
+
+static rsRetVal ATTR_NONNULL() actionLatencyStatsConstruct(action_t *const pAction) {
+    struct actLatency_s *const pLat = pAction->pLatency;
+    char name[256];
+    int i;
+    DEFiRet;
+
+    CHKiRet(statsobj.Construct(&pLat->stats));
+    snprintf(name, sizeof(name), "%s.latency", (char *)pAction->pszName);
+    CHKiRet(statsobj.SetName(pLat->stats, (uchar *)name));
+    CHKiRet(statsobj.SetOrigin(pLat->stats, (uchar *)"core.action"));
+    for (i = 0; i < pLat->nBounds; ++i) {
+        snprintf(name, sizeof(name), "le.%lld", (long long)pLat->bounds[i]);
+        CHKiRet(statsobj.AddCounter(pLat->stats, (uchar *)name, ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                    &pLat->ctrBuckets[i]));
+    }
+    CHKiRet(statsobj.AddCounter(pLat->stats, UCHAR_CONSTANT("count"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &pLat->ctrCount));
+    CHKiRet(
+        statsobj.AddCounter(pLat->stats, UCHAR_CONSTANT("sum"), ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pLat->ctrSum));
+    CHKiRet(statsobj.AddCounter(pLat->stats, UCHAR_CONSTANT("max"), ctrType_IntCtr, CTR_FLAG_NONE, &pLat->ctrMax));
+    CHKiRet(statsobj.AddCounter(pLat->stats, UCHAR_CONSTANT("p50"), ctrType_IntCtr, CTR_FLAG_NONE, &pLat->ctrP50));
+    CHKiRet(statsobj.AddCounter(pLat->stats, UCHAR_CONSTANT("p90"), ctrType_IntCtr, CTR_FLAG_NONE, &pLat->ctrP90));
+    CHKiRet(statsobj.AddCounter(pLat->stats, UCHAR_CONSTANT("p99"), ctrType_IntCtr, CTR_FLAG_NONE, &pLat->ctrP99));
+    CHKiRet(statsobj.SetReadNotifier(pLat->stats, actionLatencyStatsRead, pLat));
+    CHKiRet(statsobj.ConstructFinalize(pLat->stats));
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* must be called with the mutex locked */
+static intctr_t ATTR_NONNULL() actionLatencyPerctile(const struct actLatency_s *const pLat, const int perctile) {
+    const uint64_t rank = (pLat->winTotal * perctile + 99) / 100;
+    uint64_t cum = 0;
+    int i;
+
+    for (i = 0; i < pLat->nBounds; ++i) {
+        cum += pLat->winCounts[i];
+        if (cum >= rank) return (intctr_t)pLat->bounds[i];
+    }
+    return (intctr_t)pLat->winMax;
+}
+
+
+/* time the message was received, in ms since the epoch */
+static int64_t ATTR_NONNULL() actionLatencyRcvdAt(const smsg_t *const pMsg) {
+    int frac = pMsg->tRcvdAt.secfrac;
+    int prec;
+
+    for (prec = pMsg->tRcvdAt.secfracPrecision; prec > 3; --prec) frac /= 10;
+    for (; prec < 3; ++prec) frac *= 10;
+    return (int64_t)pMsg->ttGenTime * 1000 + frac;
+}
+
+
+/* record that the action is done with n messages received at rcvdAt[] */
+static void ATTR_NONNULL() actionLatencyAdd(struct actLatency_s *const pLat, const int64_t *const rcvdAt, const int n) {
+    uint64_t added[ACT_LATENCY_MAX_BOUNDS + 1];
+    struct timespec now;
+    int64_t nowMs, lat;
+    uint64_t cum;
+    int i, lo, hi;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    nowMs = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    memset(added, 0, sizeof(uint64_t) * (pLat->nBounds + 1));
+
+    pthread_mutex_lock(&pLat->mut);
+    for (i = 0; i < n; ++i) {
+        lat = nowMs - rcvdAt[i];
+        if (lat < 0) lat = 0; /* clock went backwards */
+        /* find the first bound >= lat */
+        lo = 0;
+        hi = pLat->nBounds;
+        while (lo < hi) {
+            const int mid = (lo + hi) / 2;
+            if (pLat->bounds[mid] < lat)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        added[lo]++;
+        pLat->ctrSum += lat;
+        if (lat > pLat->winMax) pLat->winMax = lat;
+    }
+    cum = 0;
+    for (i = 0; i <= pLat->nBounds; ++i) {
+        pLat->winCounts[i] += added[i];
+        cum += added[i];
+        if (i < pLat->nBounds) pLat->ctrBuckets[i] += cum;
+    }
+    pLat->winTotal += n;
+    pLat->ctrCount += n;
+    pLat->ctrMax = pLat->winMax;
+    pLat->ctrP50 = actionLatencyPerctile(pLat, 50);
+    pLat->ctrP90 = actionLatencyPerctile(pLat, 90);
+    pLat->ctrP99 = actionLatencyPerctile(pLat, 99);
+    pthread_mutex_unlock(&pLat->mut);
+}
+
+
+/* remember the reception time of the message just added to the worker's transaction */
+static void ATTR_NONNULL() actionLatencyNote(action_t *const pAction, wti_t *const pWti, const smsg_t *const pMsg) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pAction->iActionNbr]);
+    const int idx = wrkrInfo->p.tx.currIParam - 1;
+    int64_t *newArr;
+    int newMax;
+
+    if (idx >= wrkrInfo->p.tx.maxRcvdAt) {
+        newMax = (wrkrInfo->p.tx.maxIParams > idx) ? wrkrInfo->p.tx.maxIParams : idx + 1;
+        if ((newArr = realloc(wrkrInfo->p.tx.rcvdAt, sizeof(int64_t) * newMax)) == NULL) {
+            return; /* this one is just not recorded */
+        }
+        wrkrInfo->p.tx.rcvdAt = newArr;
+        wrkrInfo->p.tx.maxRcvdAt = newMax;
+    }
+    wrkrInfo->p.tx.rcvdAt[idx] = actionLatencyRcvdAt(pMsg);
+}
+
+
+/* record n messages of the worker's transaction, starting at first, as done */
+static void ATTR_NONNULL() actionLatencyAddTx(action_t *const pAction, wti_t *const pWti, const int first, int n) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pAction->iActionNbr]);
+
+    if (first + n > wrkrInfo->p.tx.maxRcvdAt) n = wrkrInfo->p.tx.maxRcvdAt - first;
+    if (n > 0) actionLatencyAdd(pAction->pLatency, wrkrInfo->p.tx.rcvdAt + first, n);
+}
+
+
 /* destructs an action descriptor object
  * rgerhards, 2007-08-01
  */
@@ -312,10 +555,17 @@ rsRetVal actionDestruct(action_t *const pThis) {
         qqueueDestruct(&pThis->pQueue);
     }
 
+    /* the queue worker is gone, so the group's commit threads are idle */
+    if (pThis->pGroup != NULL) actGroupDestruct(pThis->pGroup);
+
+    /* no worker can fail any longer, so write what is still buffered */
+    if (pThis->pErrFileWriter != NULL) bufwriterFileDestruct(&pThis->pErrFileWriter);
+
     /* destroy stats object, if we have one (may not always be
      * be the case, e.g. if turned off)
      */
     if (pThis->statsobj != NULL) statsobj.Destruct(&pThis->statsobj);
+    if (pThis->pLatency != NULL) actionLatencyDestruct(pThis->pLatency);
 
     if (pThis->fdErrFile != -1) close(pThis->fdErrFile);
     pthread_mutex_destroy(&pThis->mutErrFile);
@@ -323,6 +573,7 @@ rsRetVal actionDestruct(action_t *const pThis) {
     pthread_mutex_destroy(&pThis->mutWrkrDataTable);
     free((void *)pThis->pszErrFile);
     free((void *)pThis->pszExternalStateFile);
+    free(pThis->pszGroup);
     free(pThis->pszName);
     nvlstDestruct(pThis->pSyntaxLst);
     free(pThis->ppTpl);
@@ -370,7 +621,14 @@ rsRetVal actionConstruct(action_t **ppThis) {
     pThis->pszErrFile = NULL;
     pThis->maxErrFileSize = 0;
     pThis->currentErrFileSize = 0;
+    pThis->errFileBufSize = 1024 * 1024;
+    pThis->pErrFileWriter = NULL;
     pThis->pszExternalStateFile = NULL;
+    pThis->iAsyncMaxInFlight = 1;
+    pThis->iAsyncBatchSize = 0;
+    pThis->iLingerTimeout = 0;
+    pThis->iLingerMsgs = 0;
+    pThis->iLingerBytes = 0;
     pThis->fdErrFile = -1;
     pThis->bWriteAllMarkMsgs = 1;
     pThis->iExecEveryNthOccur = 0;
@@ -463,7 +721,14 @@ rsRetVal actionConstructFinalize(action_t *__restrict__ const pThis, struct nvls
     CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("resumed"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
                                 &pThis->ctrResume));
 
+    STATSCOUNTER_INIT(pThis->ctrErrFileDropped, pThis->mutCtrErrFileDropped);
+    if (pThis->pszErrFile != NULL) {
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("errorfile.dropped"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrErrFileDropped));
+    }
+
     CHKiRet(statsobj.ConstructFinalize(pThis->statsobj));
+    if (pThis->pLatency != NULL) CHKiRet(actionLatencyStatsConstruct(pThis));
 
     /* create our queue */
 
@@ -562,6 +827,18 @@ rsRetVal actionConstructFinalize(action_t *__restrict__ const pThis, struct nvls
             (char *)modGetName(pThis->pMod));
     }
 
+    /* lingering messages are already deleted from the queue, so a disk (assisted) queue
+     * could no longer save them on abort
+     */
+    if (pThis->iLingerTimeout > 0 &&
+        (pThis->pQueue->qType == QUEUETYPE_DISK || pThis->pQueue->pszFilePrefix != NULL)) {
+        LogError(0, RS_RET_CONF_PARAM_INVLD,
+                 "action '%s': action.linger.timeout can not be used with a disk "
+                 "or disk-assisted action queue - lingering disabled",
+                 pThis->pszName);
+        pThis->iLingerTimeout = 0;
+    }
+
     /* and now reset the queue params (see comment in its function header!) */
     actionResetQueueParams();
 
@@ -755,6 +1032,50 @@ static void ATTR_NONNULL() actionRetry(action_t *const pThis, wti_t *const pWti)
     incActionResumeInRow(pWti, pThis);
 }
 
+/* compute the wait before resume attempt n (counting from 0) with
+ * action.resumeBackoff="exponential": the resume interval doubles with each
+ * attempt, up to action.resumeIntervalMax. A random jitter of up to half the
+ * wait keeps actions that failed together from retrying in lockstep.
+ */
+static int ATTR_NONNULL() actionBackoffInterval(const action_t *const pThis, const int n) {
+    long long wait;
+
+    wait = (long long)pThis->iResumeInterval << (n < 20 ? n : 20);
+    if (pThis->iResumeIntervalMax > 0 && wait > pThis->iResumeIntervalMax) wait = pThis->iResumeIntervalMax;
+    if (wait > INT_MAX) wait = INT_MAX;
+    if (wait > 1) wait -= randomNumber() % (wait / 2 + 1);
+    return (int)wait;
+}
+
+
+/* wait until the next resume attempt is due. Queue workers wait on their
+ * pcondBusy, which the queue signals when it shuts down, so they are woken
+ * early in that case. Other threads just sleep.
+ */
+static rsRetVal ATTR_NONNULL() actionWaitResume(action_t *const pThis, wti_t *const pWti, const int seconds) {
+    struct timespec deadline;
+    DEFiRet;
+
+    DBGPRINTF("action '%s': waiting %d seconds for next resume attempt\n", pThis->pszName, seconds);
+    if (pWti->pWtp == NULL) {
+        srSleep(seconds, 0);
+    } else {
+        timeoutComp(&deadline, (long)seconds * 1000);
+        d_pthread_mutex_lock(pWti->pWtp->pmutUsr);
+        pthread_cleanup_push(mutexCancelCleanup, pWti->pWtp->pmutUsr);
+        while (!*pWti->pbShutdownImmediate && timeoutVal(&deadline) > 0) {
+            d_pthread_cond_timedwait(&pWti->pcondBusy, pWti->pWtp->pmutUsr, &deadline);
+        }
+        pthread_cleanup_pop(1);
+    }
+    if (*pWti->pbShutdownImmediate) {
+        ABORT_FINALIZE(RS_RET_FORCE_TERM);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
 /* Suspend action, this involves changing the action state as well
  * as setting the next retry time.
  * if we have more than 10 retries, we prolong the
@@ -775,9 +1096,13 @@ static void ATTR_NONNULL() actionSuspend(action_t *const pThis, wti_t *const pWt
      * since caching, and this would break logic (and it actually did so!)
      */
     datetime.GetTime(&ttNow);
-    suspendDuration = pThis->iResumeInterval * (getActionNbrResRtry(pWti, pThis) / 10 + 1);
-    if (pThis->iResumeIntervalMax > 0 && suspendDuration > pThis->iResumeIntervalMax) {
-        suspendDuration = pThis->iResumeIntervalMax;
+    if (pThis->bResumeBackoffExp) {
+        suspendDuration = actionBackoffInterval(pThis, getActionNbrResRtry(pWti, pThis));
+    } else {
+        suspendDuration = pThis->iResumeInterval * (getActionNbrResRtry(pWti, pThis) / 10 + 1);
+        if (pThis->iResumeIntervalMax > 0 && suspendDuration > pThis->iResumeIntervalMax) {
+            suspendDuration = pThis->iResumeIntervalMax;
+        }
     }
     pThis->ttResumeRtry = ttNow + suspendDuration;
     actionSetState(pThis, __func__, pWti, ACT_STATE_SUSP);
@@ -861,17 +1186,15 @@ static rsRetVal ATTR_NONNULL() actionDoRetry(action_t *const pThis, wti_t *const
                 actionSuspend(pThis, pWti);
                 if (getActionNbrResRtry(pWti, pThis) < 20) incActionNbrResRtry(pWti, pThis);
             } else {
+                const int wait = pThis->bResumeBackoffExp ? actionBackoffInterval(pThis, iRetries)
+                                                          : pThis->iResumeInterval;
                 ++iRetries;
                 datetime.GetTime(&ttTemp);
                 DBGPRINTF(
                     "actionDoRetry: %s, controlled by resumeInterval, may miss the next try."
                     "Will sleep %d seconds. ResumeRtry=%lld (now %lld), iRetries %d\n",
-                    pThis->pszName, pThis->iResumeInterval, (long long)pThis->ttResumeRtry, (long long)ttTemp,
-                    iRetries);
-                srSleep(pThis->iResumeInterval, 0);
-                if (*pWti->pbShutdownImmediate) {
-                    ABORT_FINALIZE(RS_RET_FORCE_TERM);
-                }
+                    pThis->pszName, wait, (long long)pThis->ttResumeRtry, (long long)ttTemp, iRetries);
+                CHKiRet(actionWaitResume(pThis, pWti, wait));
             }
         } else if (iRet == RS_RET_DISABLE_ACTION) {
             actionDisableForWorker(pThis, pWti);
@@ -929,10 +1252,7 @@ static rsRetVal ATTR_NONNULL() actionDoRetry_extFile(action_t *const pThis, wti_
                 if (getActionNbrResRtry(pWti, pThis) < 20) incActionNbrResRtry(pWti, pThis);
             } else {
                 ++iRetries;
-                srSleep(pThis->iResumeInterval, 0);
-                if (*pWti->pbShutdownImmediate) {
-                    ABORT_FINALIZE(RS_RET_FORCE_TERM);
-                }
+                CHKiRet(actionWaitResume(pThis, pWti, pThis->iResumeInterval));
             }
         } else if (iRet == RS_RET_DISABLE_ACTION) {
             actionDisableForWorker(pThis, pWti);
@@ -1122,6 +1442,40 @@ finalize_it:
 }
 
 
+/**
+ * @brief Render a template, reusing an earlier rendering of the same batch if possible.
+ *
+ * Templates shared by several actions are rendered only once per message.
+ * The worker cache is consulted only for templates that are referenced more
+ * than once and whose output does not depend on time or global state.
+ */
+static rsRetVal ATTR_NONNULL() actionRenderTpl(struct template *__restrict__ const pTpl,
+                                               wti_t *__restrict__ const pWti,
+                                               smsg_t *__restrict__ const pMsg,
+                                               actWrkrIParams_t *__restrict__ const iparam,
+                                               struct syslogTime *const ttNow) {
+    const actWrkrIParams_t *cached;
+    DEFiRet;
+
+    if (pTpl->nActionRefs < 2 || !pTpl->bRenderCacheable) {
+        CHKiRet(tplToString(pTpl, pMsg, iparam, ttNow));
+        FINALIZE;
+    }
+
+    if ((cached = wtiTplCacheLookup(pWti, pMsg, pTpl)) != NULL) {
+        CHKiRet(ExtendBuf(iparam, cached->lenStr + 1));
+        memcpy(iparam->param, cached->param, cached->lenStr + 1);
+        iparam->lenStr = cached->lenStr;
+    } else {
+        CHKiRet(tplToString(pTpl, pMsg, iparam, ttNow));
+        wtiTplCacheStore(pWti, pMsg, pTpl, iparam);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
 /* prepare the calling parameters for doAction()
  * rgerhards, 2009-05-07
  */
@@ -1139,13 +1493,13 @@ static rsRetVal prepareDoActionParams(action_t *__restrict__ const pAction,
     if (pAction->isTransactional) {
         CHKiRet(wtiNewIParam(pWti, pAction, &iparams));
         for (i = 0; i < pAction->iNumTpls; ++i) {
-            CHKiRet(tplToString(pAction->ppTpl[i], pMsg, &actParam(iparams, pAction->iNumTpls, 0, i), ttNow));
+            CHKiRet(actionRenderTpl(pAction->ppTpl[i], pWti, pMsg, &actParam(iparams, pAction->iNumTpls, 0, i), ttNow));
         }
     } else {
         for (i = 0; i < pAction->iNumTpls; ++i) {
             switch (pAction->peParamPassing[i]) {
                 case ACT_STRING_PASSING:
-                    CHKiRet(tplToString(pAction->ppTpl[i], pMsg, &(pWrkrInfo->p.nontx.actParams[i]), ttNow));
+                    CHKiRet(actionRenderTpl(pAction->ppTpl[i], pWti, pMsg, &(pWrkrInfo->p.nontx.actParams[i]), ttNow));
                     break;
                 /* note: ARRAY_PASSING mode has been removed in 8.26.0; if it
                  * is ever needed again, it can be found in 8.25.0.
@@ -1158,6 +1512,13 @@ static rsRetVal prepareDoActionParams(action_t *__restrict__ const pAction,
                     CHKiRet(tplToJSON(pAction->ppTpl[i], pMsg, &json, ttNow));
                     pWrkrInfo->p.nontx.actParams[i].param = (void *)json;
                     break;
+                case ACT_IOV_PASSING:
+                    /* the render object is kept per worker and recycled */
+                    if (pWrkrInfo->p.nontx.actParams[i].param == NULL) {
+                        CHKmalloc(pWrkrInfo->p.nontx.actParams[i].param = calloc(1, sizeof(tplIov_t)));
+                    }
+                    CHKiRet(tplToIov(pAction->ppTpl[i], pMsg, (tplIov_t *)pWrkrInfo->p.nontx.actParams[i].param, ttNow));
+                    break;
                 default:
                     dbgprintf(
                         "software bug/error: unknown "
@@ -1191,7 +1552,10 @@ void releaseDoActionParams(action_t *__restrict__ const pAction, wti_t *__restri
     pWrkrInfo = &(pWti->actWrkrInfo[pAction->iActionNbr]);
     for (j = 0; j < pAction->iNumTpls; ++j) {
         if (action_destruct) {
-            if (ACT_STRING_PASSING == pAction->peParamPassing[j]) {
+            if (ACT_IOV_PASSING == pAction->peParamPassing[j] && pWrkrInfo->p.nontx.actParams[j].param != NULL) {
+                tplIovDestruct((tplIov_t *)pWrkrInfo->p.nontx.actParams[j].param);
+            }
+            if (ACT_STRING_PASSING == pAction->peParamPassing[j] || ACT_IOV_PASSING == pAction->peParamPassing[j]) {
                 free(pWrkrInfo->p.nontx.actParams[j].param);
                 pWrkrInfo->p.nontx.actParams[j].param = NULL;
                 pWrkrInfo->p.nontx.actParams[j].lenBuf = 0;
@@ -1210,6 +1574,12 @@ void releaseDoActionParams(action_t *__restrict__ const pAction, wti_t *__restri
                     pWrkrInfo->p.nontx.actParams[j].lenBuf = 0;
                     pWrkrInfo->p.nontx.actParams[j].lenStr = 0;
                     break;
+                case ACT_IOV_PASSING:
+                    /* keep the render object, but drop references to the message */
+                    if (pWrkrInfo->p.nontx.actParams[j].param != NULL) {
+                        tplIovReset((tplIov_t *)pWrkrInfo->p.nontx.actParams[j].param);
+                    }
+                    break;
                 default:
                     /* no need to do anything with these */
                     break;
@@ -1394,7 +1764,7 @@ static rsRetVal doTransaction(action_t *__restrict__ const pThis,
                      * and the rsyslog core’s standard retry logic takes over.
                      */
                     --i; /* reprocess this message on the next loop iteration */
-                    srSleep(1, 0); /* sleep 1 second */
+                    CHKiRet(actionWaitResume(pThis, pWti, 1)); /* wait 1 second */
                     bSuspended = 1; /* mark that the one local retry has been done */
                     continue;
                 } else {
@@ -1516,6 +1886,12 @@ static void ATTR_NONNULL() actionWriteErrorFile(action_t *__restrict__ const pTh
             }
             pThis->currentErrFileSize = statbuf.st_size;
         }
+        if (pThis->errFileBufSize > 0 && runConf->bufwriter != NULL) {
+            if (bufwriterFileConstruct(runConf->bufwriter, &pThis->pErrFileWriter, pThis->fdErrFile,
+                                       pThis->errFileBufSize, pThis->pszErrFile) != RS_RET_OK) {
+                pThis->pErrFileWriter = NULL; /* write synchronously */
+            }
+        }
     }
 
     for (int i = 0; i < nparams; ++i) {
@@ -1546,10 +1922,18 @@ static void ATTR_NONNULL() actionWriteErrorFile(action_t *__restrict__ const pTh
              * otherwise need it and it safes us a copy/realloc.
              */
             rendered[toWrite - 1] = '\n'; /* NO LONGER A STRING! */
-            const ssize_t wrRet = write(pThis->fdErrFile, rendered, toWrite);
-            if (wrRet != (ssize_t)toWrite) {
-                LogError(errno, RS_RET_IO_ERROR, "action %s: error writing errorFile %s, write returned %lld",
-                         pThis->pszName, pThis->pszErrFile, (long long)wrRet);
+            if (pThis->pErrFileWriter != NULL) {
+                /* the writer thread does the actual write */
+                if (bufwriterAppend(pThis->pErrFileWriter, rendered, toWrite) != RS_RET_OK) {
+                    STATSCOUNTER_INC(pThis->ctrErrFileDropped, pThis->mutCtrErrFileDropped);
+                    if (pThis->maxErrFileSize > 0) pThis->currentErrFileSize -= toWrite;
+                }
+            } else {
+                const ssize_t wrRet = write(pThis->fdErrFile, rendered, toWrite);
+                if (wrRet != (ssize_t)toWrite) {
+                    LogError(errno, RS_RET_IO_ERROR, "action %s: error writing errorFile %s, write returned %lld",
+                             pThis->pszName, pThis->pszErrFile, (long long)wrRet);
+                }
             }
         }
         free(rendered);
@@ -1566,12 +1950,19 @@ done:
 }
 
 
+/* commit the messages of the worker's transaction one by one. Those that
+ * were suspended are copied to new_iparams; for action.latency.*, their
+ * reception times are moved to the front of rcvdAt in the same way, and
+ * messages committed here are recorded right away.
+ */
 static rsRetVal actionTryRemoveHardErrorsFromBatch(action_t *__restrict__ const pThis,
                                                    wti_t *__restrict__ const pWti,
                                                    actWrkrIParams_t *const new_iparams,
                                                    unsigned *new_nMsgs) {
     actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
     const unsigned nMsgs = wrkrInfo->p.tx.currIParam;
+    int64_t *const rcvdAt = wrkrInfo->p.tx.rcvdAt;
+    const sbool bLatency = pThis->pLatency != NULL;
     actWrkrIParams_t oneParamSet[CONF_OMOD_NUMSTRINGS_MAXSIZE];
     rsRetVal ret;
     DEFiRet;
@@ -1585,14 +1976,207 @@ static rsRetVal actionTryRemoveHardErrorsFromBatch(action_t *__restrict__ const
         if (ret == RS_RET_SUSPENDED) {
             memcpy(new_iparams + (*new_nMsgs * pThis->iNumTpls), &oneParamSet,
                    sizeof(actWrkrIParams_t) * pThis->iNumTpls);
+            /* *new_nMsgs <= i, so this does not overwrite entries still needed */
+            if (bLatency && i < (unsigned)wrkrInfo->p.tx.maxRcvdAt) rcvdAt[*new_nMsgs] = rcvdAt[i];
             ++(*new_nMsgs);
-        } else if (ret != RS_RET_OK) {
+        } else if (ret == RS_RET_OK) {
+            if (bLatency && i < (unsigned)wrkrInfo->p.tx.maxRcvdAt) actionLatencyAdd(pThis->pLatency, &rcvdAt[i], 1);
+        } else {
             actionWriteErrorFile(pThis, ret, oneParamSet, 1);
         }
     }
     RETiRet;
 }
 
+/* state shared by the parts of one asynchronous commit */
+struct actAsyncWait_s {
+    pthread_mutex_t mut;
+    pthread_cond_t cond;
+    int nPending; /* parts submitted but not yet completed */
+    sbool bFailed; /* a part failed, do not submit any more */
+};
+
+struct actAsyncTx_s {
+    struct actAsyncWait_s *pWait;
+    unsigned first; /* index of the part's first message in the batch */
+    unsigned nParams;
+    rsRetVal ret;
+};
+
+
+void actionAsyncTxDone(actAsyncTx_t *const pTx, const rsRetVal ret) {
+    struct actAsyncWait_s *const pWait = pTx->pWait;
+
+    pthread_mutex_lock(&pWait->mut);
+    pTx->ret = ret;
+    if (ret != RS_RET_OK) pWait->bFailed = 1;
+    pWait->nPending--;
+    pthread_cond_broadcast(&pWait->cond);
+    pthread_mutex_unlock(&pWait->mut);
+}
+
+
+/* swap the template params of messages i and j of a batch */
+static void swapIParams(actWrkrIParams_t *const iparams, const int nTpls, const unsigned i, const unsigned j) {
+    actWrkrIParams_t tmp;
+    int k;
+
+    for (k = 0; k < nTpls; ++k) {
+        tmp = actParam(iparams, nTpls, i, k);
+        actParam(iparams, nTpls, i, k) = actParam(iparams, nTpls, j, k);
+        actParam(iparams, nTpls, j, k) = tmp;
+    }
+}
+
+
+/**
+ * Commit the buffered messages via the module's submitTransaction() entry
+ * point. The batch is split into parts, of which up to iAsyncMaxInFlight are
+ * handed to the module before we wait for the first of them to complete.
+ * We return only after all submitted parts are completed, so the caller (and
+ * thus the queue) sees the same semantics as for a synchronous commit.
+ *
+ * If a part fails, no further parts are submitted. The messages of all parts
+ * that failed or were not submitted are moved to the front of the batch and
+ * currIParam is set to their number, so that the caller can hand them to
+ * the regular synchronous retry processing. Parts that were committed are
+ * not retried.
+ */
+static rsRetVal ATTR_NONNULL() actionCommitAsync(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+    const unsigned nMsgs = wrkrInfo->p.tx.currIParam;
+    struct actAsyncWait_s wait;
+    actAsyncTx_t *txs = NULL;
+    unsigned partSize, nParts, nSubmitted, nFailed;
+    unsigned i, j, k;
+    rsRetVal localRet;
+    DEFiRet;
+
+    partSize = (pThis->iAsyncBatchSize > 0) ? (unsigned)pThis->iAsyncBatchSize
+                                            : (nMsgs + pThis->iAsyncMaxInFlight - 1) / pThis->iAsyncMaxInFlight;
+    nParts = (nMsgs + partSize - 1) / partSize;
+    if (nParts < 2) ABORT_FINALIZE(RS_RET_NO_RUN); /* nothing to overlap */
+
+    CHKiRet(actionPrepare(pThis, pWti));
+    if (getActionState(pWti, pThis) != ACT_STATE_ITX) ABORT_FINALIZE(RS_RET_NO_RUN);
+    CHKmalloc(txs = calloc(nParts, sizeof(actAsyncTx_t)));
+
+    pthread_mutex_init(&wait.mut, NULL);
+    pthread_cond_init(&wait.cond, NULL);
+    wait.nPending = 0;
+    wait.bFailed = 0;
+    for (i = 0; i < nParts; ++i) {
+        txs[i].pWait = &wait;
+        txs[i].first = i * partSize;
+        txs[i].nParams = (nMsgs - txs[i].first < partSize) ? nMsgs - txs[i].first : partSize;
+        txs[i].ret = RS_RET_SUSPENDED; /* not yet submitted */
+    }
+
+    DBGPRINTF("actionCommitAsync[%s]: %u msgs in %u parts, max %d in flight\n", pThis->pszName, nMsgs, nParts,
+              pThis->iAsyncMaxInFlight);
+    pthread_mutex_lock(&wait.mut);
+    for (nSubmitted = 0; nSubmitted < nParts; ++nSubmitted) {
+        while (wait.nPending >= pThis->iAsyncMaxInFlight && !wait.bFailed) pthread_cond_wait(&wait.cond, &wait.mut);
+        if (wait.bFailed || *pWti->pbShutdownImmediate) break;
+        wait.nPending++;
+        pthread_mutex_unlock(&wait.mut);
+        localRet = pThis->pMod->mod.om.submitTransaction(
+            wrkrInfo->actWrkrData, &actParam(wrkrInfo->p.tx.iparams, pThis->iNumTpls, txs[nSubmitted].first, 0),
+            txs[nSubmitted].nParams, &txs[nSubmitted]);
+        if (localRet != RS_RET_OK) {
+            DBGPRINTF("actionCommitAsync[%s]: submitTransaction returned %d\n", pThis->pszName, localRet);
+            actionAsyncTxDone(&txs[nSubmitted], localRet);
+        }
+        pthread_mutex_lock(&wait.mut);
+    }
+    /* the module may still access the params of parts in flight */
+    while (wait.nPending > 0) pthread_cond_wait(&wait.cond, &wait.mut);
+    pthread_mutex_unlock(&wait.mut);
+    pthread_cond_destroy(&wait.cond);
+    pthread_mutex_destroy(&wait.mut);
+
+    /* move the messages of all unsuccessful parts to the front */
+    j = 0;
+    for (i = 0; i < nParts; ++i) {
+        if (txs[i].ret == RS_RET_OK) continue;
+        for (k = txs[i].first; k < txs[i].first + txs[i].nParams; ++k) {
+            if (j != k) {
+                swapIParams(wrkrInfo->p.tx.iparams, pThis->iNumTpls, j, k);
+                if (k < (unsigned)wrkrInfo->p.tx.maxRcvdAt) {
+                    const int64_t tmp = wrkrInfo->p.tx.rcvdAt[j];
+                    wrkrInfo->p.tx.rcvdAt[j] = wrkrInfo->p.tx.rcvdAt[k];
+                    wrkrInfo->p.tx.rcvdAt[k] = tmp;
+                }
+            }
+            ++j;
+        }
+    }
+    nFailed = j;
+    /* the committed parts are now behind the failed ones */
+    if (pThis->pLatency != NULL && nFailed > 0) actionLatencyAddTx(pThis, pWti, nFailed, nMsgs - nFailed);
+
+    if (nFailed == 0) {
+        iRet = handleActionExecResult(pThis, pWti, RS_RET_OK);
+    } else {
+        DBGPRINTF("actionCommitAsync[%s]: %u of %u msgs not committed\n", pThis->pszName, nFailed, nMsgs);
+        wrkrInfo->p.tx.currIParam = nFailed;
+        iRet = RS_RET_SUSPENDED;
+    }
+
+finalize_it:
+    free(txs);
+    RETiRet;
+}
+
+/**
+ * Check if the commit of the buffered messages shall be held back to
+ * build a larger transaction (action.linger.*). This is only done in queue
+ * workers, as only they flush expired transactions when they become idle
+ * and before they terminate. Sets the worker's wake-up deadline if the
+ * commit is held back.
+ *
+ * @return 1 if the commit shall be held back, 0 if it is due
+ */
+static sbool ATTR_NONNULL() actionLinger(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+    int i, k;
+
+    if (pThis->iLingerTimeout == 0 || pWti->pWtp == NULL || pWti->linger.bInhibit || *pWti->pbShutdownImmediate)
+        return 0;
+    /* a direct action runs in the workers of the main or ruleset queue. If that queue is disk
+     * (assisted), the batch is deleted from it before lingering messages are committed.
+     */
+    if (pThis->pQueue->qType == QUEUETYPE_DIRECT) {
+        const qqueue_t *const pOwner = (qqueue_t *)pWti->pWtp->pUsr;
+        if (pOwner->qType == QUEUETYPE_DISK || pOwner->pszFilePrefix != NULL) return 0;
+    }
+    if (pThis->iLingerMsgs > 0 && wrkrInfo->p.tx.currIParam >= pThis->iLingerMsgs) return 0;
+    if (pThis->iLingerBytes > 0) {
+        for (i = wrkrInfo->linger.nCounted; i < wrkrInfo->p.tx.currIParam; ++i) {
+            for (k = 0; k < pThis->iNumTpls; ++k) {
+                wrkrInfo->linger.bytes += actParam(wrkrInfo->p.tx.iparams, pThis->iNumTpls, i, k).lenStr;
+            }
+        }
+        wrkrInfo->linger.nCounted = wrkrInfo->p.tx.currIParam;
+        if (wrkrInfo->linger.bytes >= pThis->iLingerBytes) return 0;
+    }
+
+    if (!wrkrInfo->linger.bActive) {
+        timeoutComp(&wrkrInfo->linger.deadline, pThis->iLingerTimeout);
+        wrkrInfo->linger.bActive = 1;
+    } else if (timeoutVal(&wrkrInfo->linger.deadline) == 0) {
+        return 0;
+    }
+
+    if (!pWti->linger.bActive || wrkrInfo->linger.deadline.tv_sec < pWti->linger.deadline.tv_sec ||
+        (wrkrInfo->linger.deadline.tv_sec == pWti->linger.deadline.tv_sec &&
+         wrkrInfo->linger.deadline.tv_nsec < pWti->linger.deadline.tv_nsec)) {
+        pWti->linger.deadline = wrkrInfo->linger.deadline;
+        pWti->linger.bActive = 1;
+    }
+    return 1;
+}
+
 /**
  * Commit all messages currently buffered for an action.
  *
@@ -1617,6 +2201,9 @@ static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis,
     unsigned nMsgs = 0;
     actWrkrIParams_t *iparams = NULL;
     int needfree_iparams = 0;  // work-around for clang static analyzer false positive
+    sbool bLinger = 0;
+    int nCommitted = 0; /* for action.latency.*: committed messages at the front of p.tx.rcvdAt */
+    const uint64_t tStart = wtiTimingStart(pWti);
     DEFiRet;
 
     DBGPRINTF("actionCommit[%s]: enter, %d msgs\n", pThis->pszName, wrkrInfo->p.tx.currIParam);
@@ -1631,9 +2218,24 @@ static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis,
          */
         actionWriteErrorFile(pThis, iRet, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
         FINALIZE;
+    } else if ((bLinger = actionLinger(pThis, pWti))) {
+        DBGPRINTF("actionCommit[%s]: lingering with %d msgs\n", pThis->pszName, wrkrInfo->p.tx.currIParam);
+        FINALIZE;
     }
     DBGPRINTF("actionCommit[%s]: processing...\n", pThis->pszName);
 
+    if (pThis->pMod->mod.om.submitTransaction != NULL && pThis->iAsyncMaxInFlight > 1 &&
+        wrkrInfo->p.tx.currIParam > 1) {
+        iRet = actionCommitAsync(pThis, pWti);
+        if (iRet == RS_RET_OK) {
+            nCommitted = wrkrInfo->p.tx.currIParam;
+            FINALIZE;
+        }
+        /* whatever is left is handled by the regular synchronous processing */
+        DBGPRINTF("actionCommit[%s]: async commit returned %d, %d msgs left\n", pThis->pszName, iRet,
+                  wrkrInfo->p.tx.currIParam);
+    }
+
     /* we now do one try at commiting the whole batch. Usually, this will
      * succeed. If so, we are happy and done. If not, we dig into the details
      * of finding out if we have a non-temporary error and try to handle this
@@ -1644,6 +2246,7 @@ static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis,
     iRet = actionTryCommit(pThis, pWti, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
     DBGPRINTF("actionCommit[%s]: return actionTryCommit %d\n", pThis->pszName, iRet);
     if (iRet == RS_RET_OK) {
+        nCommitted = wrkrInfo->p.tx.currIParam;
         FINALIZE;
     }
 
@@ -1697,6 +2300,7 @@ static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis,
             continue;
         } else if (iRet == RS_RET_OK || iRet == RS_RET_SUSPENDED || iRet == RS_RET_ACTION_FAILED ||
                    iRet == RS_RET_DISABLE_ACTION) {
+            if (iRet == RS_RET_OK) nCommitted = nMsgs;
             bDone = 1;
         }
         if (getActionState(pWti, pThis) == ACT_STATE_RDY || getActionState(pWti, pThis) == ACT_STATE_SUSP ||
@@ -1709,10 +2313,37 @@ finalize_it:
     if (needfree_iparams) {
         free(iparams);
     }
-    wrkrInfo->p.tx.currIParam = 0; /* reset to beginning */
+    if (nCommitted > 0 && pThis->pLatency != NULL) actionLatencyAddTx(pThis, pWti, 0, nCommitted);
+    wtiTimingStop(&pWti->timing.output, tStart);
+    if (!bLinger) {
+        wrkrInfo->p.tx.currIParam = 0; /* reset to beginning */
+        wrkrInfo->linger.bActive = 0;
+        wrkrInfo->linger.nCounted = 0;
+        wrkrInfo->linger.bytes = 0;
+    }
     RETiRet;
 }
 
+/* Commit all transactions of this worker that were held back via
+ * action.linger.* and whose deadline expired, or all of them if bForce
+ * is set. Recomputes the worker's wake-up deadline for the rest.
+ */
+void ATTR_NONNULL() actionFlushLingering(wti_t *__restrict__ const pWti, const sbool bForce) {
+    actWrkrInfo_t *wrkrInfo;
+    int i;
+
+    if (!pWti->linger.bActive) return;
+    pWti->linger.bActive = 0;
+    pWti->linger.bInhibit = bForce;
+    for (i = 0; i < runConf->actions.iActionNbr; ++i) {
+        wrkrInfo = &(pWti->actWrkrInfo[i]);
+        if (wrkrInfo->pAction == NULL || !wrkrInfo->linger.bActive) continue;
+        DBGPRINTF("actionFlushLingering: action %d, %d msgs held back\n", i, wrkrInfo->p.tx.currIParam);
+        actionCommit(wrkrInfo->pAction, pWti); /* re-registers the deadline if not yet due */
+    }
+    pWti->linger.bInhibit = 0;
+}
+
 /* Commit all active transactions in *DIRECT mode* */
 void ATTR_NONNULL() actionCommitAllDirect(wti_t *__restrict__ const pWti) {
     int i;
@@ -1737,6 +2368,7 @@ static rsRetVal processMsgMain(action_t *__restrict__ const pAction,
                                wti_t *__restrict__ const pWti,
                                smsg_t *__restrict__ const pMsg,
                                struct syslogTime *ttNow) {
+    uint64_t tStart;
     DEFiRet;
 
     if (actionIsDisabled(pAction)) {
@@ -1744,9 +2376,13 @@ static rsRetVal processMsgMain(action_t *__restrict__ const pAction,
         ABORT_FINALIZE(RS_RET_DISABLE_ACTION);
     }
 
-    CHKiRet(prepareDoActionParams(pAction, pWti, pMsg, ttNow));
+    tStart = wtiTimingStart(pWti);
+    iRet = prepareDoActionParams(pAction, pWti, pMsg, ttNow);
+    wtiTimingStop(&pWti->timing.render, tStart);
+    CHKiRet(iRet);
 
     if (pAction->isTransactional) {
+        if (pAction->pLatency != NULL) actionLatencyNote(pAction, pWti, pMsg);
         pWti->actWrkrInfo[pAction->iActionNbr].pAction = pAction;
         DBGPRINTF("action '%s': is transactional - executing in commit phase\n", pAction->pszName);
         CHKiRet(actionPrepare(pAction, pWti));
@@ -1754,7 +2390,14 @@ static rsRetVal processMsgMain(action_t *__restrict__ const pAction,
         FINALIZE;
     }
 
+    tStart = wtiTimingStart(pWti);
     iRet = actionProcessMessage(pAction, pWti->actWrkrInfo[pAction->iActionNbr].p.nontx.actParams, pWti);
+    wtiTimingStop(&pWti->timing.output, tStart);
+    if (iRet == RS_RET_OK && pAction->pLatency != NULL) {
+        const int64_t rcvdAt = actionLatencyRcvdAt(pMsg);
+        actionLatencyAdd(pAction->pLatency, &rcvdAt, 1);
+    }
+    if (pAction->bUsesMsgPassingMode) wtiNoteMsgModified(pWti); /* message modification module */
     if (pAction->bNeedReleaseBatch) releaseDoActionParams(pAction, pWti, 0);
 finalize_it:
     if (iRet == RS_RET_OK) {
@@ -1771,6 +2414,314 @@ static void markBatchCommittedFrom(batch_t *const pBatch, const int firstElem) {
     }
 }
 
+/* Action groups (action.group).
+ *
+ * Consecutive actions with the same group name are executed by the queue
+ * worker of the first one, the group leader. The other actions (members)
+ * do not enqueue anything themselves. The leader's batch is walked only
+ * once, handing each message to all actions of the group in turn, so that
+ * actions using the same template find its rendering in the worker's
+ * template cache; each action still gets its own copy in its parameters.
+ * The commits are then run in parallel: the leader's one on the queue
+ * worker, those of the members on commit threads owned by the group. Each
+ * commit thread has its own wti. For a commit, it borrows the member's
+ * entry of the queue worker's actWrkrInfo (staged messages, action worker
+ * instance, retry state), which the queue worker does not touch until all
+ * commits are done. So the commits share no worker state.
+ */
+typedef struct actGroupJob_s {
+    action_t *pAction;
+    wti_t *pWti; /* queue worker whose messages are committed */
+    int *pnPending; /* jobs of this commit round not yet done, guarded by the group mutex */
+    struct actGroupJob_s *pNext;
+} actGroupJob_t;
+
+typedef struct actGroupThrd_s {
+    struct actGroup_s *pGroup;
+    wti_t *pWti;
+    pthread_t thrd;
+} actGroupThrd_t;
+
+struct actGroup_s {
+    action_t *pLeader;
+    action_t **members;
+    int nMembers;
+    pthread_mutex_t mut;
+    pthread_cond_t condWork; /* a job was queued or we shut down */
+    pthread_cond_t condDone; /* a job was completed */
+    actGroupJob_t *pJobs; /* queued commit jobs */
+    actGroupThrd_t *thrds;
+    int nThrds; /* number of commit threads started */
+    sbool bThrdsFailed; /* could not start all threads, do not retry */
+    sbool bShutdown;
+};
+
+
+/* swap an action's entries of two actWrkrInfo arrays */
+static void actGroupSwapWrkrInfo(wti_t *const pWti1, wti_t *const pWti2, const int iActionNbr) {
+    const actWrkrInfo_t tmp = pWti1->actWrkrInfo[iActionNbr];
+    pWti1->actWrkrInfo[iActionNbr] = pWti2->actWrkrInfo[iActionNbr];
+    pWti2->actWrkrInfo[iActionNbr] = tmp;
+}
+
+
+static void *actGroupCommitter(void *arg) {
+    actGroupThrd_t *const pThrd = (actGroupThrd_t *)arg;
+    struct actGroup_s *const pGroup = pThrd->pGroup;
+    wti_t *const pWti = pThrd->pWti;
+    actGroupJob_t *pJob;
+    sigset_t sigSet;
+
+    /* block all signals except SIGTTIN and SIGSEGV, like queue workers */
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGTTIN);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+    dbgSetThrdName(wtiGetDbgHdr(pWti));
+
+    pthread_mutex_lock(&pGroup->mut);
+    while (1) {
+        while (!pGroup->bShutdown && pGroup->pJobs == NULL) pthread_cond_wait(&pGroup->condWork, &pGroup->mut);
+        if (pGroup->pJobs == NULL) break; /* shutdown */
+        pJob = pGroup->pJobs;
+        pGroup->pJobs = pJob->pNext;
+        pthread_mutex_unlock(&pGroup->mut);
+
+        pWti->pbShutdownImmediate = pJob->pWti->pbShutdownImmediate;
+        actGroupSwapWrkrInfo(pWti, pJob->pWti, pJob->pAction->iActionNbr);
+        actionCommit(pJob->pAction, pWti);
+        actGroupSwapWrkrInfo(pWti, pJob->pWti, pJob->pAction->iActionNbr);
+
+        pthread_mutex_lock(&pGroup->mut);
+        --*pJob->pnPending;
+        pthread_cond_broadcast(&pGroup->condDone);
+    }
+    pthread_mutex_unlock(&pGroup->mut);
+    return NULL;
+}
+
+
+/* start the commit threads not yet running; must be called with the group mutex locked */
+static void ATTR_NONNULL() actGroupStartThreads(struct actGroup_s *const pGroup) {
+    actGroupThrd_t *pThrd;
+    char name[32];
+    int r;
+
+    if (pGroup->bThrdsFailed) return;
+    if (pGroup->thrds == NULL && (pGroup->thrds = calloc(pGroup->nMembers, sizeof(actGroupThrd_t))) == NULL) {
+        pGroup->bThrdsFailed = 1;
+        return;
+    }
+    while (pGroup->nThrds < pGroup->nMembers) {
+        pThrd = &pGroup->thrds[pGroup->nThrds];
+        pThrd->pGroup = pGroup;
+        snprintf(name, sizeof(name), "actgroup/w%d", pGroup->nThrds);
+        if (pThrd->pWti == NULL &&
+            (wtiConstruct(&pThrd->pWti) != RS_RET_OK ||
+             wtiSetDbgHdr(pThrd->pWti, (uchar *)name, strlen(name)) != RS_RET_OK ||
+             wtiConstructFinalize(pThrd->pWti) != RS_RET_OK)) {
+            LogError(0, RS_RET_OUT_OF_MEMORY,
+                     "action.group '%s': cannot create commit thread, "
+                     "%d of %d running",
+                     pGroup->pLeader->pszGroup, pGroup->nThrds, pGroup->nMembers);
+            pGroup->bThrdsFailed = 1;
+            return;
+        }
+        if ((r = pthread_create(&pThrd->thrd, NULL, actGroupCommitter, pThrd)) != 0) {
+            LogError(r, RS_RET_ERR,
+                     "action.group '%s': cannot create commit thread, "
+                     "%d of %d running",
+                     pGroup->pLeader->pszGroup, pGroup->nThrds, pGroup->nMembers);
+            pGroup->bThrdsFailed = 1;
+            return;
+        }
+        pGroup->nThrds++;
+    }
+}
+
+
+/* commit the leader and all members of the group, in parallel if possible */
+static rsRetVal ATTR_NONNULL() actGroupCommit(struct actGroup_s *const pGroup, wti_t *const pWti) {
+    actGroupJob_t *jobs;
+    int nPending = 0;
+    sbool bParallel = 0;
+    uint64_t tStart;
+    int i;
+    DEFiRet;
+
+    jobs = calloc(pGroup->nMembers, sizeof(actGroupJob_t));
+    pthread_mutex_lock(&pGroup->mut);
+    actGroupStartThreads(pGroup);
+    if (jobs != NULL && pGroup->nThrds > 0) {
+        for (i = 0; i < pGroup->nMembers; ++i) {
+            jobs[i].pAction = pGroup->members[i];
+            jobs[i].pWti = pWti;
+            jobs[i].pnPending = &nPending;
+            jobs[i].pNext = pGroup->pJobs;
+            pGroup->pJobs = &jobs[i];
+        }
+        nPending = pGroup->nMembers;
+        bParallel = 1;
+        pthread_cond_broadcast(&pGroup->condWork);
+    }
+    pthread_mutex_unlock(&pGroup->mut);
+
+    if (!bParallel) {
+        for (i = 0; i < pGroup->nMembers; ++i) actionCommit(pGroup->members[i], pWti);
+    }
+    iRet = actionCommit(pGroup->pLeader, pWti);
+
+    if (bParallel) {
+        /* the commits on our own thread timed themselves, waiting for the others is output time, too */
+        tStart = wtiTimingStart(pWti);
+        pthread_mutex_lock(&pGroup->mut);
+        while (nPending > 0) pthread_cond_wait(&pGroup->condDone, &pGroup->mut);
+        pthread_mutex_unlock(&pGroup->mut);
+        wtiTimingStop(&pWti->timing.output, tStart);
+    }
+    free(jobs);
+    RETiRet;
+}
+
+
+static void actGroupDestruct(struct actGroup_s *const pGroup) {
+    int i;
+
+    pthread_mutex_lock(&pGroup->mut);
+    pGroup->bShutdown = 1;
+    pthread_cond_broadcast(&pGroup->condWork);
+    pthread_mutex_unlock(&pGroup->mut);
+    for (i = 0; pGroup->thrds != NULL && i < pGroup->nMembers; ++i) {
+        if (i < pGroup->nThrds) pthread_join(pGroup->thrds[i].thrd, NULL);
+        /* all borrowed actWrkrInfo entries were given back, so there is nothing to free */
+        if (pGroup->thrds[i].pWti != NULL) wtiDestruct(&pGroup->thrds[i].pWti);
+    }
+    free(pGroup->thrds);
+    free(pGroup->members);
+    pthread_cond_destroy(&pGroup->condDone);
+    pthread_cond_destroy(&pGroup->condWork);
+    pthread_mutex_destroy(&pGroup->mut);
+    free(pGroup);
+}
+
+
+/* members are executed by the leader's queue worker, so they have nothing to submit */
+static rsRetVal doSubmitToActionQGroupMember(action_t __attribute__((unused)) * const pAction,
+                                            wti_t __attribute__((unused)) * const pWti,
+                                            smsg_t __attribute__((unused)) * const pMsg) {
+    return RS_RET_OK;
+}
+
+
+/* add pMember to the group led by pLeader. Called during ruleset optimization,
+ * when all actions are constructed but not yet activated.
+ */
+rsRetVal actionGroupAdd(action_t *const pLeader, action_t *const pMember) {
+    struct actGroup_s *pGroup = pLeader->pGroup;
+    action_t **newMembers;
+    DEFiRet;
+
+    if (pLeader->pQueue->qType == QUEUETYPE_DIRECT) {
+        LogError(0, RS_RET_CONF_PARAM_INVLD,
+                 "action '%s': action.group '%s' requires its first action '%s' "
+                 "to have a non-direct queue - action is not grouped",
+                 pMember->pszName, pMember->pszGroup, pLeader->pszName);
+        ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+    }
+    /* the members receive their messages via the leader's queue, so its filters would apply to them, too */
+    if (pLeader->bExecWhenPrevSusp || pLeader->iExecEveryNthOccur > 1 || pLeader->iSecsExecOnceInterval ||
+        !pLeader->bWriteAllMarkMsgs) {
+        LogError(0, RS_RET_CONF_PARAM_INVLD,
+                 "action '%s': the first action '%s' of action.group '%s' may not use "
+                 "execonlywhenpreviousissuspended, execution intervals or "
+                 "writeallmarkmessages=\"off\" - action is not grouped",
+                 pMember->pszName, pLeader->pszName, pMember->pszGroup);
+        ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+    }
+    if (pMember->pQueue->qType != QUEUETYPE_DIRECT || pMember->bExecWhenPrevSusp || pMember->iExecEveryNthOccur > 1 ||
+        pMember->iSecsExecOnceInterval || !pMember->bWriteAllMarkMsgs) {
+        LogError(0, RS_RET_CONF_PARAM_INVLD,
+                 "action '%s': only the first action of action.group '%s' may "
+                 "have a queue, execonlywhenpreviousissuspended, execution "
+                 "intervals or writeallmarkmessages=\"off\" - action is not grouped",
+                 pMember->pszName, pMember->pszGroup);
+        ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+    }
+
+    if (pGroup == NULL) {
+        CHKmalloc(pGroup = calloc(1, sizeof(struct actGroup_s)));
+        pGroup->pLeader = pLeader;
+        pthread_mutex_init(&pGroup->mut, NULL);
+        pthread_cond_init(&pGroup->condWork, NULL);
+        pthread_cond_init(&pGroup->condDone, NULL);
+        pLeader->pGroup = pGroup;
+    }
+    CHKmalloc(newMembers = realloc(pGroup->members, (pGroup->nMembers + 1) * sizeof(action_t *)));
+    pGroup->members = newMembers;
+    pGroup->members[pGroup->nMembers++] = pMember;
+    pMember->submitToActQ = doSubmitToActionQGroupMember;
+    DBGPRINTF("action '%s' added to group '%s' led by action '%s'\n", pMember->pszName, pMember->pszGroup,
+              pLeader->pszName);
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* processBatchMain() for a group leader: execute the batch for all
+ * actions of the group in a single pass, then commit them in parallel.
+ */
+static rsRetVal ATTR_NONNULL() processBatchGroup(struct actGroup_s *const pGroup,
+                                                 batch_t *const pBatch,
+                                                 wti_t *const pWti) {
+    struct syslogTime ttNow;
+    action_t *pAction;
+    rsRetVal localRet;
+    sbool bDone;
+    int i, j;
+    DEFiRet;
+
+    wtiResetExecState(pWti, pBatch);
+    ttNow.year = 0;
+
+    wtiTplCacheBegin(pWti);
+    for (i = 0; i < batchNumMsgs(pBatch) && !*pWti->pbShutdownImmediate; ++i) {
+        if (!batchIsValidElem(pBatch, i)) continue;
+        bDone = 1;
+        for (j = -1; j < pGroup->nMembers; ++j) {
+            if (j < 0) {
+                pAction = pGroup->pLeader;
+            } else {
+                pAction = pGroup->members[j];
+                STATSCOUNTER_INC(pAction->ctrProcessed, pAction->mutCtrProcessed);
+            }
+            localRet = processMsgMain(pAction, pWti, pBatch->pElem[i].pMsg, &ttNow);
+            DBGPRINTF("processBatchGroup: i %d, action '%s', processMsgMain iRet %d\n", i, pAction->pszName,
+                      localRet);
+            if (localRet != RS_RET_OK && localRet != RS_RET_DEFER_COMMIT && localRet != RS_RET_ACTION_FAILED &&
+                localRet != RS_RET_PREVIOUS_COMMITTED && localRet != RS_RET_DISABLE_ACTION)
+                bDone = 0;
+        }
+        /* the message is only done if every action of the group is done with it */
+        if (bDone) batchSetElemState(pBatch, i, BATCH_STATE_COMM);
+    }
+    wtiTplCacheEnd(pWti);
+
+    if (batchNumMsgs(pBatch) > 0) {
+        STATSCOUNTER_INC(pGroup->pLeader->ctrBatchesProcessed, pGroup->pLeader->mutCtrBatchesProcessed);
+        for (j = 0; j < pGroup->nMembers; ++j)
+            STATSCOUNTER_INC(pGroup->members[j]->ctrBatchesProcessed, pGroup->members[j]->mutCtrBatchesProcessed);
+    }
+
+    /* the commit threads share our action worker instances, so do not hold anything back */
+    pWti->linger.bInhibit = 1;
+    iRet = actGroupCommit(pGroup, pWti);
+    pWti->linger.bInhibit = 0;
+
+    RETiRet;
+}
+
+
 /**
  * @brief Worker callback for action queues.
  *
@@ -1790,6 +2741,11 @@ static rsRetVal ATTR_NONNULL() processBatchMain(void *__restrict__ const pVoid,
     struct syslogTime ttNow;
     DEFiRet;
 
+    if (pAction->pGroup != NULL) {
+        iRet = processBatchGroup(pAction->pGroup, pBatch, pWti);
+        FINALIZE;
+    }
+
     wtiResetExecState(pWti, pBatch);
     /* indicate we have not yet read the date */
     ttNow.year = 0;
@@ -2171,6 +3127,8 @@ static rsRetVal actionApplyCnfParam(action_t *const pAction, struct cnfparamvals
             pAction->pszErrFile = es_str2cstr(pvals[i].val.d.estr, NULL);
         } else if (!strcmp(pblk.descr[i].name, "action.errorfile.maxsize")) {
             pAction->maxErrFileSize = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.errorfile.buffersize")) {
+            pAction->errFileBufSize = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "action.externalstate.file")) {
             pAction->pszExternalStateFile = es_str2cstr(pvals[i].val.d.estr, NULL);
         } else if (!strcmp(pblk.descr[i].name, "action.writeallmarkmessages")) {
@@ -2197,6 +3155,36 @@ static rsRetVal actionApplyCnfParam(action_t *const pAction, struct cnfparamvals
             pAction->iResumeInterval = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "action.resumeintervalmax")) {
             pAction->iResumeIntervalMax = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.resumebackoff")) {
+            char *const mode = es_str2cstr(pvals[i].val.d.estr, NULL);
+            if (!strcasecmp(mode, "exponential")) {
+                pAction->bResumeBackoffExp = 1;
+            } else if (!strcasecmp(mode, "linear")) {
+                pAction->bResumeBackoffExp = 0;
+            } else {
+                LogError(0, RS_RET_PARAM_ERROR,
+                         "action.resumeBackoff: invalid value '%s', "
+                         "must be \"linear\" or \"exponential\" - using linear",
+                         mode);
+            }
+            free(mode);
+        } else if (!strcmp(pblk.descr[i].name, "action.async.maxinflight")) {
+            pAction->iAsyncMaxInFlight = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.async.batchsize")) {
+            pAction->iAsyncBatchSize = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.linger.timeout")) {
+            pAction->iLingerTimeout = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.linger.messages")) {
+            pAction->iLingerMsgs = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.linger.bytes")) {
+            pAction->iLingerBytes = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.group")) {
+            pAction->pszGroup = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(pblk.descr[i].name, "action.latency")) {
+            if (pvals[i].val.d.n && pAction->pLatency == NULL) pAction->pLatency = actionLatencyConstruct();
+        } else if (!strcmp(pblk.descr[i].name, "action.latency.buckets")) {
+            if (pAction->pLatency == NULL) pAction->pLatency = actionLatencyConstruct();
+            if (pAction->pLatency != NULL) actionLatencySetBounds(pAction, pvals[i].val.d.ar);
         } else {
             dbgprintf(
                 "action: program error, non-handled "
@@ -2253,6 +3241,13 @@ rsRetVal addAction(action_t **ppAction,
         cs.pszActionName = NULL; /* free again! */
     } else {
         actionApplyCnfParam(pAction, actParams);
+        if (pAction->iAsyncMaxInFlight > 1 && pMod->mod.om.submitTransaction == NULL) {
+            LogError(0, RS_RET_PARAM_ERROR,
+                     "action.async.maxInFlight: module %s does not support "
+                     "asynchronous commits, parameter ignored",
+                     module.GetName(pMod));
+            pAction->iAsyncMaxInFlight = 1;
+        }
     }
 
     /* check if we can obtain the template pointers - TODO: move to separate function? */
@@ -2303,6 +3298,9 @@ rsRetVal addAction(action_t **ppAction,
         } else if (iTplOpts & OMSR_TPL_AS_JSON) {
             pAction->peParamPassing[i] = ACT_JSON_PASSING;
             pAction->bNeedReleaseBatch = 1;
+        } else if (iTplOpts & OMSR_TPL_AS_IOV) {
+            pAction->peParamPassing[i] = ACT_IOV_PASSING;
+            pAction->bNeedReleaseBatch = 1;
         } else {
             pAction->peParamPassing[i] = ACT_STRING_PASSING;
         }
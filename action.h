@@ -39,6 +39,7 @@
 
 #include "syslogd-types.h"
 #include "queue.h"
+#include "bufwriter.h"
 
 /* external data */
 extern int glbliActionResumeRetryCount;
@@ -76,6 +77,7 @@ struct action_s {
     int iResumeInterval; /* resume interval for this action */
     int iResumeIntervalMax; /* maximum resume interval for this action --> -1: unbounded */
     int iResumeRetryCount; /* how often shall we retry a suspended action? (-1 --> eternal) */
+    sbool bResumeBackoffExp; /* exponential backoff with jitter instead of linear growth? */
     int iNbrNoExec; /* number of matches that did not yet yield to an exec */
     int iExecEveryNthOccur; /* execute this action only every n-th occurrence (with n=0,1 -> always) */
     int iExecEveryNthOccurTO; /* timeout for n-th occurrence feature */
@@ -101,9 +103,22 @@ struct action_s {
     int fdErrFile;
     size_t maxErrFileSize;
     size_t currentErrFileSize;
+    size_t errFileBufSize; /* max bytes buffered for the writer thread, 0 = write synchronously */
+    bufwriterFile_t *pErrFileWriter;
     pthread_mutex_t mutErrFile;
     /* external stat file system */
     const char *pszExternalStateFile;
+    /* asynchronous commits, see submitTransaction() in module-template.h */
+    int iAsyncMaxInFlight; /* max parts of a batch in flight, 1 = synchronous commits only */
+    int iAsyncBatchSize; /* messages per part, 0 = split evenly into iAsyncMaxInFlight parts */
+    /* linger: hold back commits to build larger transactions */
+    int iLingerTimeout; /* max ms a message is held back, 0 = off */
+    int iLingerMsgs; /* commit once this many messages are buffered, 0 = no limit */
+    size_t iLingerBytes; /* commit once the rendered messages reach this size, 0 = no limit */
+    /* action groups: consecutive actions with the same action.group name */
+    uchar *pszGroup; /* group name, NULL if not grouped */
+    struct actGroup_s *pGroup; /* set on the group leader only */
+    struct actLatency_s *pLatency; /* action.latency.* histogram, NULL if off */
     /* for per-worker HUP processing */
     pthread_mutex_t mutWrkrDataTable; /* protects table structures */
     void **wrkrDataTable;
@@ -117,6 +132,7 @@ struct action_s {
     STATSCOUNTER_DEF(ctrSuspend, mutCtrSuspend)
     STATSCOUNTER_DEF(ctrSuspendDuration, mutCtrSuspendDuration)
     STATSCOUNTER_DEF(ctrResume, mutCtrResume)
+    STATSCOUNTER_DEF(ctrErrFileDropped, mutCtrErrFileDropped)
 };
 
 static inline int actionLoadDisabled(action_t *const pAction) {
@@ -186,12 +202,21 @@ rsRetVal actionProcessCnf(struct cnfobj *o);
 /** Commit all outstanding transactions for direct queues. */
 void actionCommitAllDirect(wti_t *pWti);
 
+/** Commit transactions held back by action.linger.*; all of them if @p bForce, else only expired ones. */
+void actionFlushLingering(wti_t *pWti, sbool bForce);
+
+/** Let the queue worker of @p pLeader also execute @p pMember (action.group). */
+rsRetVal actionGroupAdd(action_t *pLeader, action_t *pMember);
+
 /** Remove a worker instance from the action's bookkeeping. */
 void actionRemoveWorker(action_t *const pAction, void *const actWrkrData);
 
 /** Release parameter memory allocated by prepareDoActionParams(). */
 void releaseDoActionParams(action_t *const pAction, wti_t *const pWti, int action_destruct);
 
+/** Report completion of a part submitted via submitTransaction(); callable from any thread. */
+void actionAsyncTxDone(actAsyncTx_t *const pTx, const rsRetVal ret);
+
 /** Return the action name; never returns NULL. */
 const uchar *actionGetName(const action_t *const pAction);
 
@@ -304,25 +304,25 @@ finalize_it:
 
 
 static struct scriptFunct functions[] = {
-    {"faup", 1, 1, do_faup_parse_full, initFunc_faup_parse, NULL},
-    {"faup_scheme", 1, 1, do_faup_parse_scheme, initFunc_faup_parse, NULL},
-    {"faup_credential", 1, 1, do_faup_parse_credential, initFunc_faup_parse, NULL},
-    {"faup_subdomain", 1, 1, do_faup_parse_subdomain, initFunc_faup_parse, NULL},
-    {"faup_domain", 1, 1, do_faup_parse_domain, initFunc_faup_parse, NULL},
-    {"faup_domain_without_tld", 1, 1, do_faup_parse_domain_without_tld, initFunc_faup_parse, NULL},
-    {"faup_host", 1, 1, do_faup_parse_host, initFunc_faup_parse, NULL},
-    {"faup_tld", 1, 1, do_faup_parse_tld, initFunc_faup_parse, NULL},
-    {"faup_port", 1, 1, do_faup_parse_port, initFunc_faup_parse, NULL},
-    {"faup_resource_path", 1, 1, do_faup_parse_resource_path, initFunc_faup_parse, NULL},
-    {"faup_query_string", 1, 1, do_faup_parse_query_string, initFunc_faup_parse, NULL},
-    {"faup_fragment", 1, 1, do_faup_parse_fragment, initFunc_faup_parse, NULL},
-    {NULL, 0, 0, NULL, NULL, NULL}  // last element to check end of array
+    {"faup", 1, 1, do_faup_parse_full, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_scheme", 1, 1, do_faup_parse_scheme, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_credential", 1, 1, do_faup_parse_credential, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_subdomain", 1, 1, do_faup_parse_subdomain, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_domain", 1, 1, do_faup_parse_domain, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_domain_without_tld", 1, 1, do_faup_parse_domain_without_tld, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_host", 1, 1, do_faup_parse_host, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_tld", 1, 1, do_faup_parse_tld, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_port", 1, 1, do_faup_parse_port, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_resource_path", 1, 1, do_faup_parse_resource_path, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_query_string", 1, 1, do_faup_parse_query_string, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {"faup_fragment", 1, 1, do_faup_parse_fragment, initFunc_faup_parse, NULL, SCRIPT_FUNC_PURE},
+    {NULL, 0, 0, NULL, NULL, NULL, 0}  // last element to check end of array
 };
 
 BEGINgetFunctArray
     CODESTARTgetFunctArray;
     dbgprintf("Faup: ffaup\n");
-    *version = 1;
+    *version = SCRIPT_FUNCT_IF_VERSION;
     *functArray = functions;
 ENDgetFunctArray
 
@@ -348,18 +348,18 @@ finalize_it:
 
 
 static struct scriptFunct functions[] = {
-    {"hash64", 1, 2, fmHashXX, init_fmHash64, NULL},
-    {"hash64mod", 2, 3, fmHashXXmod, init_fmHash64mod, NULL},
-    {"hash32", 1, 2, fmHashXX, init_fmHash32, NULL},
-    {"hash32mod", 2, 3, fmHashXXmod, init_fmHash32mod, NULL},
-    {NULL, 0, 0, NULL, NULL, NULL}  // last element to check end of array
+    {"hash64", 1, 2, fmHashXX, init_fmHash64, NULL, SCRIPT_FUNC_PURE},
+    {"hash64mod", 2, 3, fmHashXXmod, init_fmHash64mod, NULL, SCRIPT_FUNC_PURE},
+    {"hash32", 1, 2, fmHashXX, init_fmHash32, NULL, SCRIPT_FUNC_PURE},
+    {"hash32mod", 2, 3, fmHashXXmod, init_fmHash32mod, NULL, SCRIPT_FUNC_PURE},
+    {NULL, 0, 0, NULL, NULL, NULL, 0}  // last element to check end of array
 };
 
 
 BEGINgetFunctArray
     CODESTARTgetFunctArray;
     dbgprintf("Hash: fmhhash\n");
-    *version = 1;
+    *version = SCRIPT_FUNCT_IF_VERSION;
     *functArray = functions;
 ENDgetFunctArray
 
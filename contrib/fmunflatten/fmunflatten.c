@@ -204,13 +204,13 @@ static rsRetVal ATTR_NONNULL(1) initFunc_unflatten(struct cnffunc *const func) {
 }
 
 static struct scriptFunct functions[] = {
-    {"unflatten", 2, 2, doFunc_unflatten, initFunc_unflatten, NULL},
-    {NULL, 0, 0, NULL, NULL, NULL} /* last element to check end of array */
+    {"unflatten", 2, 2, doFunc_unflatten, initFunc_unflatten, NULL, 0},
+    {NULL, 0, 0, NULL, NULL, NULL, 0} /* last element to check end of array */
 };
 
 BEGINgetFunctArray
     CODESTARTgetFunctArray;
-    *version = 1;
+    *version = SCRIPT_FUNCT_IF_VERSION;
     *functArray = functions;
 ENDgetFunctArray
 
@@ -43,6 +43,9 @@ extern int yylex(void);
 extern int yyerror(const char*);
 %}
 
+/* only used to record the line a statement starts on */
+%locations
+
 %union {
 	char *s;
 	long long n;
@@ -168,22 +171,26 @@ script:	  stmt				{ $$ = $1; }
 	| script stmt			{ $$ = scriptAddStmt($1, $2); }
 stmt:	  actlst			{ $$ = $1; }
 	| IF expr THEN block 		{ $$ = cnfstmtNew(S_IF);
+					  cnfstmtSetLine($$, @1.first_line);
 					  $$->d.s_if.expr = $2;
 					  $$->d.s_if.t_then = $4;
 					  $$->d.s_if.t_else = NULL; }
 	| IF expr THEN block ELSE block	{ $$ = cnfstmtNew(S_IF);
+					  cnfstmtSetLine($$, @1.first_line);
 					  $$->d.s_if.expr = $2;
 					  $$->d.s_if.t_then = $4;
 					  $$->d.s_if.t_else = $6; }
 	| FOREACH iterator_decl DO block { $$ = cnfstmtNew(S_FOREACH);
+					  cnfstmtSetLine($$, @1.first_line);
 					  $$->d.s_foreach.iter = $2;
 					  $$->d.s_foreach.body = $4;}
-	| RESET VAR '=' expr ';'	{ $$ = cnfstmtNewSet($2, $4, 1); }
-	| SET VAR '=' expr ';'		{ $$ = cnfstmtNewSet($2, $4, 0); }
-	| UNSET VAR ';'			{ $$ = cnfstmtNewUnset($2); }
-	| PRIFILT block			{ $$ = cnfstmtNewPRIFILT($1, $2); }
-	| PROPFILT block		{ $$ = cnfstmtNewPROPFILT($1, $2); }
-	| RELOAD_LOOKUP_TABLE_PROCEDURE '(' fparams ')' { $$ = cnfstmtNewReloadLookupTable($3);}
+	| RESET VAR '=' expr ';'	{ $$ = cnfstmtNewSet($2, $4, 1); cnfstmtSetLine($$, @1.first_line); }
+	| SET VAR '=' expr ';'		{ $$ = cnfstmtNewSet($2, $4, 0); cnfstmtSetLine($$, @1.first_line); }
+	| UNSET VAR ';'			{ $$ = cnfstmtNewUnset($2); cnfstmtSetLine($$, @1.first_line); }
+	| PRIFILT block			{ $$ = cnfstmtNewPRIFILT($1, $2); cnfstmtSetLine($$, @1.first_line); }
+	| PROPFILT block		{ $$ = cnfstmtNewPROPFILT($1, $2); cnfstmtSetLine($$, @1.first_line); }
+	| RELOAD_LOOKUP_TABLE_PROCEDURE '(' fparams ')' { $$ = cnfstmtNewReloadLookupTable($3);
+					  cnfstmtSetLine($$, @1.first_line); }
 	| include			{ $$ = NULL; }
 	| BEGINOBJ			{ $$ = NULL; parser_errmsg("declarative object '%s' not permitted in action block [stmt]", yytext);}
 block:    stmt				{ $$ = $1; }
@@ -191,14 +198,15 @@ block:    stmt				{ $$ = $1; }
 actlst:	  s_act				{ $$ = $1; }
 	| actlst '&' s_act 		{ $$ = scriptAddStmt($1, $3); }
 /* s_act are actions and action-like statements */
-s_act:	  BEGIN_ACTION nvlst ENDOBJ	{ $$ = cnfstmtNewAct($2); }
-	| LEGACY_ACTION			{ $$ = cnfstmtNewLegaAct($1); }
-	| STOP				{ $$ = cnfstmtNew(S_STOP); }
-	| CALL NAME			{ $$ = cnfstmtNewCall($2); }
+s_act:	  BEGIN_ACTION nvlst ENDOBJ	{ $$ = cnfstmtNewAct($2); cnfstmtSetLine($$, @1.first_line); }
+	| LEGACY_ACTION			{ $$ = cnfstmtNewLegaAct($1); cnfstmtSetLine($$, @1.first_line); }
+	| STOP				{ $$ = cnfstmtNew(S_STOP); cnfstmtSetLine($$, @1.first_line); }
+	| CALL NAME			{ $$ = cnfstmtNewCall($2); cnfstmtSetLine($$, @1.first_line); }
 	| CALL_INDIRECT expr ';'	{ $$ = cnfstmtNew(S_CALL_INDIRECT);
+					  cnfstmtSetLine($$, @1.first_line);
 					  $$->d.s_call_ind.expr = $2;
 					}
-	| CONTINUE			{ $$ = cnfstmtNewContinue(); }
+	| CONTINUE			{ $$ = cnfstmtNewContinue(); cnfstmtSetLine($$, @1.first_line); }
 expr:	  expr AND expr			{ $$ = cnfexprNew(AND, $1, $3); }
 	| expr OR expr			{ $$ = cnfexprNew(OR, $1, $3); }
 	| NOT expr			{ $$ = cnfexprNew(NOT, NULL, $2); }
@@ -58,6 +58,9 @@
 #include "wti.h"
 #include "unicode-helper.h"
 #include "errmsg.h"
+#include "scriptvm.h"
+#include "acmatch.h"
+#include "redfa.h"
 #include "glbl.h"
 #ifdef HAVE_LIBYAML
     #include "yamlconf.h"
@@ -1499,6 +1502,23 @@ static es_str_t *var2String(struct svar *__restrict__ const r, int *__restrict__
     return estr;
 }
 
+/* string value of r without allocation; numbers are formatted into buf,
+ * which should have room for 32 bytes. Same value as var2String().
+ */
+static const uchar *var2View(const struct svar *const r, char *const buf, const size_t lenBuf, rs_size_t *const pLen) {
+    const char *cstr;
+    if (r->datatype == 'N') {
+        *pLen = (rs_size_t)snprintf(buf, lenBuf, "%lld", r->d.n);
+        return (const uchar *)buf;
+    } else if (r->datatype == 'J') {
+        cstr = (r->d.json == NULL) ? "" : json_object_get_string(r->d.json);
+        *pLen = strlen(cstr);
+        return (const uchar *)cstr;
+    }
+    *pLen = es_strlen(r->d.estr);
+    return es_getBufAddr(r->d.estr);
+}
+
 uchar *var2CString(struct svar *__restrict__ const r, int *__restrict__ const bMustFree) {
     uchar *cstr;
     es_str_t *estr;
@@ -1653,6 +1673,13 @@ static void doFunc_re_extract(struct cnffunc *func, struct svar *ret, void *usrp
         bHadNoMatch = 1;
         goto finalize_it;
     }
+    /* the combined automaton cannot extract, but quickly tells if there is
+     * nothing to extract at all
+     */
+    if (func->regroup != NULL && cnfregroupMatch(func->regroup, func->reId, (uchar *)str, strlen(str), pWti) == 0) {
+        bHadNoMatch = 1;
+        goto finalize_it;
+    }
 
     /* first see if we find a match, iterating through the series of
      * potential matches over the string.
@@ -1851,6 +1878,7 @@ static void ATTR_NONNULL() doFunc_parse_json(struct cnffunc *__restrict__ const
         } else {
             size_t off = (*container == '$') ? 1 : 0;
             msgAddJSON(pMsg, (uchar *)container + off, json, 0, 0);
+            wtiNoteMsgModified(pWti);
             retVal = RS_SCRIPT_EOK;
         }
     }
@@ -2214,8 +2242,10 @@ static void ATTR_NONNULL() doFunct_ReMatch(struct cnffunc *__restrict__ const fu
 
     cnfexprEval(func->expr[0], &srcVal, usrptr, pWti);
     str = (char *)var2CString(&srcVal, &bMustFree);
-    retval = regexp.regexec(func->funcdata, str, 0, NULL, 0);
-    if (retval == 0)
+    if (func->regroup != NULL &&
+        (retval = cnfregroupMatch(func->regroup, func->reId, (uchar *)str, strlen(str), pWti)) >= 0)
+        ret->d.n = retval;
+    else if ((retval = regexp.regexec(func->funcdata, str, 0, NULL, 0)) == 0)
         ret->d.n = 1;
     else {
         ret->d.n = 0;
@@ -2893,6 +2923,25 @@ static void ATTR_NONNULL() doFuncCall(struct cnffunc *__restrict__ const func,
     if (func->fPtr == NULL) {
         ret->datatype = 'N';
         ret->d.n = 0;
+    } else if (func->memoId >= 0) {
+        /* the same call is done elsewhere in the config, reuse its result */
+        const wtiFuncCacheEntry_t *const cached = wtiFuncCacheLookup(pWti, (smsg_t *)usrptr, func->memoId);
+        if (cached != NULL) {
+            ret->datatype = cached->datatype;
+            if (cached->datatype == 'S') {
+                ret->d.estr = es_strdup(cached->estr);
+            } else {
+                ret->d.n = cached->n;
+            }
+            if (func->flags & SCRIPT_FUNC_ERRNO) wtiSetScriptErrno(pWti, cached->script_errno);
+            if (ret->datatype != 'S' || ret->d.estr != NULL) return;
+        }
+        func->fPtr(func, ret, usrptr, pWti);
+        /* JSON results are not cached, the caller would get a shared object */
+        if (ret->datatype == 'N' || ret->datatype == 'S') {
+            wtiFuncCacheStore(pWti, (smsg_t *)usrptr, func->memoId, ret->datatype,
+                              (ret->datatype == 'N') ? ret->d.n : 0, (ret->datatype == 'S') ? ret->d.estr : NULL);
+        }
     } else {
         func->fPtr(func, ret, usrptr, pWti);
     }
@@ -3363,17 +3412,31 @@ finalize_it:
     if (nParamsEvaluated >= 2) varFreeMembers(&srcVal[2]);
 }
 
+/* Values which need to be allocated (string JSON values, formatted
+ * properties) are kept in the worker's property cache, so that other
+ * conditions on the same message can reuse them. Global variables ($/)
+ * are not cached, as other workers may change them at any time.
+ */
 static void evalVar(struct cnfvar *__restrict__ const var,
                     void *__restrict__ const usrptr,
-                    struct svar *__restrict__ const ret) {
+                    struct svar *__restrict__ const ret,
+                    wti_t *const pWti) {
     rs_size_t propLen;
     uchar *pszProp = NULL;
+    const uchar *cached;
     unsigned short bMustBeFreed = 0;
     rsRetVal localRet;
     struct json_object *json;
     uchar *cstr = NULL;
 
     if (var->prop.id == PROP_CEE || var->prop.id == PROP_LOCAL_VAR || var->prop.id == PROP_GLOBAL_VAR) {
+        const sbool bCacheable = (var->prop.id != PROP_GLOBAL_VAR);
+        if (bCacheable && (cached = wtiPropCacheLookup(pWti, (smsg_t *)usrptr, &var->prop, &propLen)) != NULL) {
+            DBGPRINTF("rainerscript: (json/string) var %d: '%s' [cached]\n", var->prop.id, cached);
+            ret->datatype = 'S';
+            ret->d.estr = es_newStrFromCStr((const char *)cached, propLen);
+            return;
+        }
         localRet = msgGetJSONPropJSONorString((smsg_t *)usrptr, &var->prop, &json, &cstr);
         if (json != NULL) {
             assert(cstr == NULL);
@@ -3384,14 +3447,21 @@ static void evalVar(struct cnfvar *__restrict__ const var,
         } else { /* we have a string */
             DBGPRINTF("rainerscript: (json/string) var %d: '%s'\n", var->prop.id, cstr);
             ret->datatype = 'S';
-            ret->d.estr = (localRet != RS_RET_OK || cstr == NULL)
-                              ? es_newStr(1)
-                              : es_newStrFromCStr((char *)cstr, strlen((char *)cstr));
+            if (localRet != RS_RET_OK || cstr == NULL) {
+                ret->d.estr = es_newStr(1);
+            } else {
+                propLen = strlen((char *)cstr);
+                ret->d.estr = es_newStrFromCStr((char *)cstr, propLen);
+                if (bCacheable) {
+                    wtiPropCacheStore(pWti, (smsg_t *)usrptr, &var->prop, cstr, propLen);
+                    cstr = NULL;
+                }
+            }
         }
         free(cstr);
     } else {
         ret->datatype = 'S';
-        pszProp = (uchar *)MsgGetProp((smsg_t *)usrptr, NULL, &var->prop, &propLen, &bMustBeFreed, NULL);
+        pszProp = wtiMsgGetProp(pWti, (smsg_t *)usrptr, &var->prop, &propLen, &bMustBeFreed);
         ret->d.estr = es_newStrFromCStr((char *)pszProp, propLen);
         DBGPRINTF("rainerscript: (string) var %d: '%s'\n", var->prop.id, pszProp);
         if (bMustBeFreed) free(pszProp);
@@ -3400,8 +3470,10 @@ static void evalVar(struct cnfvar *__restrict__ const var,
 
 /* perform a string comparision operation against a while array. Semantic is
  * that one one comparison is true, the whole construct is true.
- * TODO: we can obviously optimize this process. One idea is to
- * compile a regex, which should work faster than serial comparison.
+ * For larger arrays, the optimizer builds a multi-pattern matcher for
+ * contains/startswith/endswith (see acmatch.c), so that all elements are
+ * checked in a single pass. EQ/NE use a hash set for larger arrays and
+ * binary search on the sorted array otherwise.
  * Note: compiling a regex does NOT work at all. I experimented with that
  * and it was generally 5 to 10 times SLOWER than what we do here...
  */
@@ -3409,12 +3481,16 @@ static int evalStrArrayCmp(es_str_t *const estr_l, const struct cnfarray *__rest
     int i;
     int r = 0;
     es_str_t **res;
-    if (cmpop == CMP_EQ) {
-        res = bsearch(&estr_l, ar->arr, ar->nmemb, sizeof(es_str_t *), qs_arrcmp);
-        r = res != NULL;
-    } else if (cmpop == CMP_NE) {
-        res = bsearch(&estr_l, ar->arr, ar->nmemb, sizeof(es_str_t *), qs_arrcmp);
-        r = res == NULL;
+    if (ar->matcher != NULL && cmpop != CMP_EQ && cmpop != CMP_NE) {
+        r = acmatchMatch(ar->matcher, es_getBufAddr(estr_l), es_strlen(estr_l));
+    } else if (cmpop == CMP_EQ || cmpop == CMP_NE) {
+        if (ar->hashset != NULL) {
+            r = cnfarrayFind(ar, es_getBufAddr(estr_l), es_strlen(estr_l));
+        } else {
+            res = bsearch(&estr_l, ar->arr, ar->nmemb, sizeof(es_str_t *), qs_arrcmp);
+            r = res != NULL;
+        }
+        if (cmpop == CMP_NE) r = !r;
     } else {
         for (i = 0; (r == 0) && (i < ar->nmemb); ++i) {
             switch (cmpop) {
@@ -3495,8 +3571,9 @@ static int evalStrArrayCmp(es_str_t *const estr_l, const struct cnfarray *__rest
 static int eval_strcmp_like(const struct cnfexpr *__restrict__ const expr,
                             void *__restrict__ const usrptr,
                             wti_t *__restrict__ const pWti) {
-    es_str_t *__restrict__ estr_r, *__restrict__ estr_l;
-    int bMustFree, bMustFree2;
+    char buf_l[32], buf_r[32];
+    const uchar *str_l, *str_r;
+    rs_size_t len_l, len_r;
     int64_t n_r, n_l;
     int convok_r, convok_l;
     struct svar r, l; /* memory for subexpression results */
@@ -3511,11 +3588,10 @@ static int eval_strcmp_like(const struct cnfexpr *__restrict__ const expr,
     if (convok_l && convok_r) {
         ret = n_l - n_r;
     } else {
-        estr_l = var2String(&l, &bMustFree);
-        estr_r = var2String(&r, &bMustFree2);
-        ret = es_strcmp(estr_l, estr_r);
-        if (bMustFree) es_deleteStr(estr_l);
-        if (bMustFree2) es_deleteStr(estr_r);
+        /* compare without converting numbers into allocated strings */
+        str_l = var2View(&l, buf_l, sizeof(buf_l), &len_l);
+        str_r = var2View(&r, buf_r, sizeof(buf_r), &len_r);
+        ret = rsvmStrCmp(str_l, len_l, str_r, len_r);
     }
     FREE_BOTH_RET;
     return ret;
@@ -3793,7 +3869,7 @@ void ATTR_NONNULL() cnfexprEval(const struct cnfexpr *__restrict__ const expr,
             ret->d.estr = es_strdup(((struct cnfarray *)expr)->arr[0]);
             break;
         case 'V':
-            evalVar((struct cnfvar *)expr, usrptr, ret);
+            evalVar((struct cnfvar *)expr, usrptr, ret, pWti);
             break;
         case '&':
             /* TODO: think about optimization, should be possible ;) */
@@ -3848,12 +3924,164 @@ void ATTR_NONNULL() cnfexprEval(const struct cnfexpr *__restrict__ const expr,
 
 //---------------------------------------------------------
 
+/* hash set for EQ/NE comparisons against constant arrays, see
+ * cnfexprOptimize_CMPEQ_arr().
+ */
+struct cnfarrayHashSlot {
+    uint32_t hash;
+    int idx; /* index into array, -1 if slot is empty */
+};
+struct cnfarrayHash {
+    uint32_t mask;
+    struct cnfarrayHashSlot slots[];
+};
+
+/* FNV-1a */
+static inline uint32_t cnfarrayHashStr(const uchar *const str, const size_t len) {
+    uint32_t h = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; ++i) {
+        h ^= str[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* check if str is an element of the array. Uses the hash set if there is
+ * one, otherwise the array must be sorted (as done by the optimizer).
+ */
+int cnfarrayFind(const struct cnfarray *const ar, const uchar *const str, const size_t len) {
+    if (ar->hashset != NULL) {
+        const struct cnfarrayHash *const hs = ar->hashset;
+        const uint32_t h = cnfarrayHashStr(str, len);
+        uint32_t j;
+        for (j = h & hs->mask; hs->slots[j].idx != -1; j = (j + 1) & hs->mask) {
+            const es_str_t *const elt = ar->arr[hs->slots[j].idx];
+            if (hs->slots[j].hash == h && es_strlen(elt) == len && !memcmp(es_getBufAddr(elt), str, len)) return 1;
+        }
+        return 0;
+    } else {
+        int lo = 0, hi = ar->nmemb - 1;
+        while (lo <= hi) {
+            const int mid = lo + (hi - lo) / 2;
+            const int r = es_strbufcmp(ar->arr[mid], str, len);
+            if (r == 0) return 1;
+            if (r > 0)
+                hi = mid - 1;
+            else
+                lo = mid + 1;
+        }
+        return 0;
+    }
+}
+
+/* value to case index table for S_SWITCH. Keys are owned by the table. */
+struct cnfswitchSlot {
+    uint32_t hash;
+    int icase; /* -1 if slot is empty */
+    uchar *key;
+    size_t lenKey;
+};
+struct cnfswitchTable {
+    uint32_t mask;
+    uint32_t nKeys;
+    struct cnfswitchSlot *slots;
+};
+
+static struct cnfswitchSlot *cnfswitchTableSlot(const struct cnfswitchTable *const tbl,
+                                                const uchar *const key,
+                                                const size_t lenKey,
+                                                const uint32_t h) {
+    uint32_t j;
+    for (j = h & tbl->mask; tbl->slots[j].icase != -1; j = (j + 1) & tbl->mask) {
+        const struct cnfswitchSlot *const slot = &tbl->slots[j];
+        if (slot->hash == h && slot->lenKey == lenKey && !memcmp(slot->key, key, lenKey)) break;
+    }
+    return &tbl->slots[j];
+}
+
+static rsRetVal cnfswitchTableResize(struct cnfswitchTable *const tbl, const uint32_t newSize) {
+    struct cnfswitchSlot *const oldSlots = tbl->slots;
+    const uint32_t oldSize = (oldSlots == NULL) ? 0 : tbl->mask + 1;
+    uint32_t i;
+    DEFiRet;
+
+    CHKmalloc(tbl->slots = malloc(sizeof(struct cnfswitchSlot) * newSize));
+    tbl->mask = newSize - 1;
+    for (i = 0; i < newSize; ++i) tbl->slots[i].icase = -1;
+    for (i = 0; i < oldSize; ++i) {
+        if (oldSlots[i].icase != -1)
+            *cnfswitchTableSlot(tbl, oldSlots[i].key, oldSlots[i].lenKey, oldSlots[i].hash) = oldSlots[i];
+    }
+    free(oldSlots);
+
+finalize_it:
+    if (iRet != RS_RET_OK) tbl->slots = oldSlots;
+    RETiRet;
+}
+
+/* map key to case icase. If the key is already present, it is only
+ * remapped if bOverride is set. This way, both the first matching case
+ * (if building a chain top-down) and the last one (if prepending cases to
+ * an existing switch) can win, as if/else-if semantics require.
+ */
+static rsRetVal cnfswitchTableSet(struct cnfswitchTable *const tbl,
+                                  const uchar *const key,
+                                  const size_t lenKey,
+                                  const int icase,
+                                  const int bOverride) {
+    const uint32_t h = cnfarrayHashStr(key, lenKey);
+    struct cnfswitchSlot *slot;
+    DEFiRet;
+
+    if (tbl->slots == NULL || 2 * (tbl->nKeys + 1) > tbl->mask + 1)
+        CHKiRet(cnfswitchTableResize(tbl, (tbl->slots == NULL) ? 16 : 2 * (tbl->mask + 1)));
+    slot = cnfswitchTableSlot(tbl, key, lenKey, h);
+    if (slot->icase != -1) {
+        if (bOverride) slot->icase = icase;
+        FINALIZE;
+    }
+    CHKmalloc(slot->key = malloc(lenKey + 1));
+    memcpy(slot->key, key, lenKey);
+    slot->key[lenKey] = '\0';
+    slot->lenKey = lenKey;
+    slot->hash = h;
+    slot->icase = icase;
+    ++tbl->nKeys;
+
+finalize_it:
+    RETiRet;
+}
+
+static void cnfswitchTableDestruct(struct cnfswitchTable *const tbl) {
+    uint32_t i;
+    if (tbl == NULL) return;
+    if (tbl->slots != NULL) {
+        for (i = 0; i <= tbl->mask; ++i) {
+            if (tbl->slots[i].icase != -1) free(tbl->slots[i].key);
+        }
+        free(tbl->slots);
+    }
+    free(tbl);
+}
+
+/* find the case of a switch statement matching val.
+ * @return case index or -1 if the default branch is to be taken
+ */
+int cnfstmtSwitchFind(const struct cnfstmt *const stmt, const uchar *const val, const size_t len) {
+    const struct cnfswitchTable *const tbl = stmt->d.s_switch.table;
+    if (tbl->slots == NULL) return -1;
+    return cnfswitchTableSlot(tbl, val, len, cnfarrayHashStr(val, len))->icase;
+}
+
 void cnfarrayContentDestruct(struct cnfarray *ar) {
     unsigned short i;
     for (i = 0; i < ar->nmemb; ++i) {
         es_deleteStr(ar->arr[i]);
     }
     free(ar->arr);
+    acmatchDestruct(&ar->matcher);
+    free(ar->hashset);
 }
 
 static void regex_destruct(struct cnffunc *func) {
@@ -4103,48 +4331,58 @@ struct modListNode {
     struct modListNode *next;
 };
 
+/* struct scriptFunct as provided by modules with interface version 1 */
+struct scriptFunctV1 {
+    const char *fname;
+    unsigned short minParams;
+    unsigned short maxParams;
+    rscriptFuncPtr fPtr;
+    rsRetVal (*initFunc)(struct cnffunc *);
+    void (*destruct)(struct cnffunc *);
+};
+
 static struct modListNode *modListRoot = NULL;
 static struct modListNode *modListLast = NULL;
 
 static struct scriptFunct functions[] = {
-    {"strlen", 1, 1, doFunct_StrLen, NULL, NULL},
-    {"getenv", 1, 1, doFunct_Getenv, NULL, NULL},
-    {"num2ipv4", 1, 1, doFunct_num2ipv4, NULL, NULL},
-    {"int2hex", 1, 1, doFunct_Int2Hex, NULL, NULL},
-    {"substring", 3, 3, doFunct_Substring, NULL, NULL},
-    {"ltrim", 1, 1, doFunct_LTrim, NULL, NULL},
-    {"rtrim", 1, 1, doFunct_RTrim, NULL, NULL},
-    {"tolower", 1, 1, doFunct_ToLower, NULL, NULL},
-    {"toupper", 1, 1, doFunct_ToUpper, NULL, NULL},
-    {"cstr", 1, 1, doFunct_CStr, NULL, NULL},
-    {"cnum", 1, 1, doFunct_CNum, NULL, NULL},
-    {"ip42num", 1, 1, doFunct_Ipv42num, NULL, NULL},
-    {"ipv42num", 1, 1, doFunct_Ipv42num, NULL, NULL},
-    {"re_match", 2, 2, doFunct_ReMatch, initFunc_re_match, regex_destruct},
-    {"re_match_i", 2, 2, doFunct_ReMatch, initFunc_re_match_i, regex_destruct},
-    {"re_extract", 5, 5, doFunc_re_extract, initFunc_re_match, regex_destruct},
-    {"re_extract_i", 5, 5, doFunc_re_extract, initFunc_re_match_i, regex_destruct},
-    {"field", 3, 3, doFunct_Field, NULL, NULL},
-    {"exec_template", 1, 1, doFunc_exec_template, initFunc_exec_template, NULL},
-    {"prifilt", 1, 1, doFunct_Prifilt, initFunc_prifilt, NULL},
-    {"lookup", 2, 2, doFunct_Lookup, resolveLookupTable, NULL},
-    {"dyn_inc", 2, 2, doFunct_DynInc, initFunc_dyn_stats, NULL},
-    {"percentile_observe", 3, 3, doFunc_percentile_obs, initFunc_perctile_obs, NULL},
-    {"replace", 3, 3, doFunct_Replace, NULL, NULL},
-    {"wrap", 2, 3, doFunct_Wrap, NULL, NULL},
-    {"random", 1, 1, doFunct_RandomGen, NULL, NULL},
-    {"format_time", 2, 2, doFunct_FormatTime, NULL, NULL},
-    {"parse_time", 1, 1, doFunct_ParseTime, NULL, NULL},
-    {"is_time", 1, 2, doFunct_IsTime, NULL, NULL},
-    {"parse_json", 2, 2, doFunc_parse_json, NULL, NULL},
-    {"get_property", 2, 2, doFunc_get_property, NULL, NULL},
-    {"script_error", 0, 0, doFunct_ScriptError, NULL, NULL},
-    {"previous_action_suspended", 0, 0, doFunct_PreviousActionSuspended, NULL, NULL},
-    {"b64_decode", 1, 1, doFunct_Base64Dec, NULL, NULL},
-    {"split", 2, 2, doFunct_split, NULL, NULL},
-    {"is_in_subnet", 2, 2, doFunct_is_in_subnet, NULL, NULL},
-    {"append_json", 2, 3, doFunct_append_json, NULL, NULL},
-    {NULL, 0, 0, NULL, NULL, NULL}  // last element to check end of array
+    {"strlen", 1, 1, doFunct_StrLen, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"getenv", 1, 1, doFunct_Getenv, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"num2ipv4", 1, 1, doFunct_num2ipv4, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"int2hex", 1, 1, doFunct_Int2Hex, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"substring", 3, 3, doFunct_Substring, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"ltrim", 1, 1, doFunct_LTrim, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"rtrim", 1, 1, doFunct_RTrim, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"tolower", 1, 1, doFunct_ToLower, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"toupper", 1, 1, doFunct_ToUpper, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"cstr", 1, 1, doFunct_CStr, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"cnum", 1, 1, doFunct_CNum, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"ip42num", 1, 1, doFunct_Ipv42num, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"ipv42num", 1, 1, doFunct_Ipv42num, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"re_match", 2, 2, doFunct_ReMatch, initFunc_re_match, regex_destruct, SCRIPT_FUNC_PURE},
+    {"re_match_i", 2, 2, doFunct_ReMatch, initFunc_re_match_i, regex_destruct, SCRIPT_FUNC_PURE},
+    {"re_extract", 5, 5, doFunc_re_extract, initFunc_re_match, regex_destruct, SCRIPT_FUNC_PURE},
+    {"re_extract_i", 5, 5, doFunc_re_extract, initFunc_re_match_i, regex_destruct, SCRIPT_FUNC_PURE},
+    {"field", 3, 3, doFunct_Field, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"exec_template", 1, 1, doFunc_exec_template, initFunc_exec_template, NULL, 0},
+    {"prifilt", 1, 1, doFunct_Prifilt, initFunc_prifilt, NULL, 0},
+    {"lookup", 2, 2, doFunct_Lookup, resolveLookupTable, NULL, 0},
+    {"dyn_inc", 2, 2, doFunct_DynInc, initFunc_dyn_stats, NULL, 0},
+    {"percentile_observe", 3, 3, doFunc_percentile_obs, initFunc_perctile_obs, NULL, 0},
+    {"replace", 3, 3, doFunct_Replace, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"wrap", 2, 3, doFunct_Wrap, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"random", 1, 1, doFunct_RandomGen, NULL, NULL, 0},
+    {"format_time", 2, 2, doFunct_FormatTime, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"parse_time", 1, 1, doFunct_ParseTime, NULL, NULL, SCRIPT_FUNC_PURE | SCRIPT_FUNC_ERRNO},
+    {"is_time", 1, 2, doFunct_IsTime, NULL, NULL, SCRIPT_FUNC_PURE | SCRIPT_FUNC_ERRNO},
+    {"parse_json", 2, 2, doFunc_parse_json, NULL, NULL, SCRIPT_FUNC_IDEMPOTENT | SCRIPT_FUNC_ERRNO},
+    {"get_property", 2, 2, doFunc_get_property, NULL, NULL, SCRIPT_FUNC_PURE | SCRIPT_FUNC_ERRNO},
+    {"script_error", 0, 0, doFunct_ScriptError, NULL, NULL, 0},
+    {"previous_action_suspended", 0, 0, doFunct_PreviousActionSuspended, NULL, NULL, 0},
+    {"b64_decode", 1, 1, doFunct_Base64Dec, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"split", 2, 2, doFunct_split, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"is_in_subnet", 2, 2, doFunct_is_in_subnet, NULL, NULL, SCRIPT_FUNC_PURE},
+    {"append_json", 2, 3, doFunct_append_json, NULL, NULL, 0},
+    {NULL, 0, 0, NULL, NULL, NULL, 0}  // last element to check end of array
 };
 
 static rscriptFuncPtr ATTR_NONNULL() extractFuncPtr(const struct scriptFunct *const funct, const unsigned int nParams) {
@@ -4482,6 +4720,28 @@ void cnfexprPrint(struct cnfexpr *expr, int indent) {
     }
 }
 
+static void cnfstmtSwitchPrintCases(struct cnfstmt *const stmt, const int indent) {
+    const struct cnfswitchTable *const tbl = stmt->d.s_switch.table;
+    int i;
+    uint32_t j;
+    for (i = 0; i < stmt->d.s_switch.nCases; ++i) {
+        for (j = 0; tbl->slots != NULL && j <= tbl->mask; ++j) {
+            if (tbl->slots[j].icase == i) {
+                doIndent(indent);
+                dbgprintf("CASE '%s'\n", tbl->slots[j].key);
+            }
+        }
+        cnfstmtPrint(stmt->d.s_switch.cases[i], indent + 1);
+    }
+    if (stmt->d.s_switch.t_default != NULL) {
+        doIndent(indent);
+        dbgprintf("DEFAULT\n");
+        cnfstmtPrint(stmt->d.s_switch.t_default, indent + 1);
+    }
+    doIndent(indent);
+    dbgprintf("END SWITCH\n");
+}
+
 /* print only the given stmt
  * if "subtree" equals 1, the full statement subtree is printed, else
  * really only the statement.
@@ -4598,6 +4858,15 @@ void cnfstmtPrintOnly(struct cnfstmt *stmt, int indent, sbool subtree) {
                 dbgprintf("END PROPFILT\n");
             }
             break;
+        case S_SWITCH:
+            doIndent(indent);
+            if (stmt->d.s_switch.prop.name != NULL)
+                dbgprintf("SWITCH '%s', %d cases\n", stmt->d.s_switch.prop.name, stmt->d.s_switch.nCases);
+            else
+                dbgprintf("SWITCH '%s', %d cases\n", propIDToName(stmt->d.s_switch.prop.id),
+                          stmt->d.s_switch.nCases);
+            if (subtree) cnfstmtSwitchPrintCases(stmt, indent);
+            break;
         default:
             dbgprintf("error: unknown stmt type %u\n", (unsigned)stmt->nodetype);
             break;
@@ -4634,6 +4903,8 @@ struct cnfarray *cnfarrayNew(es_str_t *val) {
     if ((ar = malloc(sizeof(struct cnfarray))) != NULL) {
         ar->nodetype = 'A';
         ar->nmemb = 1;
+        ar->matcher = NULL;
+        ar->hashset = NULL;
         if ((ar->arr = malloc(sizeof(es_str_t *))) == NULL) {
             free(ar);
             ar = NULL;
@@ -4682,14 +4953,24 @@ struct cnfvar *cnfvarNew(char *name) {
 
 struct cnfstmt *cnfstmtNew(unsigned s_type) {
     struct cnfstmt *cnfstmt;
-    if ((cnfstmt = malloc(sizeof(struct cnfstmt))) != NULL) {
+    if ((cnfstmt = calloc(1, sizeof(struct cnfstmt))) != NULL) {
         cnfstmt->nodetype = s_type;
         cnfstmt->printable = NULL;
         cnfstmt->next = NULL;
+        cnfstmt->fn = (cnfcurrfn == NULL) ? NULL : strdup(cnfcurrfn);
+        cnfstmt->lineno = yylineno;
     }
     return cnfstmt;
 }
 
+/* The parser creates a statement after reading all of it, so yylineno is
+ * its last line. The grammar uses this to record the first line instead,
+ * for every kind of statement.
+ */
+void cnfstmtSetLine(struct cnfstmt *const stmt, const int lineno) {
+    if (stmt != NULL) stmt->lineno = lineno;
+}
+
 /* This function disables a cnfstmt by setting it to NOP. This is
  * useful when we detect errors late in the parsing processing, where
  * we need to return a valid cnfstmt. The optimizer later removes the
@@ -4703,6 +4984,15 @@ static void cnfstmtDisable(struct cnfstmt *cnfstmt) {
 
 static void cnfIteratorDestruct(struct cnfitr *itr);
 
+static void cnfstmtSwitchContentDestruct(struct cnfstmt *const stmt) {
+    int i;
+    msgPropDescrDestruct(&stmt->d.s_switch.prop);
+    cnfswitchTableDestruct(stmt->d.s_switch.table);
+    for (i = 0; i < stmt->d.s_switch.nCases; ++i) cnfstmtDestructLst(stmt->d.s_switch.cases[i]);
+    free(stmt->d.s_switch.cases);
+    cnfstmtDestructLst(stmt->d.s_switch.t_default);
+}
+
 /* delete a single stmt */
 static void cnfstmtDestruct(struct cnfstmt *stmt) {
     switch (stmt->nodetype) {
@@ -4720,6 +5010,7 @@ static void cnfstmtDestruct(struct cnfstmt *stmt) {
             break;
         case S_IF:
             cnfexprDestruct(stmt->d.s_if.expr);
+            rsvmDestruct(stmt->d.s_if.prog);
             if (stmt->d.s_if.t_then != NULL) {
                 cnfstmtDestructLst(stmt->d.s_if.t_then);
             }
@@ -4756,11 +5047,15 @@ static void cnfstmtDestruct(struct cnfstmt *stmt) {
                 free(stmt->d.s_reload_lookup_table.stub_value);
             }
             break;
+        case S_SWITCH:
+            cnfstmtSwitchContentDestruct(stmt);
+            break;
         default:
             DBGPRINTF("error: unknown stmt type during destruct %u\n", (unsigned)stmt->nodetype);
             break;
     }
     free(stmt->printable);
+    free(stmt->fn);
     free(stmt);
 }
 
@@ -4779,6 +5074,7 @@ struct cnfitr *cnfNewIterator(char *var, struct cnfexpr *collection) {
     if ((itr = malloc(sizeof(struct cnfitr))) != NULL) {
         itr->var = var;
         itr->collection = collection;
+        itr->bBorrow = 0;
     }
     return itr;
 }
@@ -4939,6 +5235,7 @@ struct cnfstmt *cnfstmtNewPROPFILT(char *propfilt, struct cnfstmt *t_then) {
         cnfstmt->printable = (uchar *)propfilt;
         cnfstmt->d.s_propfilt.t_then = t_then;
         cnfstmt->d.s_propfilt.regex_cache = NULL;
+        cnfstmt->d.s_propfilt.regroup = NULL;
         cnfstmt->d.s_propfilt.pCSCompValue = NULL;
         if (!glblPermitPropertyConfigFilter(loadConf, propfilt)) {
             free(cnfstmt->printable);
@@ -5223,12 +5520,81 @@ static struct cnfexpr *cnfexprOptimize_AND_OR(struct cnfexpr *expr) {
 }
 
 
+/* minimum array size for which a multi-pattern matcher is built; for
+ * smaller arrays, the plain loop is as fast.
+ */
+#define CNFARRAY_MATCHER_MIN 4
+/* minimum array size for which a hash set is built for EQ/NE */
+#define CNFARRAY_HASH_MIN 8
+
+/* build the open-addressing hash set for arr. The table is at most half
+ * full, so probe sequences stay short. On allocation failure, we just keep
+ * using binary search.
+ */
+static void cnfarrayBuildHash(struct cnfarray *const arr) {
+    struct cnfarrayHash *hs;
+    uint32_t size = 16;
+    int i;
+
+    while (size < 2 * (uint32_t)arr->nmemb) size *= 2;
+    if ((hs = malloc(sizeof(struct cnfarrayHash) + sizeof(struct cnfarrayHashSlot) * size)) == NULL) return;
+    hs->mask = size - 1;
+    for (i = 0; i < (int)size; ++i) hs->slots[i].idx = -1;
+    for (i = 0; i < arr->nmemb; ++i) {
+        const uint32_t h = cnfarrayHashStr(es_getBufAddr(arr->arr[i]), es_strlen(arr->arr[i]));
+        uint32_t j = h & hs->mask;
+        /* duplicates are already adjacent after sorting, no need to store them */
+        if (i > 0 && !es_strcmp(arr->arr[i], arr->arr[i - 1])) continue;
+        while (hs->slots[j].idx != -1) j = (j + 1) & hs->mask;
+        hs->slots[j].hash = h;
+        hs->slots[j].idx = i;
+    }
+    arr->hashset = hs;
+}
+
 /* optimize array for EQ/NEQ comparisons. We sort the array in
- * this case so that we can apply binary search later on.
+ * this case so that we can apply binary search later on. For larger
+ * arrays, we additionally build a hash set, so that a lookup needs just
+ * one hash computation and usually a single string compare.
  */
 static inline void cnfexprOptimize_CMPEQ_arr(struct cnfarray *arr) {
     DBGPRINTF("optimizer: sorting array of %d members for CMP_EQ/NEQ comparison\n", arr->nmemb);
     qsort(arr->arr, arr->nmemb, sizeof(es_str_t *), qs_arrcmp);
+    if (arr->hashset == NULL && arr->nmemb >= CNFARRAY_HASH_MIN) cnfarrayBuildHash(arr);
+}
+
+
+/* for contains/startswith/endswith against larger arrays, build a matcher
+ * which checks all elements in a single pass over the string. If this
+ * fails, we simply keep the element-by-element loop.
+ */
+static void cnfexprOptimize_CMPMULTI_arr(struct cnfarray *arr, const unsigned cmpop) {
+    enum acmatchMode mode;
+    int i;
+
+    if (arr->matcher != NULL || arr->nmemb < CNFARRAY_MATCHER_MIN) return;
+    switch (cmpop) {
+        case CMP_STARTSWITH:
+        case CMP_STARTSWITHI:
+            mode = ACMATCH_PREFIX;
+            break;
+        case CMP_ENDSWITH:
+            mode = ACMATCH_SUFFIX;
+            break;
+        default:
+            mode = ACMATCH_CONTAINS;
+            break;
+    }
+    DBGPRINTF("optimizer: building matcher for array of %d members\n", arr->nmemb);
+    if (acmatchConstruct(&arr->matcher, mode, cmpop == CMP_CONTAINSI || cmpop == CMP_STARTSWITHI) != RS_RET_OK)
+        return;
+    for (i = 0; i < arr->nmemb; ++i) {
+        if (acmatchAddPattern(arr->matcher, es_getBufAddr(arr->arr[i]), es_strlen(arr->arr[i])) != RS_RET_OK) {
+            acmatchDestruct(&arr->matcher);
+            return;
+        }
+    }
+    if (acmatchFinalize(arr->matcher) != RS_RET_OK) acmatchDestruct(&arr->matcher);
 }
 
 
@@ -5323,6 +5689,9 @@ struct cnfexpr *cnfexprOptimize(struct cnfexpr *expr) {
         case CMP_STARTSWITHI:
             expr->l = cnfexprOptimize(expr->l);
             expr->r = cnfexprOptimize(expr->r);
+            if (expr->r->nodetype == 'A') {
+                cnfexprOptimize_CMPMULTI_arr((struct cnfarray *)expr->r, expr->nodetype);
+            }
             break;
         case AND:
         case OR:
@@ -5373,6 +5742,175 @@ static void cnfstmtOptimizeForeach(struct cnfstmt *stmt) {
 }
 
 
+/* minimum number of cases for which if/else-if chains and property filters
+ * are turned into a switch; shorter sequences are as fast when evaluated
+ * one after the other.
+ */
+#define CNFSWITCH_MIN_CASES 4
+
+static int propDescrEqual(const msgPropDescr_t *const a, const msgPropDescr_t *const b) {
+    if (a->id != b->id) return 0;
+    if (a->id == PROP_CEE || a->id == PROP_LOCAL_VAR || a->id == PROP_GLOBAL_VAR)
+        return a->nameLen == b->nameLen && !memcmp(a->name, b->name, a->nameLen);
+    return 1;
+}
+
+/* check if expr is a comparison of a message property against constant
+ * strings only, i.e. "$prop == 'a'", "$prop == ['a', 'b']" or an "or" of
+ * such comparisons on the same property. JSON variables are not accepted,
+ * as they may hold non-string values, which are compared differently.
+ * @return the property variable or NULL if the expression does not qualify
+ */
+static struct cnfvar *cnfexprSwitchVar(struct cnfexpr *const expr) {
+    struct cnfvar *var, *var2;
+    struct cnfexpr *val;
+
+    if (expr->nodetype == OR) {
+        if ((var = cnfexprSwitchVar(expr->l)) == NULL || (var2 = cnfexprSwitchVar(expr->r)) == NULL) return NULL;
+        return propDescrEqual(&var->prop, &var2->prop) ? var : NULL;
+    }
+    if (expr->nodetype != CMP_EQ) return NULL;
+    if (expr->l->nodetype == 'V') {
+        var = (struct cnfvar *)expr->l;
+        val = expr->r;
+    } else if (expr->r->nodetype == 'V') {
+        var = (struct cnfvar *)expr->r;
+        val = expr->l;
+    } else {
+        return NULL;
+    }
+    if (val->nodetype != 'S' && val->nodetype != 'A') return NULL;
+    if (var->prop.id == PROP_INVALID || var->prop.id == PROP_CEE || var->prop.id == PROP_LOCAL_VAR ||
+        var->prop.id == PROP_GLOBAL_VAR)
+        return NULL;
+    return var;
+}
+
+/* add the constants of an expression accepted by cnfexprSwitchVar() */
+static rsRetVal cnfexprSwitchAddKeys(struct cnfexpr *const expr,
+                                     struct cnfswitchTable *const tbl,
+                                     const int icase,
+                                     const int bOverride) {
+    struct cnfexpr *val;
+    int i;
+    DEFiRet;
+
+    if (expr->nodetype == OR) {
+        CHKiRet(cnfexprSwitchAddKeys(expr->l, tbl, icase, bOverride));
+        CHKiRet(cnfexprSwitchAddKeys(expr->r, tbl, icase, bOverride));
+        FINALIZE;
+    }
+    val = (expr->l->nodetype == 'V') ? expr->r : expr->l;
+    if (val->nodetype == 'S') {
+        es_str_t *const estr = ((struct cnfstringval *)val)->estr;
+        CHKiRet(cnfswitchTableSet(tbl, es_getBufAddr(estr), es_strlen(estr), icase, bOverride));
+    } else {
+        struct cnfarray *const ar = (struct cnfarray *)val;
+        for (i = 0; i < ar->nmemb; ++i)
+            CHKiRet(cnfswitchTableSet(tbl, es_getBufAddr(ar->arr[i]), es_strlen(ar->arr[i]), icase, bOverride));
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+/* add the then branch of if statement "src" as new case to switch "sw".
+ * If adding the keys fails, the case is left empty, so that all keys
+ * that made it into the table still refer to a valid case.
+ */
+static rsRetVal cnfstmtSwitchAddIf(struct cnfstmt *const sw, struct cnfstmt *const src, const int bOverride) {
+    struct cnfstmt **newCases;
+    int icase;
+    DEFiRet;
+
+    CHKmalloc(newCases = realloc(sw->d.s_switch.cases, sizeof(struct cnfstmt *) * (sw->d.s_switch.nCases + 1)));
+    sw->d.s_switch.cases = newCases;
+    icase = sw->d.s_switch.nCases++;
+    newCases[icase] = NULL;
+    CHKiRet(cnfexprSwitchAddKeys(src->d.s_if.expr, sw->d.s_switch.table, icase, bOverride));
+    newCases[icase] = src->d.s_if.t_then;
+    src->d.s_if.t_then = NULL;
+
+finalize_it:
+    RETiRet;
+}
+
+/* turn a chain of "if $prop == 'a' then ... else if $prop == 'b' then ..."
+ * into a switch, so that the branch is selected by a single hash lookup.
+ * We are called bottom-up, so the else part may already be a switch on the
+ * same property. In that case, we just prepend our case to it. Otherwise,
+ * we convert the whole chain once it is long enough.
+ * Conversion happens in place, as stmt is part of its parent's list.
+ */
+static void cnfstmtOptimizeIfChain(struct cnfstmt *const stmt) {
+    struct cnfstmt *sw = NULL;
+    struct cnfstmt *chain[CNFSWITCH_MIN_CASES];
+    struct cnfstmt *s, *next;
+    struct cnfvar *var, *var2;
+    int n, i;
+    DEFiRet;
+
+    if ((var = cnfexprSwitchVar(stmt->d.s_if.expr)) == NULL) FINALIZE;
+    s = stmt->d.s_if.t_else;
+    if (s != NULL && s->next == NULL && s->nodetype == S_SWITCH && propDescrEqual(&s->d.s_switch.prop, &var->prop)) {
+        /* our condition is checked first, so our keys take precedence */
+        CHKiRet(cnfstmtSwitchAddIf(s, stmt, 1));
+        DBGPRINTF("optimizer: prepending if to SWITCH, now %d cases\n", s->d.s_switch.nCases);
+        next = stmt->next;
+        cnfexprDestruct(stmt->d.s_if.expr);
+        free(stmt->printable);
+        free(s->fn);
+        s->fn = stmt->fn;
+        s->lineno = stmt->lineno;
+        memcpy(stmt, s, sizeof(struct cnfstmt));
+        stmt->next = next;
+        free(s);
+        FINALIZE;
+    }
+
+    chain[0] = stmt;
+    for (n = 1; n < CNFSWITCH_MIN_CASES && s != NULL && s->next == NULL && s->nodetype == S_IF; ++n) {
+        if ((var2 = cnfexprSwitchVar(s->d.s_if.expr)) == NULL || !propDescrEqual(&var->prop, &var2->prop)) break;
+        chain[n] = s;
+        s = s->d.s_if.t_else;
+    }
+    if (n < CNFSWITCH_MIN_CASES) FINALIZE;
+
+    /* build the switch in a new node first, so that we can bail out
+     * without harm if we run out of memory.
+     */
+    CHKmalloc(sw = cnfstmtNew(S_SWITCH));
+    CHKiRet(msgPropDescrFill(&sw->d.s_switch.prop, (uchar *)var->name, strlen(var->name)));
+    CHKmalloc(sw->d.s_switch.table = calloc(1, sizeof(struct cnfswitchTable)));
+    for (i = 0; i < n; ++i) CHKiRet(cnfstmtSwitchAddIf(sw, chain[i], 0));
+    sw->d.s_switch.t_default = chain[n - 1]->d.s_if.t_else;
+    chain[n - 1]->d.s_if.t_else = NULL;
+    DBGPRINTF("optimizer: converting if/else-if chain to SWITCH with %d cases\n", n);
+
+    /* chain[1..] is reachable via stmt's else part */
+    cnfstmtDestructLst(stmt->d.s_if.t_else);
+    cnfexprDestruct(stmt->d.s_if.expr);
+    sw->printable = stmt->printable;
+    free(sw->fn);
+    sw->fn = stmt->fn;
+    sw->lineno = stmt->lineno;
+    sw->next = stmt->next;
+    memcpy(stmt, sw, sizeof(struct cnfstmt));
+    free(sw);
+    sw = NULL;
+
+finalize_it:
+    if (sw != NULL) {
+        /* give back the branches we already moved over */
+        for (i = 0; i < sw->d.s_switch.nCases; ++i) {
+            if (sw->d.s_switch.cases[i] != NULL) chain[i]->d.s_if.t_then = sw->d.s_switch.cases[i];
+        }
+        sw->d.s_switch.nCases = 0;
+        cnfstmtDestruct(sw);
+    }
+    if (iRet != RS_RET_OK) DBGPRINTF("optimizer: could not create SWITCH, error %d\n", iRet);
+}
+
 static void cnfstmtOptimizeIf(struct cnfstmt *stmt) {
     struct cnfstmt *t_then, *t_else;
     struct cnfexpr *expr;
@@ -5413,6 +5951,7 @@ static void cnfstmtOptimizeIf(struct cnfstmt *stmt) {
             cnfstmtOptimizePRIFilt(stmt);
         }
     }
+    if (stmt->nodetype == S_IF) cnfstmtOptimizeIfChain(stmt);
 done:
     return;
 }
@@ -5460,6 +5999,7 @@ static void cnfstmtOptimizePRIFilt(struct cnfstmt *stmt) {
     for (last = subroot; last->next != NULL; last = last->next) /* find last node in subtree */
         ;
     last->next = stmt->next;
+    free(stmt->fn);
     memcpy(stmt, subroot, sizeof(struct cnfstmt));
     free(subroot);
 
@@ -5467,6 +6007,115 @@ done:
     return;
 }
 
+/* check if a statement list may modify the message. Runs of property
+ * filters are executed one after the other, so an action inside one of them
+ * could change the property checked by the next ones. We only merge them
+ * if that cannot happen.
+ */
+static int cnfstmtMayModifyMsg(struct cnfstmt *const root) {
+    struct cnfstmt *stmt;
+    int i;
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        switch (stmt->nodetype) {
+            case S_NOP:
+            case S_STOP:
+                break;
+            case S_ACT:
+                if (stmt->d.act->bUsesMsgPassingMode) return 1;
+                break;
+            case S_PRIFILT:
+                if (cnfstmtMayModifyMsg(stmt->d.s_prifilt.t_then) || cnfstmtMayModifyMsg(stmt->d.s_prifilt.t_else))
+                    return 1;
+                break;
+            case S_PROPFILT:
+                if (cnfstmtMayModifyMsg(stmt->d.s_propfilt.t_then)) return 1;
+                break;
+            case S_SWITCH:
+                for (i = 0; i < stmt->d.s_switch.nCases; ++i) {
+                    if (cnfstmtMayModifyMsg(stmt->d.s_switch.cases[i])) return 1;
+                }
+                if (cnfstmtMayModifyMsg(stmt->d.s_switch.t_default)) return 1;
+                break;
+            default: /* anything else may modify variables or call other rulesets */
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static int cnfstmtPropfiltSwitchable(struct cnfstmt *const stmt) {
+    return stmt->nodetype == S_PROPFILT && stmt->d.s_propfilt.operation == FIOP_ISEQUAL &&
+           !stmt->d.s_propfilt.isNegated && stmt->d.s_propfilt.prop.id != PROP_INVALID &&
+           !cnfstmtMayModifyMsg(stmt->d.s_propfilt.t_then);
+}
+
+/* turn runs of legacy property filters like
+ *     :programname, isequal, "a" ...
+ *     :programname, isequal, "b" ...
+ * into a switch. As opposed to if/else-if, all filters of the run are
+ * checked, so this is only equivalent if the compare values are distinct;
+ * a duplicate ends the run. The first filter becomes the switch, the others
+ * are set to NOP and removed by the caller.
+ */
+static void cnfstmtOptimizePropfiltRuns(struct cnfstmt *const root) {
+    struct cnfstmt *stmt, *s, *end;
+    struct cnfswitchTable *tbl = NULL;
+    struct cnfstmt **cases = NULL;
+    int n, i;
+    DEFiRet;
+
+    for (stmt = root; stmt != NULL; stmt = end) {
+        end = stmt->next;
+        if (!cnfstmtPropfiltSwitchable(stmt)) continue;
+        for (n = 1, s = stmt->next; s != NULL && cnfstmtPropfiltSwitchable(s); s = s->next, ++n) {
+            if (!propDescrEqual(&stmt->d.s_propfilt.prop, &s->d.s_propfilt.prop)) break;
+        }
+        if (n < CNFSWITCH_MIN_CASES) continue;
+
+        CHKmalloc(tbl = calloc(1, sizeof(struct cnfswitchTable)));
+        CHKmalloc(cases = malloc(sizeof(struct cnfstmt *) * n));
+        for (i = 0, s = stmt; i < n; ++i, s = s->next) {
+            cstr_t *const val = s->d.s_propfilt.pCSCompValue;
+            const uint32_t nKeys = tbl->nKeys;
+            CHKiRet(cnfswitchTableSet(tbl, rsCStrGetSzStrNoNULL(val), cstrLen(val), i, 0));
+            if (tbl->nKeys == nKeys) break; /* duplicate value */
+            cases[i] = s->d.s_propfilt.t_then;
+        }
+        end = s;
+        n = i;
+        if (n < CNFSWITCH_MIN_CASES) {
+            cnfswitchTableDestruct(tbl);
+            tbl = NULL;
+            free(cases);
+            cases = NULL;
+            continue;
+        }
+
+        DBGPRINTF("optimizer: converting %d property filters to SWITCH\n", n);
+        for (i = 0, s = stmt; i < n; ++i, s = s->next) {
+            if (s->d.s_propfilt.pCSCompValue != NULL) cstrDestruct(&s->d.s_propfilt.pCSCompValue);
+            if (s != stmt) {
+                msgPropDescrDestruct(&s->d.s_propfilt.prop);
+                s->nodetype = S_NOP;
+            }
+        }
+        /* the property descriptor is moved over, it overlaps with the switch data */
+        memmove(&stmt->d.s_switch.prop, &stmt->d.s_propfilt.prop, sizeof(msgPropDescr_t));
+        stmt->nodetype = S_SWITCH;
+        stmt->d.s_switch.table = tbl;
+        stmt->d.s_switch.cases = cases;
+        stmt->d.s_switch.nCases = n;
+        stmt->d.s_switch.t_default = NULL;
+        tbl = NULL;
+        cases = NULL;
+    }
+
+finalize_it:
+    cnfswitchTableDestruct(tbl);
+    free(cases);
+    if (iRet != RS_RET_OK) DBGPRINTF("optimizer: could not create SWITCH, error %d\n", iRet);
+}
+
 static void cnfstmtOptimizeReloadLookupTable(struct cnfstmt *stmt) {
     if ((stmt->d.s_reload_lookup_table.table = lookupFindTable(stmt->d.s_reload_lookup_table.table_name)) == NULL) {
         parser_errmsg("lookup table '%s' not found\n", stmt->d.s_reload_lookup_table.table_name);
@@ -5541,6 +6190,8 @@ struct cnfstmt *cnfstmtOptimize(struct cnfstmt *root) {
             case S_RELOAD_LOOKUP_TABLE:
                 cnfstmtOptimizeReloadLookupTable(stmt);
                 break;
+            case S_SWITCH: /* created by the optimizer, nothing left to do */
+                break;
             case S_NOP:
                 // TODO: fix optimizer, re-enable. see:
                 // https://github.com/rsyslog/rsyslog/issues/2524
@@ -5554,43 +6205,741 @@ struct cnfstmt *cnfstmtOptimize(struct cnfstmt *root) {
                 break;
         }
     }
+    cnfstmtOptimizePropfiltRuns(root);
     root = removeNOPs(root);
 done:
     return root;
 }
 
-
-struct cnffparamlst *cnffparamlstNew(struct cnfexpr *expr, struct cnffparamlst *next) {
-    struct cnffparamlst *lst;
-    if ((lst = malloc(sizeof(struct cnffparamlst))) != NULL) {
-        lst->nodetype = 'P';
-        lst->expr = expr;
-        lst->next = next;
+/* (recursively) compile the conditions of all if statements into register
+ * programs, see scriptvm.c. Must be called after cnfstmtOptimize(). Called
+ * rulesets are compiled on their own, so we do not follow CALL.
+ */
+void cnfstmtCompile(struct cnfstmt *root) {
+    struct cnfstmt *stmt;
+    int i;
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        switch (stmt->nodetype) {
+            case S_IF:
+                if (stmt->d.s_if.prog == NULL) {
+                    stmt->d.s_if.prog = rsvmCompile(stmt->d.s_if.expr);
+                    if (Debug && stmt->d.s_if.prog != NULL) {
+                        dbgprintf("compiled if condition %p:\n", stmt);
+                        rsvmDebugPrint(stmt->d.s_if.prog, 1);
+                    }
+                }
+                cnfstmtCompile(stmt->d.s_if.t_then);
+                cnfstmtCompile(stmt->d.s_if.t_else);
+                break;
+            case S_FOREACH:
+                cnfstmtCompile(stmt->d.s_foreach.body);
+                break;
+            case S_PRIFILT:
+                cnfstmtCompile(stmt->d.s_prifilt.t_then);
+                cnfstmtCompile(stmt->d.s_prifilt.t_else);
+                break;
+            case S_PROPFILT:
+                cnfstmtCompile(stmt->d.s_propfilt.t_then);
+                break;
+            case S_SWITCH:
+                for (i = 0; i < stmt->d.s_switch.nCases; ++i) cnfstmtCompile(stmt->d.s_switch.cases[i]);
+                cnfstmtCompile(stmt->d.s_switch.t_default);
+                break;
+            default:
+                break;
+        }
     }
-    return lst;
 }
 
-/* Obtain function id from name AND number of params. Issues the
- * relevant error messages if errors are detected.
+
+/* Combined regex automata, see redfa.c. With script.regexEngine="dfa", the
+ * constant regexes of re_match(), re_extract() and regex property filters
+ * are grouped by the property they are applied to, and each group is
+ * compiled into a single automaton. So the first regex evaluated on a value
+ * also computes the result of all other regexes of the group. Regexes that
+ * the automaton does not support, or that are applied to something else
+ * than a plain property, continue to use regexec().
  */
-static rscriptFuncPtr funcName2Ptr(char *const fname, const unsigned short nParams) {
-    struct scriptFunct *foundFunc = searchModList(fname);
-    if (foundFunc == NULL) {
-        parser_errmsg("function '%s' not found", fname);
+struct cnfregroup {
+    struct cnfregroup *next;
+    const msgPropDescr_t *prop; /* owned by the first user of the group */
+    redfa_t *dfa;
+    int idx; /* slot of the per-worker state, see wtiRedfaCache() */
+};
+
+/* add a regex to the group for property prop (created if needed).
+ * @return the group or NULL if the regex must be run via regexec()
+ */
+static struct cnfregroup *cnfregroupAdd(struct cnfregroup **const pRoot,
+                                        const msgPropDescr_t *const prop,
+                                        const uchar *const regex,
+                                        const int flags,
+                                        int *const pId) {
+    struct cnfregroup *grp;
+    rsRetVal localRet;
+
+    for (grp = *pRoot; grp != NULL; grp = grp->next) {
+        if (propDescrEqual(grp->prop, prop)) break;
+    }
+    if (grp == NULL) {
+        if ((grp = calloc(1, sizeof(struct cnfregroup))) == NULL) return NULL;
+        if (redfaConstruct(&grp->dfa) != RS_RET_OK) {
+            free(grp);
+            return NULL;
+        }
+        grp->prop = prop;
+        grp->idx = (*pRoot == NULL) ? 0 : (*pRoot)->idx + 1;
+        grp->next = *pRoot;
+        *pRoot = grp;
+    }
+    if ((localRet = redfaAddPattern(grp->dfa, regex, flags, pId)) != RS_RET_OK) {
+        DBGPRINTF("regex '%s' not combined (%d), using regexec()\n", regex, localRet);
         return NULL;
-    } else {
-        return extractFuncPtr(foundFunc, nParams);
     }
+    return grp;
 }
 
-rsRetVal addMod2List(const int __attribute__((unused)) version, struct scriptFunct *functArray)
-/*version currently not used, might be needed later for versin check*/
-{
+static void cnfexprCombineRegex(struct cnfexpr *const expr, struct cnfregroup **const pRoot) {
+    struct cnffunc *func;
+    unsigned short i;
+
+    if (expr == NULL) return;
+    switch (expr->nodetype) {
+        case CMP_NE:
+        case CMP_EQ:
+        case CMP_LE:
+        case CMP_GE:
+        case CMP_LT:
+        case CMP_GT:
+        case CMP_STARTSWITH:
+        case CMP_ENDSWITH:
+        case CMP_STARTSWITHI:
+        case CMP_CONTAINS:
+        case CMP_CONTAINSI:
+        case OR:
+        case AND:
+        case '&':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            cnfexprCombineRegex(expr->l, pRoot);
+            cnfexprCombineRegex(expr->r, pRoot);
+            break;
+        case NOT:
+        case 'M':
+            cnfexprCombineRegex(expr->r, pRoot);
+            break;
+        case 'F':
+            func = (struct cnffunc *)expr;
+            for (i = 0; i < func->nParams; ++i) cnfexprCombineRegex(func->expr[i], pRoot);
+            if ((func->fPtr == doFunct_ReMatch || func->fPtr == doFunc_re_extract) && func->funcdata != NULL &&
+                func->regroup == NULL && func->expr[0]->nodetype == 'V' && func->expr[1]->nodetype == 'S') {
+                const int bIcase = es_strbufcmp(func->fname, (uchar *)"re_match_i", sizeof("re_match_i") - 1) == 0 ||
+                                   es_strbufcmp(func->fname, (uchar *)"re_extract_i", sizeof("re_extract_i") - 1) == 0;
+                char *const regex = es_str2cstr(((struct cnfstringval *)func->expr[1])->estr, NULL);
+                if (regex != NULL) {
+                    func->regroup = cnfregroupAdd(pRoot, &((struct cnfvar *)func->expr[0])->prop, (uchar *)regex,
+                                                  REDFA_EXTENDED | (bIcase ? REDFA_ICASE : 0), &func->reId);
+                    free(regex);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/* (recursively) add all suitable regexes of a ruleset to the combined
+ * automata in *pRoot. Called rulesets are handled on their own.
+ */
+void cnfstmtCombineRegex(struct cnfstmt *const root, struct cnfregroup **const pRoot) {
+    struct cnfstmt *stmt;
+    int i;
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        switch (stmt->nodetype) {
+            case S_IF:
+                cnfexprCombineRegex(stmt->d.s_if.expr, pRoot);
+                cnfstmtCombineRegex(stmt->d.s_if.t_then, pRoot);
+                cnfstmtCombineRegex(stmt->d.s_if.t_else, pRoot);
+                break;
+            case S_SET:
+                cnfexprCombineRegex(stmt->d.s_set.expr, pRoot);
+                break;
+            case S_CALL_INDIRECT:
+                cnfexprCombineRegex(stmt->d.s_call_ind.expr, pRoot);
+                break;
+            case S_FOREACH:
+                cnfexprCombineRegex(stmt->d.s_foreach.iter->collection, pRoot);
+                cnfstmtCombineRegex(stmt->d.s_foreach.body, pRoot);
+                break;
+            case S_PRIFILT:
+                cnfstmtCombineRegex(stmt->d.s_prifilt.t_then, pRoot);
+                cnfstmtCombineRegex(stmt->d.s_prifilt.t_else, pRoot);
+                break;
+            case S_PROPFILT:
+                if ((stmt->d.s_propfilt.operation == FIOP_REGEX || stmt->d.s_propfilt.operation == FIOP_EREREGEX) &&
+                    stmt->d.s_propfilt.pCSCompValue != NULL && stmt->d.s_propfilt.regroup == NULL) {
+                    const int flags = (stmt->d.s_propfilt.operation == FIOP_EREREGEX) ? REDFA_EXTENDED : 0;
+                    stmt->d.s_propfilt.regroup =
+                        cnfregroupAdd(pRoot, &stmt->d.s_propfilt.prop,
+                                      rsCStrGetSzStrNoNULL(stmt->d.s_propfilt.pCSCompValue), flags,
+                                      &stmt->d.s_propfilt.reId);
+                }
+                cnfstmtCombineRegex(stmt->d.s_propfilt.t_then, pRoot);
+                break;
+            case S_SWITCH:
+                for (i = 0; i < stmt->d.s_switch.nCases; ++i) cnfstmtCombineRegex(stmt->d.s_switch.cases[i], pRoot);
+                cnfstmtCombineRegex(stmt->d.s_switch.t_default, pRoot);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+rsRetVal cnfregroupFinalizeAll(struct cnfregroup *const root) {
+    struct cnfregroup *grp;
+    DEFiRet;
+    for (grp = root; grp != NULL; grp = grp->next) {
+        CHKiRet(redfaFinalize(grp->dfa));
+        DBGPRINTF("combined regex automaton %d: %d regexes\n", grp->idx, redfaNumPatterns(grp->dfa));
+    }
+finalize_it:
+    RETiRet;
+}
+
+void cnfregroupDestructAll(struct cnfregroup *root) {
+    while (root != NULL) {
+        struct cnfregroup *const todel = root;
+        root = root->next;
+        redfaDestruct(&todel->dfa);
+        free(todel);
+    }
+}
+
+/* @return 1 if regex id of group grp matches, 0 if not, -1 if the caller
+ * must use regexec() instead
+ */
+int cnfregroupMatch(
+    struct cnfregroup *const grp, const int id, const uchar *const str, const size_t len, wti_t *const pWti) {
+    redfaCache_t **ppCache;
+    if (pWti == NULL || (ppCache = wtiRedfaCache(pWti, grp->idx)) == NULL) return -1;
+    return redfaMatch(grp->dfa, ppCache, str, len, id);
+}
+
+/* check if the value of expr can only change within the processing of a
+ * message if the message itself is modified, which flushes the function
+ * result cache (see wtiNoteMsgModified()). Global variables are changed
+ * by other workers and system properties like $now change over time.
+ */
+static int cnfexprIsMemoizable(const struct cnfexpr *const expr) {
+    const struct cnffunc *func;
+    const struct cnfvar *var;
+    unsigned short i;
+
+    switch (expr->nodetype) {
+        case 'N':
+        case 'S':
+        case 'A':
+            return 1;
+        case 'V':
+            var = (const struct cnfvar *)expr;
+            return var->prop.id != PROP_GLOBAL_VAR &&
+                   (var->prop.id < PROP_SYS_NOW || var->prop.id > PROP_SYS_NOW_UXTIMESTAMP);
+        case 'F':
+            func = (const struct cnffunc *)expr;
+            if (func->fPtr == NULL || !(func->flags & (SCRIPT_FUNC_PURE | SCRIPT_FUNC_IDEMPOTENT))) return 0;
+            for (i = 0; i < func->nParams; ++i) {
+                if (!cnfexprIsMemoizable(func->expr[i])) return 0;
+            }
+            return 1;
+        case NOT:
+        case 'M':
+            return cnfexprIsMemoizable(expr->r);
+        case CMP_NE:
+        case CMP_EQ:
+        case CMP_LE:
+        case CMP_GE:
+        case CMP_LT:
+        case CMP_GT:
+        case CMP_STARTSWITH:
+        case CMP_ENDSWITH:
+        case CMP_STARTSWITHI:
+        case CMP_CONTAINS:
+        case CMP_CONTAINSI:
+        case OR:
+        case AND:
+        case '&':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            return cnfexprIsMemoizable(expr->l) && cnfexprIsMemoizable(expr->r);
+        default:
+            return 0;
+    }
+}
+
+static inline uint32_t cnfmemoHashStr(const uint32_t h, es_str_t *const estr) {
+    return h * 31 + cnfarrayHashStr(es_getBufAddr(estr), es_strlen(estr));
+}
+
+/* hash of a memoizable expression, consistent with cnfexprMemoEqual() */
+static uint32_t cnfexprMemoHash(const struct cnfexpr *const expr) {
+    const struct cnffunc *func;
+    const struct cnfarray *ar;
+    const struct cnfvar *var;
+    uint32_t h = expr->nodetype;
+    int i;
+
+    switch (expr->nodetype) {
+        case 'N':
+            h = h * 31 + (uint32_t)((const struct cnfnumval *)expr)->val;
+            break;
+        case 'S':
+            h = cnfmemoHashStr(h, ((const struct cnfstringval *)expr)->estr);
+            break;
+        case 'A':
+            ar = (const struct cnfarray *)expr;
+            for (i = 0; i < ar->nmemb; ++i) h = cnfmemoHashStr(h, ar->arr[i]);
+            break;
+        case 'V':
+            var = (const struct cnfvar *)expr;
+            h = h * 31 + var->prop.id;
+            if (var->prop.id == PROP_CEE || var->prop.id == PROP_LOCAL_VAR)
+                h = h * 31 + cnfarrayHashStr(var->prop.name, var->prop.nameLen);
+            break;
+        case 'F':
+            func = (const struct cnffunc *)expr;
+            h = cnfmemoHashStr(h, func->fname);
+            for (i = 0; i < func->nParams; ++i) h = h * 31 + cnfexprMemoHash(func->expr[i]);
+            break;
+        case NOT:
+        case 'M':
+            h = h * 31 + cnfexprMemoHash(expr->r);
+            break;
+        default:
+            h = h * 31 + cnfexprMemoHash(expr->l);
+            h = h * 31 + cnfexprMemoHash(expr->r);
+            break;
+    }
+    return h;
+}
+
+/* check if two memoizable expressions always evaluate to the same value */
+static int cnfexprMemoEqual(const struct cnfexpr *const a, const struct cnfexpr *const b) {
+    const struct cnffunc *fa, *fb;
+    const struct cnfarray *aa, *ab;
+    int i;
+
+    if (a->nodetype != b->nodetype) return 0;
+    switch (a->nodetype) {
+        case 'N':
+            return ((const struct cnfnumval *)a)->val == ((const struct cnfnumval *)b)->val;
+        case 'S':
+            return !es_strcmp(((const struct cnfstringval *)a)->estr, ((const struct cnfstringval *)b)->estr);
+        case 'A':
+            aa = (const struct cnfarray *)a;
+            ab = (const struct cnfarray *)b;
+            if (aa->nmemb != ab->nmemb) return 0;
+            for (i = 0; i < aa->nmemb; ++i) {
+                if (es_strcmp(aa->arr[i], ab->arr[i])) return 0;
+            }
+            return 1;
+        case 'V':
+            return propDescrEqual(&((const struct cnfvar *)a)->prop, &((const struct cnfvar *)b)->prop);
+        case 'F':
+            /* the name is compared as well, e.g. re_match and re_match_i share fPtr */
+            fa = (const struct cnffunc *)a;
+            fb = (const struct cnffunc *)b;
+            if (fa->fPtr != fb->fPtr || fa->nParams != fb->nParams || es_strcmp(fa->fname, fb->fname)) return 0;
+            for (i = 0; i < fa->nParams; ++i) {
+                if (!cnfexprMemoEqual(fa->expr[i], fb->expr[i])) return 0;
+            }
+            return 1;
+        case NOT:
+        case 'M':
+            return cnfexprMemoEqual(a->r, b->r);
+        default:
+            return cnfexprMemoEqual(a->l, b->l) && cnfexprMemoEqual(a->r, b->r);
+    }
+}
+
+static void cnfexprCollectMemoCalls(struct cnfexpr *const expr, struct cnfmemoCalls *const calls) {
+    struct cnffunc *func;
+    struct cnfmemoCall *newCalls;
+    unsigned short i;
+
+    if (expr == NULL) return;
+    switch (expr->nodetype) {
+        case CMP_NE:
+        case CMP_EQ:
+        case CMP_LE:
+        case CMP_GE:
+        case CMP_LT:
+        case CMP_GT:
+        case CMP_STARTSWITH:
+        case CMP_ENDSWITH:
+        case CMP_STARTSWITHI:
+        case CMP_CONTAINS:
+        case CMP_CONTAINSI:
+        case OR:
+        case AND:
+        case '&':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            cnfexprCollectMemoCalls(expr->l, calls);
+            cnfexprCollectMemoCalls(expr->r, calls);
+            break;
+        case NOT:
+        case 'M':
+            cnfexprCollectMemoCalls(expr->r, calls);
+            break;
+        case 'F':
+            func = (struct cnffunc *)expr;
+            for (i = 0; i < func->nParams; ++i) cnfexprCollectMemoCalls(func->expr[i], calls);
+            if (!cnfexprIsMemoizable(expr)) break;
+            if (calls->nCalls == calls->maxCalls) {
+                const int newMax = (calls->maxCalls == 0) ? 64 : calls->maxCalls * 2;
+                if ((newCalls = realloc(calls->calls, sizeof(struct cnfmemoCall) * newMax)) == NULL) {
+                    break; /* this call is simply not memoized */
+                }
+                calls->calls = newCalls;
+                calls->maxCalls = newMax;
+            }
+            calls->calls[calls->nCalls].hash = cnfexprMemoHash(expr);
+            calls->calls[calls->nCalls].func = func;
+            ++calls->nCalls;
+            break;
+        default:
+            break;
+    }
+}
+
+/* (recursively) add all calls of a ruleset whose result can be reused
+ * for the same message to *calls. Called rulesets are handled on their own.
+ */
+void cnfstmtCollectMemoCalls(struct cnfstmt *const root, struct cnfmemoCalls *const calls) {
+    struct cnfstmt *stmt;
+    int i;
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        switch (stmt->nodetype) {
+            case S_IF:
+                cnfexprCollectMemoCalls(stmt->d.s_if.expr, calls);
+                cnfstmtCollectMemoCalls(stmt->d.s_if.t_then, calls);
+                cnfstmtCollectMemoCalls(stmt->d.s_if.t_else, calls);
+                break;
+            case S_SET:
+                cnfexprCollectMemoCalls(stmt->d.s_set.expr, calls);
+                break;
+            case S_CALL_INDIRECT:
+                cnfexprCollectMemoCalls(stmt->d.s_call_ind.expr, calls);
+                break;
+            case S_FOREACH:
+                cnfexprCollectMemoCalls(stmt->d.s_foreach.iter->collection, calls);
+                cnfstmtCollectMemoCalls(stmt->d.s_foreach.body, calls);
+                break;
+            case S_PRIFILT:
+                cnfstmtCollectMemoCalls(stmt->d.s_prifilt.t_then, calls);
+                cnfstmtCollectMemoCalls(stmt->d.s_prifilt.t_else, calls);
+                break;
+            case S_PROPFILT:
+                cnfstmtCollectMemoCalls(stmt->d.s_propfilt.t_then, calls);
+                break;
+            case S_SWITCH:
+                for (i = 0; i < stmt->d.s_switch.nCases; ++i)
+                    cnfstmtCollectMemoCalls(stmt->d.s_switch.cases[i], calls);
+                cnfstmtCollectMemoCalls(stmt->d.s_switch.t_default, calls);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static int cmpMemoCall(const void *a, const void *b) {
+    const uint32_t ha = ((const struct cnfmemoCall *)a)->hash;
+    const uint32_t hb = ((const struct cnfmemoCall *)b)->hash;
+    return (ha < hb) ? -1 : (ha > hb) ? 1 : 0;
+}
+
+/* give each group of identical calls collected by cnfstmtCollectMemoCalls()
+ * a common memo id, so that only the first of them is executed per message.
+ * Calls that occur only once keep memoId -1, caching them would not pay.
+ * The collected calls are freed.
+ * @return number of ids assigned
+ */
+int cnfmemoAssignIds(struct cnfmemoCalls *const calls) {
+    int nIds = 0;
+    int i, j, k;
+
+    qsort(calls->calls, calls->nCalls, sizeof(struct cnfmemoCall), cmpMemoCall);
+    for (i = 0; i < calls->nCalls; i = j) {
+        for (j = i + 1; j < calls->nCalls && calls->calls[j].hash == calls->calls[i].hash; ++j)
+            ;
+        /* calls i..j-1 have the same hash, group them by equality */
+        for (k = i; k < j; ++k) {
+            struct cnffunc *const func = calls->calls[k].func;
+            int id = -1;
+            if (func->memoId != -1) continue;
+            for (int m = k + 1; m < j; ++m) {
+                struct cnffunc *const other = calls->calls[m].func;
+                if (other->memoId == -1 && cnfexprMemoEqual((struct cnfexpr *)func, (struct cnfexpr *)other)) {
+                    if (id == -1) id = nIds++;
+                    other->memoId = id;
+                }
+            }
+            func->memoId = id;
+            if (id != -1) {
+                DBGPRINTF("memoizing calls of %.*s() as id %d\n", (int)es_strlen(func->fname),
+                          (char *)es_getBufAddr(func->fname), id);
+            }
+        }
+    }
+    free(calls->calls);
+    calls->calls = NULL;
+    calls->nCalls = calls->maxCalls = 0;
+    return nIds;
+}
+
+/* check if evaluating expr can not modify the message, that is if it only
+ * calls pure functions
+ */
+static int cnfexprIsReadOnly(const struct cnfexpr *const expr) {
+    const struct cnffunc *func;
+    unsigned short i;
+
+    if (expr == NULL) return 1;
+    switch (expr->nodetype) {
+        case 'N':
+        case 'S':
+        case 'A':
+        case 'V':
+        case S_FUNC_EXISTS:
+            return 1;
+        case 'F':
+            func = (const struct cnffunc *)expr;
+            if (!(func->flags & SCRIPT_FUNC_PURE)) return 0;
+            for (i = 0; i < func->nParams; ++i) {
+                if (!cnfexprIsReadOnly(func->expr[i])) return 0;
+            }
+            return 1;
+        case NOT:
+        case 'M':
+            return cnfexprIsReadOnly(expr->r);
+        case CMP_NE:
+        case CMP_EQ:
+        case CMP_LE:
+        case CMP_GE:
+        case CMP_LT:
+        case CMP_GT:
+        case CMP_STARTSWITH:
+        case CMP_ENDSWITH:
+        case CMP_STARTSWITHI:
+        case CMP_CONTAINS:
+        case CMP_CONTAINSI:
+        case OR:
+        case AND:
+        case '&':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            return cnfexprIsReadOnly(expr->l) && cnfexprIsReadOnly(expr->r);
+        default:
+            return 0;
+    }
+}
+
+/* check if the JSON variables a and b ("$!a!b" style names without the "$")
+ * may overlap, that is if one of them is the other or contains it.
+ */
+static int varPathsOverlap(const char *const a, const char *const b) {
+    const size_t lenA = strlen(a);
+    const size_t lenB = strlen(b);
+    const size_t len = (lenA < lenB) ? lenA : lenB;
+
+    if (a[0] != b[0]) return 0;
+    if (strncasecmp(a, b, len)) return 0;
+    /* "!ab" does not contain "!a", but "!a!b" does */
+    return lenA == lenB || (lenA > len && a[len] == '!') || (lenB > len && b[len] == '!') || len == 1;
+}
+
+/* maximum nesting of called rulesets followed by cnfstmtMayModifyVar() */
+#define FOREACH_MAX_CALL_DEPTH 8
+
+/* check if executing root may modify the JSON variable var or anything
+ * inside it. This is a conservative check: if in doubt, we assume it does.
+ */
+static int cnfstmtMayModifyVar(const struct cnfstmt *const root, const char *const var, const int depth) {
+    const struct cnfstmt *stmt;
+    int i;
+
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        switch (stmt->nodetype) {
+            case S_NOP:
+            case S_STOP:
+            case S_RELOAD_LOOKUP_TABLE:
+                break;
+            case S_SET:
+                if (varPathsOverlap((char *)stmt->d.s_set.varname, var) || !cnfexprIsReadOnly(stmt->d.s_set.expr))
+                    return 1;
+                break;
+            case S_UNSET:
+                if (varPathsOverlap((char *)stmt->d.s_unset.varname, var)) return 1;
+                break;
+            case S_IF:
+                if (!cnfexprIsReadOnly(stmt->d.s_if.expr) || cnfstmtMayModifyVar(stmt->d.s_if.t_then, var, depth) ||
+                    cnfstmtMayModifyVar(stmt->d.s_if.t_else, var, depth))
+                    return 1;
+                break;
+            case S_FOREACH:
+                if (varPathsOverlap(stmt->d.s_foreach.iter->var, var) ||
+                    !cnfexprIsReadOnly(stmt->d.s_foreach.iter->collection) ||
+                    cnfstmtMayModifyVar(stmt->d.s_foreach.body, var, depth))
+                    return 1;
+                break;
+            case S_PRIFILT:
+                if (cnfstmtMayModifyVar(stmt->d.s_prifilt.t_then, var, depth) ||
+                    cnfstmtMayModifyVar(stmt->d.s_prifilt.t_else, var, depth))
+                    return 1;
+                break;
+            case S_PROPFILT:
+                if (cnfstmtMayModifyVar(stmt->d.s_propfilt.t_then, var, depth) ||
+                    cnfstmtMayModifyVar(stmt->d.s_propfilt.t_else, var, depth))
+                    return 1;
+                break;
+            case S_SWITCH:
+                for (i = 0; i < stmt->d.s_switch.nCases; ++i) {
+                    if (cnfstmtMayModifyVar(stmt->d.s_switch.cases[i], var, depth)) return 1;
+                }
+                if (cnfstmtMayModifyVar(stmt->d.s_switch.t_default, var, depth)) return 1;
+                break;
+            case S_CALL:
+                /* a ruleset with a queue works on a copy of the message */
+                if (stmt->d.s_call.ruleset != NULL) break;
+                if (depth >= FOREACH_MAX_CALL_DEPTH || cnfstmtMayModifyVar(stmt->d.s_call.stmt, var, depth + 1))
+                    return 1;
+                break;
+            case S_ACT:
+                if (stmt->d.act->bUsesMsgPassingMode) return 1;
+                break;
+            case S_CALL_INDIRECT:
+            default:
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/* decide for each foreach loop below root if it can iterate over the
+ * collection inside the message instead of a copy of it. This is the case
+ * if the collection is a local or message variable (global variables may
+ * be modified by other threads) and the loop body can neither modify it
+ * nor the loop variable. Must be called after call targets are resolved.
+ */
+void cnfstmtAnalyzeForeach(struct cnfstmt *const root) {
+    struct cnfstmt *stmt;
+    const struct cnfvar *coll;
+    char collName[1024];
+    int i;
+
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        switch (stmt->nodetype) {
+            case S_FOREACH:
+                coll = (const struct cnfvar *)stmt->d.s_foreach.iter->collection;
+                if (coll->nodetype == 'V' && (coll->prop.id == PROP_CEE || coll->prop.id == PROP_LOCAL_VAR) &&
+                    (size_t)coll->prop.nameLen < sizeof(collName)) {
+                    /* prop.name always starts with '!', whatever the root */
+                    memcpy(collName, coll->prop.name, coll->prop.nameLen + 1);
+                    collName[0] = (coll->prop.id == PROP_LOCAL_VAR) ? '.' : '!';
+                    stmt->d.s_foreach.iter->bBorrow =
+                        !varPathsOverlap(stmt->d.s_foreach.iter->var, collName) &&
+                        !cnfstmtMayModifyVar(stmt->d.s_foreach.body, collName, 0) &&
+                        !cnfstmtMayModifyVar(stmt->d.s_foreach.body, stmt->d.s_foreach.iter->var, 0);
+                    DBGPRINTF("foreach over %s %s the collection\n", collName,
+                              stmt->d.s_foreach.iter->bBorrow ? "borrows" : "copies");
+                }
+                cnfstmtAnalyzeForeach(stmt->d.s_foreach.body);
+                break;
+            case S_IF:
+                cnfstmtAnalyzeForeach(stmt->d.s_if.t_then);
+                cnfstmtAnalyzeForeach(stmt->d.s_if.t_else);
+                break;
+            case S_PRIFILT:
+                cnfstmtAnalyzeForeach(stmt->d.s_prifilt.t_then);
+                cnfstmtAnalyzeForeach(stmt->d.s_prifilt.t_else);
+                break;
+            case S_PROPFILT:
+                cnfstmtAnalyzeForeach(stmt->d.s_propfilt.t_then);
+                cnfstmtAnalyzeForeach(stmt->d.s_propfilt.t_else);
+                break;
+            case S_SWITCH:
+                for (i = 0; i < stmt->d.s_switch.nCases; ++i) cnfstmtAnalyzeForeach(stmt->d.s_switch.cases[i]);
+                cnfstmtAnalyzeForeach(stmt->d.s_switch.t_default);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+struct cnffparamlst *cnffparamlstNew(struct cnfexpr *expr, struct cnffparamlst *next) {
+    struct cnffparamlst *lst;
+    if ((lst = malloc(sizeof(struct cnffparamlst))) != NULL) {
+        lst->nodetype = 'P';
+        lst->expr = expr;
+        lst->next = next;
+    }
+    return lst;
+}
+
+/* Obtain function id from name AND number of params. Issues the
+ * relevant error messages if errors are detected.
+ */
+static rscriptFuncPtr funcName2Ptr(char *const fname, const unsigned short nParams) {
+    struct scriptFunct *foundFunc = searchModList(fname);
+    if (foundFunc == NULL) {
+        parser_errmsg("function '%s' not found", fname);
+        return NULL;
+    } else {
+        return extractFuncPtr(foundFunc, nParams);
+    }
+}
+
+rsRetVal addMod2List(const int version, struct scriptFunct *functArray) {
     DEFiRet;
     int i;
     struct modListNode *newNode;
+
+    if (version > SCRIPT_FUNCT_IF_VERSION) {
+        parser_errmsg("function module interface version %d not supported, this rsyslog supports up to %d", version,
+                      SCRIPT_FUNCT_IF_VERSION);
+        ABORT_FINALIZE(RS_RET_MISSING_INTERFACE);
+    }
+    if (version < 2) {
+        /* older modules lack the flags member; their functions are not memoized */
+        const struct scriptFunctV1 *const v1 = (const struct scriptFunctV1 *)functArray;
+        for (i = 0; v1[i].fname != NULL; ++i);
+        CHKmalloc(functArray = calloc(i + 1, sizeof(struct scriptFunct)));
+        for (i = 0; v1[i].fname != NULL; ++i) {
+            functArray[i].fname = v1[i].fname;
+            functArray[i].minParams = v1[i].minParams;
+            functArray[i].maxParams = v1[i].maxParams;
+            functArray[i].fPtr = v1[i].fPtr;
+            functArray[i].initFunc = v1[i].initFunc;
+            functArray[i].destruct = v1[i].destruct;
+        }
+    }
     CHKmalloc(newNode = (struct modListNode *)malloc(sizeof(struct modListNode)));
-    newNode->version = 1;
+    newNode->version = version;
     newNode->next = NULL;
 
     i = 0;
@@ -5625,6 +6974,9 @@ struct cnffunc *cnffuncNew(es_str_t *fname, struct cnffparamlst *paramlst) {
         func->nParams = nParams;
         func->funcdata = NULL;
         func->destructable_funcdata = 1;
+        func->regroup = NULL;
+        func->flags = 0;
+        func->memoId = -1;
         cstr = es_str2cstr(fname, NULL);
         func->fPtr = funcName2Ptr(cstr, nParams);
 
@@ -5643,6 +6995,7 @@ struct cnffunc *cnffuncNew(es_str_t *fname, struct cnffparamlst *paramlst) {
         }
         /* some functions require special initialization */
         struct scriptFunct *foundFunc = searchModList(cstr);
+        if (foundFunc && func->fPtr != NULL) func->flags = foundFunc->flags;
         if (foundFunc && foundFunc->initFunc != NULL) {
             foundFunc->initFunc(func);
         }
@@ -5671,6 +7024,9 @@ struct cnffunc *cnffuncNew_prifilt(int fac) {
         func->nParams = 0;
         func->fPtr = doFunct_Prifilt;
         func->destructable_funcdata = 1;
+        func->regroup = NULL;
+        func->flags = 0;
+        func->memoId = -1;
         ((struct funcData_prifilt *)func->funcdata)->pmask[fac] = TABLE_ALLPRI;
     }
     return func;
@@ -5972,7 +7328,7 @@ char *rmLeadingSpace(char *s) {
 rsRetVal initRainerscript(void) {
     DEFiRet;
     CHKmalloc(modListRoot = (struct modListNode *)malloc(sizeof(struct modListNode)));
-    modListRoot->version = 1;
+    modListRoot->version = SCRIPT_FUNCT_IF_VERSION;
     modListRoot->modFcts = functions;
     modListRoot->next = NULL;
     modListLast = modListRoot;
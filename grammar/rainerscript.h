@@ -122,6 +122,7 @@ struct nvlst {
 #define S_RELOAD_LOOKUP_TABLE 4010
 #define S_CALL_INDIRECT 4011
 #define S_FUNC_EXISTS 4012 /* special case function which must get varname only */
+#define S_SWITCH 4013 /* created by optimizer from if/else-if chains and property filters */
 
 enum cnfFiltType { CNFFILT_NONE, CNFFILT_PRI, CNFFILT_PROP, CNFFILT_SCRIPT };
 const char *cnfFiltType2str(const enum cnfFiltType filttype);
@@ -131,11 +132,15 @@ struct cnfstmt {
     unsigned nodetype;
     struct cnfstmt *next;
     uchar *printable; /* printable text for debugging */
+    char *fn; /* config file the statement is defined in */
+    int lineno; /* ... and the line it starts on */
+    struct scriptprof_s *prof; /* execution profile, NULL if not profiling */
     union {
         struct {
             struct cnfexpr *expr;
             struct cnfstmt *t_then;
             struct cnfstmt *t_else;
+            struct rsvmProg *prog; /* compiled condition, NULL if interpreted */
         } s_if;
         struct {
             uchar *varname;
@@ -161,6 +166,8 @@ struct cnfstmt {
         struct {
             fiop_t operation;
             regex_t *regex_cache; /* cache for compiled REs, if used */
+            struct cnfregroup *regroup; /* combined regex automaton, if any */
+            int reId; /* id of the regex inside regroup */
             struct cstr_s *pCSCompValue; /* value to "compare" against */
             sbool isNegated;
             msgPropDescr_t prop; /* requested property */
@@ -177,6 +184,13 @@ struct cnfstmt {
             uchar *table_name;
             uchar *stub_value;
         } s_reload_lookup_table;
+        struct {
+            msgPropDescr_t prop; /* property all cases compare against */
+            struct cnfswitchTable *table; /* maps property value to case index */
+            struct cnfstmt **cases; /* statements per case, entries may be NULL */
+            int nCases;
+            struct cnfstmt *t_default; /* executed if no case matches */
+        } s_switch;
     } d;
 };
 
@@ -189,6 +203,7 @@ struct cnfexpr {
 struct cnfitr {
     char *var;
     struct cnfexpr *collection;
+    sbool bBorrow; /* iterate over the collection in place, see cnfstmtAnalyzeForeach() */
 } __attribute__((aligned(8)));
 
 struct cnfnumval {
@@ -211,6 +226,8 @@ struct cnfarray {
     unsigned nodetype;
     int nmemb;
     es_str_t **arr;
+    struct acmatch_s *matcher; /* for contains/startswith/endswith, built by optimizer */
+    struct cnfarrayHash *hashset; /* for ==/!=, built by optimizer */
 } __attribute__((aligned(8)));
 
 struct cnffparamlst {
@@ -265,6 +282,10 @@ struct cnffunc {
     rscriptFuncPtr fPtr;
     void *funcdata; /* global data for function-specific use (e.g. compiled regex) */
     uint8_t destructable_funcdata;
+    struct cnfregroup *regroup; /* combined regex automaton the regex is part of, if any */
+    int reId; /* id of the regex inside regroup */
+    unsigned flags; /* SCRIPT_FUNC_* of the called function */
+    int memoId; /* id of the per-message result cache slot, -1 if the result is not cached */
     struct cnfexpr *expr[];
 } __attribute__((aligned(8)));
 
@@ -282,10 +303,30 @@ struct scriptFunct {
     rscriptFuncPtr fPtr;
     rsRetVal (*initFunc)(struct cnffunc *);
     void (*destruct)(struct cnffunc *);
-    /* currently no optimizer entrypoint, may be added later.
-     * Since the optimizer needs metadata about functions, it does
-     * not seem practical to add such a function at the current state
-     */
+    unsigned flags; /* SCRIPT_FUNC_* metadata for the optimizer, 0 if nothing is known */
+};
+
+/* version of the function module interface, see getFunctArray(). Version 2
+ * added scriptFunct.flags; tables of version 1 modules are converted on load.
+ */
+#define SCRIPT_FUNCT_IF_VERSION 2
+
+/* function flags for struct scriptFunct. A call is only memoized if the
+ * function is either pure or idempotent.
+ */
+#define SCRIPT_FUNC_PURE 0x01 /* result depends only on the params and the message */
+#define SCRIPT_FUNC_IDEMPOTENT 0x02 /* modifies the message, but repeating the call has no further effect */
+#define SCRIPT_FUNC_ERRNO 0x04 /* sets script_error(), which must be restored for a memoized result */
+
+/* calls collected by cnfstmtCollectMemoCalls() */
+struct cnfmemoCall {
+    uint32_t hash; /* over function and params, equal calls have equal hashes */
+    struct cnffunc *func;
+};
+struct cnfmemoCalls {
+    struct cnfmemoCall *calls;
+    int nCalls;
+    int maxCalls;
 };
 
 
@@ -411,6 +452,7 @@ int cnfparamvalsIsSet(struct cnfparamblk *params, struct cnfparamvals *vals);
 void varDelete(const struct svar *v);
 void cnfparamvalsDestruct(const struct cnfparamvals *paramvals, const struct cnfparamblk *blk);
 struct cnfstmt *cnfstmtNew(unsigned s_type);
+void cnfstmtSetLine(struct cnfstmt *stmt, int lineno);
 struct cnfitr *cnfNewIterator(char *var, struct cnfexpr *collection);
 void cnfstmtPrintOnly(struct cnfstmt *stmt, int indent, sbool subtree);
 void cnfstmtPrint(struct cnfstmt *stmt, int indent);
@@ -428,10 +470,20 @@ struct cnfstmt *cnfstmtNewContinue(void);
 struct cnfstmt *cnfstmtNewReloadLookupTable(struct cnffparamlst *fparams);
 void cnfstmtDestructLst(struct cnfstmt *root);
 struct cnfstmt *cnfstmtOptimize(struct cnfstmt *root);
+void cnfstmtCompile(struct cnfstmt *root);
 struct cnfarray *cnfarrayNew(es_str_t *val);
 struct cnfarray *cnfarrayDup(struct cnfarray *old);
 struct cnfarray *cnfarrayAdd(struct cnfarray *ar, es_str_t *val);
 void cnfarrayContentDestruct(struct cnfarray *ar);
+int cnfarrayFind(const struct cnfarray *ar, const uchar *str, size_t len);
+int cnfstmtSwitchFind(const struct cnfstmt *stmt, const uchar *val, size_t len);
+void cnfstmtCombineRegex(struct cnfstmt *root, struct cnfregroup **pRoot);
+rsRetVal cnfregroupFinalizeAll(struct cnfregroup *root);
+void cnfregroupDestructAll(struct cnfregroup *root);
+int cnfregroupMatch(struct cnfregroup *grp, int id, const uchar *str, size_t len, wti_t *pWti);
+void cnfstmtCollectMemoCalls(struct cnfstmt *root, struct cnfmemoCalls *calls);
+int cnfmemoAssignIds(struct cnfmemoCalls *calls);
+void cnfstmtAnalyzeForeach(struct cnfstmt *root);
 const char *getFIOPName(unsigned iFIOP);
 rsRetVal initRainerscript(void);
 void unescapeStr(uchar *s, int len);
@@ -0,0 +1,883 @@
+/* scriptvm.c - register based evaluation of RainerScript conditions
+ *
+ * The tree interpreter (cnfexprEval) evaluates each node into a struct svar
+ * and, for string values, duplicates them into freshly allocated es_str_t
+ * objects. For the typical routing condition, e.g.
+ *     if $programname == "sshd" and $msg contains "Failed" then ...
+ * this means several malloc/free pairs per message and condition. Here, such
+ * conditions are compiled into a flat instruction sequence working on a
+ * small register file. String registers are views into constants or into
+ * the message itself, so no allocation is needed. The common string
+ * functions (field(), tolower(), ltrim(), ...) and concatenation work on
+ * such views, too; where they need to build a new string, it is placed in
+ * the worker's scratch arena. Nodes which cannot be
+ * handled natively are handed back to cnfexprEval() from inside the program,
+ * which keeps the semantics identical to the interpreter.
+ *
+ * Module begun 2026-10-18 by Rainer Gerhards
+ *
+ * Copyright 2026 Rainer Gerhards and Others.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * The rsyslog runtime library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The rsyslog runtime library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the rsyslog runtime library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * A copy of the GPL can be found in the file "COPYING" in this distribution.
+ * A copy of the LGPL can be found in the file "COPYING.LESSER" in this distribution.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <libestr.h>
+
+#include "rsyslog.h"
+#include "rainerscript.h"
+#include "scriptvm.h"
+#include "grammar.h"
+#include "msg.h"
+#include "debug.h"
+#include "acmatch.h"
+#include "wti.h"
+
+/* instruction set */
+enum rsvmOp {
+    RSVM_LOADN, /* dst = imm.n */
+    RSVM_LOADS, /* dst = string constant imm.p (es_str_t) */
+    RSVM_LOADPROP, /* dst = message property imm.p (msgPropDescr_t) */
+    RSVM_EVALNUM, /* dst = var2Number(cnfexprEval(imm.p)) */
+    RSVM_CMP, /* dst = a <aux> b, aux is the grammar token of the comparison */
+    RSVM_CMPARR, /* dst = a <aux> array imm.p */
+    RSVM_ARITH, /* dst = a <aux> b, aux is one of + - * / % */
+    RSVM_NEG, /* dst = -a */
+    RSVM_NOT, /* dst = !a */
+    RSVM_TRUTH, /* dst = a ? 1 : 0 */
+    RSVM_ANDJ, /* if !a: a = 0, goto aux */
+    RSVM_ORJ, /* if a: a = 1, goto aux */
+    RSVM_CONCAT, /* dst = a & b */
+    RSVM_CALL, /* dst = native function imm.p (rsvmFunc_t) of registers a .. a+b-1, dst == a */
+    RSVM_RET /* return a */
+};
+
+static const char *const opNames[] = {"loadn", "loads", "loadprop", "evalnum", "cmp",    "cmparr", "arith", "neg",
+                                      "not",   "truth", "andj",     "orj",     "concat", "call",   "ret"};
+
+typedef struct rsvmInsn_s {
+    uint8_t op;
+    uint8_t dst;
+    uint8_t a;
+    uint8_t b;
+    int aux;
+    union {
+        long long n;
+        const void *p;
+    } imm;
+} rsvmInsn_t;
+
+struct rsvmProg {
+    int nInsns;
+    int nRegs;
+    rsvmInsn_t insns[];
+};
+
+/* A register is either a number (str == NULL) or a string view. If the
+ * view points to memory we own, toFree is set.
+ */
+typedef struct rsvmReg_s {
+    const uchar *str;
+    uchar *toFree;
+    rs_size_t len;
+    long long n;
+} rsvmReg_t;
+
+/* compiler state */
+typedef struct rsvmCompiler_s {
+    rsvmInsn_t *insns;
+    int nInsns;
+    int maxInsns;
+    int nRegs;
+} rsvmCompiler_t;
+
+enum rsvmType { RSVM_T_ERR = -1, RSVM_T_NUM = 0, RSVM_T_STR = 1 };
+
+/* native implementation of a RainerScript function, see nativeFuncs[] */
+typedef struct rsvmFunc_s {
+    const char *name;
+    unsigned short nParams;
+    enum rsvmType type; /* type of the result */
+    void (*fn)(rsvmReg_t *args, wti_t *pWti); /* stores the result in args[0] */
+} rsvmFunc_t;
+
+static const rsvmFunc_t *findNativeFunc(const struct cnffunc *func);
+
+
+/* ---------------------------------------------------------------------- *
+ * compiler                                                               *
+ * ---------------------------------------------------------------------- */
+
+static int isCmpOp(const unsigned nodetype) {
+    switch (nodetype) {
+        case CMP_EQ:
+        case CMP_NE:
+        case CMP_LE:
+        case CMP_GE:
+        case CMP_LT:
+        case CMP_GT:
+        case CMP_STARTSWITH:
+        case CMP_STARTSWITHI:
+        case CMP_ENDSWITH:
+        case CMP_CONTAINS:
+        case CMP_CONTAINSI:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int isMsgVar(const struct cnfexpr *const expr) {
+    const struct cnfvar *const var = (const struct cnfvar *)expr;
+    return var->prop.id != PROP_CEE && var->prop.id != PROP_LOCAL_VAR && var->prop.id != PROP_GLOBAL_VAR;
+}
+
+/* can the value of expr be computed natively, with the exact type
+ * the interpreter would produce?
+ */
+static int isNative(const struct cnfexpr *const expr) {
+    const struct cnffunc *func;
+    unsigned short i;
+
+    switch (expr->nodetype) {
+        case 'N':
+        case 'S':
+        case 'A':
+        case AND:
+        case OR:
+        case NOT:
+        case 'M':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            return 1;
+        case 'V':
+            return isMsgVar(expr);
+        case '&':
+            return isNative(expr->l) && isNative(expr->r);
+        case 'F':
+            func = (const struct cnffunc *)expr;
+            if (findNativeFunc(func) == NULL) return 0;
+            /* cnum() of a string constant uses a different conversion */
+            if (func->fPtr != NULL && !es_strbufcmp(func->fname, (uchar *)"cnum", sizeof("cnum") - 1) &&
+                (func->expr[0]->nodetype == 'S' || func->expr[0]->nodetype == 'A'))
+                return 0;
+            for (i = 0; i < func->nParams; ++i) {
+                if (!isNative(func->expr[i])) return 0;
+            }
+            return 1;
+        default:
+            if (isCmpOp(expr->nodetype)) return isNative(expr->l) && isNative(expr->r);
+            return 0;
+    }
+}
+
+static int emit(rsvmCompiler_t *const cs, const uint8_t op, const int dst, const int a, const int b) {
+    rsvmInsn_t *newInsns;
+    if (cs->nInsns == cs->maxInsns) {
+        const int newMax = (cs->maxInsns == 0) ? 16 : cs->maxInsns * 2;
+        if ((newInsns = realloc(cs->insns, sizeof(rsvmInsn_t) * newMax)) == NULL) return -1;
+        cs->insns = newInsns;
+        cs->maxInsns = newMax;
+    }
+    memset(&cs->insns[cs->nInsns], 0, sizeof(rsvmInsn_t));
+    cs->insns[cs->nInsns].op = op;
+    cs->insns[cs->nInsns].dst = (uint8_t)dst;
+    cs->insns[cs->nInsns].a = (uint8_t)a;
+    cs->insns[cs->nInsns].b = (uint8_t)b;
+    return cs->nInsns++;
+}
+
+static int compileExpr(rsvmCompiler_t *cs, const struct cnfexpr *expr, int dst);
+
+/* compile an operand whose value is only used as a number */
+static int compileNum(rsvmCompiler_t *const cs, const struct cnfexpr *const expr, const int dst) {
+    int i;
+    if (isNative(expr)) return compileExpr(cs, expr, dst) == RSVM_T_ERR ? -1 : 0;
+    if ((i = emit(cs, RSVM_EVALNUM, dst, 0, 0)) < 0) return -1;
+    cs->insns[i].imm.p = expr;
+    return 0;
+}
+
+static int compileLogic(rsvmCompiler_t *const cs, const struct cnfexpr *const expr, const int dst) {
+    int jmp;
+    if (compileNum(cs, expr->l, dst) != 0) return RSVM_T_ERR;
+    if ((jmp = emit(cs, (expr->nodetype == AND) ? RSVM_ANDJ : RSVM_ORJ, 0, dst, 0)) < 0) return RSVM_T_ERR;
+    if (compileNum(cs, expr->r, dst + 1) != 0) return RSVM_T_ERR;
+    if (emit(cs, RSVM_TRUTH, dst, dst + 1, 0) < 0) return RSVM_T_ERR;
+    cs->insns[jmp].aux = cs->nInsns;
+    return RSVM_T_NUM;
+}
+
+static int compileCmp(rsvmCompiler_t *const cs, const struct cnfexpr *const expr, const int dst) {
+    int i;
+    const int typeL = compileExpr(cs, expr->l, dst);
+    if (typeL == RSVM_T_ERR) return RSVM_T_ERR;
+    /* array semantics as in cnfexprEval(): EQ and NE only search the array
+     * for string operands, the other operators always do.
+     */
+    if (expr->r->nodetype == 'A' && expr->nodetype != CMP_LE && expr->nodetype != CMP_GE &&
+        expr->nodetype != CMP_LT && expr->nodetype != CMP_GT &&
+        (typeL == RSVM_T_STR || (expr->nodetype != CMP_EQ && expr->nodetype != CMP_NE))) {
+        if ((i = emit(cs, RSVM_CMPARR, dst, dst, 0)) < 0) return RSVM_T_ERR;
+        cs->insns[i].aux = (int)expr->nodetype;
+        cs->insns[i].imm.p = expr->r;
+        return RSVM_T_NUM;
+    }
+    if (compileExpr(cs, expr->r, dst + 1) == RSVM_T_ERR) return RSVM_T_ERR;
+    if ((i = emit(cs, RSVM_CMP, dst, dst, dst + 1)) < 0) return RSVM_T_ERR;
+    cs->insns[i].aux = (int)expr->nodetype;
+    return RSVM_T_NUM;
+}
+
+/* compile expr so that its value ends up in register dst. Registers
+ * above dst may be used as temporaries. Returns the static type of the
+ * value or RSVM_T_ERR.
+ */
+static int compileExpr(rsvmCompiler_t *const cs, const struct cnfexpr *const expr, const int dst) {
+    const struct cnffunc *func;
+    const rsvmFunc_t *nf;
+    int i;
+
+    if (dst + 1 >= RSVM_MAX_REGS) return RSVM_T_ERR;
+    if (dst + 2 > cs->nRegs) cs->nRegs = dst + 2;
+
+    switch (expr->nodetype) {
+        case 'N':
+            if ((i = emit(cs, RSVM_LOADN, dst, 0, 0)) < 0) return RSVM_T_ERR;
+            cs->insns[i].imm.n = ((const struct cnfnumval *)expr)->val;
+            return RSVM_T_NUM;
+        case 'S':
+            if ((i = emit(cs, RSVM_LOADS, dst, 0, 0)) < 0) return RSVM_T_ERR;
+            cs->insns[i].imm.p = ((const struct cnfstringval *)expr)->estr;
+            return RSVM_T_STR;
+        case 'A':
+            /* in regular operations, an array evaluates to its first element */
+            if ((i = emit(cs, RSVM_LOADS, dst, 0, 0)) < 0) return RSVM_T_ERR;
+            cs->insns[i].imm.p = ((const struct cnfarray *)expr)->arr[0];
+            return RSVM_T_STR;
+        case 'V':
+            if (!isMsgVar(expr)) break;
+            if ((i = emit(cs, RSVM_LOADPROP, dst, 0, 0)) < 0) return RSVM_T_ERR;
+            cs->insns[i].imm.p = &((const struct cnfvar *)expr)->prop;
+            return RSVM_T_STR;
+        case AND:
+        case OR:
+            return compileLogic(cs, expr, dst);
+        case NOT:
+        case 'M':
+            if (compileNum(cs, expr->r, dst) != 0) return RSVM_T_ERR;
+            if (emit(cs, (expr->nodetype == NOT) ? RSVM_NOT : RSVM_NEG, dst, dst, 0) < 0) return RSVM_T_ERR;
+            return RSVM_T_NUM;
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            if (compileNum(cs, expr->l, dst) != 0 || compileNum(cs, expr->r, dst + 1) != 0) return RSVM_T_ERR;
+            if ((i = emit(cs, RSVM_ARITH, dst, dst, dst + 1)) < 0) return RSVM_T_ERR;
+            cs->insns[i].aux = (int)expr->nodetype;
+            return RSVM_T_NUM;
+        case '&':
+            if (!isNative(expr)) break;
+            if (compileExpr(cs, expr->l, dst) == RSVM_T_ERR || compileExpr(cs, expr->r, dst + 1) == RSVM_T_ERR)
+                return RSVM_T_ERR;
+            if (emit(cs, RSVM_CONCAT, dst, dst, dst + 1) < 0) return RSVM_T_ERR;
+            return RSVM_T_STR;
+        case 'F':
+            if (!isNative(expr)) break;
+            func = (const struct cnffunc *)expr;
+            nf = findNativeFunc(func);
+            /* params go to consecutive registers, each one may use the ones above it */
+            for (i = 0; i < func->nParams; ++i) {
+                if (compileExpr(cs, func->expr[i], dst + i) == RSVM_T_ERR) return RSVM_T_ERR;
+            }
+            if ((i = emit(cs, RSVM_CALL, dst, dst, func->nParams)) < 0) return RSVM_T_ERR;
+            cs->insns[i].imm.p = nf;
+            return nf->type;
+        default:
+            if (isCmpOp(expr->nodetype) && isNative(expr)) return compileCmp(cs, expr, dst);
+            break;
+    }
+
+    /* everything else is left to the interpreter. Note that this is only
+     * reached for nodes which always yield a number or whose value is only
+     * used as number by the caller.
+     */
+    return (compileNum(cs, expr, dst) == 0) ? RSVM_T_NUM : RSVM_T_ERR;
+}
+
+struct rsvmProg *rsvmCompile(struct cnfexpr *const expr) {
+    rsvmCompiler_t cs;
+    struct rsvmProg *prog = NULL;
+
+    memset(&cs, 0, sizeof(cs));
+    if (!isNative(expr)) {
+        /* would just be a single call into the interpreter */
+        goto done;
+    }
+    if (compileExpr(&cs, expr, 0) == RSVM_T_ERR) goto done;
+    if (emit(&cs, RSVM_RET, 0, 0, 0) < 0) goto done;
+
+    if ((prog = malloc(sizeof(struct rsvmProg) + sizeof(rsvmInsn_t) * cs.nInsns)) == NULL) goto done;
+    prog->nInsns = cs.nInsns;
+    prog->nRegs = cs.nRegs;
+    memcpy(prog->insns, cs.insns, sizeof(rsvmInsn_t) * cs.nInsns);
+
+done:
+    free(cs.insns);
+    return prog;
+}
+
+void rsvmDestruct(struct rsvmProg *const prog) {
+    free(prog);
+}
+
+void rsvmDebugPrint(const struct rsvmProg *const prog, const int indent) {
+    int i;
+    if (prog == NULL) return;
+    for (i = 0; i < prog->nInsns; ++i) {
+        const rsvmInsn_t *const insn = &prog->insns[i];
+        dbgprintf("%*s%3d: %-8s r%d, r%d, r%d aux %d\n", indent * 2, "", i, opNames[insn->op], insn->dst, insn->a,
+                  insn->b, insn->aux);
+    }
+}
+
+
+/* ---------------------------------------------------------------------- *
+ * virtual machine                                                        *
+ * ---------------------------------------------------------------------- */
+
+static void setNum(rsvmReg_t *const r, const long long n) {
+    free(r->toFree);
+    r->toFree = NULL;
+    r->str = NULL;
+    r->n = n;
+}
+
+static void setStr(rsvmReg_t *const r, const uchar *const str, const rs_size_t len, uchar *const toFree) {
+    free(r->toFree);
+    r->toFree = toFree;
+    r->str = str;
+    r->len = len;
+}
+
+/* same as str2num() in rainerscript.c, but on a view */
+static long long viewToNum(const uchar *const c, const rs_size_t len, int *const bSuccess) {
+    rs_size_t i;
+    int neg;
+    long long num = 0;
+
+    if (len == 0) {
+        *bSuccess = 1;
+        return 0;
+    }
+    if (c[0] == '-') {
+        neg = -1;
+        i = 1;
+    } else {
+        neg = 1;
+        i = 0;
+    }
+    while (i < len && isdigit(c[i])) {
+        num = num * 10 + c[i] - '0';
+        ++i;
+    }
+    *bSuccess = (i == len) ? 1 : 0;
+    return num * neg;
+}
+
+/* equivalent of var2Number() */
+static long long regToNum(const rsvmReg_t *const r, int *const bSuccess) {
+    if (r->str != NULL) return viewToNum(r->str, r->len, bSuccess);
+    *bSuccess = 1;
+    return r->n;
+}
+
+/* equivalent of var2String(); numbers are formatted into buf */
+static const uchar *regToStr(const rsvmReg_t *const r, char *const buf, const size_t lenBuf, rs_size_t *const pLen) {
+    if (r->str != NULL) {
+        *pLen = r->len;
+        return r->str;
+    }
+    *pLen = (rs_size_t)snprintf(buf, lenBuf, "%lld", r->n);
+    return (const uchar *)buf;
+}
+
+int rsvmStrCmp(const uchar *const s1, const rs_size_t len1, const uchar *const s2, const rs_size_t len2) {
+    rs_size_t i;
+    for (i = 0; i < len1; ++i) {
+        if (i == len2) return 1;
+        if (s1[i] != s2[i]) return s1[i] - s2[i];
+    }
+    return (i < len2) ? -1 : 0;
+}
+
+static int viewStartsWith(const uchar *s, rs_size_t len, const uchar *prefix, rs_size_t lenPrefix, int bCaseless) {
+    rs_size_t i;
+    if (len < lenPrefix) return 0;
+    if (!bCaseless) return memcmp(s, prefix, lenPrefix) == 0;
+    for (i = 0; i < lenPrefix; ++i) {
+        if (tolower(s[i]) != tolower(prefix[i])) return 0;
+    }
+    return 1;
+}
+
+static int viewEndsWith(const uchar *s, rs_size_t len, const uchar *suffix, rs_size_t lenSuffix) {
+    return len >= lenSuffix && memcmp(s + len - lenSuffix, suffix, lenSuffix) == 0;
+}
+
+static int viewContains(const uchar *s, rs_size_t len, const uchar *needle, rs_size_t lenNeedle, int bCaseless) {
+    rs_size_t i;
+    if (lenNeedle > len) return 0;
+    for (i = 0; i + lenNeedle <= len; ++i) {
+        if (viewStartsWith(s + i, lenNeedle, needle, lenNeedle, bCaseless)) return 1;
+    }
+    return 0;
+}
+
+/* equivalent of evalStrArrayCmp() */
+static int cmpArray(const uchar *const s, const rs_size_t len, const struct cnfarray *const ar, const int cmpop) {
+    int i;
+    if (cmpop == CMP_EQ || cmpop == CMP_NE) {
+        /* hash set or binary search on the sorted array, see optimizer */
+        const int found = cnfarrayFind(ar, s, (size_t)len);
+        return (cmpop == CMP_EQ) ? found : !found;
+    }
+    if (ar->matcher != NULL) return acmatchMatch(ar->matcher, s, (size_t)len);
+    for (i = 0; i < ar->nmemb; ++i) {
+        const uchar *const elt = es_getBufAddr(ar->arr[i]);
+        const rs_size_t lenElt = es_strlen(ar->arr[i]);
+        int r;
+        switch (cmpop) {
+            case CMP_STARTSWITH:
+            case CMP_STARTSWITHI:
+                r = viewStartsWith(s, len, elt, lenElt, cmpop == CMP_STARTSWITHI);
+                break;
+            case CMP_ENDSWITH:
+                r = viewEndsWith(s, len, elt, lenElt);
+                break;
+            case CMP_CONTAINS:
+            case CMP_CONTAINSI:
+                r = viewContains(s, len, elt, lenElt, cmpop == CMP_CONTAINSI);
+                break;
+            default:
+                r = 0;
+                break;
+        }
+        if (r) return 1;
+    }
+    return 0;
+}
+
+/* EQ and NE as implemented by cnfexprEval(). Note that NE returns the
+ * raw es_strcmp() value for strings, which we need to preserve.
+ */
+static long long cmpEqNe(const rsvmReg_t *const l, const rsvmReg_t *const r, const int bEq) {
+    char numbuf[32];
+    rs_size_t lenNum;
+    const uchar *num;
+    long long n;
+    int convok;
+    int c;
+
+    if (l->str != NULL && r->str != NULL) {
+        c = rsvmStrCmp(l->str, l->len, r->str, r->len);
+        return bEq ? !c : c;
+    }
+    if (l->str != NULL) {
+        n = viewToNum(l->str, l->len, &convok);
+        if (convok) return bEq ? (n == r->n) : (n != r->n);
+        num = regToStr(r, numbuf, sizeof(numbuf), &lenNum);
+        c = rsvmStrCmp(l->str, l->len, num, lenNum);
+        return bEq ? !c : c;
+    }
+    if (r->str != NULL) {
+        n = viewToNum(r->str, r->len, &convok);
+        if (convok) return bEq ? (l->n == n) : (l->n != n);
+        num = regToStr(l, numbuf, sizeof(numbuf), &lenNum);
+        c = rsvmStrCmp(r->str, r->len, num, lenNum);
+        return bEq ? !c : c;
+    }
+    return bEq ? (l->n == r->n) : (l->n != r->n);
+}
+
+/* equivalent of eval_strcmp_like() */
+static int cmpOrder(const rsvmReg_t *const l, const rsvmReg_t *const r) {
+    char bufL[32], bufR[32];
+    rs_size_t lenL, lenR;
+    const uchar *sL, *sR;
+    int convok_l, convok_r = 0;
+    const long long n_l = regToNum(l, &convok_l);
+    long long n_r = 0;
+
+    if (convok_l) n_r = regToNum(r, &convok_r);
+    if (convok_l && convok_r) return (int)(n_l - n_r);
+    sL = regToStr(l, bufL, sizeof(bufL), &lenL);
+    sR = regToStr(r, bufR, sizeof(bufR), &lenR);
+    return rsvmStrCmp(sL, lenL, sR, lenR);
+}
+
+static long long cmpRegs(const rsvmReg_t *const l, const rsvmReg_t *const r, const int cmpop) {
+    char bufL[32], bufR[32];
+    rs_size_t lenL, lenR;
+    const uchar *sL, *sR;
+
+    switch (cmpop) {
+        case CMP_EQ:
+            return cmpEqNe(l, r, 1);
+        case CMP_NE:
+            return cmpEqNe(l, r, 0);
+        case CMP_LE:
+            return cmpOrder(l, r) <= 0;
+        case CMP_GE:
+            return cmpOrder(l, r) >= 0;
+        case CMP_LT:
+            return cmpOrder(l, r) < 0;
+        case CMP_GT:
+            return cmpOrder(l, r) > 0;
+        default:
+            break;
+    }
+    sL = regToStr(l, bufL, sizeof(bufL), &lenL);
+    sR = regToStr(r, bufR, sizeof(bufR), &lenR);
+    switch (cmpop) {
+        case CMP_STARTSWITH:
+        case CMP_STARTSWITHI:
+            return viewStartsWith(sL, lenL, sR, lenR, cmpop == CMP_STARTSWITHI);
+        case CMP_ENDSWITH:
+            return viewEndsWith(sL, lenL, sR, lenR);
+        case CMP_CONTAINS:
+        case CMP_CONTAINSI:
+            return viewContains(sL, lenL, sR, lenR, cmpop == CMP_CONTAINSI);
+        default:
+            return 0;
+    }
+}
+
+static long long arith(const long long n_l, const long long n_r, const int op) {
+    switch (op) {
+        case '+':
+            return n_l + n_r;
+        case '-':
+            return n_l - n_r;
+        case '*':
+            return n_l * n_r;
+        case '/':
+            return (n_r == 0) ? 0 : n_l / n_r;
+        case '%':
+            return (n_r == 0) ? 0 : n_l % n_r;
+        default:
+            return 0;
+    }
+}
+
+
+/* ---------------------------------------------------------------------- *
+ * native functions                                                       *
+ * ---------------------------------------------------------------------- */
+
+/* buffer for a new string of len bytes (plus NUL), taken from the scratch
+ * arena if possible. *pToFree is set if it is on the heap.
+ */
+static uchar *newStrBuf(wti_t *const pWti, const rs_size_t len, uchar **const pToFree) {
+    uchar *buf;
+    *pToFree = NULL;
+    if ((buf = wtiScratchAlloc(pWti, (size_t)len + 1)) == NULL) {
+        buf = *pToFree = malloc((size_t)len + 1);
+    }
+    return buf;
+}
+
+/* store a copy of str in r */
+static void setStrCopy(rsvmReg_t *const r, const uchar *const str, const rs_size_t len, wti_t *const pWti) {
+    uchar *toFree;
+    uchar *const buf = newStrBuf(pWti, len, &toFree);
+    if (buf == NULL) {
+        setStr(r, (const uchar *)"", 0, NULL);
+        return;
+    }
+    memcpy(buf, str, len);
+    buf[len] = '\0';
+    setStr(r, buf, len, toFree);
+}
+
+/* convert a number register into a string register, as var2String() does */
+static void regMakeStr(rsvmReg_t *const r, wti_t *const pWti) {
+    char buf[32];
+    rs_size_t len;
+    if (r->str != NULL) return;
+    len = (rs_size_t)snprintf(buf, sizeof(buf), "%lld", r->n);
+    setStrCopy(r, (const uchar *)buf, len, pWti);
+}
+
+/* length of the string as seen by functions working on C strings */
+static rs_size_t viewCStrLen(const uchar *const s, const rs_size_t len) {
+    const uchar *const nul = memchr(s, '\0', len);
+    return (nul == NULL) ? len : (rs_size_t)(nul - s);
+}
+
+/* offset of the first occurrence of needle in s, -1 if there is none */
+static int viewFind(const uchar *const s, const rs_size_t len, const uchar *const needle, const rs_size_t lenNeedle) {
+    rs_size_t i;
+    if (lenNeedle > len) return -1;
+    for (i = 0; i + lenNeedle <= len; ++i) {
+        if (memcmp(s + i, needle, lenNeedle) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static void fnStrLen(rsvmReg_t *const args, wti_t *const pWti __attribute__((unused))) {
+    char buf[32];
+    rs_size_t len;
+    regToStr(&args[0], buf, sizeof(buf), &len);
+    setNum(&args[0], len);
+}
+
+static void changeCase(rsvmReg_t *const arg, wti_t *const pWti, const int bUpper) {
+    char buf[32];
+    rs_size_t len, i;
+    uchar *toFree;
+    const uchar *const s = regToStr(arg, buf, sizeof(buf), &len);
+    uchar *const res = newStrBuf(pWti, len, &toFree);
+    if (res == NULL) {
+        setStr(arg, (const uchar *)"", 0, NULL);
+        return;
+    }
+    for (i = 0; i < len; ++i) res[i] = bUpper ? toupper((int)s[i]) : tolower((int)s[i]);
+    res[len] = '\0';
+    setStr(arg, res, len, toFree);
+}
+
+static void fnToLower(rsvmReg_t *const args, wti_t *const pWti) {
+    changeCase(&args[0], pWti, 0);
+}
+
+static void fnToUpper(rsvmReg_t *const args, wti_t *const pWti) {
+    changeCase(&args[0], pWti, 1);
+}
+
+static void fnCStr(rsvmReg_t *const args, wti_t *const pWti) {
+    regMakeStr(&args[0], pWti);
+}
+
+static void fnCNum(rsvmReg_t *const args, wti_t *const pWti __attribute__((unused))) {
+    int convok;
+    setNum(&args[0], regToNum(&args[0], &convok));
+}
+
+/* trimming just narrows the view, the register keeps owning the memory */
+static void fnLTrim(rsvmReg_t *const args, wti_t *const pWti) {
+    rs_size_t len, i;
+    regMakeStr(&args[0], pWti);
+    len = viewCStrLen(args[0].str, args[0].len);
+    for (i = 0; i < len && args[0].str[i] == ' '; ++i)
+        ;
+    args[0].str += i;
+    args[0].len = len - i;
+}
+
+static void fnRTrim(rsvmReg_t *const args, wti_t *const pWti) {
+    int i;
+    regMakeStr(&args[0], pWti);
+    const int len = (int)viewCStrLen(args[0].str, args[0].len);
+    for (i = len - 1; i > 0 && args[0].str[i] == ' '; --i)
+        ;
+    args[0].len = (len == 0 || (i == 0 && args[0].str[0] == ' ')) ? 0 : (rs_size_t)(i + 1);
+}
+
+/* same as doExtractFieldByChar() and doExtractFieldByStr() */
+static void fnField(rsvmReg_t *const args, wti_t *const pWti) {
+    static const uchar notFound[] = "***FIELD NOT FOUND***";
+    rs_size_t len, pos = 0, end = 0;
+    int convok;
+    int fld = 1;
+    int off;
+
+    regMakeStr(&args[0], pWti);
+    const uchar *const s = args[0].str;
+    len = viewCStrLen(s, args[0].len);
+    const int matchnbr = (int)regToNum(&args[2], &convok);
+    if (args[1].str != NULL) {
+        const uchar *const delim = args[1].str;
+        const rs_size_t lenDelim = args[1].len;
+        const rs_size_t lenSearch = viewCStrLen(delim, lenDelim);
+        while (fld < matchnbr && (off = viewFind(s + pos, len - pos, delim, lenSearch)) >= 0) {
+            pos += off + lenDelim;
+            if (pos > len) pos = len;
+            ++fld;
+        }
+        if (fld == matchnbr) {
+            off = viewFind(s + pos, len - pos, delim, lenSearch);
+            end = (off < 0) ? len : pos + off;
+        }
+    } else {
+        const uchar delim = (uchar)(char)args[1].n;
+        while (pos < len && fld < matchnbr) {
+            while (pos < len && s[pos] != delim) ++pos;
+            if (pos < len) {
+                ++pos;
+                ++fld;
+            }
+        }
+        for (end = pos; end < len && s[end] != delim; ++end)
+            ;
+    }
+    if (fld == matchnbr) {
+        args[0].str = s + pos;
+        args[0].len = end - pos;
+    } else {
+        setStr(&args[0], notFound, sizeof(notFound) - 1, NULL);
+    }
+}
+
+/* the functions that can be evaluated on string views. Their results are
+ * the same as those of the interpreter's implementation.
+ */
+static const rsvmFunc_t nativeFuncs[] = {{"strlen", 1, RSVM_T_NUM, fnStrLen},  {"tolower", 1, RSVM_T_STR, fnToLower},
+                                         {"toupper", 1, RSVM_T_STR, fnToUpper}, {"cstr", 1, RSVM_T_STR, fnCStr},
+                                         {"cnum", 1, RSVM_T_NUM, fnCNum},       {"ltrim", 1, RSVM_T_STR, fnLTrim},
+                                         {"rtrim", 1, RSVM_T_STR, fnRTrim},     {"field", 3, RSVM_T_STR, fnField},
+                                         {NULL, 0, RSVM_T_ERR, NULL}};
+
+static const rsvmFunc_t *findNativeFunc(const struct cnffunc *const func) {
+    const rsvmFunc_t *nf;
+    if (func->fPtr == NULL) return NULL; /* unknown function, error already reported */
+    for (nf = nativeFuncs; nf->name != NULL; ++nf) {
+        if (func->nParams == nf->nParams && es_strlen(func->fname) == strlen(nf->name) &&
+            !es_strbufcmp(func->fname, (const uchar *)nf->name, strlen(nf->name)))
+            return nf;
+    }
+    return NULL;
+}
+
+
+int rsvmExecBool(const struct rsvmProg *const prog, void *const usrptr, wti_t *const pWti) {
+    rsvmReg_t regs[RSVM_MAX_REGS];
+    struct svar v;
+    uchar *pszProp;
+    rs_size_t propLen;
+    unsigned short bMustBeFreed;
+    char buf[32];
+    rs_size_t len;
+    const uchar *s;
+    int convok;
+    int retVal = 0;
+    int pc = 0;
+    int i;
+    const size_t scratchMark = wtiScratchMark(pWti);
+
+    memset(regs, 0, sizeof(rsvmReg_t) * prog->nRegs);
+    while (pc < prog->nInsns) {
+        const rsvmInsn_t *const insn = &prog->insns[pc++];
+        rsvmReg_t *const dst = &regs[insn->dst];
+        rsvmReg_t *const a = &regs[insn->a];
+        switch (insn->op) {
+            case RSVM_LOADN:
+                setNum(dst, insn->imm.n);
+                break;
+            case RSVM_LOADS:
+                setStr(dst, es_getBufAddr((es_str_t *)insn->imm.p), es_strlen((es_str_t *)insn->imm.p), NULL);
+                break;
+            case RSVM_LOADPROP:
+                bMustBeFreed = 0;
+                pszProp = MsgGetProp((smsg_t *)usrptr, NULL, (msgPropDescr_t *)insn->imm.p, &propLen, &bMustBeFreed,
+                                     NULL);
+                if (pszProp == NULL) {
+                    setStr(dst, (const uchar *)"", 0, NULL);
+                } else {
+                    setStr(dst, pszProp, propLen, bMustBeFreed ? pszProp : NULL);
+                }
+                break;
+            case RSVM_EVALNUM:
+                cnfexprEval((const struct cnfexpr *)insn->imm.p, &v, usrptr, pWti);
+                setNum(dst, var2Number(&v, NULL));
+                varFreeMembers(&v);
+                break;
+            case RSVM_CMP:
+                setNum(dst, cmpRegs(a, &regs[insn->b], insn->aux));
+                break;
+            case RSVM_CMPARR:
+                s = regToStr(a, buf, sizeof(buf), &len);
+                setNum(dst, cmpArray(s, len, (const struct cnfarray *)insn->imm.p, insn->aux));
+                break;
+            case RSVM_ARITH: {
+                const long long n_l = regToNum(a, &convok);
+                setNum(dst, arith(n_l, regToNum(&regs[insn->b], &convok), insn->aux));
+            } break;
+            case RSVM_NEG:
+                setNum(dst, -regToNum(a, &convok));
+                break;
+            case RSVM_NOT:
+                setNum(dst, !regToNum(a, &convok));
+                break;
+            case RSVM_TRUTH:
+                setNum(dst, regToNum(a, &convok) ? 1 : 0);
+                break;
+            case RSVM_ANDJ:
+                if (!regToNum(a, &convok)) {
+                    setNum(a, 0);
+                    pc = insn->aux;
+                }
+                break;
+            case RSVM_ORJ:
+                if (regToNum(a, &convok)) {
+                    setNum(a, 1);
+                    pc = insn->aux;
+                }
+                break;
+            case RSVM_CONCAT: {
+                char bufR[32];
+                rs_size_t lenR;
+                uchar *toFree;
+                const uchar *const sL = regToStr(a, buf, sizeof(buf), &len);
+                const uchar *const sR = regToStr(&regs[insn->b], bufR, sizeof(bufR), &lenR);
+                uchar *const res = newStrBuf(pWti, len + lenR, &toFree);
+                if (res == NULL) {
+                    setStr(dst, (const uchar *)"", 0, NULL);
+                } else {
+                    memcpy(res, sL, len);
+                    memcpy(res + len, sR, lenR);
+                    res[len + lenR] = '\0';
+                    setStr(dst, res, len + lenR, toFree);
+                }
+            } break;
+            case RSVM_CALL:
+                ((const rsvmFunc_t *)insn->imm.p)->fn(a, pWti);
+                break;
+            case RSVM_RET:
+                retVal = (int)regToNum(a, &convok);
+                pc = prog->nInsns;
+                break;
+            default:
+                DBGPRINTF("scriptvm: invalid opcode %d\n", insn->op);
+                pc = prog->nInsns;
+                break;
+        }
+    }
+
+    for (i = 0; i < prog->nRegs; ++i) free(regs[i].toFree);
+    wtiScratchRelease(pWti, scratchMark);
+    return retVal;
+}
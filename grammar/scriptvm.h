@@ -0,0 +1,62 @@
+/* scriptvm.h - register based evaluation of RainerScript conditions
+ *
+ * Module begun 2026-10-18 by Rainer Gerhards
+ *
+ * Copyright 2026 Rainer Gerhards and Others.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * The rsyslog runtime library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The rsyslog runtime library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the rsyslog runtime library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * A copy of the GPL can be found in the file "COPYING" in this distribution.
+ * A copy of the LGPL can be found in the file "COPYING.LESSER" in this distribution.
+ */
+#ifndef INC_SCRIPTVM_H
+#define INC_SCRIPTVM_H
+
+#include "rainerscript.h"
+
+/** maximum number of registers a compiled program may use */
+#define RSVM_MAX_REGS 32
+
+struct rsvmProg;
+
+/**
+ * Compile an (already optimized) expression into a register program.
+ *
+ * Comparisons, logical and arithmetic operators on constants and message
+ * properties are translated into native instructions which work on string
+ * views and plain integers and thus do not allocate memory. So are string
+ * concatenation and the functions strlen(), tolower(), toupper(), cstr(),
+ * cnum(), ltrim(), rtrim() and field(); strings they create are placed in
+ * the worker's scratch arena. Everything else (other functions, JSON
+ * variables) is evaluated by the regular interpreter from within the
+ * program.
+ *
+ * @return the program or NULL if the expression does not benefit from
+ *         compilation (or on error). In that case the tree interpreter
+ *         must be used.
+ */
+struct rsvmProg *rsvmCompile(struct cnfexpr *expr);
+
+/** Evaluate a program with the semantics of cnfexprEvalBool(). */
+int rsvmExecBool(const struct rsvmProg *prog, void *usrptr, wti_t *pWti);
+
+/** Same result as es_strcmp(), including the actual (not just sign) value, but on plain buffers. */
+int rsvmStrCmp(const uchar *s1, rs_size_t len1, const uchar *s2, rs_size_t len2);
+
+void rsvmDestruct(struct rsvmProg *prog);
+void rsvmDebugPrint(const struct rsvmProg *prog, int indent);
+
+#endif /* #ifndef INC_SCRIPTVM_H */
@@ -148,13 +148,13 @@ static void ATTR_NONNULL(1) destructFunc_http_request(struct cnffunc *const func
 }
 
 static struct scriptFunct functions[] = {
-    {"http_request", 1, 1, doFunc_http_request, initFunc_http_request, destructFunc_http_request},
-    {NULL, 0, 0, NULL, NULL, NULL}  // last element to check end of array
+    {"http_request", 1, 1, doFunc_http_request, initFunc_http_request, destructFunc_http_request, 0},
+    {NULL, 0, 0, NULL, NULL, NULL, 0}  // last element to check end of array
 };
 
 BEGINgetFunctArray
     CODESTARTgetFunctArray;
-    *version = 1;
+    *version = SCRIPT_FUNCT_IF_VERSION;
     *functArray = functions;
 ENDgetFunctArray
 
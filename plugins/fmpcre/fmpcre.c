@@ -90,11 +90,12 @@ static void ATTR_NONNULL(1) destruct_pcre(struct cnffunc *const func) {
     }
 }
 
-static struct scriptFunct functions[] = {{"pcre_match", 2, 2, doFunc_pcre_match, initFunc_pcre_match, destruct_pcre},
-                                         {NULL, 0, 0, NULL, NULL, NULL}};
+static struct scriptFunct functions[] = {
+    {"pcre_match", 2, 2, doFunc_pcre_match, initFunc_pcre_match, destruct_pcre, SCRIPT_FUNC_PURE},
+    {NULL, 0, 0, NULL, NULL, NULL, 0}};
 
 BEGINgetFunctArray
-    CODESTARTgetFunctArray *version = 1;
+    CODESTARTgetFunctArray *version = SCRIPT_FUNCT_IF_VERSION;
     *functArray = functions;
 ENDgetFunctArray
 
@@ -34,6 +34,7 @@
 #include <signal.h>
 #include <errno.h>
 #include <unistd.h>
+#include <sys/uio.h>
 #include "conf.h"
 #include "syslogd-types.h"
 #include "srUtils.h"
@@ -58,6 +59,7 @@ DEF_OMOD_STATIC_DATA;
 
 typedef struct _instanceData {
     int bUseArrayInterface; /* uses action use array instead of string template interface? */
+    int bUseIov; /* template is passed as iovec segments, written without copy */
     int bEnsureLFEnding; /* ensure that a linefeed is written at the end of EACH
              record (test aid for nettester) */
     uchar *templateName;
@@ -85,6 +87,7 @@ struct modConfData_s {
 
 static modConfData_t *loadModConf = NULL; /* modConf ptr to use for the current load process */
 static modConfData_t *runModConf = NULL; /* modConf ptr to use for the current exec process */
+static int bIovPassingSupported = 0; /* does core support template passing as iovec? */
 
 
 BEGINinitConfVars /* (re)set config variables to default values */
@@ -156,6 +159,26 @@ BEGINtryResume
     CODESTARTtryResume;
 ENDtryResume
 
+/* write a template that was passed in iovec mode. The rendered segments
+ * are handed to the kernel directly, so the message is not copied into an
+ * intermediate buffer first.
+ */
+static void writeIov(const instanceData *const pData, const tplIov_t *const pIov) {
+    ssize_t r;
+
+    if (pIov->nIov > 0 && (r = writev(1, pIov->iov, pIov->nIov)) != (ssize_t)pIov->lenTotal) {
+        DBGPRINTF("omstdout: error %zd writing %zu bytes to stdout\n", r, pIov->lenTotal);
+    }
+    if (pData->bEnsureLFEnding) {
+        const struct iovec *const last = (pIov->nIov > 0) ? &pIov->iov[pIov->nIov - 1] : NULL;
+        if (last == NULL || ((const char *)last->iov_base)[last->iov_len - 1] != '\n') {
+            if ((r = write(1, "\n", 1)) != 1) { /* write missing LF */
+                DBGPRINTF("omstdout: error %zd writing \\n to stdout\n", r);
+            }
+        }
+    }
+}
+
 BEGINdoAction
     char **szParams;
     char *toWrite;
@@ -167,6 +190,10 @@ BEGINdoAction
     int r;
     CODESTARTdoAction;
     dbgprintf("omstdout: in doAction\n");
+    if (pWrkrData->pData->bUseIov) {
+        writeIov(pWrkrData->pData, (const tplIov_t *)(void *)ppString[0]);
+        FINALIZE;
+    }
     if (pWrkrData->pData->bUseArrayInterface) {
         dbgprintf("omstdout: in ArrayInterface\n");
         /* if we use array passing, we need to put together a string
@@ -211,12 +238,14 @@ BEGINdoAction
             DBGPRINTF("omstdout: error %d writing \\n to stdout\n", r);
         }
     }
+finalize_it:
 ENDdoAction
 
 static void setInstParamDefaults(instanceData *pData) {
     pData->bEnsureLFEnding = 1;
     pData->templateName = (uchar *)"RSYSLOG_FileFormat";
     pData->bUseArrayInterface = 0;
+    pData->bUseIov = bIovPassingSupported;
 }
 
 
@@ -265,7 +294,7 @@ BEGINnewActInst
     CODE_STD_STRING_REQUESTnewActInst(1);
     // TODO: make the template a parameter
     tplToUse = (uchar *)strdup((pData->templateName == NULL) ? "RSYSLOG_FileFormat" : (char *)pData->templateName);
-    CHKiRet(OMSRsetEntry(*ppOMSR, 0, tplToUse, OMSR_NO_RQD_TPL_OPTS));
+    CHKiRet(OMSRsetEntry(*ppOMSR, 0, tplToUse, pData->bUseIov ? OMSR_TPL_AS_IOV : OMSR_NO_RQD_TPL_OPTS));
     CODE_STD_FINALIZERnewActInst;
     if (bDestructPValsOnExit) cnfparamvalsDestruct(pvals, &actpblk);
 ENDnewActInst
@@ -335,6 +364,7 @@ BEGINmodInit()
         /* found entry point, so let's see if core supports array passing */
         CHKiRet((*pomsrGetSupportedTplOpts)(&opts));
         if (opts & OMSR_TPL_AS_ARRAY) bArrayPassingSupported = 1;
+        if (opts & OMSR_TPL_AS_IOV) bIovPassingSupported = 1;
     } else if (localRet != RS_RET_ENTRY_POINT_NOT_FOUND) {
         ABORT_FINALIZE(localRet); /* Something else went wrong, what is not acceptable */
     }
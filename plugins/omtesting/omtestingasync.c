@@ -0,0 +1,397 @@
+/* omtestingasync.c
+ *
+ * This module is a testing aid for the asynchronous commit interface of
+ * output modules (submitTransaction(), see module-template.h). It is not
+ * meant to be used in production. The messages are written to a file.
+ * Each part of a batch handed over by the core is completed by a per-worker
+ * completion thread after a configurable delay, so that parts overlap.
+ * Every n-th part can be made to fail, and on shutdown the number of parts,
+ * failed parts and the maximum number of parts that were in flight at the
+ * same time are written to a stats file. This permits the testbench to
+ * check partial failure handling and action.async.maxInFlight. With
+ * reject="on", all messages are rejected with a permanent error, so that
+ * they go to action.errorfile.
+ *
+ * Sample:
+ * action(type="omtestingasync" file="out.log" statsfile="stats.log"
+ *        delay="10" failevery="5" action.async.maxInFlight="3")
+ *
+ * NOTE: read comments in module-template.h to understand how this file
+ *       works!
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of rsyslog.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include "rsyslog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <assert.h>
+#include <pthread.h>
+#include "conf.h"
+#include "syslogd-types.h"
+#include "srUtils.h"
+#include "template.h"
+#include "module-template.h"
+#include "errmsg.h"
+#include "action.h"
+
+MODULE_TYPE_OUTPUT;
+MODULE_TYPE_NOKEEP;
+MODULE_CNFNAME("omtestingasync")
+
+/* internal structures
+ */
+DEF_OMOD_STATIC_DATA;
+
+typedef struct _instanceData {
+    uchar *file;
+    uchar *statsfile; /* NULL if no stats are to be written */
+    uchar *tplName;
+    int fd;
+    int iDelay; /* completion delay in milliseconds */
+    int iFailEvery; /* fail every n-th part, 0 = never */
+    sbool bReject; /* reject all messages with RS_RET_DATAFAIL */
+    pthread_mutex_t mut; /* guards everything below and writes to fd */
+    int nParts;
+    int nFailed;
+    int nInFlight;
+    int maxInFlight;
+} instanceData;
+
+/* a part submitted, but not yet completed */
+typedef struct asyncPart_s {
+    actWrkrIParams_t *pParams;
+    unsigned nParams;
+    actAsyncTx_t *pTx;
+    sbool bFail;
+    struct asyncPart_s *pNext;
+} asyncPart_t;
+
+typedef struct wrkrInstanceData {
+    instanceData *pData;
+    pthread_t thrd; /* completes the parts, in submission order */
+    sbool bThrdStarted;
+    sbool bShutdown;
+    pthread_mutex_t mut;
+    pthread_cond_t cond;
+    asyncPart_t *pRoot;
+    asyncPart_t *pLast;
+} wrkrInstanceData_t;
+
+/* tables for interfacing with the v6 config system */
+/* action (instance) parameters */
+static struct cnfparamdescr actpdescr[] = {
+    {"file", eCmdHdlrGetWord, CNFPARAM_REQUIRED},
+    {"statsfile", eCmdHdlrGetWord, 0},
+    {"template", eCmdHdlrGetWord, 0},
+    {"delay", eCmdHdlrNonNegInt, 0},
+    {"failevery", eCmdHdlrNonNegInt, 0},
+    {"reject", eCmdHdlrBinary, 0},
+};
+static struct cnfparamblk actpblk = {CNFPARAMBLK_VERSION, sizeof(actpdescr) / sizeof(struct cnfparamdescr), actpdescr};
+
+struct modConfData_s {
+    rsconf_t *pConf; /* our overall config object */
+};
+
+static modConfData_t *loadModConf = NULL; /* modConf ptr to use for the current load process */
+static modConfData_t *runModConf = NULL; /* modConf ptr to use for the current exec process */
+
+
+/* write messages to the output file. Must be called with pData->mut locked. */
+static void writeMsgs(instanceData *const pData, actWrkrIParams_t *const pParams, const unsigned nParams) {
+    ssize_t r;
+
+    for (unsigned i = 0; i < nParams; ++i) {
+        const actWrkrIParams_t *const pParam = &actParam(pParams, 1, i, 0);
+        if ((r = write(pData->fd, pParam->param, pParam->lenStr)) != (ssize_t)pParam->lenStr) {
+            DBGPRINTF("omtestingasync: error %zd writing to '%s'\n", r, pData->file);
+        }
+    }
+}
+
+
+static void *completionThrd(void *arg) {
+    wrkrInstanceData_t *const pWrkrData = (wrkrInstanceData_t *)arg;
+    instanceData *const pData = pWrkrData->pData;
+    asyncPart_t *pPart;
+
+    pthread_mutex_lock(&pWrkrData->mut);
+    while (1) {
+        while (pWrkrData->pRoot == NULL && !pWrkrData->bShutdown) pthread_cond_wait(&pWrkrData->cond, &pWrkrData->mut);
+        if (pWrkrData->pRoot == NULL) break; /* shutdown */
+        pPart = pWrkrData->pRoot;
+        pWrkrData->pRoot = pPart->pNext;
+        if (pWrkrData->pRoot == NULL) pWrkrData->pLast = NULL;
+        pthread_mutex_unlock(&pWrkrData->mut);
+
+        srSleep(pData->iDelay / 1000, (pData->iDelay % 1000) * 1000);
+        pthread_mutex_lock(&pData->mut);
+        if (!pPart->bFail) writeMsgs(pData, pPart->pParams, pPart->nParams);
+        pData->nInFlight--;
+        pthread_mutex_unlock(&pData->mut);
+        /* the core may submit the next part as soon as we are done */
+        actionAsyncTxDone(pPart->pTx, pPart->bFail ? RS_RET_SUSPENDED : RS_RET_OK);
+        free(pPart);
+
+        pthread_mutex_lock(&pWrkrData->mut);
+    }
+    pthread_mutex_unlock(&pWrkrData->mut);
+    return NULL;
+}
+
+
+BEGINinitConfVars /* (re)set config variables to default values */
+    CODESTARTinitConfVars;
+ENDinitConfVars
+
+
+BEGINcreateInstance
+    CODESTARTcreateInstance;
+    pData->fd = -1;
+    pthread_mutex_init(&pData->mut, NULL);
+ENDcreateInstance
+
+
+BEGINcreateWrkrInstance
+    int r;
+    CODESTARTcreateWrkrInstance;
+    pthread_mutex_init(&pWrkrData->mut, NULL);
+    pthread_cond_init(&pWrkrData->cond, NULL);
+    if ((r = pthread_create(&pWrkrData->thrd, NULL, completionThrd, pWrkrData)) != 0) {
+        LogError(r, RS_RET_ERR, "omtestingasync: cannot create completion thread");
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    pWrkrData->bThrdStarted = 1;
+finalize_it:
+ENDcreateWrkrInstance
+
+
+BEGINbeginCnfLoad
+    CODESTARTbeginCnfLoad;
+    loadModConf = pModConf;
+    pModConf->pConf = pConf;
+ENDbeginCnfLoad
+
+
+BEGINendCnfLoad
+    CODESTARTendCnfLoad;
+    loadModConf = NULL; /* done loading */
+ENDendCnfLoad
+
+BEGINcheckCnf
+    CODESTARTcheckCnf;
+ENDcheckCnf
+
+BEGINactivateCnf
+    CODESTARTactivateCnf;
+    runModConf = pModConf;
+ENDactivateCnf
+
+BEGINfreeCnf
+    CODESTARTfreeCnf;
+ENDfreeCnf
+
+
+BEGINisCompatibleWithFeature
+    CODESTARTisCompatibleWithFeature;
+ENDisCompatibleWithFeature
+
+
+BEGINfreeInstance
+    FILE *fp;
+    CODESTARTfreeInstance;
+    if (pData->statsfile != NULL) {
+        if ((fp = fopen((char *)pData->statsfile, "w")) == NULL) {
+            LogError(errno, RS_RET_ERR, "omtestingasync: cannot open stats file '%s'", pData->statsfile);
+        } else {
+            fprintf(fp, "parts=%d failed=%d maxinflight=%d\n", pData->nParts, pData->nFailed, pData->maxInFlight);
+            fclose(fp);
+        }
+    }
+    if (pData->fd != -1) close(pData->fd);
+    free(pData->file);
+    free(pData->statsfile);
+    free(pData->tplName);
+    pthread_mutex_destroy(&pData->mut);
+ENDfreeInstance
+
+
+BEGINfreeWrkrInstance
+    CODESTARTfreeWrkrInstance;
+    /* the core waits for all parts to complete, so there is nothing queued any longer */
+    if (pWrkrData->bThrdStarted) {
+        pthread_mutex_lock(&pWrkrData->mut);
+        pWrkrData->bShutdown = 1;
+        pthread_cond_signal(&pWrkrData->cond);
+        pthread_mutex_unlock(&pWrkrData->mut);
+        pthread_join(pWrkrData->thrd, NULL);
+    }
+    pthread_cond_destroy(&pWrkrData->cond);
+    pthread_mutex_destroy(&pWrkrData->mut);
+ENDfreeWrkrInstance
+
+
+BEGINdbgPrintInstInfo
+    CODESTARTdbgPrintInstInfo;
+    dbgprintf("omtestingasync\n");
+    dbgprintf("\tfile='%s'\n", pData->file);
+    dbgprintf("\tdelay=%d, failevery=%d, reject=%d\n", pData->iDelay, pData->iFailEvery, pData->bReject);
+ENDdbgPrintInstInfo
+
+
+BEGINtryResume
+    CODESTARTtryResume;
+ENDtryResume
+
+
+BEGINbeginTransaction
+    CODESTARTbeginTransaction;
+ENDbeginTransaction
+
+
+/* the synchronous commit, also used by the core to retry failed parts; it succeeds unless reject is set */
+BEGINcommitTransaction
+    instanceData *const pData = pWrkrData->pData;
+    CODESTARTcommitTransaction;
+    if (pData->bReject) ABORT_FINALIZE(RS_RET_DATAFAIL);
+    pthread_mutex_lock(&pData->mut);
+    writeMsgs(pData, pParams, nParams);
+    pthread_mutex_unlock(&pData->mut);
+finalize_it:
+ENDcommitTransaction
+
+
+BEGINsubmitTransaction
+    instanceData *const pData = pWrkrData->pData;
+    asyncPart_t *pPart;
+    CODESTARTsubmitTransaction;
+    if (pData->bReject) ABORT_FINALIZE(RS_RET_DATAFAIL);
+    CHKmalloc(pPart = calloc(1, sizeof(asyncPart_t)));
+    pPart->pParams = pParams;
+    pPart->nParams = nParams;
+    pPart->pTx = pTx;
+
+    pthread_mutex_lock(&pData->mut);
+    pData->nParts++;
+    if (pData->iFailEvery > 0 && pData->nParts % pData->iFailEvery == 0) {
+        pPart->bFail = 1;
+        pData->nFailed++;
+    }
+    if (++pData->nInFlight > pData->maxInFlight) pData->maxInFlight = pData->nInFlight;
+    pthread_mutex_unlock(&pData->mut);
+
+    pthread_mutex_lock(&pWrkrData->mut);
+    if (pWrkrData->pLast == NULL)
+        pWrkrData->pRoot = pPart;
+    else
+        pWrkrData->pLast->pNext = pPart;
+    pWrkrData->pLast = pPart;
+    pthread_cond_signal(&pWrkrData->cond);
+    pthread_mutex_unlock(&pWrkrData->mut);
+finalize_it:
+ENDsubmitTransaction
+
+
+static void setInstParamDefaults(instanceData *pData) {
+    pData->iDelay = 10;
+    pData->iFailEvery = 0;
+}
+
+
+BEGINnewActInst
+    struct cnfparamvals *pvals;
+    int i;
+    CODESTARTnewActInst;
+    if ((pvals = nvlstGetParams(lst, &actpblk, NULL)) == NULL) {
+        ABORT_FINALIZE(RS_RET_MISSING_CNFPARAMS);
+    }
+
+    CHKiRet(createInstance(&pData));
+    setInstParamDefaults(pData);
+
+    for (i = 0; i < actpblk.nParams; ++i) {
+        if (!pvals[i].bUsed) {
+            continue;
+        } else if (!strcmp(actpblk.descr[i].name, "file")) {
+            CHKmalloc(pData->file = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL));
+        } else if (!strcmp(actpblk.descr[i].name, "statsfile")) {
+            CHKmalloc(pData->statsfile = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL));
+        } else if (!strcmp(actpblk.descr[i].name, "template")) {
+            CHKmalloc(pData->tplName = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL));
+        } else if (!strcmp(actpblk.descr[i].name, "delay")) {
+            pData->iDelay = (int)pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "failevery")) {
+            pData->iFailEvery = (int)pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "reject")) {
+            pData->bReject = (sbool)pvals[i].val.d.n;
+        } else {
+            DBGPRINTF("omtestingasync: program error, non-handled param '%s'\n", actpblk.descr[i].name);
+        }
+    }
+
+    if ((pData->fd = open((char *)pData->file, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)) == -1) {
+        LogError(errno, RS_RET_FILE_OPEN_ERROR, "omtestingasync: cannot open '%s'", pData->file);
+        ABORT_FINALIZE(RS_RET_FILE_OPEN_ERROR);
+    }
+
+    CODE_STD_STRING_REQUESTnewActInst(1);
+    CHKiRet(OMSRsetEntry(*ppOMSR, 0,
+                         (uchar *)strdup((pData->tplName == NULL) ? "RSYSLOG_FileFormat" : (char *)pData->tplName),
+                         OMSR_NO_RQD_TPL_OPTS));
+    CODE_STD_FINALIZERnewActInst;
+    cnfparamvalsDestruct(pvals, &actpblk);
+ENDnewActInst
+
+
+BEGINparseSelectorAct
+    CODESTARTparseSelectorAct;
+    /* old-style config is not supported */
+    ABORT_FINALIZE(RS_RET_CONFLINE_UNPROCESSED);
+    CODE_STD_FINALIZERparseSelectorAct
+ENDparseSelectorAct
+
+
+BEGINmodExit
+    CODESTARTmodExit;
+ENDmodExit
+
+
+BEGINqueryEtryPt
+    CODESTARTqueryEtryPt;
+    CODEqueryEtryPt_STD_OMODTX_QUERIES;
+    CODEqueryEtryPt_TXIF_ASYNC_OMOD_QUERIES;
+    CODEqueryEtryPt_STD_OMOD8_QUERIES;
+    CODEqueryEtryPt_STD_CONF2_CNFNAME_QUERIES;
+    CODEqueryEtryPt_STD_CONF2_QUERIES;
+    CODEqueryEtryPt_STD_CONF2_OMOD_QUERIES;
+ENDqueryEtryPt
+
+
+BEGINmodInit()
+    CODESTARTmodInit;
+    INITLegCnfVars;
+    *ipIFVersProvided = CURR_MOD_IF_VERSION; /* we only support the current interface specification */
+    CODEmodInit_QueryRegCFSLineHdlr
+    /* old-style system not supported */
+ENDmodInit
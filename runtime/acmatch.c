@@ -0,0 +1,312 @@
+/* acmatch.c - multi-pattern string matching (Aho-Corasick)
+ *
+ * The patterns are stored in a trie. Each node keeps its outgoing edges as
+ * a run of (character, target) pairs sorted by character, so lookups are
+ * cheap for the typical small fanout. As the root usually has the largest
+ * fanout and is visited most often, it has a full 256 entry table. For
+ * "contains" mode, failure links are computed after all patterns have been
+ * added and the terminal flag is propagated along them, so a single pass
+ * over the input suffices and the first hit terminates the search.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "rsyslog.h"
+#include "acmatch.h"
+
+typedef struct acmatchNode_s {
+    int fail; /* failure link (contains mode only) */
+    int edges; /* while building: head of edge list; afterwards: first edge of sorted run */
+    int nEdges;
+    sbool terminal; /* a pattern ends here (or, via fail links, at a suffix of this node) */
+} acmatchNode_t;
+
+struct acmatch_s {
+    enum acmatchMode mode;
+    int bCaseless;
+    sbool bFinalized;
+    acmatchNode_t *nodes;
+    int nNodes;
+    int maxNodes;
+    uchar *edgeChar;
+    int *edgeTarget;
+    int *edgeNext; /* only used while building */
+    int nEdges;
+    int maxEdges;
+    int rootNext[256]; /* 0 means "no edge", as no edge leads back to the root */
+};
+
+
+static inline uchar acmatchFold(const acmatch_t *const pThis, const uchar c) {
+    return pThis->bCaseless ? (uchar)tolower(c) : c;
+}
+
+
+/* find edge target in finalized structure, -1 if there is none */
+static inline int acmatchFind(const acmatch_t *const pThis, const int node, const uchar c) {
+    const acmatchNode_t *const n = &pThis->nodes[node];
+    const uchar *const chars = pThis->edgeChar + n->edges;
+    int lo = 0;
+    int hi = n->nEdges - 1;
+
+    if (node == 0) return pThis->rootNext[c] == 0 ? -1 : pThis->rootNext[c];
+    while (lo <= hi) {
+        const int mid = (lo + hi) / 2;
+        if (chars[mid] == c) return pThis->edgeTarget[n->edges + mid];
+        if (chars[mid] < c)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
+}
+
+
+static rsRetVal acmatchNewNode(acmatch_t *const pThis, int *const pNode) {
+    acmatchNode_t *newNodes;
+    DEFiRet;
+
+    if (pThis->nNodes == pThis->maxNodes) {
+        const int newMax = pThis->maxNodes * 2;
+        CHKmalloc(newNodes = realloc(pThis->nodes, sizeof(acmatchNode_t) * newMax));
+        pThis->nodes = newNodes;
+        pThis->maxNodes = newMax;
+    }
+    memset(&pThis->nodes[pThis->nNodes], 0, sizeof(acmatchNode_t));
+    pThis->nodes[pThis->nNodes].edges = -1;
+    *pNode = pThis->nNodes++;
+
+finalize_it:
+    RETiRet;
+}
+
+
+static rsRetVal acmatchNewEdge(acmatch_t *const pThis, const int from, const uchar c, const int to) {
+    DEFiRet;
+
+    if (pThis->nEdges == pThis->maxEdges) {
+        const int newMax = pThis->maxEdges * 2;
+        uchar *newChar;
+        int *newTarget, *newNext;
+        CHKmalloc(newChar = realloc(pThis->edgeChar, newMax));
+        pThis->edgeChar = newChar;
+        CHKmalloc(newTarget = realloc(pThis->edgeTarget, sizeof(int) * newMax));
+        pThis->edgeTarget = newTarget;
+        CHKmalloc(newNext = realloc(pThis->edgeNext, sizeof(int) * newMax));
+        pThis->edgeNext = newNext;
+        pThis->maxEdges = newMax;
+    }
+    pThis->edgeChar[pThis->nEdges] = c;
+    pThis->edgeTarget[pThis->nEdges] = to;
+    pThis->edgeNext[pThis->nEdges] = pThis->nodes[from].edges;
+    pThis->nodes[from].edges = pThis->nEdges++;
+    pThis->nodes[from].nEdges++;
+
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal acmatchConstruct(acmatch_t **const ppThis, const enum acmatchMode mode, const int bCaseless) {
+    acmatch_t *pThis = NULL;
+    int root;
+    DEFiRet;
+
+    CHKmalloc(pThis = calloc(1, sizeof(acmatch_t)));
+    pThis->mode = mode;
+    pThis->bCaseless = bCaseless;
+    pThis->maxNodes = 64;
+    CHKmalloc(pThis->nodes = malloc(sizeof(acmatchNode_t) * pThis->maxNodes));
+    pThis->maxEdges = 64;
+    CHKmalloc(pThis->edgeChar = malloc(pThis->maxEdges));
+    CHKmalloc(pThis->edgeTarget = malloc(sizeof(int) * pThis->maxEdges));
+    CHKmalloc(pThis->edgeNext = malloc(sizeof(int) * pThis->maxEdges));
+    CHKiRet(acmatchNewNode(pThis, &root));
+    *ppThis = pThis;
+    pThis = NULL;
+
+finalize_it:
+    if (pThis != NULL) acmatchDestruct(&pThis);
+    RETiRet;
+}
+
+
+rsRetVal acmatchAddPattern(acmatch_t *const pThis, const uchar *const pat, const size_t lenPat) {
+    int node = 0;
+    size_t i;
+    DEFiRet;
+
+    if (pThis->bFinalized) ABORT_FINALIZE(RS_RET_ERR);
+    for (i = 0; i < lenPat; ++i) {
+        const uchar c = acmatchFold(pThis, pat[(pThis->mode == ACMATCH_SUFFIX) ? lenPat - 1 - i : i]);
+        int e;
+        int next = -1;
+        for (e = pThis->nodes[node].edges; e != -1; e = pThis->edgeNext[e]) {
+            if (pThis->edgeChar[e] == c) {
+                next = pThis->edgeTarget[e];
+                break;
+            }
+        }
+        if (next == -1) {
+            CHKiRet(acmatchNewNode(pThis, &next));
+            CHKiRet(acmatchNewEdge(pThis, node, c, next));
+        }
+        node = next;
+    }
+    pThis->nodes[node].terminal = 1;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* convert the per-node edge lists into runs sorted by character */
+static rsRetVal acmatchSortEdges(acmatch_t *const pThis) {
+    uchar *newChar = NULL;
+    int *newTarget = NULL;
+    int node;
+    int pos = 0;
+    DEFiRet;
+
+    CHKmalloc(newChar = malloc(pThis->nEdges + 1));
+    CHKmalloc(newTarget = malloc(sizeof(int) * (pThis->nEdges + 1)));
+    for (node = 0; node < pThis->nNodes; ++node) {
+        acmatchNode_t *const n = &pThis->nodes[node];
+        const int start = pos;
+        int e;
+        for (e = n->edges; e != -1; e = pThis->edgeNext[e]) {
+            /* insertion sort, fanout is usually small */
+            int j = pos++;
+            while (j > start && newChar[j - 1] > pThis->edgeChar[e]) {
+                newChar[j] = newChar[j - 1];
+                newTarget[j] = newTarget[j - 1];
+                --j;
+            }
+            newChar[j] = pThis->edgeChar[e];
+            newTarget[j] = pThis->edgeTarget[e];
+        }
+        n->edges = start;
+    }
+    free(pThis->edgeChar);
+    free(pThis->edgeTarget);
+    free(pThis->edgeNext);
+    pThis->edgeChar = newChar;
+    pThis->edgeTarget = newTarget;
+    pThis->edgeNext = NULL;
+    newChar = NULL;
+    newTarget = NULL;
+
+finalize_it:
+    free(newChar);
+    free(newTarget);
+    RETiRet;
+}
+
+
+/* compute failure links in breadth-first order */
+static rsRetVal acmatchBuildFailLinks(acmatch_t *const pThis) {
+    int *queue = NULL;
+    int head = 0, tail = 0;
+    DEFiRet;
+
+    CHKmalloc(queue = malloc(sizeof(int) * pThis->nNodes));
+    queue[tail++] = 0;
+    while (head < tail) {
+        const int u = queue[head++];
+        const acmatchNode_t *const nu = &pThis->nodes[u];
+        int k;
+        for (k = 0; k < nu->nEdges; ++k) {
+            const uchar c = pThis->edgeChar[nu->edges + k];
+            const int v = pThis->edgeTarget[nu->edges + k];
+            int f = 0;
+            if (u != 0) {
+                int t;
+                f = nu->fail;
+                while ((t = acmatchFind(pThis, f, c)) == -1 && f != 0) f = pThis->nodes[f].fail;
+                f = (t == -1) ? 0 : t;
+            }
+            pThis->nodes[v].fail = f;
+            if (pThis->nodes[f].terminal) pThis->nodes[v].terminal = 1;
+            queue[tail++] = v;
+        }
+    }
+
+finalize_it:
+    free(queue);
+    RETiRet;
+}
+
+
+rsRetVal acmatchFinalize(acmatch_t *const pThis) {
+    int k;
+    DEFiRet;
+
+    if (pThis->bFinalized) FINALIZE;
+    CHKiRet(acmatchSortEdges(pThis));
+    for (k = 0; k < pThis->nodes[0].nEdges; ++k) {
+        pThis->rootNext[pThis->edgeChar[pThis->nodes[0].edges + k]] = pThis->edgeTarget[pThis->nodes[0].edges + k];
+    }
+    if (pThis->mode == ACMATCH_CONTAINS) CHKiRet(acmatchBuildFailLinks(pThis));
+    pThis->bFinalized = 1;
+
+finalize_it:
+    RETiRet;
+}
+
+
+int acmatchMatch(const acmatch_t *const pThis, const uchar *const buf, const size_t lenBuf) {
+    int state = 0;
+    size_t i;
+
+    if (pThis->nodes[0].terminal) return 1; /* empty pattern matches everything */
+
+    if (pThis->mode == ACMATCH_CONTAINS) {
+        for (i = 0; i < lenBuf; ++i) {
+            const uchar c = acmatchFold(pThis, buf[i]);
+            int t;
+            while ((t = acmatchFind(pThis, state, c)) == -1 && state != 0) state = pThis->nodes[state].fail;
+            state = (t == -1) ? 0 : t;
+            if (pThis->nodes[state].terminal) return 1;
+        }
+        return 0;
+    }
+
+    for (i = 0; i < lenBuf; ++i) {
+        const uchar c = acmatchFold(pThis, buf[(pThis->mode == ACMATCH_SUFFIX) ? lenBuf - 1 - i : i]);
+        if ((state = acmatchFind(pThis, state, c)) == -1) return 0;
+        if (pThis->nodes[state].terminal) return 1;
+    }
+    return 0;
+}
+
+
+void acmatchDestruct(acmatch_t **const ppThis) {
+    acmatch_t *const pThis = *ppThis;
+    if (pThis == NULL) return;
+    free(pThis->nodes);
+    free(pThis->edgeChar);
+    free(pThis->edgeTarget);
+    free(pThis->edgeNext);
+    free(pThis);
+    *ppThis = NULL;
+}
@@ -0,0 +1,59 @@
+/* acmatch.h - multi-pattern string matching (Aho-Corasick)
+ *
+ * Matches a string against a whole set of patterns in a single pass. This
+ * is used to speed up RainerScript comparisons like
+ *     if $msg contains ["a", "b", ...] then
+ * which would otherwise need to search for each array element in turn.
+ * Besides "contains" (full Aho-Corasick automaton), "starts with" and
+ * "ends with" are supported, which only need the plain trie.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INCLUDED_ACMATCH_H
+#define INCLUDED_ACMATCH_H
+
+#include <stddef.h>
+
+/** match modes */
+enum acmatchMode {
+    ACMATCH_CONTAINS, /**< any pattern occurs somewhere in the string */
+    ACMATCH_PREFIX, /**< the string starts with any pattern */
+    ACMATCH_SUFFIX /**< the string ends with any pattern */
+};
+
+typedef struct acmatch_s acmatch_t;
+
+/**
+ * Create an empty matcher. If @p bCaseless is set, patterns and input are
+ * compared case-insensitively (ASCII tolower()).
+ */
+rsRetVal acmatchConstruct(acmatch_t **ppThis, enum acmatchMode mode, int bCaseless);
+
+/** Add a pattern. Must be called before acmatchFinalize(). */
+rsRetVal acmatchAddPattern(acmatch_t *pThis, const uchar *pat, size_t lenPat);
+
+/** Build the search structures; no patterns can be added afterwards. */
+rsRetVal acmatchFinalize(acmatch_t *pThis);
+
+/** @return 1 if @p buf matches any pattern according to the mode, 0 otherwise */
+int acmatchMatch(const acmatch_t *pThis, const uchar *buf, size_t lenBuf);
+
+void acmatchDestruct(acmatch_t **ppThis);
+
+#endif /* #ifndef INCLUDED_ACMATCH_H */
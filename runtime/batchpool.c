@@ -0,0 +1,231 @@
+/* batchpool.c - parallel execution of a batch in chunks
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "rsyslog.h"
+#include "errmsg.h"
+#include "wti.h"
+#include "action.h"
+#include "batchpool.h"
+
+typedef struct batchpoolWrkr_s {
+    batchpool_t *pPool;
+    wti_t *pWti;
+    pthread_t thrd;
+    sbool bStarted;
+} batchpoolWrkr_t;
+
+struct batchpool_s {
+    pthread_mutex_t mut;
+    pthread_cond_t condWork; /* a new batch is available or we shut down */
+    pthread_cond_t condDone; /* a chunk was committed or a helper left the batch */
+    int nWrkrs;
+    batchpoolWrkr_t *wrkrs;
+    sbool bShutdown;
+    /* the batch currently executed, all guarded by mut */
+    sbool bBusy;
+    unsigned seq; /* incremented for each new batch */
+    batch_t *pBatch;
+    int chunkSize;
+    int nChunks;
+    batchpoolChunkFn_t fn;
+    rsRetVal *results;
+    int *pbShutdownImmediate;
+    int nextChunk; /* next chunk to grab */
+    int nextCommit; /* next chunk to commit */
+    int nHelpers; /* helpers currently working on the batch */
+};
+
+
+/* execute chunks of the current batch until none is left. Called with
+ * the mutex unlocked.
+ */
+static void ATTR_NONNULL() runChunks(batchpool_t *const pThis, wti_t *const pWti) {
+    int chunk, first, n;
+
+    pthread_mutex_lock(&pThis->mut);
+    while (pThis->nextChunk < pThis->nChunks) {
+        chunk = pThis->nextChunk++;
+        pthread_mutex_unlock(&pThis->mut);
+
+        first = chunk * pThis->chunkSize;
+        n = batchNumMsgs(pThis->pBatch) - first;
+        if (n > pThis->chunkSize) n = pThis->chunkSize;
+        DBGPRINTF("batchpool: %s executes messages %d..%d\n", wtiGetDbgHdr(pWti), first, first + n - 1);
+        pThis->fn(pThis->pBatch, first, n, pThis->results, pWti);
+
+        /* the actions must see the chunks in batch order */
+        pthread_mutex_lock(&pThis->mut);
+        while (pThis->nextCommit != chunk) pthread_cond_wait(&pThis->condDone, &pThis->mut);
+        pthread_mutex_unlock(&pThis->mut);
+        actionCommitAllDirect(pWti);
+        pthread_mutex_lock(&pThis->mut);
+        pThis->nextCommit++;
+        pthread_cond_broadcast(&pThis->condDone);
+    }
+    pthread_mutex_unlock(&pThis->mut);
+}
+
+
+static void *batchpoolWrkr(void *arg) {
+    batchpoolWrkr_t *const pWrkr = (batchpoolWrkr_t *)arg;
+    batchpool_t *const pThis = pWrkr->pPool;
+    wti_t *const pWti = pWrkr->pWti;
+    unsigned seenSeq = 0;
+    sigset_t sigSet;
+
+    /* block all signals except SIGTTIN and SIGSEGV, like queue workers */
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGTTIN);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+    dbgSetThrdName(wtiGetDbgHdr(pWti));
+
+    pthread_mutex_lock(&pThis->mut);
+    while (1) {
+        while (!pThis->bShutdown && seenSeq == pThis->seq) pthread_cond_wait(&pThis->condWork, &pThis->mut);
+        if (pThis->bShutdown) break;
+        seenSeq = pThis->seq;
+        if (!pThis->bBusy) continue; /* we woke up too late, that batch is done */
+        pThis->nHelpers++;
+        pWti->pbShutdownImmediate = pThis->pbShutdownImmediate;
+        wtiResetExecState(pWti, pThis->pBatch);
+        pthread_mutex_unlock(&pThis->mut);
+
+        wtiTplCacheBegin(pWti);
+        wtiPropCacheBegin(pWti);
+        wtiFuncCacheBegin(pWti);
+        runChunks(pThis, pWti);
+        wtiTplCacheEnd(pWti);
+        wtiPropCacheEnd(pWti);
+        wtiFuncCacheEnd(pWti);
+
+        pthread_mutex_lock(&pThis->mut);
+        pThis->nHelpers--;
+        pthread_cond_broadcast(&pThis->condDone);
+    }
+    pthread_mutex_unlock(&pThis->mut);
+
+    wtiFreeActWrkrs(pWti);
+    return NULL;
+}
+
+
+rsRetVal batchpoolConstruct(batchpool_t **const ppThis, const int nWorkers) {
+    batchpool_t *pThis = NULL;
+    char name[32];
+    int i, r;
+    DEFiRet;
+
+    CHKmalloc(pThis = calloc(1, sizeof(batchpool_t)));
+    pthread_mutex_init(&pThis->mut, NULL);
+    pthread_cond_init(&pThis->condWork, NULL);
+    pthread_cond_init(&pThis->condDone, NULL);
+    CHKmalloc(pThis->wrkrs = calloc(nWorkers, sizeof(batchpoolWrkr_t)));
+    pThis->nWrkrs = nWorkers;
+    for (i = 0; i < nWorkers; ++i) {
+        pThis->wrkrs[i].pPool = pThis;
+        CHKiRet(wtiConstruct(&pThis->wrkrs[i].pWti));
+        snprintf(name, sizeof(name), "batchpool/w%d", i);
+        CHKiRet(wtiSetDbgHdr(pThis->wrkrs[i].pWti, (uchar *)name, strlen(name)));
+        CHKiRet(wtiConstructFinalize(pThis->wrkrs[i].pWti));
+        if ((r = pthread_create(&pThis->wrkrs[i].thrd, NULL, batchpoolWrkr, &pThis->wrkrs[i])) != 0) {
+            LogError(r, RS_RET_ERR, "script.parallel.workers: cannot create helper thread");
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+        pThis->wrkrs[i].bStarted = 1;
+    }
+    DBGPRINTF("batchpool: %d helper threads started\n", nWorkers);
+    *ppThis = pThis;
+
+finalize_it:
+    if (iRet != RS_RET_OK && pThis != NULL) batchpoolDestruct(&pThis);
+    RETiRet;
+}
+
+
+void batchpoolDestruct(batchpool_t **const ppThis) {
+    batchpool_t *const pThis = *ppThis;
+    int i;
+
+    pthread_mutex_lock(&pThis->mut);
+    pThis->bShutdown = 1;
+    pthread_cond_broadcast(&pThis->condWork);
+    pthread_mutex_unlock(&pThis->mut);
+    for (i = 0; pThis->wrkrs != NULL && i < pThis->nWrkrs; ++i) {
+        if (pThis->wrkrs[i].bStarted) pthread_join(pThis->wrkrs[i].thrd, NULL);
+        if (pThis->wrkrs[i].pWti != NULL) wtiDestruct(&pThis->wrkrs[i].pWti);
+    }
+    free(pThis->wrkrs);
+    pthread_cond_destroy(&pThis->condDone);
+    pthread_cond_destroy(&pThis->condWork);
+    pthread_mutex_destroy(&pThis->mut);
+    free(pThis);
+    *ppThis = NULL;
+}
+
+
+rsRetVal batchpoolRun(batchpool_t *const pThis,
+                      batch_t *const pBatch,
+                      const int chunkSize,
+                      batchpoolChunkFn_t fn,
+                      rsRetVal *const results,
+                      wti_t *const pWti) {
+    DEFiRet;
+
+    pthread_mutex_lock(&pThis->mut);
+    if (pThis->bBusy || pThis->bShutdown) {
+        pthread_mutex_unlock(&pThis->mut);
+        ABORT_FINALIZE(RS_RET_NO_RUN);
+    }
+    pThis->bBusy = 1;
+    pThis->seq++;
+    pThis->pBatch = pBatch;
+    pThis->chunkSize = chunkSize;
+    pThis->nChunks = (batchNumMsgs(pBatch) + chunkSize - 1) / chunkSize;
+    pThis->fn = fn;
+    pThis->results = results;
+    pThis->pbShutdownImmediate = pWti->pbShutdownImmediate;
+    pThis->nextChunk = 0;
+    pThis->nextCommit = 0;
+    pthread_cond_broadcast(&pThis->condWork);
+    pthread_mutex_unlock(&pThis->mut);
+
+    /* chunks must be committed in order, so the caller must not hold back its commits */
+    pWti->linger.bInhibit = 1;
+    runChunks(pThis, pWti);
+    pWti->linger.bInhibit = 0;
+
+    /* helpers may still be executing their last chunk */
+    pthread_mutex_lock(&pThis->mut);
+    while (pThis->nHelpers > 0 || pThis->nextCommit < pThis->nChunks)
+        pthread_cond_wait(&pThis->condDone, &pThis->mut);
+    pThis->bBusy = 0;
+    pthread_mutex_unlock(&pThis->mut);
+
+finalize_it:
+    RETiRet;
+}
@@ -0,0 +1,63 @@
+/* batchpool.h - parallel execution of a batch in chunks
+ *
+ * If enabled via the script.parallel.workers global parameter, a queue
+ * worker splits large batches into chunks of consecutive messages. These
+ * chunks are executed by the worker itself and a pool of helper threads,
+ * each one grabbing the next unprocessed chunk when it is done with its
+ * previous one. Each helper has its own wti, and thus its own action
+ * worker instances. After a chunk is executed, its direct-mode actions are
+ * committed, strictly in chunk order, so that each action sees the messages
+ * in the same order as if the batch had been executed by a single thread.
+ * As this only holds for transactional actions, the ruleset module uses the
+ * pool only for rulesets without other actions and queue hand-offs.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INCLUDED_BATCHPOOL_H
+#define INCLUDED_BATCHPOOL_H
+
+#include "batch.h"
+
+typedef struct batchpool_s batchpool_t;
+
+/* executes the batch elements first..first+n-1 and stores their results,
+ * like scriptExec() returns them, in results[]
+ */
+typedef void (*batchpoolChunkFn_t)(batch_t *pBatch, int first, int n, rsRetVal *results, wti_t *pWti);
+
+/** Create a pool with @p nWorkers helper threads and start them. */
+rsRetVal batchpoolConstruct(batchpool_t **ppThis, int nWorkers);
+
+/** Stop the helper threads and free their action worker instances. */
+void batchpoolDestruct(batchpool_t **ppThis);
+
+/**
+ * Execute @p pBatch in chunks of @p chunkSize messages, calling @p fn for
+ * each chunk. The calling worker takes part with @p pWti. Returns
+ * RS_RET_NO_RUN without doing anything if the pool is already working on a
+ * batch of another worker; the caller must then execute the batch itself.
+ */
+rsRetVal batchpoolRun(batchpool_t *pThis,
+                      batch_t *pBatch,
+                      int chunkSize,
+                      batchpoolChunkFn_t fn,
+                      rsRetVal *results,
+                      wti_t *pWti);
+
+#endif /* #ifndef INCLUDED_BATCHPOOL_H */
@@ -0,0 +1,242 @@
+/* bufwriter.c - buffered file writes done by a background thread
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "rsyslog.h"
+#include "errmsg.h"
+#include "bufwriter.h"
+
+struct bufwriterFile_s {
+    bufwriter_t *pWriter;
+    int fd;
+    char *pszName;
+    size_t maxBuffered;
+    char *buf; /* records appended, but not yet handed to the writer thread */
+    size_t len;
+    char *spare; /* buffer the writer thread currently writes from */
+    sbool bQueued; /* in the writer's queue? */
+    sbool bWriting; /* the writer thread works on this file right now */
+    bufwriterFile_t *pNextQueued;
+};
+
+struct bufwriter_s {
+    pthread_mutex_t mut; /* guards the writer and all its files */
+    pthread_cond_t condWork; /* a file was queued or we shut down */
+    pthread_cond_t condDone; /* the writer finished writing a buffer */
+    pthread_t thrd;
+    sbool bStarted;
+    sbool bShutdown;
+    bufwriterFile_t *pQueueRoot;
+    bufwriterFile_t *pQueueLast;
+};
+
+
+static void doWrite(bufwriterFile_t *const pFile, const char *buf, size_t len) {
+    ssize_t r;
+
+    while (len > 0) {
+        r = write(pFile->fd, buf, len);
+        if (r == -1 && errno == EINTR) continue;
+        if (r <= 0) {
+            LogError(errno, RS_RET_IO_ERROR, "error writing %s, %zu bytes lost", pFile->pszName, len);
+            return;
+        }
+        buf += r;
+        len -= r;
+    }
+}
+
+
+static void *bufwriterThrd(void *arg) {
+    bufwriter_t *const pThis = (bufwriter_t *)arg;
+    bufwriterFile_t *pFile;
+    char *buf;
+    size_t len;
+    sigset_t sigSet;
+
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+    dbgSetThrdName((uchar *)"bufwriter");
+
+    pthread_mutex_lock(&pThis->mut);
+    while (1) {
+        while (pThis->pQueueRoot == NULL && !pThis->bShutdown) pthread_cond_wait(&pThis->condWork, &pThis->mut);
+        if (pThis->pQueueRoot == NULL) break; /* shutdown, and all is written */
+        pFile = pThis->pQueueRoot;
+        pThis->pQueueRoot = pFile->pNextQueued;
+        if (pThis->pQueueRoot == NULL) pThis->pQueueLast = NULL;
+        pFile->bQueued = 0;
+
+        /* swap buffers, so that records can be appended while we write */
+        buf = pFile->buf;
+        len = pFile->len;
+        pFile->buf = pFile->spare;
+        pFile->spare = buf;
+        pFile->len = 0;
+        pFile->bWriting = 1;
+        pthread_mutex_unlock(&pThis->mut);
+
+        doWrite(pFile, buf, len);
+
+        pthread_mutex_lock(&pThis->mut);
+        pFile->bWriting = 0;
+        pthread_cond_broadcast(&pThis->condDone);
+    }
+    pthread_mutex_unlock(&pThis->mut);
+    return NULL;
+}
+
+
+rsRetVal bufwriterAppend(bufwriterFile_t *const pFile, const char *const data, const size_t len) {
+    bufwriter_t *const pThis = pFile->pWriter;
+    int r;
+    DEFiRet;
+
+    pthread_mutex_lock(&pThis->mut);
+    if (pFile->len + len > pFile->maxBuffered) {
+        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    }
+    if (pFile->buf == NULL) {
+        CHKmalloc(pFile->buf = malloc(pFile->maxBuffered));
+    }
+    memcpy(pFile->buf + pFile->len, data, len);
+    pFile->len += len;
+
+    if (!pFile->bQueued) {
+        pFile->bQueued = 1;
+        pFile->pNextQueued = NULL;
+        if (pThis->pQueueLast == NULL)
+            pThis->pQueueRoot = pFile;
+        else
+            pThis->pQueueLast->pNextQueued = pFile;
+        pThis->pQueueLast = pFile;
+        pthread_cond_signal(&pThis->condWork);
+    }
+
+    if (!pThis->bStarted) {
+        if ((r = pthread_create(&pThis->thrd, NULL, bufwriterThrd, pThis)) != 0) {
+            LogError(r, RS_RET_ERR, "cannot create buffered writer thread, writing %s synchronously", pFile->pszName);
+            /* we still hold the mutex, so nobody else touches the buffer */
+            doWrite(pFile, pFile->buf, pFile->len);
+            pFile->len = 0;
+            pThis->pQueueRoot = pThis->pQueueLast = NULL;
+            pFile->bQueued = 0;
+            FINALIZE;
+        }
+        pThis->bStarted = 1;
+    }
+
+finalize_it:
+    pthread_mutex_unlock(&pThis->mut);
+    RETiRet;
+}
+
+
+rsRetVal bufwriterFileConstruct(bufwriter_t *const pWriter,
+                                bufwriterFile_t **const ppFile,
+                                const int fd,
+                                const size_t maxBuffered,
+                                const char *const pszName) {
+    bufwriterFile_t *pFile = NULL;
+    DEFiRet;
+
+    CHKmalloc(pFile = calloc(1, sizeof(bufwriterFile_t)));
+    CHKmalloc(pFile->pszName = strdup(pszName));
+    CHKmalloc(pFile->spare = malloc(maxBuffered));
+    pFile->pWriter = pWriter;
+    pFile->fd = fd;
+    pFile->maxBuffered = maxBuffered;
+    *ppFile = pFile;
+
+finalize_it:
+    if (iRet != RS_RET_OK && pFile != NULL) {
+        free(pFile->pszName);
+        free(pFile);
+    }
+    RETiRet;
+}
+
+
+void bufwriterFileDestruct(bufwriterFile_t **const ppFile) {
+    bufwriterFile_t *const pFile = *ppFile;
+    bufwriter_t *const pThis = pFile->pWriter;
+    bufwriterFile_t *pPrev;
+
+    pthread_mutex_lock(&pThis->mut);
+    if (pFile->bQueued) {
+        if (pThis->pQueueRoot == pFile) {
+            pThis->pQueueRoot = pFile->pNextQueued;
+            pPrev = NULL;
+        } else {
+            for (pPrev = pThis->pQueueRoot; pPrev->pNextQueued != pFile; pPrev = pPrev->pNextQueued)
+                ;
+            pPrev->pNextQueued = pFile->pNextQueued;
+        }
+        if (pThis->pQueueLast == pFile) pThis->pQueueLast = pPrev;
+    }
+    while (pFile->bWriting) pthread_cond_wait(&pThis->condDone, &pThis->mut);
+    pthread_mutex_unlock(&pThis->mut);
+
+    doWrite(pFile, pFile->buf, pFile->len);
+    free(pFile->buf);
+    free(pFile->spare);
+    free(pFile->pszName);
+    free(pFile);
+    *ppFile = NULL;
+}
+
+
+rsRetVal bufwriterConstruct(bufwriter_t **const ppThis) {
+    bufwriter_t *pThis;
+    DEFiRet;
+
+    CHKmalloc(pThis = calloc(1, sizeof(bufwriter_t)));
+    pthread_mutex_init(&pThis->mut, NULL);
+    pthread_cond_init(&pThis->condWork, NULL);
+    pthread_cond_init(&pThis->condDone, NULL);
+    *ppThis = pThis;
+
+finalize_it:
+    RETiRet;
+}
+
+
+void bufwriterDestruct(bufwriter_t **const ppThis) {
+    bufwriter_t *const pThis = *ppThis;
+
+    pthread_mutex_lock(&pThis->mut);
+    pThis->bShutdown = 1;
+    pthread_cond_signal(&pThis->condWork);
+    pthread_mutex_unlock(&pThis->mut);
+    if (pThis->bStarted) pthread_join(pThis->thrd, NULL);
+    pthread_cond_destroy(&pThis->condDone);
+    pthread_cond_destroy(&pThis->condWork);
+    pthread_mutex_destroy(&pThis->mut);
+    free(pThis);
+    *ppThis = NULL;
+}
@@ -0,0 +1,60 @@
+/* bufwriter.h - buffered file writes done by a background thread
+ *
+ * Callers append records to a per-file buffer in memory and return
+ * immediately. A single writer thread, shared by all files, writes the
+ * buffered data with one write() per buffer swap. The memory per file is
+ * bounded; records that do not fit are dropped and the caller is told so.
+ * This is used for action.errorfile, so that a destination that rejects
+ * all messages does not slow down the workers to disk-write speed.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INCLUDED_BUFWRITER_H
+#define INCLUDED_BUFWRITER_H
+
+typedef struct bufwriter_s bufwriter_t;
+typedef struct bufwriterFile_s bufwriterFile_t;
+
+/** Create the writer; its thread is started when data is first appended. */
+rsRetVal bufwriterConstruct(bufwriter_t **ppThis);
+
+/** Stop the writer thread. All files must have been destructed before. */
+void bufwriterDestruct(bufwriter_t **ppThis);
+
+/**
+ * Create a buffered file for the already opened @p fd, holding at most
+ * @p maxBuffered bytes not yet written. @p pszName is used in error
+ * messages only. The fd remains owned by the caller.
+ */
+rsRetVal bufwriterFileConstruct(bufwriter_t *pWriter,
+                                bufwriterFile_t **ppFile,
+                                int fd,
+                                size_t maxBuffered,
+                                const char *pszName);
+
+/** Write what is still buffered, synchronously, and free the file object. */
+void bufwriterFileDestruct(bufwriterFile_t **ppFile);
+
+/**
+ * Append @p len bytes to the file's buffer. Returns RS_RET_OUT_OF_MEMORY
+ * without appending anything if they do not fit.
+ */
+rsRetVal bufwriterAppend(bufwriterFile_t *pFile, const char *data, size_t len);
+
+#endif /* #ifndef INCLUDED_BUFWRITER_H */
@@ -194,6 +194,16 @@ static struct cnfparamdescr cnfparamdescr[] = {
     {"reverselookup.cache.ttl.enable", eCmdHdlrBinary, 0},
     {"parser.supportcompressionextension", eCmdHdlrBinary, 0},
     {"shutdown.queue.doublesize", eCmdHdlrBinary, 0},
+    {"template.compile", eCmdHdlrBinary, 0},
+    {"script.compile", eCmdHdlrBinary, 0},
+    {"script.batcheval", eCmdHdlrBinary, 0},
+    {"script.regexengine", eCmdHdlrGetWord, 0},
+    {"script.memoize", eCmdHdlrBinary, 0},
+    {"script.profile", eCmdHdlrBinary, 0},
+    {"script.profile.samplerate", eCmdHdlrPositiveInt, 0},
+    {"script.profile.file", eCmdHdlrGetWord, 0},
+    {"script.parallel.workers", eCmdHdlrNonNegInt, 0},
+    {"script.parallel.chunksize", eCmdHdlrPositiveInt, 0},
     {"debug.files", eCmdHdlrArray, 0},
     {"debug.whitelist", eCmdHdlrBinary, 0},
     {"libcapng.default", eCmdHdlrBinary, 0},
@@ -668,6 +678,20 @@ static rsRetVal ATTR_NONNULL() setReportChildProcessExits(const uchar *const mod
     RETiRet;
 }
 
+static rsRetVal ATTR_NONNULL() setScriptRegexEngine(const uchar *const engine) {
+    DEFiRet;
+    if (!strcmp((char *)engine, "posix")) {
+        loadConf->globals.scriptRegexEngine = SCRIPT_REGEX_ENGINE_POSIX;
+    } else if (!strcmp((char *)engine, "dfa")) {
+        loadConf->globals.scriptRegexEngine = SCRIPT_REGEX_ENGINE_DFA;
+    } else {
+        LogError(0, RS_RET_CONF_PARAM_INVLD, "invalid value '%s' for global parameter script.regexEngine -- ignored",
+                 engine);
+        iRet = RS_RET_CONF_PARAM_INVLD;
+    }
+    RETiRet;
+}
+
 /** Convert enable/warn/disable config-format policy text to its internal enum. */
 static rsRetVal ATTR_NONNULL()
     setCompatConfigFormatMode(const char *const param, const uchar *const mode, int *const dst) {
@@ -1096,6 +1120,8 @@ static rsRetVal resetConfigVariables(uchar __attribute__((unused)) * pp, void __
     LocalHostNameOverride = NULL;
     free(loadConf->globals.oversizeMsgErrorFile);
     loadConf->globals.oversizeMsgErrorFile = NULL;
+    free(loadConf->globals.scriptProfileFile);
+    loadConf->globals.scriptProfileFile = NULL;
     loadConf->globals.oversizeMsgInputMode = glblOversizeMsgInputMode_Accept;
     loadConf->globals.reportChildProcessExits = REPORT_CHILD_PROCESS_EXITS_ERRORS;
     free(loadConf->globals.pszWorkDir);
@@ -1506,6 +1532,29 @@ rsRetVal glblDoneLoadCnf(void) {
             glblDbgWhitelist = (int)cnfparamvals[i].val.d.n;
         } else if (!strcmp(paramblk.descr[i].name, "shutdown.queue.doublesize")) {
             loadConf->globals.shutdownQueueDoubleSize = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "template.compile")) {
+            loadConf->globals.bTemplateCompile = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "script.compile")) {
+            loadConf->globals.bScriptCompile = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "script.batcheval")) {
+            loadConf->globals.bScriptBatchEval = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "script.regexengine")) {
+            const char *const tmp = es_str2cstr(cnfparamvals[i].val.d.estr, NULL);
+            setScriptRegexEngine((uchar *)tmp);
+            free((void *)tmp);
+        } else if (!strcmp(paramblk.descr[i].name, "script.memoize")) {
+            loadConf->globals.bScriptMemoize = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "script.profile")) {
+            loadConf->globals.bScriptProfile = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "script.profile.samplerate")) {
+            loadConf->globals.scriptProfileSampleRate = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "script.profile.file")) {
+            free(loadConf->globals.scriptProfileFile);
+            loadConf->globals.scriptProfileFile = (uchar *)es_str2cstr(cnfparamvals[i].val.d.estr, NULL);
+        } else if (!strcmp(paramblk.descr[i].name, "script.parallel.workers")) {
+            loadConf->globals.scriptParallelWorkers = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "script.parallel.chunksize")) {
+            loadConf->globals.scriptParallelChunkSize = (int)cnfparamvals[i].val.d.n;
         } else if (!strcmp(paramblk.descr[i].name, "umask")) {
             loadConf->globals.umask = (int)cnfparamvals[i].val.d.n;
         } else if (!strcmp(paramblk.descr[i].name, "shutdown.enable.ctlc")) {
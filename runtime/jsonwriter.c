@@ -0,0 +1,257 @@
+/* jsonwriter.c - streaming JSON writer
+ *
+ * See jsonwriter.h for a description of the interface.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "rsyslog.h"
+#include "jsonwriter.h"
+#include "strscan.h"
+
+static const char hexdigit[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+
+/* make sure at least "needed" more bytes (plus the final NUL) fit */
+static rsRetVal ATTR_NONNULL() jsonWriterReserve(jsonWriter_t *const w, const size_t needed) {
+    size_t newSize;
+    uchar *newBuf;
+    DEFiRet;
+
+    if (w->len + needed + 1 <= w->buf->lenBuf) FINALIZE;
+    newSize = (w->buf->lenBuf == 0) ? 128 : w->buf->lenBuf;
+    while (newSize < w->len + needed + 1) newSize *= 2;
+    if (newSize > UINT32_MAX) ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    CHKmalloc(newBuf = realloc(w->buf->param, newSize));
+    w->buf->param = newBuf;
+    w->buf->lenBuf = (uint32_t)newSize;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* emit a separator if the current item is not the first on its level */
+static rsRetVal ATTR_NONNULL() jsonWriterBeginItem(jsonWriter_t *const w) {
+    DEFiRet;
+    if (w->bAfterKey) {
+        w->bAfterKey = 0;
+        FINALIZE;
+    }
+    if (w->needSep[w->depth]) {
+        CHKiRet(jsonWriterAppend(w, w->sep, w->lenSep));
+    }
+    w->needSep[w->depth] = 1;
+finalize_it:
+    RETiRet;
+}
+
+
+static rsRetVal ATTR_NONNULL() jsonWriterOpen(jsonWriter_t *const w, const char c) {
+    DEFiRet;
+    if (w->depth >= JSONWRITER_MAX_DEPTH) ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    CHKiRet(jsonWriterBeginItem(w));
+    CHKiRet(jsonWriterAppend(w, &c, 1));
+    ++w->depth;
+    w->needSep[w->depth] = 0;
+finalize_it:
+    RETiRet;
+}
+
+
+static rsRetVal ATTR_NONNULL() jsonWriterClose(jsonWriter_t *const w, const char c) {
+    DEFiRet;
+    if (w->depth == 0 || w->bAfterKey) ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    --w->depth;
+    CHKiRet(jsonWriterAppend(w, &c, 1));
+finalize_it:
+    RETiRet;
+}
+
+
+/* write the escaped string body (without quotes). Runs of characters that
+ * need no escaping are located with the vectorized scanner and copied in
+ * one go.
+ */
+static rsRetVal ATTR_NONNULL() jsonWriterEscaped(jsonWriter_t *const w, const uchar *val, size_t len) {
+    uchar *dst;
+    DEFiRet;
+
+    while (len > 0) {
+        const size_t run = rsStrScanJSONEscape(val, len);
+        CHKiRet(jsonWriterAppend(w, (const char *)val, run));
+        val += run;
+        len -= run;
+        if (len == 0) break;
+        CHKiRet(jsonWriterReserve(w, 6));
+        dst = w->buf->param + w->len;
+        *dst++ = '\\';
+        switch (*val) {
+            case '"':
+            case '\\':
+            case '/':
+                *dst++ = *val;
+                break;
+            case '\b':
+                *dst++ = 'b';
+                break;
+            case '\f':
+                *dst++ = 'f';
+                break;
+            case '\n':
+                *dst++ = 'n';
+                break;
+            case '\r':
+                *dst++ = 'r';
+                break;
+            case '\t':
+                *dst++ = 't';
+                break;
+            default:
+                *dst++ = 'u';
+                *dst++ = '0';
+                *dst++ = '0';
+                *dst++ = hexdigit[*val >> 4];
+                *dst++ = hexdigit[*val & 0x0f];
+                break;
+        }
+        w->len = (size_t)(dst - w->buf->param);
+        ++val;
+        --len;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+void jsonWriterInit(jsonWriter_t *const w, actWrkrIParams_t *const buf, const size_t offs, const char *const sep) {
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->len = offs;
+    w->sep = (sep == NULL) ? "," : sep;
+    w->lenSep = strlen(w->sep);
+}
+
+
+rsRetVal jsonWriterAppend(jsonWriter_t *const w, const char *const data, const size_t len) {
+    DEFiRet;
+    if (len == 0) FINALIZE;
+    CHKiRet(jsonWriterReserve(w, len));
+    memcpy(w->buf->param + w->len, data, len);
+    w->len += len;
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal jsonWriterBeginObject(jsonWriter_t *const w) {
+    return jsonWriterOpen(w, '{');
+}
+
+
+rsRetVal jsonWriterEndObject(jsonWriter_t *const w) {
+    return jsonWriterClose(w, '}');
+}
+
+
+rsRetVal jsonWriterBeginArray(jsonWriter_t *const w) {
+    return jsonWriterOpen(w, '[');
+}
+
+
+rsRetVal jsonWriterEndArray(jsonWriter_t *const w) {
+    return jsonWriterClose(w, ']');
+}
+
+
+static rsRetVal jsonWriterDoKey(jsonWriter_t *const w, const uchar *const name, const size_t len, const int bEscape) {
+    DEFiRet;
+    if (w->bAfterKey) ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    CHKiRet(jsonWriterBeginItem(w));
+    CHKiRet(jsonWriterAppend(w, "\"", 1));
+    if (bEscape) {
+        CHKiRet(jsonWriterEscaped(w, name, len));
+    } else {
+        CHKiRet(jsonWriterAppend(w, (const char *)name, len));
+    }
+    CHKiRet(jsonWriterAppend(w, "\":", 2));
+    w->bAfterKey = 1;
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal jsonWriterKey(jsonWriter_t *const w, const uchar *const name, const size_t len) {
+    return jsonWriterDoKey(w, name, len, 1);
+}
+
+
+rsRetVal jsonWriterKeyRaw(jsonWriter_t *const w, const uchar *const name, const size_t len) {
+    return jsonWriterDoKey(w, name, len, 0);
+}
+
+
+rsRetVal jsonWriterString(jsonWriter_t *const w, const uchar *const val, const size_t len) {
+    DEFiRet;
+    CHKiRet(jsonWriterBeginItem(w));
+    CHKiRet(jsonWriterAppend(w, "\"", 1));
+    CHKiRet(jsonWriterEscaped(w, val, len));
+    CHKiRet(jsonWriterAppend(w, "\"", 1));
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal jsonWriterRaw(jsonWriter_t *const w, const uchar *const val, const size_t len) {
+    DEFiRet;
+    CHKiRet(jsonWriterBeginItem(w));
+    CHKiRet(jsonWriterAppend(w, (const char *)val, len));
+finalize_it:
+    RETiRet;
+}
+
+
+void jsonWriterMark(const jsonWriter_t *const w, jsonWriterMark_t *const m) {
+    m->len = w->len;
+    m->depth = w->depth;
+    m->bAfterKey = w->bAfterKey;
+    m->needSep = w->needSep[w->depth];
+}
+
+
+void jsonWriterRollback(jsonWriter_t *const w, const jsonWriterMark_t *const m) {
+    w->len = m->len;
+    w->depth = m->depth;
+    w->bAfterKey = m->bAfterKey;
+    w->needSep[w->depth] = m->needSep;
+}
+
+
+rsRetVal jsonWriterFinish(jsonWriter_t *const w) {
+    DEFiRet;
+    CHKiRet(jsonWriterReserve(w, 0));
+    w->buf->param[w->len] = '\0';
+    w->buf->lenStr = (uint32_t)w->len;
+finalize_it:
+    RETiRet;
+}
@@ -0,0 +1,98 @@
+/* jsonwriter.h - streaming JSON writer
+ *
+ * A small writer that renders JSON text straight into a growable output
+ * buffer, without building a json_object tree first. It keeps track of
+ * nesting and member separators and does string escaping. Output modules
+ * that assemble JSON documents per message (bulk requests and similar) can
+ * use it instead of creating and serializing libfastjson objects.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INCLUDED_JSONWRITER_H
+#define INCLUDED_JSONWRITER_H
+
+#include <stddef.h>
+
+/** Maximum nesting depth of objects and arrays. */
+#define JSONWRITER_MAX_DEPTH 64
+
+/**
+ * @struct jsonWriter_s
+ * @brief State of a streaming JSON writer.
+ *
+ * The output is written to an actWrkrIParams_t buffer owned by the caller,
+ * which is grown as required. This permits to render directly into the
+ * template work buffers of action workers.
+ */
+typedef struct jsonWriter_s {
+    actWrkrIParams_t *buf; /**< output buffer, grown via realloc() */
+    size_t len; /**< bytes written so far */
+    const char *sep; /**< separator between members, e.g. "," or ", " */
+    size_t lenSep;
+    int depth; /**< current nesting level, 0 is top level */
+    sbool bAfterKey; /**< a key was written, next item is its value */
+    sbool needSep[JSONWRITER_MAX_DEPTH + 1]; /**< per level: separator needed before next item */
+} jsonWriter_t;
+
+/**
+ * @brief Saved writer position, see jsonWriterMark() and jsonWriterRollback().
+ */
+typedef struct jsonWriterMark_s {
+    size_t len;
+    int depth;
+    sbool bAfterKey;
+    sbool needSep;
+} jsonWriterMark_t;
+
+/**
+ * Initialize @p w to append to @p buf, starting at offset @p offs.
+ * @p sep is used between members and array elements; NULL means ",".
+ */
+void jsonWriterInit(jsonWriter_t *w, actWrkrIParams_t *buf, size_t offs, const char *sep);
+
+/** Append raw bytes without any separator handling (e.g. whitespace or a trailer). */
+rsRetVal jsonWriterAppend(jsonWriter_t *w, const char *data, size_t len);
+
+rsRetVal jsonWriterBeginObject(jsonWriter_t *w);
+rsRetVal jsonWriterEndObject(jsonWriter_t *w);
+rsRetVal jsonWriterBeginArray(jsonWriter_t *w);
+rsRetVal jsonWriterEndArray(jsonWriter_t *w);
+
+/** Write the escaped member name @p name followed by a colon. */
+rsRetVal jsonWriterKey(jsonWriter_t *w, const uchar *name, size_t len);
+
+/** Like jsonWriterKey(), but write @p name verbatim (it must not need escaping). */
+rsRetVal jsonWriterKeyRaw(jsonWriter_t *w, const uchar *name, size_t len);
+
+/** Write @p val as escaped and quoted JSON string. */
+rsRetVal jsonWriterString(jsonWriter_t *w, const uchar *val, size_t len);
+
+/** Write @p val verbatim as value; it must already be valid JSON. */
+rsRetVal jsonWriterRaw(jsonWriter_t *w, const uchar *val, size_t len);
+
+/** Remember the current position, e.g. to drop an object that remains empty. */
+void jsonWriterMark(const jsonWriter_t *w, jsonWriterMark_t *m);
+
+/** Discard everything written since @p m was taken. */
+void jsonWriterRollback(jsonWriter_t *w, const jsonWriterMark_t *m);
+
+/** NUL-terminate the output and store its length in the buffer's lenStr. */
+rsRetVal jsonWriterFinish(jsonWriter_t *w);
+
+#endif /* #ifndef INCLUDED_JSONWRITER_H */
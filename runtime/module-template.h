@@ -245,6 +245,30 @@
     RETiRet;                 \
     }
 
+/* submitTransaction()
+ * Optional asynchronous variant of commitTransaction(), used if the action
+ * is configured with action.async.maxInFlight > 1. The module hands the
+ * messages to its backend and returns without waiting for the result. Once
+ * the backend has committed the messages, or failed to, the module must
+ * call actionAsyncTxDone(pTx, status) exactly once, from any thread. The
+ * messages in pParams remain valid until then. If submitTransaction()
+ * returns anything but RS_RET_OK, the messages were not accepted and
+ * actionAsyncTxDone() must not be called. Messages whose status is not
+ * RS_RET_OK are retried via commitTransaction(), which must be provided as
+ * well. Needs CORE_FEATURE_ASYNC_COMMIT.
+ */
+#define BEGINsubmitTransaction                                                                     \
+    static rsRetVal submitTransaction(wrkrInstanceData_t __attribute__((unused)) *const pWrkrData, \
+                                      actWrkrIParams_t *const pParams, const unsigned nParams,     \
+                                      actAsyncTx_t *const pTx) {                                   \
+        DEFiRet;
+
+#define CODESTARTsubmitTransaction /* currently empty, but may be extended */
+
+#define ENDsubmitTransaction \
+    RETiRet;                 \
+    }
+
 /* endTransaction()
  * introduced in v4.3.3 -- rgerhards, 2009-04-27
  */
@@ -611,6 +635,14 @@
         *pEtryPoint = endTransaction;                \
     }
 
+/**
+ * \brief For output modules with asynchronous commits, see submitTransaction().
+ */
+#define CODEqueryEtryPt_TXIF_ASYNC_OMOD_QUERIES       \
+    if (!strcmp((char *)name, "submitTransaction")) { \
+        *pEtryPoint = submitTransaction;              \
+    }
+
 /**
  * \brief Optional support for feature compatibility query.
  */
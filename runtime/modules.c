@@ -247,7 +247,7 @@ static rsRetVal queryCoreFeatureSupport(int *pBool, unsigned uFeat) {
 
     if (pBool == NULL) ABORT_FINALIZE(RS_RET_PARAM_ERROR);
 
-    *pBool = (uFeat & CORE_FEATURE_BATCHING) ? 1 : 0;
+    *pBool = (uFeat & (CORE_FEATURE_BATCHING | CORE_FEATURE_ASYNC_COMMIT)) ? 1 : 0;
 
 finalize_it:
     RETiRet;
@@ -653,6 +653,22 @@ static rsRetVal doModInit(pModInit_t modInit, uchar *name, void *pModHdlr, modIn
                 ABORT_FINALIZE(localRet);
             }
 
+            localRet = (*pNew->modQueryEtryPt)((uchar *)"submitTransaction", &pNew->mod.om.submitTransaction);
+            if (localRet == RS_RET_MODULE_ENTRY_POINT_NOT_FOUND) {
+                pNew->mod.om.submitTransaction = NULL;
+            } else if (localRet != RS_RET_OK) {
+                ABORT_FINALIZE(localRet);
+            }
+
+            if (pNew->mod.om.submitTransaction != NULL && pNew->mod.om.commitTransaction == NULL) {
+                LogError(0, RS_RET_INVLD_OMOD,
+                         "module %s provides submitTransaction() but "
+                         "not commitTransaction() - asynchronous commits "
+                         "disabled",
+                         name);
+                pNew->mod.om.submitTransaction = NULL;
+            }
+
             if (pNew->mod.om.doAction == NULL && pNew->mod.om.commitTransaction == NULL) {
                 LogError(0, RS_RET_INVLD_OMOD,
                          "module %s does neither provide doAction() "
@@ -744,7 +760,7 @@ static rsRetVal doModInit(pModInit_t modInit, uchar *name, void *pModHdlr, modIn
             struct scriptFunct *functArray;
             pNew->mod.fm.getFunctArray(&version, &functArray);
             dbgprintf("LLL: %s\n", functArray[0].fname);
-            addMod2List(version, functArray);
+            CHKiRet(addMod2List(version, functArray));
             break;
         case eMOD_ANY: /* this is mostly to keep the compiler happy! */
             DBGPRINTF("PROGRAM ERROR: eMOD_ANY set as module type\n");
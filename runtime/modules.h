@@ -137,6 +137,7 @@ struct modInfo_s {
              */
             rsRetVal (*beginTransaction)(void *);
             rsRetVal (*commitTransaction)(void *const, actWrkrIParams_t *const, const unsigned);
+            rsRetVal (*submitTransaction)(void *const, actWrkrIParams_t *const, const unsigned, actAsyncTx_t *const);
             rsRetVal (*doAction)(void **params, void *pWrkrData);
             rsRetVal (*endTransaction)(void *);
             rsRetVal (*parseSelectorAct)(uchar **, void **, omodStringRequest_t **);
@@ -67,6 +67,7 @@
 #include "rsconf.h"
 #include "parserif.h"
 #include "errmsg.h"
+#include "strscan.h"
 
 #define DEV_DEBUG 0 /* set to 1 to enable very verbose developer debugging messages */
 
@@ -3034,6 +3035,40 @@ finalize_it:
 }
 
 
+/* like msgGetJSONPropJSON(), but returns a new reference to the object
+ * inside the message instead of a copy. The caller must ensure that the
+ * object is not modified while it uses it, so this must not be used for
+ * global variables.
+ */
+rsRetVal msgGetJSONPropJSONRef(smsg_t *const pMsg, msgPropDescr_t *pProp, struct json_object **pjson) {
+    struct json_object **jroot;
+    uchar *leaf;
+    struct json_object *parent;
+    pthread_mutex_t *mut = NULL;
+    DEFiRet;
+
+    *pjson = NULL;
+
+    CHKiRet(getJSONRootAndMutex(pMsg, pProp->id, &jroot, &mut));
+    pthread_mutex_lock(mut);
+
+    if (!strcmp((char *)pProp->name, "!")) {
+        *pjson = *jroot;
+        FINALIZE;
+    }
+    leaf = jsonPathGetLeaf(pProp->name, pProp->nameLen);
+    CHKiRet(jsonPathFindParent(*jroot, pProp->name, leaf, &parent, 0));
+    if (jsonVarExtract(parent, (char *)leaf, pjson) == FALSE) {
+        ABORT_FINALIZE(RS_RET_NOT_FOUND);
+    }
+
+finalize_it:
+    if (*pjson != NULL) json_object_get(*pjson);
+    if (mut != NULL) pthread_mutex_unlock(mut);
+    RETiRet;
+}
+
+
 /* Helper for jsonAddVal(), to be called onces we know there are actually
  * json escapes inside the string. If so, this function takes over.
  * Splitting the functions permits us to make some performance optimizations.
@@ -3072,11 +3107,15 @@ static rsRetVal ATTR_NONNULL(1, 4) jsonAddVal_escaped(uchar *const pSrc,
     memcpy(dst_w, pSrc, len_none_escaped_head);
     dst_w += len_none_escaped_head;
 
-    /* now do the escaping */
+    /* now do the escaping. Runs of characters that do not need escaping
+     * are located by the vectorized scanner and copied in bulk.
+     */
     for (i = len_none_escaped_head; i < buflen; ++i) {
+        const size_t run = rsStrScanJSONEscape(pSrc + i, buflen - i);
         const size_t dst_offset = dst_w - dst_base;
-        if (dst_offset >= dst_realloc_size) {
-            const size_t new_size = 2 * dst_size;
+        if (dst_offset + run >= dst_realloc_size) {
+            size_t new_size = 2 * dst_size;
+            while (dst_offset + run >= new_size - 10) new_size *= 2;
             if (dst_base == wrkbuf) {
                 CHKmalloc(newbuf = malloc(new_size));
                 memcpy(newbuf, dst_base, dst_offset);
@@ -3088,83 +3127,81 @@ static rsRetVal ATTR_NONNULL(1, 4) jsonAddVal_escaped(uchar *const pSrc,
             dst_base = newbuf;
             dst_w = dst_base + dst_offset;
         }
+        memcpy(dst_w, pSrc + i, run);
+        dst_w += run;
+        i += run;
+        if (i == buflen) break;
         c = pSrc[i];
-        if ((c >= 0x30 && c <= 0x5b) || (c >= 0x23 && c <= 0x2e) || (c >= 0x5d /* && c <= 0x10FFFF*/) || c == 0x20 ||
-            c == 0x21) {
-            /* no need to escape */
-            *dst_w++ = c;
-        } else {
-            /* we must escape, try RFC4627-defined special sequences first */
-            switch (c) {
-                case '\0':
-                    *dst_w++ = '\\';
-                    *dst_w++ = 'u';
-                    *dst_w++ = '0';
-                    *dst_w++ = '0';
-                    *dst_w++ = '0';
-                    *dst_w++ = '0';
-                    break;
-                case '\"':
-                    *dst_w++ = '\\';
-                    *dst_w++ = '"';
-                    break;
-                case '/':
-                    *dst_w++ = '\\';
-                    *dst_w++ = '/';
-                    break;
-                case '\\':
-                    if (escapeAll == RSFALSE) {
-                        ni = i + 1;
-                        if (ni <= buflen) {
-                            nc = pSrc[ni];
-
-                            /* Attempt to not double encode */
-                            if (nc == '"' || nc == '/' || nc == '\\' || nc == 'b' || nc == 'f' || nc == 'n' ||
-                                nc == 'r' || nc == 't' || nc == 'u') {
-                                *dst_w++ = c;
-                                *dst_w++ = nc;
-                                i = ni;
-                                break;
-                            }
+        /* we must escape, try RFC4627-defined special sequences first */
+        switch (c) {
+            case '\0':
+                *dst_w++ = '\\';
+                *dst_w++ = 'u';
+                *dst_w++ = '0';
+                *dst_w++ = '0';
+                *dst_w++ = '0';
+                *dst_w++ = '0';
+                break;
+            case '\"':
+                *dst_w++ = '\\';
+                *dst_w++ = '"';
+                break;
+            case '/':
+                *dst_w++ = '\\';
+                *dst_w++ = '/';
+                break;
+            case '\\':
+                if (escapeAll == RSFALSE) {
+                    ni = i + 1;
+                    if (ni <= buflen) {
+                        nc = pSrc[ni];
+
+                        /* Attempt to not double encode */
+                        if (nc == '"' || nc == '/' || nc == '\\' || nc == 'b' || nc == 'f' || nc == 'n' ||
+                            nc == 'r' || nc == 't' || nc == 'u') {
+                            *dst_w++ = c;
+                            *dst_w++ = nc;
+                            i = ni;
+                            break;
                         }
                     }
-                    *dst_w++ = '\\';
-                    *dst_w++ = '\\';
-                    break;
-                case '\010':
-                    *dst_w++ = '\\';
-                    *dst_w++ = 'b';
-                    break;
-                case '\014':
-                    *dst_w++ = '\\';
-                    *dst_w++ = 'f';
-                    break;
-                case '\n':
-                    *dst_w++ = '\\';
-                    *dst_w++ = 'n';
-                    break;
-                case '\r':
-                    *dst_w++ = '\\';
-                    *dst_w++ = 'r';
-                    break;
-                case '\t':
-                    *dst_w++ = '\\';
-                    *dst_w++ = 't';
-                    break;
-                default:
-                    /* TODO : proper Unicode encoding (see header comment) */
-                    for (j = 0; j < 4; ++j) {
-                        numbuf[3 - j] = hexdigit[c % 16];
-                        c = c / 16;
-                    }
-                    *dst_w++ = '\\';
-                    *dst_w++ = 'u';
-                    *dst_w++ = numbuf[0];
-                    *dst_w++ = numbuf[1];
-                    *dst_w++ = numbuf[2];
-                    *dst_w++ = numbuf[3];
-                    break;
-            }
+                }
+                *dst_w++ = '\\';
+                *dst_w++ = '\\';
+                break;
+            case '\010':
+                *dst_w++ = '\\';
+                *dst_w++ = 'b';
+                break;
+            case '\014':
+                *dst_w++ = '\\';
+                *dst_w++ = 'f';
+                break;
+            case '\n':
+                *dst_w++ = '\\';
+                *dst_w++ = 'n';
+                break;
+            case '\r':
+                *dst_w++ = '\\';
+                *dst_w++ = 'r';
+                break;
+            case '\t':
+                *dst_w++ = '\\';
+                *dst_w++ = 't';
+                break;
+            default:
+                /* TODO : proper Unicode encoding (see header comment) */
+                for (j = 0; j < 4; ++j) {
+                    numbuf[3 - j] = hexdigit[c % 16];
+                    c = c / 16;
+                }
+                *dst_w++ = '\\';
+                *dst_w++ = 'u';
+                *dst_w++ = numbuf[0];
+                *dst_w++ = numbuf[1];
+                *dst_w++ = numbuf[2];
+                *dst_w++ = numbuf[3];
+                break;
         }
     }
     if (*dst == NULL) {
@@ -3190,13 +3227,10 @@ static rsRetVal ATTR_NONNULL(1, 3)
     es_size_t i;
     DEFiRet;
 
-    for (i = 0; i < buflen; ++i) {
-        const uchar c = pSrc[i];
-        if (!((c >= 0x30 && c <= 0x5b) || (c >= 0x23 && c <= 0x2e) || (c >= 0x5d /* && c <= 0x10FFFF*/) || c == 0x20 ||
-              c == 0x21)) {
-            iRet = jsonAddVal_escaped(pSrc, buflen, i, dst, escapeAll);
-            FINALIZE;
-        }
+    i = rsStrScanJSONEscape(pSrc, buflen);
+    if (i < buflen) {
+        iRet = jsonAddVal_escaped(pSrc, buflen, i, dst, escapeAll);
+        FINALIZE;
     }
     if (*dst != NULL) {
         es_addBuf(dst, (const char *)pSrc, buflen);
@@ -254,6 +254,7 @@ rsRetVal propNameToID(const uchar *pName, propid_t *pPropID);
 uchar *propIDToName(propid_t propID);
 rsRetVal ATTR_NONNULL() msgCheckVarExists(smsg_t *const pMsg, msgPropDescr_t *pProp);
 rsRetVal msgGetJSONPropJSON(smsg_t *pMsg, msgPropDescr_t *pProp, struct json_object **pjson);
+rsRetVal msgGetJSONPropJSONRef(smsg_t *pMsg, msgPropDescr_t *pProp, struct json_object **pjson);
 rsRetVal msgGetJSONPropJSONorString(smsg_t *const pMsg,
                                     msgPropDescr_t *pProp,
                                     struct json_object **pjson,
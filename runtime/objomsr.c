@@ -140,7 +140,8 @@ int OMSRgetEntry(omodStringRequest_t *pThis, int iEntry, uchar **ppTplName, int
 rsRetVal OMSRgetSupportedTplOpts(unsigned long *pOpts) {
     DEFiRet;
     assert(pOpts != NULL);
-    *pOpts = OMSR_RQD_TPL_OPT_SQL | OMSR_TPL_AS_ARRAY | OMSR_TPL_AS_MSG | OMSR_TPL_AS_JSON | OMSR_TPL_AS_DYNAFILE;
+    *pOpts = OMSR_RQD_TPL_OPT_SQL | OMSR_TPL_AS_ARRAY | OMSR_TPL_AS_MSG | OMSR_TPL_AS_JSON | OMSR_TPL_AS_DYNAFILE |
+             OMSR_TPL_AS_IOV;
     RETiRet;
 }
 
@@ -291,9 +291,22 @@ static struct cnfparamdescr cnfpdescr[] = {{"queue.filename", eCmdHdlrGetWord, 0
                                            {"queue.cry.provider", eCmdHdlrGetWord, 0},
                                            {"queue.samplinginterval", eCmdHdlrInt, 0},
                                            {"queue.takeflowctlfrommsg", eCmdHdlrBinary, 0},
-                                           {"queue.oncorruption", eCmdHdlrGetWord, 0}};
+                                           {"queue.oncorruption", eCmdHdlrGetWord, 0},
+                                           {"queue.timing", eCmdHdlrBinary, 0},
+                                           {"queue.timing.samplinginterval", eCmdHdlrPositiveInt, 0}};
 static struct cnfparamblk pblk = {CNFPARAMBLK_VERSION, sizeof(cnfpdescr) / sizeof(struct cnfparamdescr), cnfpdescr};
 
+/* queue.timing: add the time since the worker's current phase began to
+ * counter ctr, extrapolated to all batches, and begin the next phase
+ */
+#define TIMING_PHASE_DONE(pThis, pWti, ctr, mut)                                                 \
+    do {                                                                                         \
+        const uint64_t tNow_ = wtiTimingNow();                                                   \
+        STATSCOUNTER_ADD((pThis)->ctr, (pThis)->mut,                                             \
+                         (tNow_ - (pWti)->timing.tPhase) * (pThis)->iTimingSmpInterval);         \
+        (pWti)->timing.tPhase = tNow_;                                                           \
+    } while (0)
+
 /* support to detect duplicate queue file names */
 struct queue_filename {
     struct queue_filename *next;
@@ -481,6 +494,8 @@ void qqueueDbgPrint(qqueue_t *pThis) {
     dbgoprint((obj_t *)pThis, "queue.dequeueslowdown: %d\n", pThis->iDeqSlowdown);
     dbgoprint((obj_t *)pThis, "queue.dequeuetimebegin: %d\n", pThis->iDeqtWinFromHr);
     dbgoprint((obj_t *)pThis, "queue.dequeuetimeend: %d\n", pThis->iDeqtWinToHr);
+    dbgoprint((obj_t *)pThis, "queue.timing: %d\n", pThis->bTiming);
+    dbgoprint((obj_t *)pThis, "queue.timing.samplinginterval: %d\n", pThis->iTimingSmpInterval);
 }
 
 
@@ -2328,6 +2343,8 @@ void qqueueSetDefaultsActionQueue(qqueue_t *pThis) {
     pThis->iDeqtWinFromHr = 0;
     pThis->iDeqtWinToHr = 25; /* disable time-windowed dequeuing by default */
     pThis->iSmpInterval = 0; /* disable sampling */
+    pThis->bTiming = 0;
+    pThis->iTimingSmpInterval = 1;
     pThis->onCorruption = QUEUE_ON_CORRUPTION_SAFE_MODE;
 }
 
@@ -2360,6 +2377,8 @@ void qqueueSetDefaultsRulesetQueue(qqueue_t *pThis) {
     pThis->iDeqtWinFromHr = 0;
     pThis->iDeqtWinToHr = 25; /* disable time-windowed dequeuing by default */
     pThis->iSmpInterval = 0; /* disable sampling */
+    pThis->bTiming = 0;
+    pThis->iTimingSmpInterval = 1;
     pThis->onCorruption = QUEUE_ON_CORRUPTION_SAFE_MODE;
 }
 
@@ -2694,6 +2713,7 @@ static rsRetVal ATTR_NONNULL() DequeueConsumableElements(qqueue_t *const pThis,
 
     nDeleted = pWti->batch.nElemDeq;
     DeleteProcessedBatch(pThis, &pWti->batch);
+    if (pWti->timing.bActive) TIMING_PHASE_DONE(pThis, pWti, ctrTimeDelete, mutCtrTimeDelete);
 
     nDequeued = nDiscarded = 0;
     if (pThis->qType == QUEUETYPE_DISK) {
@@ -3141,6 +3161,39 @@ static rsRetVal batchProcessed(qqueue_t *pThis, wti_t *pWti) {
 }
 
 
+/* queue.timing: a worker begins a new batch. Adds the time the worker was
+ * idle and decides if this batch is timed.
+ */
+static void ATTR_NONNULL() queueTimingBegin(qqueue_t *const pThis, wti_t *const pWti) {
+    pWti->timing.bEnabled = 1;
+    if (pWti->timing.idle > 0) {
+        STATSCOUNTER_ADD(pThis->ctrTimeIdle, pThis->mutCtrTimeIdle, pWti->timing.idle);
+        pWti->timing.idle = 0;
+    }
+    if (++pWti->timing.nBatches >= pThis->iTimingSmpInterval) {
+        pWti->timing.nBatches = 0;
+        pWti->timing.bActive = 1;
+        pWti->timing.render = 0;
+        pWti->timing.output = 0;
+        pWti->timing.tPhase = wtiTimingNow();
+    }
+}
+
+
+/* queue.timing: the consumer is done with a timed batch. Everything it did
+ * besides rendering templates and calling output modules is rule processing.
+ */
+static void ATTR_NONNULL() queueTimingEnd(qqueue_t *const pThis, wti_t *const pWti) {
+    const uint64_t elapsed = wtiTimingNow() - pWti->timing.tPhase;
+    const uint64_t inActions = pWti->timing.render + pWti->timing.output;
+    const int n = pThis->iTimingSmpInterval;
+
+    STATSCOUNTER_ADD(pThis->ctrTimeRules, pThis->mutCtrTimeRules, (elapsed > inActions ? elapsed - inActions : 0) * n);
+    STATSCOUNTER_ADD(pThis->ctrTimeRender, pThis->mutCtrTimeRender, pWti->timing.render * n);
+    STATSCOUNTER_ADD(pThis->ctrTimeOutput, pThis->mutCtrTimeOutput, pWti->timing.output * n);
+}
+
+
 /* This is the queue consumer in the regular (non-DA) case. It is
  * protected by the queue mutex, but MUST release it as soon as possible.
  * rgerhards, 2008-01-21
@@ -3155,7 +3208,9 @@ static rsRetVal ConsumerReg(qqueue_t *pThis, wti_t *pWti) {
     ISOBJ_TYPE_assert(pThis, qqueue);
     ISOBJ_TYPE_assert(pWti, wti);
 
+    if (pThis->bTiming) queueTimingBegin(pThis, pWti);
     iRet = DequeueForConsumer(pThis, pWti, &skippedMsgs);
+    if (pWti->timing.bActive) TIMING_PHASE_DONE(pThis, pWti, ctrTimeDequeue, mutCtrTimeDequeue);
     if (iRet == RS_RET_FILE_NOT_FOUND) {
         /* This is a fatal condition and means the queue is almost unusable */
         d_pthread_mutex_unlock(pThis->mut);
@@ -3187,6 +3242,7 @@ static rsRetVal ConsumerReg(qqueue_t *pThis, wti_t *pWti) {
 
     pWti->pbShutdownImmediate = &pThis->bShutdownImmediate;
     CHKiRet(pThis->pConsumer(pThis->pAction, &pWti->batch, pWti));
+    if (pWti->timing.bActive) queueTimingEnd(pThis, pWti);
 
     /* we now need to check if we should deliberately delay processing a bit
      * and, if so, do that. -- rgerhards, 2008-01-30
@@ -3200,6 +3256,7 @@ static rsRetVal ConsumerReg(qqueue_t *pThis, wti_t *pWti) {
     pthread_setcancelstate(iCancelStateSave, NULL);
 
 finalize_it:
+    pWti->timing.bActive = 0;
     DBGPRINTF("regular consumer finished, iret=%d, szlog %d sz phys %d\n", iRet, getLogicalQueueSize(pThis),
               getPhysicalQueueSize(pThis));
 
@@ -3543,6 +3600,27 @@ rsRetVal qqueueStart(rsconf_t *cnf, qqueue_t *pThis) /* this is the Construction
     CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("maxqsize"), ctrType_Int, CTR_FLAG_NONE,
                                 &pThis->ctrMaxqsize));
 
+    if (pThis->bTiming) {
+        STATSCOUNTER_INIT(pThis->ctrTimeIdle, pThis->mutCtrTimeIdle);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("timing.idle"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrTimeIdle));
+        STATSCOUNTER_INIT(pThis->ctrTimeDequeue, pThis->mutCtrTimeDequeue);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("timing.dequeue"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrTimeDequeue));
+        STATSCOUNTER_INIT(pThis->ctrTimeRules, pThis->mutCtrTimeRules);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("timing.rules"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrTimeRules));
+        STATSCOUNTER_INIT(pThis->ctrTimeRender, pThis->mutCtrTimeRender);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("timing.render"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrTimeRender));
+        STATSCOUNTER_INIT(pThis->ctrTimeOutput, pThis->mutCtrTimeOutput);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("timing.output"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrTimeOutput));
+        STATSCOUNTER_INIT(pThis->ctrTimeDelete, pThis->mutCtrTimeDelete);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("timing.delete"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrTimeDelete));
+    }
+
     CHKiRet(statsobj.ConstructFinalize(pThis->statsobj));
 
 finalize_it:
@@ -4474,6 +4552,10 @@ rsRetVal qqueueApplyCnfParam(qqueue_t *pThis, struct nvlst *lst) {
             pThis->iDeqtWinToHr = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "queue.samplinginterval")) {
             pThis->iSmpInterval = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "queue.timing")) {
+            pThis->bTiming = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "queue.timing.samplinginterval")) {
+            pThis->iTimingSmpInterval = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "queue.takeflowctlfrommsg")) {
             pThis->takeFlowCtlFromMsg = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "queue.oncorruption")) {
@@ -4546,7 +4628,8 @@ int queuesEqual(qqueue_t *pOld, qqueue_t *pNew) {
             NUM_EQUALS(toActShutdown) && NUM_EQUALS(toEnq) && NUM_EQUALS(toWrkShutdown) &&
             NUM_EQUALS(iMinMsgsPerWrkr) && NUM_EQUALS(iMaxFileSize) && NUM_EQUALS(bSaveOnShutdown) &&
             NUM_EQUALS(iDeqSlowdown) && NUM_EQUALS(iDeqtWinFromHr) && NUM_EQUALS(iDeqtWinToHr) &&
-            NUM_EQUALS(iSmpInterval) && NUM_EQUALS(takeFlowCtlFromMsg) && USTR_EQUALS(pszFilePrefix) &&
+            NUM_EQUALS(iSmpInterval) && NUM_EQUALS(bTiming) && NUM_EQUALS(iTimingSmpInterval) &&
+            NUM_EQUALS(takeFlowCtlFromMsg) && USTR_EQUALS(pszFilePrefix) &&
             USTR_EQUALS(cryprovName));
 }
 
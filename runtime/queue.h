@@ -222,6 +222,15 @@ struct queue_s {
         STATSCOUNTER_DEF(ctrFDscrd, mutCtrFDscrd)
         STATSCOUNTER_DEF(ctrNFDscrd, mutCtrNFDscrd)
         int ctrMaxqsize; /* NOT guarded by a mutex */
+        /* queue.timing: where the workers spend their time, in us */
+        sbool bTiming;
+        int iTimingSmpInterval; /* time only every n-th batch of each worker */
+        STATSCOUNTER_DEF(ctrTimeIdle, mutCtrTimeIdle)
+        STATSCOUNTER_DEF(ctrTimeDequeue, mutCtrTimeDequeue)
+        STATSCOUNTER_DEF(ctrTimeRules, mutCtrTimeRules)
+        STATSCOUNTER_DEF(ctrTimeRender, mutCtrTimeRender)
+        STATSCOUNTER_DEF(ctrTimeOutput, mutCtrTimeOutput)
+        STATSCOUNTER_DEF(ctrTimeDelete, mutCtrTimeDelete)
         int iSmpInterval; /* line interval of sampling logs */
         int isRunning;
 };
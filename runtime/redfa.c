@@ -0,0 +1,938 @@
+/* redfa.c - combined matching of many regular expressions
+ *
+ * Each pattern is parsed into a small syntax tree and then compiled into a
+ * Thompson NFA that ends in a match state carrying the pattern id. All
+ * patterns share one NFA; the search is unanchored, so when stepping from
+ * one position to the next, the start states of all patterns are added
+ * again. Each DFA state is the set of NFA states active at a position.
+ * The DFA is never built in full. Instead, every thread builds the states
+ * it actually visits in its own redfaCache_t. That keeps the automaton
+ * read-only at run time, so no locking is needed. The number of DFA states
+ * in a cache is limited; if the limit is hit, the cache is flushed and
+ * rebuilt on the fly.
+ *
+ * Anchors are zero-width NFA states: "^" can only be passed when starting
+ * at the begin of the string, "$" only after the last character.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "rsyslog.h"
+#include "redfa.h"
+
+#define REDFA_DUP_MAX 255 /* largest repeat count, as RE_DUP_MAX */
+#define REDFA_MAX_DEPTH 64 /* maximum nesting of groups */
+#define REDFA_MAX_NFA 65536 /* NFA states of all patterns together */
+#define REDFA_MAX_DSTATES 1024 /* DFA states per cache before it is flushed */
+#define REDFA_MAX_POOL (1024 * 1024) /* NFA state references per cache before it is flushed */
+#define REDFA_HASH_SIZE 2048 /* buckets for DFA state lookup, power of two */
+
+#define REDFA_CL_BOL 0x01 /* closure may pass "^" */
+#define REDFA_CL_EOL 0x02 /* closure may pass "$" */
+
+typedef uint32_t redfaSet_t[8]; /* a set of bytes */
+
+enum redfaNfaType {
+    RN_SET, /* consume a byte from set arg */
+    RN_SPLIT, /* continue at out and out1 */
+    RN_BOL, /* "^" */
+    RN_EOL, /* "$" */
+    RN_MATCH /* pattern arg matched */
+};
+
+typedef struct {
+    uint8_t type;
+    int out;
+    int out1;
+    int arg;
+} redfaNfa_t;
+
+struct redfa_s {
+    redfaNfa_t *nfa;
+    int nNfa;
+    int maxNfa;
+    redfaSet_t *sets;
+    int nSets;
+    int maxSets;
+    int *starts; /* start state of each pattern */
+    int nPatterns;
+    int maxPatterns;
+    int nWords; /* size of a pattern bitset in uint32_t */
+    sbool bFinalized;
+};
+
+/* syntax tree of the pattern being added */
+enum redfaNodeType { RT_SET, RT_CAT, RT_ALT, RT_REPEAT, RT_BOL, RT_EOL };
+
+typedef struct {
+    uint8_t type;
+    int left; /* also the repeated node */
+    int right;
+    int set;
+    int min;
+    int max; /* -1: unbounded */
+} redfaNode_t;
+
+typedef struct {
+    redfa_t *pThis;
+    const uchar *p;
+    int flags;
+    int depth;
+    rsRetVal err; /* why parsing failed */
+    redfaNode_t *nodes;
+    int nNodes;
+    int maxNodes;
+} redfaParse_t;
+
+typedef struct {
+    int members; /* first NFA state in the member pool, sorted */
+    int nMembers;
+    uint32_t hash;
+    int hashNext;
+    int accept; /* patterns matched in this state, offset into accept pool, -1 if none */
+    int acceptEnd; /* ... if the string ends here; -1 if none, -2 if not yet known */
+    int next[256]; /* transitions, -1 if not yet known */
+} redfaDState_t;
+
+struct redfaCache_s {
+    const redfa_t *owner;
+    /* last string and its result */
+    sbool bValid;
+    uchar *val;
+    size_t lenVal;
+    size_t maxVal;
+    uint32_t *result;
+    /* the DFA built so far */
+    redfaDState_t *dstates;
+    int nDStates;
+    int maxDStates;
+    int start; /* -1 if not yet built */
+    unsigned nFlushes;
+    int *memberPool;
+    int nMemberPool;
+    int maxMemberPool;
+    uint32_t *acceptPool;
+    int nAcceptPool;
+    int maxAcceptPool;
+    int hashTab[REDFA_HASH_SIZE];
+    /* scratch space for closure computation */
+    uint32_t *mark;
+    uint32_t gen;
+    int *stack;
+    int *work;
+    int nWork;
+};
+
+
+static inline void redfaSetAdd(redfaSet_t set, const unsigned c) {
+    set[c >> 5] |= (uint32_t)1 << (c & 31);
+}
+
+static inline int redfaSetHas(const redfaSet_t set, const unsigned c) {
+    return (set[c >> 5] >> (c & 31)) & 1;
+}
+
+
+/* ---------- parser ---------- */
+
+static int redfaNewSet(redfaParse_t *const ps) {
+    redfa_t *const pThis = ps->pThis;
+    if (pThis->nSets == pThis->maxSets) {
+        const int newMax = pThis->maxSets == 0 ? 16 : pThis->maxSets * 2;
+        redfaSet_t *const newSets = realloc(pThis->sets, sizeof(redfaSet_t) * newMax);
+        if (newSets == NULL) {
+            ps->err = RS_RET_OUT_OF_MEMORY;
+            return -1;
+        }
+        pThis->sets = newSets;
+        pThis->maxSets = newMax;
+    }
+    memset(pThis->sets[pThis->nSets], 0, sizeof(redfaSet_t));
+    return pThis->nSets++;
+}
+
+static int redfaNewNode(redfaParse_t *const ps, const uint8_t type, const int left, const int right) {
+    redfaNode_t *n;
+    if (ps->nNodes == ps->maxNodes) {
+        const int newMax = ps->maxNodes == 0 ? 32 : ps->maxNodes * 2;
+        redfaNode_t *const newNodes = realloc(ps->nodes, sizeof(redfaNode_t) * newMax);
+        if (newNodes == NULL) {
+            ps->err = RS_RET_OUT_OF_MEMORY;
+            return -1;
+        }
+        ps->nodes = newNodes;
+        ps->maxNodes = newMax;
+    }
+    n = &ps->nodes[ps->nNodes];
+    n->type = type;
+    n->left = left;
+    n->right = right;
+    n->set = -1;
+    n->min = n->max = 0;
+    return ps->nNodes++;
+}
+
+/* REG_ICASE: add the other case of all letters in the set */
+static void redfaSetFoldCase(redfaSet_t set) {
+    int c;
+    for (c = 0; c < 256; ++c) {
+        if (redfaSetHas(set, c)) {
+            if (isupper(c)) redfaSetAdd(set, tolower(c));
+            if (islower(c)) redfaSetAdd(set, toupper(c));
+        }
+    }
+}
+
+static int redfaNewSetNode(redfaParse_t *const ps, int *const pSet) {
+    int node;
+    if ((*pSet = redfaNewSet(ps)) == -1) return -1;
+    if ((node = redfaNewNode(ps, RT_SET, -1, -1)) == -1) return -1;
+    ps->nodes[node].set = *pSet;
+    return node;
+}
+
+static int redfaParseLiteral(redfaParse_t *const ps, const uchar c) {
+    int set;
+    const int node = redfaNewSetNode(ps, &set);
+    if (node == -1) return -1;
+    redfaSetAdd(ps->pThis->sets[set], c);
+    if (ps->flags & REDFA_ICASE) redfaSetFoldCase(ps->pThis->sets[set]);
+    return node;
+}
+
+static int redfaParseAny(redfaParse_t *const ps) {
+    int set, c;
+    const int node = redfaNewSetNode(ps, &set);
+    if (node == -1) return -1;
+    for (c = 1; c < 256; ++c) redfaSetAdd(ps->pThis->sets[set], c);
+    return node;
+}
+
+static int redfaAddClass(redfaParse_t *const ps, redfaSet_t set, const uchar *const name, const size_t len) {
+    static const struct {
+        const char *name;
+        int (*fn)(int);
+    } classes[] = {{"alpha", isalpha}, {"digit", isdigit}, {"alnum", isalnum}, {"upper", isupper},
+                   {"lower", islower}, {"space", isspace}, {"blank", isblank}, {"punct", ispunct},
+                   {"print", isprint}, {"graph", isgraph}, {"cntrl", iscntrl}, {"xdigit", isxdigit}};
+    size_t i;
+    int c;
+
+    for (i = 0; i < sizeof(classes) / sizeof(classes[0]); ++i) {
+        if (strlen(classes[i].name) == len && !memcmp(classes[i].name, name, len)) break;
+    }
+    if (i == sizeof(classes) / sizeof(classes[0])) return -1;
+    /* regcomp() does not agree with itself on how these interact with REG_ICASE */
+    if ((ps->flags & REDFA_ICASE) && (classes[i].fn == isupper || classes[i].fn == islower)) return -1;
+    for (c = 1; c < 256; ++c) {
+        if (classes[i].fn(c)) redfaSetAdd(set, c);
+    }
+    return 0;
+}
+
+/* bracket expression, ps->p is on the opening '[' */
+static int redfaParseBracket(redfaParse_t *const ps) {
+    int set, node, c;
+    int bNegate = 0;
+    int bFirst = 1;
+    redfaSet_t tmp;
+
+    memset(tmp, 0, sizeof(tmp));
+    ++ps->p;
+    if (*ps->p == '^') {
+        bNegate = 1;
+        ++ps->p;
+    }
+    while (1) {
+        const uchar lo = *ps->p;
+        if (lo == '\0') return -1;
+        if (lo == ']' && !bFirst) {
+            ++ps->p;
+            break;
+        }
+        if (lo == '[' && ps->p[1] == ':') {
+            const uchar *const name = ps->p + 2;
+            const uchar *end = name;
+            while (*end != '\0' && *end != ':') ++end;
+            if (end[0] != ':' || end[1] != ']') return -1;
+            if (redfaAddClass(ps, tmp, name, end - name) != 0) return -1;
+            ps->p = end + 2;
+        } else if (lo == '[' && (ps->p[1] == '=' || ps->p[1] == '.')) {
+            return -1; /* equivalence classes and collating symbols */
+        } else if (lo == '-' && !bFirst && ps->p[1] != ']') {
+            return -1; /* as in "[a-c-e]", not portable */
+        } else if (ps->p[1] == '-' && ps->p[2] != ']' && ps->p[2] != '\0') {
+            const uchar hi = ps->p[2];
+            if (hi == '[' || hi < lo) return -1;
+            for (c = lo; c <= hi; ++c) redfaSetAdd(tmp, c);
+            ps->p += 3;
+        } else {
+            redfaSetAdd(tmp, lo);
+            ++ps->p;
+        }
+        bFirst = 0;
+    }
+
+    if (ps->flags & REDFA_ICASE) redfaSetFoldCase(tmp);
+    if ((node = redfaNewSetNode(ps, &set)) == -1) return -1;
+    for (c = 1; c < 256; ++c) {
+        if (redfaSetHas(tmp, c) != bNegate) redfaSetAdd(ps->pThis->sets[set], c);
+    }
+    return node;
+}
+
+static int redfaAtConcatEnd(const redfaParse_t *const ps) {
+    const uchar *const p = ps->p;
+    if (*p == '\0') return 1;
+    if (ps->flags & REDFA_EXTENDED) return *p == '|' || (*p == ')' && ps->depth > 0);
+    return p[0] == '\\' && p[1] == ')' && ps->depth > 0;
+}
+
+/* an escaped character that stands for itself. Escaped letters and digits
+ * are back-references or GNU extensions like \w, as are \< \> \` \'
+ */
+static int redfaIsPlainEscape(const uchar c) {
+    return c != '\0' && c < 0x80 && !isalnum(c) && strchr("<>`'", c) == NULL;
+}
+
+static int redfaParseAlt(redfaParse_t *ps);
+
+static int redfaParseGroup(redfaParse_t *const ps, const size_t lenOpen) {
+    int node;
+    if (++ps->depth > REDFA_MAX_DEPTH) return -1;
+    ps->p += lenOpen;
+    if ((node = redfaParseAlt(ps)) == -1) return -1;
+    if (ps->flags & REDFA_EXTENDED) {
+        if (*ps->p != ')') return -1;
+        ++ps->p;
+    } else {
+        if (ps->p[0] != '\\' || ps->p[1] != ')') return -1;
+        ps->p += 2;
+    }
+    --ps->depth;
+    return node;
+}
+
+static int redfaParseAtom(redfaParse_t *const ps, const int bFirst) {
+    const uchar c = *ps->p;
+
+    if (c == '[') return redfaParseBracket(ps);
+    if (c == '.') {
+        ++ps->p;
+        return redfaParseAny(ps);
+    }
+
+    if (ps->flags & REDFA_EXTENDED) {
+        switch (c) {
+            case '(':
+                return redfaParseGroup(ps, 1);
+            case ')':
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+                return -1;
+            case '^':
+                if (!bFirst) return -1;
+                ++ps->p;
+                return redfaNewNode(ps, RT_BOL, -1, -1);
+            case '$':
+                ++ps->p;
+                if (!redfaAtConcatEnd(ps)) return -1;
+                return redfaNewNode(ps, RT_EOL, -1, -1);
+            case '\\':
+                if (!redfaIsPlainEscape(ps->p[1])) return -1;
+                ps->p += 2;
+                return redfaParseLiteral(ps, ps->p[-1]);
+            default:
+                ++ps->p;
+                return redfaParseLiteral(ps, c);
+        }
+    }
+
+    /* basic syntax */
+    switch (c) {
+        case '\\':
+            if (ps->p[1] == '(') return redfaParseGroup(ps, 2);
+            if (!redfaIsPlainEscape(ps->p[1]) || strchr("(){}|+?", ps->p[1]) != NULL) return -1;
+            ps->p += 2;
+            return redfaParseLiteral(ps, ps->p[-1]);
+        case '*':
+            return -1; /* literal at the start of an RE, but not portable */
+        case '^':
+            if (bFirst) {
+                if (ps->depth > 0) return -1; /* anchor or literal, depends on the library */
+                ++ps->p;
+                return redfaNewNode(ps, RT_BOL, -1, -1);
+            }
+            ++ps->p;
+            return redfaParseLiteral(ps, c);
+        case '$':
+            if (ps->p[1] == '\0' && ps->depth == 0) {
+                ++ps->p;
+                return redfaNewNode(ps, RT_EOL, -1, -1);
+            }
+            if (ps->p[1] == '\\' && ps->p[2] == ')') return -1;
+            ++ps->p;
+            return redfaParseLiteral(ps, c);
+        default:
+            ++ps->p;
+            return redfaParseLiteral(ps, c);
+    }
+}
+
+/* "{m}", "{m,}" or "{m,n}" (with backslashes in basic syntax); ps->p is on
+ * the first digit
+ */
+static int redfaParseInterval(redfaParse_t *const ps, int *const pMin, int *const pMax) {
+    int n = 0;
+    if (!isdigit(*ps->p)) return -1;
+    while (isdigit(*ps->p)) {
+        n = n * 10 + (*ps->p++ - '0');
+        if (n > REDFA_DUP_MAX) return -1;
+    }
+    *pMin = *pMax = n;
+    if (*ps->p == ',') {
+        ++ps->p;
+        if (isdigit(*ps->p)) {
+            n = 0;
+            while (isdigit(*ps->p)) {
+                n = n * 10 + (*ps->p++ - '0');
+                if (n > REDFA_DUP_MAX) return -1;
+            }
+            if (n < *pMin) return -1;
+            *pMax = n;
+        } else {
+            *pMax = -1;
+        }
+    }
+    if (ps->flags & REDFA_EXTENDED) {
+        if (*ps->p != '}') return -1;
+        ++ps->p;
+    } else {
+        if (ps->p[0] != '\\' || ps->p[1] != '}') return -1;
+        ps->p += 2;
+    }
+    return 0;
+}
+
+/* checks for a quantifier and consumes it; returns 1 if one was found,
+ * 0 if not, -1 on error
+ */
+static int redfaParseQuantifier(redfaParse_t *const ps, int *const pMin, int *const pMax) {
+    const uchar c = *ps->p;
+    if (c == '*') {
+        ++ps->p;
+        *pMin = 0;
+        *pMax = -1;
+        return 1;
+    }
+    if (ps->flags & REDFA_EXTENDED) {
+        if (c == '+' || c == '?') {
+            ++ps->p;
+            *pMin = (c == '+') ? 1 : 0;
+            *pMax = (c == '+') ? -1 : 1;
+            return 1;
+        }
+        if (c == '{') {
+            ++ps->p;
+            return redfaParseInterval(ps, pMin, pMax) == 0 ? 1 : -1;
+        }
+    } else if (c == '\\' && ps->p[1] == '{') {
+        ps->p += 2;
+        return redfaParseInterval(ps, pMin, pMax) == 0 ? 1 : -1;
+    }
+    return 0;
+}
+
+static int redfaParseRepeat(redfaParse_t *const ps, const int bFirst) {
+    int min, max, r, node;
+    const int atom = redfaParseAtom(ps, bFirst);
+
+    if (atom == -1) return -1;
+    if ((r = redfaParseQuantifier(ps, &min, &max)) <= 0) return r == 0 ? atom : -1;
+    if (ps->nodes[atom].type == RT_BOL || ps->nodes[atom].type == RT_EOL) return -1;
+    if ((node = redfaNewNode(ps, RT_REPEAT, atom, -1)) == -1) return -1;
+    ps->nodes[node].min = min;
+    ps->nodes[node].max = max;
+    /* "a**" and the like are accepted by some libraries only */
+    if (redfaParseQuantifier(ps, &min, &max) != 0) return -1;
+    return node;
+}
+
+static int redfaParseConcat(redfaParse_t *const ps) {
+    int result = -1;
+    int bFirst = 1;
+    while (!redfaAtConcatEnd(ps)) {
+        const int node = redfaParseRepeat(ps, bFirst);
+        if (node == -1) return -1;
+        result = (result == -1) ? node : redfaNewNode(ps, RT_CAT, result, node);
+        if (result == -1) return -1;
+        bFirst = 0;
+    }
+    return result; /* empty (sub)expressions are not supported */
+}
+
+static int redfaParseAlt(redfaParse_t *const ps) {
+    int result = redfaParseConcat(ps);
+    while (result != -1 && (ps->flags & REDFA_EXTENDED) && *ps->p == '|') {
+        int right;
+        ++ps->p;
+        if ((right = redfaParseConcat(ps)) == -1) return -1;
+        result = redfaNewNode(ps, RT_ALT, result, right);
+    }
+    return result;
+}
+
+
+/* ---------- NFA construction ---------- */
+
+static int redfaNewState(redfa_t *const pThis, const uint8_t type, const int out, const int out1, const int arg) {
+    redfaNfa_t *n;
+    if (pThis->nNfa == REDFA_MAX_NFA) return -1;
+    if (pThis->nNfa == pThis->maxNfa) {
+        const int newMax = pThis->maxNfa == 0 ? 64 : pThis->maxNfa * 2;
+        redfaNfa_t *const newNfa = realloc(pThis->nfa, sizeof(redfaNfa_t) * newMax);
+        if (newNfa == NULL) return -1;
+        pThis->nfa = newNfa;
+        pThis->maxNfa = newMax;
+    }
+    n = &pThis->nfa[pThis->nNfa];
+    n->type = type;
+    n->out = out;
+    n->out1 = out1;
+    n->arg = arg;
+    return pThis->nNfa++;
+}
+
+/* emit the states for syntax tree node @p node, continuing at @p next;
+ * returns the entry state or -1
+ */
+static int redfaEmit(redfa_t *const pThis, const redfaNode_t *const nodes, const int node, const int next) {
+    const redfaNode_t *const nd = &nodes[node];
+    int cur, i;
+
+    switch (nd->type) {
+        case RT_SET:
+            return redfaNewState(pThis, RN_SET, next, -1, nd->set);
+        case RT_BOL:
+            return redfaNewState(pThis, RN_BOL, next, -1, 0);
+        case RT_EOL:
+            return redfaNewState(pThis, RN_EOL, next, -1, 0);
+        case RT_CAT:
+            if ((cur = redfaEmit(pThis, nodes, nd->right, next)) == -1) return -1;
+            return redfaEmit(pThis, nodes, nd->left, cur);
+        case RT_ALT: {
+            const int l = redfaEmit(pThis, nodes, nd->left, next);
+            const int r = (l == -1) ? -1 : redfaEmit(pThis, nodes, nd->right, next);
+            return (r == -1) ? -1 : redfaNewState(pThis, RN_SPLIT, l, r, 0);
+        }
+        case RT_REPEAT:
+            if (nd->max == -1) {
+                int body;
+                if ((cur = redfaNewState(pThis, RN_SPLIT, -1, next, 0)) == -1) return -1;
+                if ((body = redfaEmit(pThis, nodes, nd->left, cur)) == -1) return -1;
+                pThis->nfa[cur].out = body;
+            } else {
+                cur = next;
+                for (i = nd->min; i < nd->max; ++i) {
+                    const int body = redfaEmit(pThis, nodes, nd->left, cur);
+                    if (body == -1 || (cur = redfaNewState(pThis, RN_SPLIT, body, next, 0)) == -1) return -1;
+                }
+            }
+            for (i = 0; i < nd->min; ++i) {
+                if ((cur = redfaEmit(pThis, nodes, nd->left, cur)) == -1) return -1;
+            }
+            return cur;
+        default:
+            return -1;
+    }
+}
+
+
+rsRetVal redfaConstruct(redfa_t **const ppThis) {
+    DEFiRet;
+    CHKmalloc(*ppThis = calloc(1, sizeof(redfa_t)));
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal redfaAddPattern(redfa_t *const pThis, const uchar *const regex, const int flags, int *const pId) {
+    const int nNfaOld = pThis->nNfa;
+    const int nSetsOld = pThis->nSets;
+    redfaParse_t ps;
+    int root, match, start;
+    DEFiRet;
+
+    memset(&ps, 0, sizeof(ps));
+    ps.pThis = pThis;
+    ps.p = regex;
+    ps.flags = flags;
+    ps.err = RS_RET_NOT_IMPLEMENTED;
+
+    if (pThis->bFinalized) ABORT_FINALIZE(RS_RET_ERR);
+    if ((root = redfaParseAlt(&ps)) == -1 || *ps.p != '\0') ABORT_FINALIZE(ps.err);
+
+    if (pThis->nPatterns == pThis->maxPatterns) {
+        const int newMax = pThis->maxPatterns == 0 ? 16 : pThis->maxPatterns * 2;
+        int *newStarts;
+        CHKmalloc(newStarts = realloc(pThis->starts, sizeof(int) * newMax));
+        pThis->starts = newStarts;
+        pThis->maxPatterns = newMax;
+    }
+    /* running out of NFA space is not an error, the pattern is just too big */
+    if ((match = redfaNewState(pThis, RN_MATCH, -1, -1, pThis->nPatterns)) == -1 ||
+        (start = redfaEmit(pThis, ps.nodes, root, match)) == -1)
+        ABORT_FINALIZE(RS_RET_NOT_IMPLEMENTED);
+    pThis->starts[pThis->nPatterns] = start;
+    *pId = pThis->nPatterns++;
+
+finalize_it:
+    if (iRet != RS_RET_OK) {
+        pThis->nNfa = nNfaOld;
+        pThis->nSets = nSetsOld;
+    }
+    free(ps.nodes);
+    RETiRet;
+}
+
+
+rsRetVal redfaFinalize(redfa_t *const pThis) {
+    pThis->nWords = (pThis->nPatterns + 31) / 32;
+    if (pThis->nWords == 0) pThis->nWords = 1;
+    pThis->bFinalized = 1;
+    return RS_RET_OK;
+}
+
+
+int redfaNumPatterns(const redfa_t *const pThis) {
+    return pThis->nPatterns;
+}
+
+
+void redfaDestruct(redfa_t **const ppThis) {
+    redfa_t *const pThis = *ppThis;
+    if (pThis == NULL) return;
+    free(pThis->nfa);
+    free(pThis->sets);
+    free(pThis->starts);
+    free(pThis);
+    *ppThis = NULL;
+}
+
+
+/* ---------- lazy DFA ---------- */
+
+static rsRetVal redfaCacheConstruct(const redfa_t *const pThis, redfaCache_t **const ppCache) {
+    redfaCache_t *c = NULL;
+    DEFiRet;
+
+    CHKmalloc(c = calloc(1, sizeof(redfaCache_t)));
+    c->owner = pThis;
+    c->start = -1;
+    memset(c->hashTab, 0xff, sizeof(c->hashTab));
+    CHKmalloc(c->result = calloc(pThis->nWords, sizeof(uint32_t)));
+    CHKmalloc(c->mark = calloc(pThis->nNfa + 1, sizeof(uint32_t)));
+    CHKmalloc(c->stack = malloc(sizeof(int) * (2 * pThis->nNfa + 2)));
+    CHKmalloc(c->work = malloc(sizeof(int) * (pThis->nNfa + 1)));
+    *ppCache = c;
+    c = NULL;
+
+finalize_it:
+    redfaCacheDestruct(&c);
+    RETiRet;
+}
+
+
+void redfaCacheDestruct(redfaCache_t **const ppCache) {
+    redfaCache_t *const c = *ppCache;
+    if (c == NULL) return;
+    free(c->val);
+    free(c->result);
+    free(c->dstates);
+    free(c->memberPool);
+    free(c->acceptPool);
+    free(c->mark);
+    free(c->stack);
+    free(c->work);
+    free(c);
+    *ppCache = NULL;
+}
+
+
+static void redfaNewGen(redfaCache_t *const c, const redfa_t *const pThis) {
+    if (++c->gen == 0) {
+        memset(c->mark, 0, sizeof(uint32_t) * (pThis->nNfa + 1));
+        c->gen = 1;
+    }
+    c->nWork = 0;
+}
+
+
+/* add all states reachable from @p s without consuming input to the work
+ * list; only byte-consuming, "$" and match states are kept
+ */
+static void redfaClosure(redfaCache_t *const c, const redfa_t *const pThis, const int s, const int flags) {
+    int sp = 0;
+    c->stack[sp++] = s;
+    while (sp > 0) {
+        const int cur = c->stack[--sp];
+        const redfaNfa_t *const n = &pThis->nfa[cur];
+        if (c->mark[cur] == c->gen) continue;
+        c->mark[cur] = c->gen;
+        switch (n->type) {
+            case RN_SET:
+            case RN_MATCH:
+                c->work[c->nWork++] = cur;
+                break;
+            case RN_EOL:
+                if (flags & REDFA_CL_EOL)
+                    c->stack[sp++] = n->out;
+                else
+                    c->work[c->nWork++] = cur;
+                break;
+            case RN_BOL:
+                if (flags & REDFA_CL_BOL) c->stack[sp++] = n->out;
+                break;
+            case RN_SPLIT:
+                c->stack[sp++] = n->out1;
+                c->stack[sp++] = n->out;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+
+/* store the patterns matched by the work list in the accept pool;
+ * returns the offset, -1 if there are none or -2 if out of memory
+ */
+static int redfaStoreAccept(redfaCache_t *const c, const redfa_t *const pThis) {
+    uint32_t *bits;
+    int i, off;
+    int bAny = 0;
+
+    for (i = 0; i < c->nWork && !bAny; ++i) bAny = pThis->nfa[c->work[i]].type == RN_MATCH;
+    if (!bAny) return -1;
+    if (c->nAcceptPool + pThis->nWords > c->maxAcceptPool) {
+        const int newMax = (c->maxAcceptPool == 0 ? 64 : c->maxAcceptPool * 2) + pThis->nWords;
+        uint32_t *const newPool = realloc(c->acceptPool, sizeof(uint32_t) * newMax);
+        if (newPool == NULL) return -2;
+        c->acceptPool = newPool;
+        c->maxAcceptPool = newMax;
+    }
+    off = c->nAcceptPool;
+    c->nAcceptPool += pThis->nWords;
+    bits = c->acceptPool + off;
+    memset(bits, 0, sizeof(uint32_t) * pThis->nWords);
+    for (i = 0; i < c->nWork; ++i) {
+        const redfaNfa_t *const n = &pThis->nfa[c->work[i]];
+        if (n->type == RN_MATCH) bits[n->arg / 32] |= (uint32_t)1 << (n->arg % 32);
+    }
+    return off;
+}
+
+
+static void redfaFlush(redfaCache_t *const c) {
+    c->nDStates = 0;
+    c->nMemberPool = 0;
+    c->nAcceptPool = 0;
+    c->start = -1;
+    memset(c->hashTab, 0xff, sizeof(c->hashTab));
+    ++c->nFlushes;
+}
+
+
+static int redfaCmpInt(const void *const a, const void *const b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+/* find or create the DFA state for the work list. May flush the cache.
+ * Returns the state or -1 if out of memory.
+ */
+static int redfaAddDState(redfaCache_t *const c, const redfa_t *const pThis) {
+    uint32_t hash = 2166136261u;
+    redfaDState_t *d;
+    int i, idx;
+
+    qsort(c->work, c->nWork, sizeof(int), redfaCmpInt);
+    for (i = 0; i < c->nWork; ++i) hash = (hash ^ (uint32_t)c->work[i]) * 16777619u;
+    for (idx = c->hashTab[hash & (REDFA_HASH_SIZE - 1)]; idx != -1; idx = c->dstates[idx].hashNext) {
+        d = &c->dstates[idx];
+        if (d->hash == hash && d->nMembers == c->nWork &&
+            !memcmp(c->memberPool + d->members, c->work, sizeof(int) * c->nWork))
+            return idx;
+    }
+
+    if (c->nDStates == REDFA_MAX_DSTATES || c->nMemberPool + c->nWork > REDFA_MAX_POOL) redfaFlush(c);
+    if (c->nDStates == c->maxDStates) {
+        const int newMax = c->maxDStates == 0 ? 16 : c->maxDStates * 2;
+        redfaDState_t *const newStates = realloc(c->dstates, sizeof(redfaDState_t) * newMax);
+        if (newStates == NULL) return -1;
+        c->dstates = newStates;
+        c->maxDStates = newMax;
+    }
+    if (c->nMemberPool + c->nWork > c->maxMemberPool) {
+        const int newMax = (c->maxMemberPool == 0 ? 256 : c->maxMemberPool * 2) + c->nWork;
+        int *const newPool = realloc(c->memberPool, sizeof(int) * newMax);
+        if (newPool == NULL) return -1;
+        c->memberPool = newPool;
+        c->maxMemberPool = newMax;
+    }
+
+    idx = c->nDStates;
+    d = &c->dstates[idx];
+    if ((d->accept = redfaStoreAccept(c, pThis)) == -2) return -1;
+    d->members = c->nMemberPool;
+    d->nMembers = c->nWork;
+    memcpy(c->memberPool + d->members, c->work, sizeof(int) * c->nWork);
+    c->nMemberPool += c->nWork;
+    d->hash = hash;
+    d->hashNext = c->hashTab[hash & (REDFA_HASH_SIZE - 1)];
+    c->hashTab[hash & (REDFA_HASH_SIZE - 1)] = idx;
+    d->acceptEnd = -2;
+    memset(d->next, 0xff, sizeof(d->next));
+    return c->nDStates++;
+}
+
+
+static int redfaStartState(redfaCache_t *const c, const redfa_t *const pThis) {
+    int i;
+    redfaNewGen(c, pThis);
+    for (i = 0; i < pThis->nPatterns; ++i) redfaClosure(c, pThis, pThis->starts[i], REDFA_CL_BOL);
+    return redfaAddDState(c, pThis);
+}
+
+
+static int redfaStep(redfaCache_t *const c, const redfa_t *const pThis, const int cur, const uchar ch) {
+    const unsigned nFlushes = c->nFlushes;
+    const redfaDState_t *const d = &c->dstates[cur];
+    int i, next;
+
+    redfaNewGen(c, pThis);
+    for (i = 0; i < d->nMembers; ++i) {
+        const redfaNfa_t *const n = &pThis->nfa[c->memberPool[d->members + i]];
+        if (n->type == RN_SET && redfaSetHas(pThis->sets[n->arg], ch)) redfaClosure(c, pThis, n->out, 0);
+    }
+    /* unanchored search: every pattern may also start at the next position */
+    for (i = 0; i < pThis->nPatterns; ++i) redfaClosure(c, pThis, pThis->starts[i], 0);
+    next = redfaAddDState(c, pThis);
+    if (next != -1 && nFlushes == c->nFlushes) c->dstates[cur].next[ch] = next;
+    return next;
+}
+
+
+/* patterns matched if the string ends in state @p cur; returns the offset
+ * into the accept pool, -1 if none or -2 if out of memory
+ */
+static int redfaAcceptEnd(redfaCache_t *const c, const redfa_t *const pThis, const int cur, const int flags) {
+    const redfaDState_t *const d = &c->dstates[cur];
+    int i;
+
+    redfaNewGen(c, pThis);
+    for (i = 0; i < d->nMembers; ++i) {
+        const int s = c->memberPool[d->members + i];
+        const redfaNfa_t *const n = &pThis->nfa[s];
+        if (n->type == RN_MATCH) {
+            c->mark[s] = c->gen;
+            c->work[c->nWork++] = s;
+        } else if (n->type == RN_EOL) {
+            redfaClosure(c, pThis, n->out, flags);
+        }
+    }
+    return redfaStoreAccept(c, pThis);
+}
+
+
+static void redfaOrBits(uint32_t *const dst, const uint32_t *const src, const int nWords) {
+    int i;
+    for (i = 0; i < nWords; ++i) dst[i] |= src[i];
+}
+
+
+static rsRetVal redfaRun(const redfa_t *const pThis, redfaCache_t *const c, const uchar *const buf,
+                         const size_t lenBuf) {
+    int cur, end;
+    size_t i;
+    DEFiRet;
+
+    c->bValid = 0;
+    memset(c->result, 0, sizeof(uint32_t) * pThis->nWords);
+    if (c->start == -1) {
+        if ((cur = redfaStartState(c, pThis)) == -1) ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+        c->start = cur;
+    }
+    cur = c->start;
+    for (i = 0; i < lenBuf; ++i) {
+        int next;
+        if (c->dstates[cur].accept >= 0) redfaOrBits(c->result, c->acceptPool + c->dstates[cur].accept, pThis->nWords);
+        if ((next = c->dstates[cur].next[buf[i]]) == -1 && (next = redfaStep(c, pThis, cur, buf[i])) == -1)
+            ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+        cur = next;
+    }
+
+    if (lenBuf == 0) {
+        /* "^" and "$" both hold here; this is not cached as the start
+         * state may also be reached later in other strings
+         */
+        end = redfaAcceptEnd(c, pThis, cur, REDFA_CL_BOL | REDFA_CL_EOL);
+    } else {
+        if (c->dstates[cur].acceptEnd == -2) c->dstates[cur].acceptEnd = redfaAcceptEnd(c, pThis, cur, REDFA_CL_EOL);
+        end = c->dstates[cur].acceptEnd;
+    }
+    if (end == -2) ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    if (end >= 0) redfaOrBits(c->result, c->acceptPool + end, pThis->nWords);
+
+    /* remember the string, so that queries for other patterns are free */
+    if (lenBuf > c->maxVal) {
+        uchar *const newVal = realloc(c->val, lenBuf);
+        if (newVal == NULL) FINALIZE; /* result is fine, just not cached */
+        c->val = newVal;
+        c->maxVal = lenBuf;
+    }
+    if (lenBuf > 0) memcpy(c->val, buf, lenBuf);
+    c->lenVal = lenBuf;
+    c->bValid = 1;
+
+finalize_it:
+    RETiRet;
+}
+
+
+int redfaMatch(const redfa_t *const pThis, redfaCache_t **const ppCache, const uchar *const buf, const size_t lenBuf,
+               const int id) {
+    redfaCache_t *c;
+
+    if (!pThis->bFinalized || id < 0 || id >= pThis->nPatterns) return -1;
+    if (*ppCache != NULL && (*ppCache)->owner != pThis) redfaCacheDestruct(ppCache);
+    if (*ppCache == NULL && redfaCacheConstruct(pThis, ppCache) != RS_RET_OK) return -1;
+    c = *ppCache;
+
+    if (!c->bValid || c->lenVal != lenBuf || (lenBuf > 0 && memcmp(c->val, buf, lenBuf))) {
+        if (redfaRun(pThis, c, buf, lenBuf) != RS_RET_OK) return -1;
+    }
+    return (c->result[id / 32] >> (id % 32)) & 1;
+}
@@ -0,0 +1,75 @@
+/* redfa.h - combined matching of many regular expressions
+ *
+ * All patterns added to one object are compiled into a single automaton.
+ * One linear pass over a string determines which of the patterns match
+ * (anywhere in the string, as regexec() does). There is no backtracking.
+ * The automaton is a Thompson NFA that each thread turns into a DFA lazily,
+ * see redfaMatch().
+ *
+ * Only a subset of POSIX basic and extended regular expressions is
+ * supported. redfaAddPattern() rejects everything else, so that the caller
+ * can use regcomp()/regexec() for that pattern instead. Matching is done on
+ * bytes with the C locale's character classes, which is what regexec()
+ * does inside rsyslogd.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INCLUDED_REDFA_H
+#define INCLUDED_REDFA_H
+
+#include <stddef.h>
+
+/** pattern flags */
+#define REDFA_EXTENDED 0x01 /**< POSIX extended syntax (REG_EXTENDED) */
+#define REDFA_ICASE 0x02 /**< ignore case (REG_ICASE) */
+
+typedef struct redfa_s redfa_t;
+typedef struct redfaCache_s redfaCache_t;
+
+rsRetVal redfaConstruct(redfa_t **ppThis);
+
+/**
+ * Add a pattern. Must be called before redfaFinalize(). On success,
+ * @p pId receives the number to query the pattern with. Returns
+ * RS_RET_NOT_IMPLEMENTED if the pattern uses syntax that is not supported
+ * (or is invalid); the automaton is unchanged in that case.
+ */
+rsRetVal redfaAddPattern(redfa_t *pThis, const uchar *regex, int flags, int *pId);
+
+/** No patterns can be added afterwards. */
+rsRetVal redfaFinalize(redfa_t *pThis);
+
+int redfaNumPatterns(const redfa_t *pThis);
+
+/**
+ * Check if pattern @p id matches @p buf. The first call for a string runs
+ * the automaton and remembers the result for all patterns, so that queries
+ * for the other patterns on the same string are answered from @p ppCache.
+ * The cache holds the DFA states built so far and must only be used by a
+ * single thread; it is created on first use.
+ * @return 1 on match, 0 on no match, -1 if the check could not be done
+ *         (out of memory); the caller must then fall back to regexec()
+ */
+int redfaMatch(const redfa_t *pThis, redfaCache_t **ppCache, const uchar *buf, size_t lenBuf, int id);
+
+void redfaCacheDestruct(redfaCache_t **ppCache);
+
+void redfaDestruct(redfa_t **ppThis);
+
+#endif /* #ifndef INCLUDED_REDFA_H */
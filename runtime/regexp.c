@@ -35,7 +35,6 @@
 #include "regexp.h"
 #include "errmsg.h"
 #include "hashtable.h"
-#include "hashtable_itr.h"
 
 MODULE_TYPE_LIB
 MODULE_TYPE_NOKEEP;
@@ -62,8 +61,11 @@ static pthread_mutex_t mut_regexp;
 // Map a regex_t to its associated uncompiled parameters.
 static struct hashtable *regex_to_uncomp = NULL;
 
-// Map a (regexp_t, pthead_t) to a perthread_regex.
-static struct hashtable *perthread_regexs = NULL;
+// Thread-local table of perthread_regex, see get_perthread_regex().
+static pthread_key_t perthread_key;
+
+// Incremented by each regfree(), tells threads to drop their copies.
+static unsigned regexp_generation = 0;
 
 
 /*
@@ -84,10 +86,22 @@ typedef struct perthread_regex {
     const regex_t *original_preg;
     regex_t preg;
     int ret;
-    pthread_mutex_t lock;
-    pthread_t thread;
 } perthread_regex_t;
 
+/*
+ * The copies of one thread, an open addressing hash table keyed by the
+ * address of the original regex_t. It is only ever accessed by its thread,
+ * so regexec() needs no lock. As the memory of a freed regex_t may be
+ * reused for a different regex, the table is flushed when the thread
+ * notices that regfree() has been called since it last looked.
+ */
+typedef struct perthread_table {
+    unsigned generation;
+    unsigned nEntries;
+    unsigned size; /* power of two */
+    perthread_regex_t **entries;
+} perthread_table_t;
+
 
 static unsigned __attribute__((nonnull(1))) int hash_from_regex(void *k) {
     return (uintptr_t) * (regex_t **)k;
@@ -97,19 +111,20 @@ static int key_equals_regex(void *key1, void *key2) {
     return *(regex_t **)key1 == *(regex_t **)key2;
 }
 
-static unsigned __attribute__((nonnull(1))) int hash_from_tregex(void *k) {
-    perthread_regex_t *entry = k;
-    // Cast to (void*) is ok here because already used in other parts of the code.
-    uintptr_t thread_id = (uintptr_t)(void *)entry->thread;
-
-    return thread_id ^ (uintptr_t)entry->original_preg;
+static inline unsigned perthread_slot(const perthread_table_t *const tab, const regex_t *const preg) {
+    return (unsigned)(((uintptr_t)preg >> 4) * 2654435761u) & (tab->size - 1);
 }
 
-static int key_equals_tregex(void *key1, void *key2) {
-    perthread_regex_t *entry1 = key1;
-    perthread_regex_t *entry2 = key2;
-
-    return (pthread_equal(entry1->thread, entry2->thread) && entry1->original_preg == entry2->original_preg);
+static inline unsigned load_generation(void) {
+#ifdef HAVE_ATOMIC_BUILTINS
+    return __atomic_load_n(&regexp_generation, __ATOMIC_ACQUIRE);
+#else
+    unsigned generation;
+    pthread_mutex_lock(&mut_regexp);
+    generation = regexp_generation;
+    pthread_mutex_unlock(&mut_regexp);
+    return generation;
+#endif
 }
 
 
@@ -129,34 +144,92 @@ static perthread_regex_t *create_perthread_regex(const regex_t *preg, uncomp_reg
     entry->original_preg = preg;
     DBGPRINTF("regexp: regcomp %p %p\n", entry, &entry->preg);
     entry->ret = regcomp(&entry->preg, uncomp->regex, uncomp->cflags);
-    pthread_mutex_init(&entry->lock, NULL);
-    entry->thread = pthread_self();
     return entry;
 }
 
+static void destroy_perthread_regex(perthread_regex_t *entry) {
+    if (entry->ret == 0) regfree(&entry->preg);
+    free(entry);
+}
+
+static void perthread_table_flush(perthread_table_t *tab) {
+    for (unsigned i = 0; i < tab->size; ++i) {
+        if (tab->entries[i] != NULL) {
+            destroy_perthread_regex(tab->entries[i]);
+            tab->entries[i] = NULL;
+        }
+    }
+    tab->nEntries = 0;
+}
+
+static void perthread_table_destruct(void *ptr) {
+    perthread_table_t *tab = ptr;
+    if (tab == NULL) return;
+    perthread_table_flush(tab);
+    free(tab->entries);
+    free(tab);
+}
+
+static int perthread_table_insert(perthread_table_t *tab, perthread_regex_t *entry) {
+    unsigned slot;
+
+    if ((tab->nEntries + 1) * 2 > tab->size) {
+        const unsigned newSize = (tab->size == 0) ? 16 : tab->size * 2;
+        perthread_table_t grown = {tab->generation, 0, newSize, calloc(newSize, sizeof(perthread_regex_t *))};
+        if (grown.entries == NULL) return 0;
+        for (unsigned i = 0; i < tab->size; ++i) {
+            if (tab->entries[i] != NULL) perthread_table_insert(&grown, tab->entries[i]);
+        }
+        free(tab->entries);
+        *tab = grown;
+    }
+    for (slot = perthread_slot(tab, entry->original_preg); tab->entries[slot] != NULL;
+         slot = (slot + 1) & (tab->size - 1))
+        ;
+    tab->entries[slot] = entry;
+    tab->nEntries++;
+    return 1;
+}
+
 // Get (or create) a regex_t to be used by the current thread.
 static perthread_regex_t *get_perthread_regex(const regex_t *preg) {
+    perthread_table_t *tab = pthread_getspecific(perthread_key);
     perthread_regex_t *entry = NULL;
-    perthread_regex_t key = {.original_preg = preg, .thread = pthread_self()};
+    const unsigned generation = load_generation();
 
-    pthread_mutex_lock(&mut_regexp);
-    entry = hashtable_search(perthread_regexs, (void *)&key);
-    if (!entry) {
-        uncomp_regex_t *uncomp = hashtable_search(regex_to_uncomp, (void *)&preg);
-
-        if (uncomp) {
-            entry = create_perthread_regex(preg, uncomp);
-            if (!hashtable_insert(perthread_regexs, (void *)entry, entry)) {
-                LogError(0, RS_RET_INTERNAL_ERROR,
-                         "error trying to insert thread-regexp into hash-table - things "
-                         "will not work 100%% correctly (mostly probably out of memory issue)");
-            }
+    if (tab == NULL) {
+        if ((tab = calloc(1, sizeof(*tab))) == NULL) return NULL;
+        if (pthread_setspecific(perthread_key, tab) != 0) {
+            free(tab);
+            return NULL;
         }
+        tab->generation = generation;
     }
-    if (entry) {
-        pthread_mutex_lock(&entry->lock);
+    if (tab->generation != generation) {
+        perthread_table_flush(tab);
+        tab->generation = generation;
+    }
+    if (tab->size > 0) {
+        for (unsigned slot = perthread_slot(tab, preg); tab->entries[slot] != NULL;
+             slot = (slot + 1) & (tab->size - 1)) {
+            if (tab->entries[slot]->original_preg == preg) return tab->entries[slot];
+        }
+    }
+
+    /* first use of this regex by this thread */
+    pthread_mutex_lock(&mut_regexp);
+    uncomp_regex_t *uncomp = hashtable_search(regex_to_uncomp, (void *)&preg);
+    if (uncomp) {
+        entry = create_perthread_regex(preg, uncomp);
     }
     pthread_mutex_unlock(&mut_regexp);
+    if (entry && !perthread_table_insert(tab, entry)) {
+        LogError(0, RS_RET_OUT_OF_MEMORY,
+                 "error trying to insert thread-regexp into hash-table - things "
+                 "will not work 100%% correctly (mostly probably out of memory issue)");
+        destroy_perthread_regex(entry);
+        entry = NULL;
+    }
     return entry;
 }
 
@@ -178,44 +251,21 @@ static void remove_uncomp_regexp(regex_t *preg) {
 }
 
 static void _regfree(regex_t *preg) {
-    int ret = 0;
-    struct hashtable_itr *itr = NULL;
-
     if (!preg) return;
 
     regfree(preg);
     remove_uncomp_regexp(preg);
 
+    /* Copies made by other threads are dropped by them on their next
+     * regexec(), or when they terminate.
+     */
+#ifdef HAVE_ATOMIC_BUILTINS
+    __atomic_add_fetch(&regexp_generation, 1, __ATOMIC_RELEASE);
+#else
     pthread_mutex_lock(&mut_regexp);
-    if (!hashtable_count(perthread_regexs)) {
-        pthread_mutex_unlock(&mut_regexp);
-        return;
-    }
-
-    // This can be long to iterate other all regexps, but regfree doesn't get called
-    // a lot during processing.
-    itr = hashtable_iterator(perthread_regexs);
-    do {
-        perthread_regex_t *entry = (perthread_regex_t *)hashtable_iterator_value(itr);
-
-        // Do it before freeing the entry.
-        ret = hashtable_iterator_advance(itr);
-
-        if (entry->original_preg == preg) {
-            // This allows us to avoid freeing this while somebody is still using it.
-            pthread_mutex_lock(&entry->lock);
-            // We can unlock immediately after because mut_regexp is locked.
-            pthread_mutex_unlock(&entry->lock);
-            pthread_mutex_destroy(&entry->lock);
-            regfree(&entry->preg);
-
-            // Do it last because it will free entry.
-            hashtable_remove(perthread_regexs, (void *)entry);
-        }
-    } while (ret);
-    free(itr);
-
+    regexp_generation++;
     pthread_mutex_unlock(&mut_regexp);
+#endif
 }
 
 static int _regcomp(regex_t *preg, const char *regex, int cflags) {
@@ -248,15 +298,7 @@ static int _regcomp(regex_t *preg, const char *regex, int cflags) {
         free(uncomp);
         return REG_ESPACE;
     }
-
-    perthread_regex_t *entry = get_perthread_regex(preg);
-    if (entry) {
-        ret = entry->ret;
-        pthread_mutex_unlock(&entry->lock);
-    } else {
-        ret = REG_ESPACE;
-    }
-    return ret;
+    return 0;
 }
 
 static int _regexec(const regex_t *preg, const char *string, size_t nmatch, regmatch_t pmatch[], int eflags) {
@@ -264,7 +306,6 @@ static int _regexec(const regex_t *preg, const char *string, size_t nmatch, regm
     int ret = REG_NOMATCH;
     if (entry != NULL) {
         ret = regexec(&entry->preg, string, nmatch, pmatch, eflags);
-        pthread_mutex_unlock(&entry->lock);
     }
     return ret;
 }
@@ -274,11 +315,7 @@ static size_t _regerror(int errcode, const regex_t *preg, char *errbuf, size_t e
 
     if (entry) preg = &entry->preg;
 
-    size_t ret = regerror(errcode, preg, errbuf, errbuf_size);
-
-    if (entry) pthread_mutex_unlock(&entry->lock);
-
-    return ret;
+    return regerror(errcode, preg, errbuf, errbuf_size);
 }
 
 /* queryInterface function
@@ -322,15 +359,12 @@ BEGINAbstractObjClassInit(regexp, 1, OBJ_IS_LOADABLE_MODULE) /* class, version *
         pthread_mutex_init(&mut_regexp, NULL);
 
         regex_to_uncomp = create_hashtable(100, hash_from_regex, key_equals_regex, NULL);
-        perthread_regexs = create_hashtable(100, hash_from_tregex, key_equals_tregex, NULL);
-        if (regex_to_uncomp == NULL || perthread_regexs == NULL) {
+        if (regex_to_uncomp == NULL || pthread_key_create(&perthread_key, perthread_table_destruct) != 0) {
             LogError(0, RS_RET_INTERNAL_ERROR,
                      "error trying to initialize hash-table "
                      "for regexp table. regexp will be disabled.");
             if (regex_to_uncomp) hashtable_destroy(regex_to_uncomp, 1);
-            if (perthread_regexs) hashtable_destroy(perthread_regexs, 1);
             regex_to_uncomp = NULL;
-            perthread_regexs = NULL;
             ABORT_FINALIZE(RS_RET_INTERNAL_ERROR);
         }
     }
@@ -343,9 +377,10 @@ ENDObjClassInit(regexp)
 BEGINObjClassExit(regexp, OBJ_IS_LOADABLE_MODULE) /* class, version */
     if (USE_PERTHREAD_REGEX) {
         /* release objects we no longer need */
+        perthread_table_destruct(pthread_getspecific(perthread_key));
+        pthread_key_delete(perthread_key);
         pthread_mutex_destroy(&mut_regexp);
         if (regex_to_uncomp) hashtable_destroy(regex_to_uncomp, 1);
-        if (perthread_regexs) hashtable_destroy(perthread_regexs, 1);
     }
 ENDObjClassExit(regexp)
 
@@ -248,6 +248,16 @@ static void cnfSetDefaults(rsconf_t *pThis) {
     pThis->globals.dnscacheDefaultTTL = 24 * 60 * 60;
     pThis->globals.dnscacheEnableTTL = 0;
     pThis->globals.shutdownQueueDoubleSize = 0;
+    pThis->globals.bTemplateCompile = 0;
+    pThis->globals.bScriptCompile = 0;
+    pThis->globals.bScriptBatchEval = 0;
+    pThis->globals.scriptRegexEngine = SCRIPT_REGEX_ENGINE_POSIX;
+    pThis->globals.bScriptMemoize = 1;
+    pThis->globals.bScriptProfile = 0;
+    pThis->globals.scriptProfileSampleRate = 1;
+    pThis->globals.scriptProfileFile = NULL;
+    pThis->globals.scriptParallelWorkers = 0;
+    pThis->globals.scriptParallelChunkSize = 64;
     pThis->globals.optionDisallowWarning = 1;
     pThis->globals.bSupportCompressionExtension = 1;
 #ifdef ENABLE_LIBLOGGING_STDLOG
@@ -360,6 +370,7 @@ BEGINobjDestruct(rsconf) /* be sure to specify the object type also in END and C
     free(pThis->globals.pszDfltNetstrmDrvrKeyFile);
     free(pThis->globals.pszDfltNetstrmDrvr);
     free(pThis->globals.oversizeMsgErrorFile);
+    free(pThis->globals.scriptProfileFile);
 #ifdef ENABLE_LIBLOGGING_STDLOG
     stdlog_close(pThis->globals.stdlog_hdl);
     free(pThis->globals.stdlog_chanspec);
@@ -367,6 +378,8 @@ BEGINobjDestruct(rsconf) /* be sure to specify the object type also in END and C
     lookupDestroyCnf();
     ratelimit_cfgsDestruct(&pThis->ratelimit_cfgs);
     llDestroy(&(pThis->rulesets.llRulesets));
+    cnfregroupDestructAll(pThis->regroups);
+    scriptprofDestructAll(&pThis->scriptprofs);
 ENDobjDestruct(rsconf)
 
 
@@ -1021,6 +1034,17 @@ finalize_it:
     RETiRet;
 }
 
+/* start the helper threads that execute chunks of large batches */
+static rsRetVal activateBatchPool(void) {
+    DEFiRet;
+
+    if (runConf->globals.scriptParallelWorkers > 0) {
+        CHKiRet(batchpoolConstruct(&runConf->batchpool, runConf->globals.scriptParallelWorkers));
+    }
+finalize_it:
+    RETiRet;
+}
+
 /* activate the main queue */
 static rsRetVal activateMainQueue(void) {
     DEFiRet;
@@ -1102,7 +1126,9 @@ static rsRetVal activate(rsconf_t *cnf) {
     lookupActivateConf();
     tellModulesActivateConfig();
     startInputModules();
+    CHKiRet(bufwriterConstruct(&runConf->bufwriter));
     CHKiRet(activateActions());
+    CHKiRet(activateBatchPool());
     CHKiRet(activateRulesetQueues());
     CHKiRet(activateMainQueue());
     /* finally let the inputs run... */
@@ -1562,6 +1588,7 @@ static rsRetVal load(rsconf_t **cnf, uchar *confFile) {
      * additional error messages and we want to see these even if we abort.
      */
     rulesetOptimizeAll(loadConf);
+    tplCompileAll(loadConf);
 
     if (r == 1) {
         LogError(0, RS_RET_CONF_PARSE_ERROR,
@@ -28,6 +28,9 @@
 #include "lookup.h"
 #include "dynstats.h"
 #include "perctile_stats.h"
+#include "scriptprof.h"
+#include "batchpool.h"
+#include "bufwriter.h"
 #include "timezones.h"
 #include "ratelimit.h"
 
@@ -41,6 +44,9 @@
 #define COMPAT_CONFIGFORMAT_WARN 1
 #define COMPAT_CONFIGFORMAT_DISABLE 2
 
+#define SCRIPT_REGEX_ENGINE_POSIX 0
+#define SCRIPT_REGEX_ENGINE_DFA 1
+
 #define COMPAT_DEFAULTS_SECURE_STRICT 0
 #define COMPAT_DEFAULTS_SECURE_BACKWARD_COMPATIBLE 1
 #define COMPAT_DEFAULTS_SECURE_WARN 2
@@ -169,6 +175,16 @@ struct globals_s {
     unsigned dnscacheDefaultTTL; /* 24 hrs default TTL */
     int dnscacheEnableTTL; /* expire entries or not (0) ? */
     int shutdownQueueDoubleSize;
+    int bTemplateCompile; /* generate specialized renderers for list templates */
+    int bScriptCompile; /* compile script conditions into register programs */
+    int bScriptBatchEval; /* execute scripts statement-major for whole batches */
+    int scriptRegexEngine; /* SCRIPT_REGEX_ENGINE_* */
+    int bScriptMemoize; /* reuse results of repeated pure function calls per message */
+    int bScriptProfile; /* keep execution profiles of statements and rulesets */
+    int scriptProfileSampleRate; /* time only every n-th execution */
+    uchar *scriptProfileFile; /* where SIGUSR2 writes the profiles to */
+    int scriptParallelWorkers; /* helper threads executing chunks of a batch, 0 = off */
+    int scriptParallelChunkSize; /* messages per chunk */
     int optionDisallowWarning; /* complain if message from disallowed sender is received */
     int bSupportCompressionExtension;
 #ifdef ENABLE_LIBLOGGING_STDLOG
@@ -285,6 +301,10 @@ struct rsconf_s {
         timezones_t timezones;
         qqueue_t *pMsgQueue; /* the main message queue */
         ratelimit_cfgs_t ratelimit_cfgs;
+        struct cnfregroup *regroups; /* combined regex automata, see rainerscript.c */
+        scriptprof_t *scriptprofs; /* execution profiles, if script.profile is on */
+        batchpool_t *batchpool; /* helper threads, if script.parallel.workers is set */
+        bufwriter_t *bufwriter; /* writes action error files in the background */
 };
 
 
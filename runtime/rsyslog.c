@@ -232,6 +232,8 @@ rsRetVal rsrtInit(const char **ppErrObj, obj_if_t *pObjIF) {
         CHKiRet(dynstatsClassInit());
         if (ppErrObj != NULL) *ppErrObj = "perctile_stats";
         CHKiRet(perctileClassInit());
+        if (ppErrObj != NULL) *ppErrObj = "scriptprof";
+        CHKiRet(scriptprofClassInit());
 
         /* dummy "classes" */
         if (ppErrObj != NULL) *ppErrObj = "str";
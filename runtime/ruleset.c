@@ -46,6 +46,7 @@
 #include "rsconf.h"
 #include "action.h"
 #include "rainerscript.h"
+#include "scriptvm.h"
 #include "srUtils.h"
 #include "modules.h"
 #include "wti.h"
@@ -80,6 +81,7 @@ rsRetVal rulesetKeyDestruct(void __attribute__((unused)) * pData) {
 /* iterate over all actions in a script (stmt subtree) */
 static void scriptIterateAllActions(struct cnfstmt *root, rsRetVal (*pFunc)(void *, void *), void *pParam) {
     struct cnfstmt *stmt;
+    int i;
     for (stmt = root; stmt != NULL; stmt = stmt->next) {
         switch (stmt->nodetype) {
             case S_NOP:
@@ -107,6 +109,11 @@ static void scriptIterateAllActions(struct cnfstmt *root, rsRetVal (*pFunc)(void
             case S_PROPFILT:
                 scriptIterateAllActions(stmt->d.s_propfilt.t_then, pFunc, pParam);
                 break;
+            case S_SWITCH:
+                for (i = 0; i < stmt->d.s_switch.nCases; ++i)
+                    scriptIterateAllActions(stmt->d.s_switch.cases[i], pFunc, pParam);
+                scriptIterateAllActions(stmt->d.s_switch.t_default, pFunc, pParam);
+                break;
             case S_RELOAD_LOOKUP_TABLE: /* this is a NOP */
                 break;
             default:
@@ -190,13 +197,15 @@ static rsRetVal ATTR_NONNULL()
     DEFiRet;
     cnfexprEval(stmt->d.s_set.expr, &result, pMsg, pWti);
     msgSetJSONFromVar(pMsg, stmt->d.s_set.varname, &result, stmt->d.s_set.force_reset);
+    wtiNoteMsgModified(pWti);
     varDelete(&result);
     RETiRet;
 }
 
-static rsRetVal execUnset(struct cnfstmt *stmt, smsg_t *pMsg) {
+static rsRetVal execUnset(struct cnfstmt *stmt, smsg_t *pMsg, wti_t *const pWti) {
     DEFiRet;
     msgDelJSON(pMsg, stmt->d.s_unset.varname);
+    wtiNoteMsgModified(pWti);
     RETiRet;
 }
 
@@ -259,10 +268,17 @@ finalize_it:
     RETiRet;
 }
 
+static int evalIf(struct cnfstmt *const stmt, smsg_t *const pMsg, wti_t *const pWti) {
+    const int bRet = (stmt->d.s_if.prog != NULL) ? rsvmExecBool(stmt->d.s_if.prog, pMsg, pWti)
+                                                 : cnfexprEvalBool(stmt->d.s_if.expr, pMsg, pWti);
+    if (bRet && stmt->prof != NULL) scriptprofNoteMatch(stmt->prof);
+    return bRet;
+}
+
 static rsRetVal execIf(struct cnfstmt *const stmt, smsg_t *const pMsg, wti_t *const pWti) {
     sbool bRet;
     DEFiRet;
-    bRet = cnfexprEvalBool(stmt->d.s_if.expr, pMsg, pWti);
+    bRet = evalIf(stmt, pMsg, pWti);
     DBGPRINTF("if condition result is %d\n", bRet);
     if (bRet) {
         if (stmt->d.s_if.t_then != NULL) CHKiRet(scriptExec(stmt->d.s_if.t_then, pMsg, pWti));
@@ -273,12 +289,26 @@ finalize_it:
     RETiRet;
 }
 
+/* sets the loop variable to o and runs the loop body. The loop variable
+ * references o instead of a copy, as the loop body is executed by this
+ * thread only: if it modifies the variable, it modifies the element of
+ * our private copy of the collection, and if the collection is borrowed
+ * from the message, cnfstmtAnalyzeForeach() made sure the body does not
+ * modify it. Global variables are shared between threads, as is the root
+ * object of a message, so they still get a copy.
+ */
 static rsRetVal invokeForeachBodyWith(struct cnfstmt *stmt, json_object *o, smsg_t *pMsg, wti_t *pWti) {
+    uchar *const var = (uchar *)stmt->d.s_foreach.iter->var;
     struct svar v;
     v.datatype = 'J';
     v.d.json = o;
     DEFiRet;
-    CHKiRet(msgSetJSONFromVar(pMsg, (uchar *)stmt->d.s_foreach.iter->var, &v, 1));
+    if (var[0] == '/' || var[1] == '\0') {
+        CHKiRet(msgSetJSONFromVar(pMsg, var, &v, 1));
+    } else {
+        CHKiRet(msgAddJSON(pMsg, var, json_object_get(o), 1, 0));
+    }
+    wtiNoteMsgModified(pWti);
     CHKiRet(scriptExec(stmt->d.s_foreach.body, pMsg, pWti));
 finalize_it:
     RETiRet;
@@ -317,14 +347,19 @@ static rsRetVal callForeachObject(struct cnfstmt *stmt, json_object *arr, smsg_t
         curr_key++;
         json_object_iter_next(&it);
     }
-    CHKmalloc(entry = json_object_new_object());
     for (int i = 0; i < len; i++) {
         if (json_object_object_get_ex(arr, keys[i], &curr)) {
+            /* a new entry each time, as the previous one may still be
+             * referenced by the loop variable
+             */
+            CHKmalloc(entry = json_object_new_object());
             CHKmalloc(key = json_object_new_string(keys[i]));
             json_object_object_add(entry, "key", key);
             key = NULL;
             json_object_object_add(entry, "value", json_object_get(curr));
             CHKiRet(invokeForeachBodyWith(stmt, entry, pMsg, pWti));
+            json_object_put(entry);
+            entry = NULL;
         }
     }
 finalize_it:
@@ -345,7 +380,12 @@ static rsRetVal ATTR_NONNULL() execForeach(struct cnfstmt *const stmt, smsg_t *c
     DEFiRet;
 
     /* arr can either be an array or an associative-array (obj) */
-    arr = cnfexprEvalCollection(stmt->d.s_foreach.iter->collection, pMsg, pWti);
+    if (stmt->d.s_foreach.iter->bBorrow) {
+        /* the body cannot modify the collection, so no need to copy it */
+        msgGetJSONPropJSONRef(pMsg, &((struct cnfvar *)stmt->d.s_foreach.iter->collection)->prop, &arr);
+    } else {
+        arr = cnfexprEvalCollection(stmt->d.s_foreach.iter->collection, pMsg, pWti);
+    }
 
     if (arr == NULL) {
         DBGPRINTF("foreach loop skipped, as object to iterate upon is empty\n");
@@ -359,6 +399,7 @@ static rsRetVal ATTR_NONNULL() execForeach(struct cnfstmt *const stmt, smsg_t *c
         FINALIZE;
     }
     CHKiRet(msgDelJSON(pMsg, (uchar *)stmt->d.s_foreach.iter->var));
+    wtiNoteMsgModified(pWti);
 
 finalize_it:
     if (arr != NULL) json_object_put(arr);
@@ -366,14 +407,18 @@ finalize_it:
     RETiRet;
 }
 
+static int evalPRIFILT(struct cnfstmt *stmt, smsg_t *pMsg) {
+    if ((stmt->d.s_prifilt.pmask[pMsg->iFacility] == TABLE_NOPRI) ||
+        ((stmt->d.s_prifilt.pmask[pMsg->iFacility] & (1 << pMsg->iSeverity)) == 0))
+        return 0;
+    if (stmt->prof != NULL) scriptprofNoteMatch(stmt->prof);
+    return 1;
+}
+
 static rsRetVal execPRIFILT(struct cnfstmt *stmt, smsg_t *pMsg, wti_t *pWti) {
     int bRet;
     DEFiRet;
-    if ((stmt->d.s_prifilt.pmask[pMsg->iFacility] == TABLE_NOPRI) ||
-        ((stmt->d.s_prifilt.pmask[pMsg->iFacility] & (1 << pMsg->iSeverity)) == 0))
-        bRet = 0;
-    else
-        bRet = 1;
+    bRet = evalPRIFILT(stmt, pMsg);
 
     DBGPRINTF("PRIFILT condition result is %d\n", bRet);
     if (bRet) {
@@ -387,15 +432,16 @@ finalize_it:
 
 
 /* helper to execPROPFILT(), as the evaluation itself is quite lengthy */
-static int evalPROPFILT(struct cnfstmt *stmt, smsg_t *pMsg) {
+static int evalPROPFILT(struct cnfstmt *stmt, smsg_t *pMsg, wti_t *pWti) {
     unsigned short pbMustBeFreed;
     uchar *pszPropVal;
     int bRet = 0;
+    int r;
     rs_size_t propLen;
 
     if (stmt->d.s_propfilt.prop.id == PROP_INVALID) goto done;
 
-    pszPropVal = MsgGetProp(pMsg, NULL, &stmt->d.s_propfilt.prop, &propLen, &pbMustBeFreed, NULL);
+    pszPropVal = wtiMsgGetProp(pWti, pMsg, &stmt->d.s_propfilt.prop, &propLen, &pbMustBeFreed);
 
     /* Now do the compares (short list currently ;)) */
     switch (stmt->d.s_propfilt.operation) {
@@ -418,14 +464,16 @@ static int evalPROPFILT(struct cnfstmt *stmt, smsg_t *pMsg) {
                 bRet = 1; /* process message! */
             break;
         case FIOP_REGEX:
-            if (rsCStrSzStrMatchRegex(stmt->d.s_propfilt.pCSCompValue, (unsigned char *)pszPropVal, 0,
-                                      &stmt->d.s_propfilt.regex_cache) == RS_RET_OK)
-                bRet = 1;
-            break;
         case FIOP_EREREGEX:
-            if (rsCStrSzStrMatchRegex(stmt->d.s_propfilt.pCSCompValue, (unsigned char *)pszPropVal, 1,
-                                      &stmt->d.s_propfilt.regex_cache) == RS_RET_OK)
+            if (stmt->d.s_propfilt.regroup != NULL &&
+                (r = cnfregroupMatch(stmt->d.s_propfilt.regroup, stmt->d.s_propfilt.reId, pszPropVal,
+                                     strlen((char *)pszPropVal), pWti)) >= 0) {
+                bRet = r;
+            } else if (rsCStrSzStrMatchRegex(stmt->d.s_propfilt.pCSCompValue, (unsigned char *)pszPropVal,
+                                             stmt->d.s_propfilt.operation == FIOP_EREREGEX,
+                                             &stmt->d.s_propfilt.regex_cache) == RS_RET_OK) {
                 bRet = 1;
+            }
             break;
         case FIOP_NOP:
         default:
@@ -461,6 +509,7 @@ static int evalPROPFILT(struct cnfstmt *stmt, smsg_t *pMsg) {
     /* cleanup */
     if (pbMustBeFreed) free(pszPropVal);
 done:
+    if (bRet && stmt->prof != NULL) scriptprofNoteMatch(stmt->prof);
     return bRet;
 }
 
@@ -468,13 +517,40 @@ static rsRetVal execPROPFILT(struct cnfstmt *stmt, smsg_t *pMsg, wti_t *pWti) {
     sbool bRet;
     DEFiRet;
 
-    bRet = evalPROPFILT(stmt, pMsg);
+    bRet = evalPROPFILT(stmt, pMsg, pWti);
     DBGPRINTF("PROPFILT condition result is %d\n", bRet);
     if (bRet) CHKiRet(scriptExec(stmt->d.s_propfilt.t_then, pMsg, pWti));
 finalize_it:
     RETiRet;
 }
 
+/* execute a switch, which the optimizer creates from if/else-if chains and
+ * runs of property filters comparing a single property against constants.
+ */
+static int evalSwitch(struct cnfstmt *stmt, smsg_t *pMsg, wti_t *pWti) {
+    unsigned short pbMustBeFreed;
+    uchar *pszPropVal;
+    rs_size_t propLen;
+    int icase;
+
+    pszPropVal = wtiMsgGetProp(pWti, pMsg, &stmt->d.s_switch.prop, &propLen, &pbMustBeFreed);
+    icase = cnfstmtSwitchFind(stmt, pszPropVal, propLen);
+    DBGPRINTF("SWITCH value '%s' selects case %d\n", pszPropVal, icase);
+    if (pbMustBeFreed) free(pszPropVal);
+    if (icase != -1 && stmt->prof != NULL) scriptprofNoteMatch(stmt->prof);
+    return icase;
+}
+
+static rsRetVal execSwitch(struct cnfstmt *stmt, smsg_t *pMsg, wti_t *pWti) {
+    int icase;
+    DEFiRet;
+
+    icase = evalSwitch(stmt, pMsg, pWti);
+    CHKiRet(scriptExec((icase == -1) ? stmt->d.s_switch.t_default : stmt->d.s_switch.cases[icase], pMsg, pWti));
+finalize_it:
+    RETiRet;
+}
+
 static rsRetVal ATTR_NONNULL() execReloadLookupTable(struct cnfstmt *stmt) {
     assert(stmt != NULL);
     lookup_ref_t *t;
@@ -493,6 +569,61 @@ finalize_it:
     RETiRet;
 }
 
+/* execute a single statement (including its subtree) for one message */
+static rsRetVal ATTR_NONNULL() execStmt(struct cnfstmt *const stmt, smsg_t *const pMsg, wti_t *const pWti) {
+    struct timespec start;
+    int bTimed = 0;
+    DEFiRet;
+
+    if (stmt->prof != NULL) bTimed = scriptprofBegin(stmt->prof, 1, &start);
+    switch (stmt->nodetype) {
+        case S_NOP:
+            break;
+        case S_STOP:
+            ABORT_FINALIZE(RS_RET_DISCARDMSG);
+            break;
+        case S_ACT:
+            CHKiRet(execAct(stmt, pMsg, pWti));
+            break;
+        case S_SET:
+            CHKiRet(execSet(stmt, pMsg, pWti));
+            break;
+        case S_UNSET:
+            CHKiRet(execUnset(stmt, pMsg, pWti));
+            break;
+        case S_CALL:
+            CHKiRet(execCall(stmt, pMsg, pWti));
+            break;
+        case S_CALL_INDIRECT:
+            CHKiRet(execCallIndirect(stmt, pMsg, pWti));
+            break;
+        case S_IF:
+            CHKiRet(execIf(stmt, pMsg, pWti));
+            break;
+        case S_FOREACH:
+            CHKiRet(execForeach(stmt, pMsg, pWti));
+            break;
+        case S_PRIFILT:
+            CHKiRet(execPRIFILT(stmt, pMsg, pWti));
+            break;
+        case S_PROPFILT:
+            CHKiRet(execPROPFILT(stmt, pMsg, pWti));
+            break;
+        case S_SWITCH:
+            CHKiRet(execSwitch(stmt, pMsg, pWti));
+            break;
+        case S_RELOAD_LOOKUP_TABLE:
+            CHKiRet(execReloadLookupTable(stmt));
+            break;
+        default:
+            dbgprintf("error: unknown stmt type %u during exec\n", (unsigned)stmt->nodetype);
+            break;
+    }
+finalize_it:
+    if (bTimed) scriptprofEnd(stmt->prof, &start);
+    RETiRet;
+}
+
 /* The rainerscript execution engine. It is debatable if that would be better
  * contained in grammer/rainerscript.c, HOWEVER, that file focusses primarily
  * on the parsing and object creation part. So as an actual executor, it is
@@ -513,52 +644,284 @@ static rsRetVal ATTR_NONNULL(2, 3) scriptExec(struct cnfstmt *const root, smsg_t
         if (Debug) {
             cnfstmtPrintOnly(stmt, 2, 0);
         }
-        switch (stmt->nodetype) {
-            case S_NOP:
-                break;
-            case S_STOP:
-                ABORT_FINALIZE(RS_RET_DISCARDMSG);
-                break;
-            case S_ACT:
-                CHKiRet(execAct(stmt, pMsg, pWti));
-                break;
-            case S_SET:
-                CHKiRet(execSet(stmt, pMsg, pWti));
-                break;
-            case S_UNSET:
-                CHKiRet(execUnset(stmt, pMsg));
-                break;
-            case S_CALL:
-                CHKiRet(execCall(stmt, pMsg, pWti));
-                break;
-            case S_CALL_INDIRECT:
-                CHKiRet(execCallIndirect(stmt, pMsg, pWti));
-                break;
-            case S_IF:
-                CHKiRet(execIf(stmt, pMsg, pWti));
-                break;
-            case S_FOREACH:
-                CHKiRet(execForeach(stmt, pMsg, pWti));
-                break;
-            case S_PRIFILT:
-                CHKiRet(execPRIFILT(stmt, pMsg, pWti));
-                break;
-            case S_PROPFILT:
-                CHKiRet(execPROPFILT(stmt, pMsg, pWti));
-                break;
-            case S_RELOAD_LOOKUP_TABLE:
-                CHKiRet(execReloadLookupTable(stmt));
-                break;
-            default:
-                dbgprintf("error: unknown stmt type %u during exec\n", (unsigned)stmt->nodetype);
-                break;
+        CHKiRet(execStmt(stmt, pMsg, pWti));
+    }
+finalize_it:
+    RETiRet;
+}
+
+
+/* Statement-major ("batch at a time") execution, enabled by script.batchEval.
+ * Instead of running the whole script for one message after the other, each
+ * statement is executed for all messages of the batch that reach it. For
+ * statements that select between statement lists (if, filters, switch),
+ * the condition is first evaluated for all of these messages in a tight
+ * loop, and then each selected list is executed for its subset. So the
+ * condition's code and constants stay hot in the cache. Per message, the
+ * same statements are executed in the same order as in scriptExec().
+ * The worker's execution state (script_error(), previous action suspended)
+ * is kept per message and switched in before each statement is executed
+ * for it. Only the interleaving between messages differs, which is visible
+ * only to global variables and to the order of messages between different
+ * actions.
+ */
+
+/* per message copy of pWti->execState */
+typedef struct msgExecState_s {
+    uint8_t script_errno;
+    uint8_t bPrevWasSuspended;
+} msgExecState_t;
+
+static inline void execStateLoad(wti_t *const pWti, const msgExecState_t *const pState) {
+    wtiSetScriptErrno(pWti, pState->script_errno);
+    pWti->execState.bPrevWasSuspended = pState->bPrevWasSuspended;
+}
+
+static inline void execStateSave(const wti_t *const pWti, msgExecState_t *const pState) {
+    pState->script_errno = wtiGetScriptErrno(pWti);
+    pState->bPrevWasSuspended = wtiGetPrevWasSuspended(pWti);
+}
+
+/* number of statement lists a statement selects from, 0 if it is no branch */
+static int stmtNumBranches(const struct cnfstmt *const stmt) {
+    switch (stmt->nodetype) {
+        case S_IF:
+        case S_PRIFILT:
+        case S_PROPFILT:
+            return 2;
+        case S_SWITCH:
+            return stmt->d.s_switch.nCases + 1;
+        default:
+            return 0;
+    }
+}
+
+static struct cnfstmt *stmtBranch(const struct cnfstmt *const stmt, const int branch) {
+    switch (stmt->nodetype) {
+        case S_IF:
+            return (branch == 0) ? stmt->d.s_if.t_then : stmt->d.s_if.t_else;
+        case S_PRIFILT:
+            return (branch == 0) ? stmt->d.s_prifilt.t_then : stmt->d.s_prifilt.t_else;
+        case S_PROPFILT:
+            return (branch == 0) ? stmt->d.s_propfilt.t_then : NULL;
+        case S_SWITCH:
+            return (branch < stmt->d.s_switch.nCases) ? stmt->d.s_switch.cases[branch] : stmt->d.s_switch.t_default;
+        default:
+            return NULL;
+    }
+}
+
+/* evaluate which statement list a message takes */
+static int stmtSelectBranch(struct cnfstmt *const stmt, smsg_t *const pMsg, wti_t *const pWti) {
+    int icase;
+    switch (stmt->nodetype) {
+        case S_IF:
+            return evalIf(stmt, pMsg, pWti) ? 0 : 1;
+        case S_PRIFILT:
+            return evalPRIFILT(stmt, pMsg) ? 0 : 1;
+        case S_PROPFILT:
+            return evalPROPFILT(stmt, pMsg, pWti) ? 0 : 1;
+        case S_SWITCH:
+            icase = evalSwitch(stmt, pMsg, pWti);
+            return (icase == -1) ? stmt->d.s_switch.nCases : icase;
+        default:
+            return 0;
+    }
+}
+
+/* execute statement list root for the batch elements idx[0..nIdx-1].
+ * results[] holds the state of each batch element; elements whose state is
+ * no longer RS_RET_OK (stop, errors) take no further part. states[] holds
+ * their execution state. idx is used as work space.
+ */
+static rsRetVal scriptExecBatch(struct cnfstmt *const root,
+                                batch_t *const pBatch,
+                                int *const idx,
+                                int nIdx,
+                                rsRetVal *const results,
+                                msgExecState_t *const states,
+                                wti_t *const pWti) {
+    struct cnfstmt *stmt, *branch;
+    struct timespec start;
+    int bTimed;
+    int *buf = NULL;
+    int *sel, *cnt, *sub;
+    int nBranches;
+    int i, j, b;
+    rsRetVal localRet;
+    DEFiRet;
+
+    for (stmt = root; stmt != NULL && nIdx > 0; stmt = stmt->next) {
+        if (*pWti->pbShutdownImmediate) {
+            DBGPRINTF("scriptExecBatch: ShutdownImmediate set, force terminating\n");
+            ABORT_FINALIZE(RS_RET_FORCE_TERM);
+        }
+        if (Debug) {
+            cnfstmtPrintOnly(stmt, 2, 0);
+        }
+        nBranches = stmtNumBranches(stmt);
+        if (nBranches > 0) buf = malloc(sizeof(int) * (2 * nIdx + nBranches + 1));
+        if (buf == NULL) {
+            /* no branch, or out of memory: plain per-message execution */
+            for (i = 0; i < nIdx; ++i) {
+                execStateLoad(pWti, &states[idx[i]]);
+                results[idx[i]] = execStmt(stmt, pBatch->pElem[idx[i]].pMsg, pWti);
+                execStateSave(pWti, &states[idx[i]]);
+            }
+        } else {
+            /* execStmt() is bypassed, so we must do the profiling */
+            bTimed = (stmt->prof != NULL) ? scriptprofBegin(stmt->prof, nIdx, &start) : 0;
+            sel = buf;
+            sub = buf + nIdx;
+            cnt = buf + 2 * nIdx;
+            memset(cnt, 0, sizeof(int) * (nBranches + 1));
+            for (i = 0; i < nIdx; ++i) {
+                execStateLoad(pWti, &states[idx[i]]);
+                sel[i] = stmtSelectBranch(stmt, pBatch->pElem[idx[i]].pMsg, pWti);
+                execStateSave(pWti, &states[idx[i]]);
+                ++cnt[sel[i] + 1];
+            }
+            /* group the messages by branch, keeping their order */
+            for (b = 0; b < nBranches; ++b) cnt[b + 1] += cnt[b];
+            for (i = 0; i < nIdx; ++i) sub[cnt[sel[i]]++] = idx[i];
+            for (b = 0, j = 0; b < nBranches; ++b) {
+                /* cnt[b] is now the end of branch b's group */
+                if ((branch = stmtBranch(stmt, b)) != NULL && cnt[b] > j) {
+                    localRet = scriptExecBatch(branch, pBatch, sub + j, cnt[b] - j, results, states, pWti);
+                    if (localRet == RS_RET_FORCE_TERM) {
+                        free(buf);
+                        buf = NULL;
+                        ABORT_FINALIZE(RS_RET_FORCE_TERM);
+                    }
+                }
+                j = cnt[b];
+            }
+            free(buf);
+            buf = NULL;
+            if (bTimed) scriptprofEnd(stmt->prof, &start);
+        }
+        /* drop messages which are done */
+        for (i = 0, j = 0; i < nIdx; ++i) {
+            if (results[idx[i]] == RS_RET_OK) idx[j++] = idx[i];
+        }
+        nIdx = j;
+    }
+finalize_it:
+    if (iRet == RS_RET_FORCE_TERM) {
+        /* messages still in flight must not be flagged as committed */
+        for (i = 0; i < nIdx; ++i) {
+            if (results[idx[i]] == RS_RET_OK) results[idx[i]] = RS_RET_FORCE_TERM;
+        }
+    }
+    RETiRet;
+}
+
+/* run a batch statement-major, grouped by ruleset. Afterwards, results[i]
+ * holds the result for batch element i, like scriptExec() would have
+ * returned it; elements not processed due to shutdown are left as
+ * RS_RET_FORCE_TERM. Each message starts with the execution state the
+ * worker had at the start of the batch; afterwards, the worker has the
+ * state of the last message, as with per-message execution.
+ */
+static rsRetVal execBatchStmtMajor(batch_t *const pBatch, rsRetVal *const results, wti_t *const pWti) {
+    const int nMsgs = batchNumMsgs(pBatch);
+    int *idx = NULL;
+    sbool *pending = NULL;
+    msgExecState_t *states = NULL;
+    ruleset_t *pRuleset;
+    struct timespec start;
+    int bTimed;
+    int first, i, n;
+    DEFiRet;
+
+    CHKmalloc(idx = malloc(sizeof(int) * nMsgs));
+    CHKmalloc(pending = malloc(sizeof(sbool) * nMsgs));
+    CHKmalloc(states = malloc(sizeof(msgExecState_t) * nMsgs));
+    for (i = 0; i < nMsgs; ++i) {
+        pending[i] = 1;
+        results[i] = RS_RET_FORCE_TERM;
+        execStateSave(pWti, &states[i]);
+    }
+    for (first = 0; first < nMsgs && !*(pWti->pbShutdownImmediate); ++first) {
+        if (!pending[first]) continue;
+        pRuleset = pBatch->pElem[first].pMsg->pRuleset;
+        for (i = first, n = 0; i < nMsgs; ++i) {
+            if (pending[i] && pBatch->pElem[i].pMsg->pRuleset == pRuleset) {
+                pending[i] = 0;
+                results[i] = RS_RET_OK;
+                idx[n++] = i;
+            }
         }
+        if (pRuleset == NULL) pRuleset = runConf->rulesets.pDflt;
+        DBGPRINTF("processBATCH: statement-major execution of %d messages for ruleset %p\n", n, pRuleset);
+        bTimed = (pRuleset->prof != NULL) ? scriptprofBegin(pRuleset->prof, n, &start) : 0;
+        scriptExecBatch(pRuleset->root, pBatch, idx, n, results, states, pWti);
+        if (bTimed) scriptprofEnd(pRuleset->prof, &start);
     }
+    execStateLoad(pWti, &states[nMsgs - 1]);
+
 finalize_it:
+    free(idx);
+    free(pending);
+    free(states);
     RETiRet;
 }
 
 
+/* execute the script of the ruleset a message was submitted to */
+static rsRetVal ATTR_NONNULL() rulesetExec(ruleset_t *const pRuleset, smsg_t *const pMsg, wti_t *const pWti) {
+    struct timespec start;
+    int bTimed;
+    rsRetVal localRet;
+
+    if (pRuleset->prof == NULL) return scriptExec(pRuleset->root, pMsg, pWti);
+    bTimed = scriptprofBegin(pRuleset->prof, 1, &start);
+    localRet = scriptExec(pRuleset->root, pMsg, pWti);
+    if (bTimed) scriptprofEnd(pRuleset->prof, &start);
+    return localRet;
+}
+
+
+/* check if all messages of a batch belong to rulesets that may be executed
+ * in chunks by the batch pool
+ */
+static int batchIsChunkable(batch_t *const pBatch) {
+    ruleset_t *pRuleset, *pPrev = NULL;
+    int i;
+
+    for (i = 0; i < batchNumMsgs(pBatch); ++i) {
+        pRuleset = pBatch->pElem[i].pMsg->pRuleset;
+        if (pRuleset == NULL) pRuleset = runConf->rulesets.pDflt;
+        if (pRuleset == pPrev) continue;
+        if (!pRuleset->bChunkable) return 0;
+        pPrev = pRuleset;
+    }
+    return 1;
+}
+
+
+/* execute a chunk of a batch on behalf of the batch pool, see
+ * script.parallel.workers. Suspended messages are retried by the
+ * worker which owns the batch.
+ */
+static void execBatchChunk(batch_t *const pBatch, const int first, const int n, rsRetVal *const results,
+                           wti_t *const pWti) {
+    smsg_t *pMsg;
+    ruleset_t *pRuleset;
+    int i;
+
+    for (i = first; i < first + n; ++i) {
+        if (*pWti->pbShutdownImmediate) {
+            results[i] = RS_RET_FORCE_TERM;
+            continue;
+        }
+        pMsg = pBatch->pElem[i].pMsg;
+        pRuleset = (pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt : pMsg->pRuleset;
+        results[i] = rulesetExec(pRuleset, pMsg, pWti);
+    }
+}
+
+
 /* Process (consume) a batch of messages. Calls the actions configured.
  * This is called by MAIN queues.
  */
@@ -567,27 +930,58 @@ static rsRetVal processBatch(batch_t *pBatch, wti_t *pWti) {
     smsg_t *pMsg;
     ruleset_t *pRuleset;
     rsRetVal localRet;
+    rsRetVal *results = NULL;
     DEFiRet;
 
     DBGPRINTF("processBATCH: batch of %d elements must be processed\n", pBatch->nElem);
 
     wtiResetExecState(pWti, pBatch);
+    wtiTplCacheBegin(pWti);
+    wtiPropCacheBegin(pWti);
+    wtiFuncCacheBegin(pWti);
 
     /* execution phase */
-    for (i = 0; i < batchNumMsgs(pBatch) && !*(pWti->pbShutdownImmediate); ++i) {
-        pMsg = pBatch->pElem[i].pMsg;
-        DBGPRINTF("processBATCH: next msg %d: %.128s\n", i, pMsg->pszRawMsg);
-        pRuleset = (pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt : pMsg->pRuleset;
-        localRet = scriptExec(pRuleset->root, pMsg, pWti);
-        /* the most important case here is that processing may be aborted
-         * due to pbShutdownImmediate, in which case we MUST NOT flag this
-         * message as committed. If we would do so, the message would
-         * potentially be lost.
-         */
-        if (localRet == RS_RET_OK)
-            batchSetElemState(pBatch, i, BATCH_STATE_COMM);
-        else if (localRet == RS_RET_SUSPENDED)
-            --i;
+    if (runConf->batchpool != NULL && batchNumMsgs(pBatch) > runConf->globals.scriptParallelChunkSize &&
+        batchIsChunkable(pBatch)) {
+        if ((results = malloc(sizeof(rsRetVal) * batchNumMsgs(pBatch))) != NULL &&
+            batchpoolRun(runConf->batchpool, pBatch, runConf->globals.scriptParallelChunkSize, execBatchChunk, results,
+                         pWti) != RS_RET_OK) {
+            free(results); /* pool busy, execute ourselves */
+            results = NULL;
+        }
+    }
+    if (results == NULL && runConf->globals.bScriptBatchEval && batchNumMsgs(pBatch) > 1) {
+        if ((results = malloc(sizeof(rsRetVal) * batchNumMsgs(pBatch))) != NULL &&
+            execBatchStmtMajor(pBatch, results, pWti) != RS_RET_OK) {
+            free(results); /* fall back to regular execution */
+            results = NULL;
+        }
+    }
+    if (results != NULL) {
+        for (i = 0; i < batchNumMsgs(pBatch); ++i) {
+            /* as below, a suspended message is processed again */
+            pMsg = pBatch->pElem[i].pMsg;
+            pRuleset = (pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt : pMsg->pRuleset;
+            while (results[i] == RS_RET_SUSPENDED && !*(pWti->pbShutdownImmediate))
+                results[i] = rulesetExec(pRuleset, pMsg, pWti);
+            if (results[i] == RS_RET_OK) batchSetElemState(pBatch, i, BATCH_STATE_COMM);
+        }
+    } else {
+        for (i = 0; i < batchNumMsgs(pBatch) && !*(pWti->pbShutdownImmediate); ++i) {
+            pMsg = pBatch->pElem[i].pMsg;
+            DBGPRINTF("processBATCH: next msg %d: %.128s\n", i, pMsg->pszRawMsg);
+            pRuleset = (pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt : pMsg->pRuleset;
+            localRet = rulesetExec(pRuleset, pMsg, pWti);
+            /* the most important case here is that processing may be aborted
+             * due to pbShutdownImmediate, in which case we MUST NOT flag this
+             * message as committed. If we would do so, the message would
+             * potentially be lost.
+             */
+            if (localRet == RS_RET_OK)
+                batchSetElemState(pBatch, i, BATCH_STATE_COMM);
+            else if (localRet == RS_RET_SUSPENDED)
+                --i;
+        }
     }
 
     /* commit phase */
@@ -596,6 +990,10 @@ static rsRetVal processBatch(batch_t *pBatch, wti_t *pWti) {
         "[processed %d of %d messages]\n",
         i, batchNumMsgs(pBatch));
     actionCommitAllDirect(pWti);
+    wtiTplCacheEnd(pWti);
+    wtiPropCacheEnd(pWti);
+    wtiFuncCacheEnd(pWti);
+    free(results);
 
     DBGPRINTF("processBATCH: batch of %d elements has been processed\n", pBatch->nElem);
     RETiRet;
@@ -705,6 +1103,7 @@ finalize_it:
 BEGINobjConstruct(ruleset) /* be sure to specify the object type also in END macro! */
     pThis->root = NULL;
     pThis->last = NULL;
+    pThis->prof = NULL;
 ENDobjConstruct(ruleset)
 
 
@@ -782,8 +1181,10 @@ static rsRetVal destructAllActions(rsconf_t *conf) {
      */
     DBGPRINTF("destructAllActions: queue shutdown\n");
     llExecFunc(&(conf->rulesets.llRulesets), doShutdownQueueWorkers, NULL);
+    if (conf->batchpool != NULL) batchpoolDestruct(&conf->batchpool);
     DBGPRINTF("destructAllActions: action and conf stmt shutdown\n");
     llExecFunc(&(conf->rulesets.llRulesets), doDestructCnfStmt, NULL);
+    if (conf->bufwriter != NULL) bufwriterDestruct(&conf->bufwriter);
 
     CHKiRet(llDestroy(&(conf->rulesets.llRulesets)));
     CHKiRet(llInit(&(conf->rulesets.llRulesets), rulesetDestructForLinkedList, rulesetKeyDestruct,
@@ -834,6 +1235,7 @@ static void rulesetOptimize(ruleset_t *pRuleset) {
         rulesetDebugPrint((ruleset_t *)pRuleset);
     }
     pRuleset->root = cnfstmtOptimize(pRuleset->root);
+    if (loadConf->globals.bScriptCompile) cnfstmtCompile(pRuleset->root);
     if (Debug) {
         dbgprintf("ruleset '%s' after optimization:\n", pRuleset->pszName);
         rulesetDebugPrint((ruleset_t *)pRuleset);
@@ -847,11 +1249,212 @@ DEFFUNC_llExecFunc(doRulesetOptimizeAll) {
 }
 /* optimize all rulesets
  */
+/* helper for rulesetOptimizeAll(), adds the regexes of a single ruleset to
+ * the combined regex automata
+ */
+DEFFUNC_llExecFunc(doRulesetCombineRegex) {
+    cnfstmtCombineRegex(((ruleset_t *)pData)->root, &((rsconf_t *)pParam)->regroups);
+    return RS_RET_OK;
+}
+
+/* helper for rulesetOptimizeAll(), decides which foreach loops of a single
+ * ruleset can iterate without copying the collection
+ */
+DEFFUNC_llExecFunc(doRulesetAnalyzeForeach) {
+    cnfstmtAnalyzeForeach(((ruleset_t *)pData)->root);
+    return RS_RET_OK;
+}
+
+/* helper for rulesetOptimizeAll(), collects the memoizable function calls
+ * of a single ruleset
+ */
+DEFFUNC_llExecFunc(doRulesetCollectMemoCalls) {
+    cnfstmtCollectMemoCalls(((ruleset_t *)pData)->root, (struct cnfmemoCalls *)pParam);
+    return RS_RET_OK;
+}
+
+/* create the execution profile of a single statement, see script.profile */
+static rsRetVal ATTR_NONNULL() stmtCreateProfile(struct cnfstmt *const stmt, rsconf_t *const conf) {
+    char kind[256];
+    char name[512];
+    char *rsName;
+    DEFiRet;
+
+    switch (stmt->nodetype) {
+        case S_STOP:
+            strcpy(kind, "stop");
+            break;
+        case S_SET:
+            snprintf(kind, sizeof(kind), "set %s", (char *)stmt->d.s_set.varname);
+            break;
+        case S_UNSET:
+            snprintf(kind, sizeof(kind), "unset %s", (char *)stmt->d.s_unset.varname);
+            break;
+        case S_CALL:
+            CHKmalloc(rsName = es_str2cstr(stmt->d.s_call.name, NULL));
+            snprintf(kind, sizeof(kind), "call %s", rsName);
+            free(rsName);
+            break;
+        case S_CALL_INDIRECT:
+            strcpy(kind, "call_indirect");
+            break;
+        case S_ACT:
+            snprintf(kind, sizeof(kind), "action %s", (char *)stmt->d.act->pszName);
+            break;
+        case S_IF:
+            strcpy(kind, "if");
+            break;
+        case S_FOREACH:
+            strcpy(kind, "foreach");
+            break;
+        case S_PRIFILT:
+        case S_PROPFILT:
+            snprintf(kind, sizeof(kind), "filter %s", (stmt->printable == NULL) ? "" : (char *)stmt->printable);
+            break;
+        case S_SWITCH:
+            strcpy(kind, "switch");
+            break;
+        case S_RELOAD_LOOKUP_TABLE:
+            strcpy(kind, "reload_lookup_table");
+            break;
+        default:
+            FINALIZE;
+    }
+    snprintf(name, sizeof(name), "%s:%d %s", (stmt->fn == NULL) ? "-" : stmt->fn, stmt->lineno, kind);
+    CHKiRet(scriptprofConstruct(&conf->scriptprofs, (uchar *)name, stmtNumBranches(stmt) > 0,
+                                conf->globals.scriptProfileSampleRate, &stmt->prof));
+finalize_it:
+    RETiRet;
+}
+
+static rsRetVal scriptCreateProfiles(struct cnfstmt *const root, rsconf_t *const conf) {
+    struct cnfstmt *stmt;
+    int b;
+    DEFiRet;
+
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        CHKiRet(stmtCreateProfile(stmt, conf));
+        if (stmt->nodetype == S_FOREACH) CHKiRet(scriptCreateProfiles(stmt->d.s_foreach.body, conf));
+        for (b = 0; b < stmtNumBranches(stmt); ++b) CHKiRet(scriptCreateProfiles(stmtBranch(stmt, b), conf));
+    }
+finalize_it:
+    RETiRet;
+}
+
+/* helper for rulesetOptimizeAll(), creates the profiles of a single ruleset */
+DEFFUNC_llExecFunc(doRulesetCreateProfiles) {
+    ruleset_t *const pThis = (ruleset_t *)pData;
+    rsconf_t *const conf = (rsconf_t *)pParam;
+    uchar name[512];
+    DEFiRet;
+
+    snprintf((char *)name, sizeof(name), "ruleset %s", (char *)pThis->pszName);
+    CHKiRet(scriptprofConstruct(&conf->scriptprofs, name, 0, conf->globals.scriptProfileSampleRate, &pThis->prof));
+    CHKiRet(scriptCreateProfiles(pThis->root, conf));
+finalize_it:
+    RETiRet;
+}
+
+/* form the action groups of a statement list: consecutive actions with
+ * the same action.group name are handed to the first of them
+ */
+static void scriptGroupActions(struct cnfstmt *const root) {
+    struct cnfstmt *stmt;
+    action_t *pLeader = NULL;
+    int b;
+
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        if (stmt->nodetype == S_ACT && stmt->d.act->pszGroup != NULL) {
+            if (pLeader != NULL && !strcmp((char *)pLeader->pszGroup, (char *)stmt->d.act->pszGroup)) {
+                actionGroupAdd(pLeader, stmt->d.act); /* on error, the action just stays ungrouped */
+            } else {
+                pLeader = stmt->d.act;
+            }
+            continue;
+        }
+        if (stmt->nodetype != S_NOP) pLeader = NULL;
+        if (stmt->nodetype == S_FOREACH) scriptGroupActions(stmt->d.s_foreach.body);
+        for (b = 0; b < stmtNumBranches(stmt); ++b) scriptGroupActions(stmtBranch(stmt, b));
+    }
+}
+
+/* check if a statement list may be executed in chunks by the batch pool.
+ * Only the commits of direct-mode transactional actions are replayed in
+ * batch order. Other actions would see the messages in the order the
+ * chunks happen to be executed, as would the queues of actions and
+ * rulesets messages are handed to. Called rulesets are checked as well,
+ * depth guards against call loops.
+ */
+static int scriptChunkable(struct cnfstmt *const root, const int depth) {
+    struct cnfstmt *stmt;
+    int b;
+
+    if (depth > 100) return 0;
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        switch (stmt->nodetype) {
+            case S_ACT:
+                if (stmt->d.act->pQueue->qType != QUEUETYPE_DIRECT || !stmt->d.act->isTransactional) return 0;
+                break;
+            case S_CALL:
+                if (stmt->d.s_call.ruleset != NULL || !scriptChunkable(stmt->d.s_call.stmt, depth + 1)) return 0;
+                break;
+            case S_CALL_INDIRECT:
+                return 0;
+            case S_FOREACH:
+                if (!scriptChunkable(stmt->d.s_foreach.body, depth + 1)) return 0;
+                break;
+            default:
+                for (b = 0; b < stmtNumBranches(stmt); ++b) {
+                    if (!scriptChunkable(stmtBranch(stmt, b), depth + 1)) return 0;
+                }
+                break;
+        }
+    }
+    return 1;
+}
+
+/* helper for rulesetOptimizeAll(), checks if a single ruleset may be executed in chunks */
+DEFFUNC_llExecFunc(doRulesetCheckChunkable) {
+    ruleset_t *const pThis = (ruleset_t *)pData;
+    pThis->bChunkable = scriptChunkable(pThis->root, 0);
+    if (*(int *)pParam && !pThis->bChunkable) {
+        LogMsg(0, RS_RET_OK, LOG_INFO,
+               "script.parallel.workers: ruleset '%s' contains non-transactional or queued actions "
+               "or hands messages to a ruleset queue, its batches are not executed in parallel",
+               pThis->pszName);
+    }
+    return RS_RET_OK;
+}
+
+/* helper for rulesetOptimizeAll(), forms the action groups of a single ruleset */
+DEFFUNC_llExecFunc(doRulesetGroupActions) {
+    ruleset_t *const pThis = (ruleset_t *)pData;
+    scriptGroupActions(pThis->root);
+    return RS_RET_OK;
+}
+
 rsRetVal rulesetOptimizeAll(rsconf_t *conf) {
     DEFiRet;
     dbgprintf("begin ruleset optimization phase\n");
     llExecFunc(&(conf->rulesets.llRulesets), doRulesetOptimizeAll, NULL);
+    llExecFunc(&(conf->rulesets.llRulesets), doRulesetAnalyzeForeach, NULL);
+    llExecFunc(&(conf->rulesets.llRulesets), doRulesetGroupActions, NULL);
+    llExecFunc(&(conf->rulesets.llRulesets), doRulesetCheckChunkable, &conf->globals.scriptParallelWorkers);
+    if (conf->globals.scriptRegexEngine == SCRIPT_REGEX_ENGINE_DFA) {
+        llExecFunc(&(conf->rulesets.llRulesets), doRulesetCombineRegex, conf);
+        CHKiRet(cnfregroupFinalizeAll(conf->regroups));
+    }
+    if (conf->globals.bScriptMemoize) {
+        struct cnfmemoCalls calls = {NULL, 0, 0};
+        llExecFunc(&(conf->rulesets.llRulesets), doRulesetCollectMemoCalls, &calls);
+        const int nIds = cnfmemoAssignIds(&calls);
+        dbgprintf("%d groups of identical function calls are memoized\n", nIds);
+    }
+    if (conf->globals.bScriptProfile) {
+        CHKiRet(llExecFunc(&(conf->rulesets.llRulesets), doRulesetCreateProfiles, conf));
+    }
     dbgprintf("ruleset optimization phase finished.\n");
+finalize_it:
     RETiRet;
 }
 
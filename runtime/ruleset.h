@@ -36,6 +36,8 @@ struct ruleset_s {
         struct cnfstmt *root;
         struct cnfstmt *last;
         parserList_t *pParserLst; /* list of parsers to use for this ruleset */
+        scriptprof_t *prof; /* execution profile, NULL if not profiling */
+        sbool bChunkable; /* may be executed in chunks by the batch pool, see scriptChunkable() */
 };
 
 /* interfaces */
@@ -0,0 +1,150 @@
+/* scriptprof.c - execution profile of RainerScript statements and rulesets
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "rsyslog.h"
+#include "unicode-helper.h"
+#include "errmsg.h"
+#include "srUtils.h"
+#include "scriptprof.h"
+
+/* definitions for objects we access */
+DEFobjStaticHelpers;
+DEFobjCurrIf(statsobj)
+
+
+rsRetVal scriptprofClassInit(void) {
+    DEFiRet;
+    CHKiRet(objGetObjInterface(&obj));
+    CHKiRet(objUse(statsobj, CORE_COMPONENT));
+finalize_it:
+    RETiRet;
+}
+
+
+static void scriptprofDestruct(scriptprof_t *const pThis) {
+    if (pThis->stats != NULL) statsobj.Destruct(&pThis->stats);
+    DESTROY_ATOMIC_HELPER_MUT64(pThis->mutCtrExecs);
+    DESTROY_ATOMIC_HELPER_MUT64(pThis->mutCtrMatches);
+    DESTROY_ATOMIC_HELPER_MUT64(pThis->mutCtrCpuNs);
+    DESTROY_ATOMIC_HELPER_MUT64(pThis->mutRuns);
+    free(pThis->name);
+    free(pThis);
+}
+
+
+rsRetVal scriptprofConstruct(scriptprof_t **const ppList,
+                             const uchar *const name,
+                             const int bHasMatches,
+                             const unsigned sampleRate,
+                             scriptprof_t **const ppThis) {
+    scriptprof_t *pThis = NULL;
+    DEFiRet;
+
+    CHKmalloc(pThis = calloc(1, sizeof(scriptprof_t)));
+    STATSCOUNTER_INIT(pThis->ctrExecs, pThis->mutCtrExecs);
+    STATSCOUNTER_INIT(pThis->ctrMatches, pThis->mutCtrMatches);
+    STATSCOUNTER_INIT(pThis->ctrCpuNs, pThis->mutCtrCpuNs);
+    STATSCOUNTER_INIT(pThis->nRuns, pThis->mutRuns);
+    pThis->sampleRate = (sampleRate < 1) ? 1 : sampleRate;
+    CHKmalloc(pThis->name = ustrdup(name));
+
+    CHKiRet(statsobj.Construct(&pThis->stats));
+    CHKiRet(statsobj.SetName(pThis->stats, pThis->name));
+    CHKiRet(statsobj.SetOrigin(pThis->stats, UCHAR_CONSTANT("script.profile")));
+    CHKiRet(statsobj.AddCounter(pThis->stats, UCHAR_CONSTANT("executions"), ctrType_IntCtr, CTR_FLAG_NONE,
+                                &pThis->ctrExecs));
+    if (bHasMatches) {
+        CHKiRet(statsobj.AddCounter(pThis->stats, UCHAR_CONSTANT("matches"), ctrType_IntCtr, CTR_FLAG_NONE,
+                                    &pThis->ctrMatches));
+    }
+    CHKiRet(statsobj.AddCounter(pThis->stats, UCHAR_CONSTANT("cputime.ns"), ctrType_IntCtr, CTR_FLAG_NONE,
+                                &pThis->ctrCpuNs));
+    CHKiRet(statsobj.ConstructFinalize(pThis->stats));
+
+    pThis->next = *ppList;
+    *ppList = pThis;
+    *ppThis = pThis;
+
+finalize_it:
+    if (iRet != RS_RET_OK && pThis != NULL) scriptprofDestruct(pThis);
+    RETiRet;
+}
+
+
+static int cmpProfCpu(const void *a, const void *b) {
+    const scriptprof_t *const pa = *(scriptprof_t *const *)a;
+    const scriptprof_t *const pb = *(scriptprof_t *const *)b;
+    if (pa->ctrCpuNs != pb->ctrCpuNs) return (pa->ctrCpuNs < pb->ctrCpuNs) ? 1 : -1;
+    return (pa->ctrExecs < pb->ctrExecs) ? 1 : (pa->ctrExecs > pb->ctrExecs) ? -1 : 0;
+}
+
+rsRetVal scriptprofDump(scriptprof_t *const pList, const char *const fn) {
+    scriptprof_t **sorted = NULL;
+    scriptprof_t *p;
+    FILE *fp = NULL;
+    size_t n, i;
+    DEFiRet;
+
+    for (n = 0, p = pList; p != NULL; p = p->next) ++n;
+    CHKmalloc(sorted = malloc(sizeof(scriptprof_t *) * (n + 1)));
+    for (i = 0, p = pList; p != NULL; p = p->next) sorted[i++] = p;
+    /* counters may change while we sort, but that only affects the order */
+    qsort(sorted, n, sizeof(scriptprof_t *), cmpProfCpu);
+
+    if ((fp = fopen(fn, "w")) == NULL) {
+        LogError(errno, RS_RET_FILE_OPEN_ERROR, "script.profile: cannot open dump file '%s'", fn);
+        ABORT_FINALIZE(RS_RET_FILE_OPEN_ERROR);
+    }
+    fprintf(fp, "# cputime_us executions matches name\n");
+    for (i = 0; i < n; ++i) {
+        fprintf(fp, "%llu %llu %llu %s\n", (unsigned long long)sorted[i]->ctrCpuNs / 1000,
+                (unsigned long long)sorted[i]->ctrExecs, (unsigned long long)sorted[i]->ctrMatches,
+                (char *)sorted[i]->name);
+    }
+    if (fclose(fp) != 0) {
+        fp = NULL;
+        LogError(errno, RS_RET_IO_ERROR, "script.profile: error writing dump file '%s'", fn);
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    fp = NULL;
+    DBGPRINTF("script.profile: wrote %zu profiles to '%s'\n", n, fn);
+
+finalize_it:
+    if (fp != NULL) fclose(fp);
+    free(sorted);
+    RETiRet;
+}
+
+
+void scriptprofDestructAll(scriptprof_t **const ppList) {
+    scriptprof_t *p, *del;
+    for (p = *ppList; p != NULL;) {
+        del = p;
+        p = p->next;
+        scriptprofDestruct(del);
+    }
+    *ppList = NULL;
+}
@@ -0,0 +1,88 @@
+/* scriptprof.h - execution profile of RainerScript statements and rulesets
+ *
+ * If enabled via the script.profile global parameter, each statement and
+ * each ruleset gets a profile that counts how often it was executed, how
+ * often its condition matched (for if, filters and switch) and the CPU time
+ * spent in it, including nested statements. The profiles are exported as
+ * impstats counters and can be written to a file on SIGUSR2.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INCLUDED_SCRIPTPROF_H
+#define INCLUDED_SCRIPTPROF_H
+
+#include <time.h>
+#include "atomic.h"
+#include "statsobj.h"
+
+typedef struct scriptprof_s scriptprof_t;
+struct scriptprof_s {
+    scriptprof_t *next; /* all profiles of a config, for the dump */
+    uchar *name; /* "file:line statement" or "ruleset name" */
+    statsobj_t *stats;
+    unsigned sampleRate; /* only every n-th run is timed */
+    STATSCOUNTER_DEF(ctrExecs, mutCtrExecs)
+    STATSCOUNTER_DEF(ctrMatches, mutCtrMatches)
+    STATSCOUNTER_DEF(ctrCpuNs, mutCtrCpuNs)
+    STATSCOUNTER_DEF(nRuns, mutRuns)
+};
+
+rsRetVal scriptprofClassInit(void);
+
+/**
+ * Create a profile and add it to @p ppList. The matches counter is only
+ * exported if @p bHasMatches is set.
+ */
+rsRetVal scriptprofConstruct(scriptprof_t **ppList, const uchar *name, int bHasMatches, unsigned sampleRate,
+                             scriptprof_t **ppThis);
+
+/** Write all profiles of the list to @p fn, most expensive first. */
+rsRetVal scriptprofDump(scriptprof_t *pList, const char *fn);
+
+void scriptprofDestructAll(scriptprof_t **ppList);
+
+/* The counters are updated directly and not via STATSCOUNTER_*, as the
+ * profile is also needed without impstats (for the dump).
+ */
+
+/* Count @p nExecs executions (a batch may run a statement for several
+ * messages at once). Returns 1 if the run is to be timed; the caller must
+ * then call scriptprofEnd() with the same @p start.
+ */
+static inline int scriptprofBegin(scriptprof_t *const pThis, const unsigned nExecs, struct timespec *const start) {
+    ATOMIC_ADD_uint64(&pThis->ctrExecs, &pThis->mutCtrExecs, nExecs);
+    if (pThis->sampleRate > 1 && ATOMIC_INC_AND_FETCH_uint64(&pThis->nRuns, &pThis->mutRuns) % pThis->sampleRate != 0)
+        return 0;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, start);
+    return 1;
+}
+
+static inline void scriptprofEnd(scriptprof_t *const pThis, const struct timespec *const start) {
+    struct timespec end;
+    int64_t ns;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+    ns = (int64_t)(end.tv_sec - start->tv_sec) * 1000000000 + (end.tv_nsec - start->tv_nsec);
+    if (ns > 0) ATOMIC_ADD_uint64(&pThis->ctrCpuNs, &pThis->mutCtrCpuNs, (uint64)ns * pThis->sampleRate);
+}
+
+static inline void scriptprofNoteMatch(scriptprof_t *const pThis) {
+    ATOMIC_INC_uint64(&pThis->ctrMatches, &pThis->mutCtrMatches);
+}
+
+#endif /* #ifndef INCLUDED_SCRIPTPROF_H */
@@ -0,0 +1,160 @@
+/* strscan.h - vectorized scanners for characters that need escaping
+ *
+ * The template engine and the JSON property encoder spend most of their
+ * time looking for the (rare) characters that need to be escaped. The
+ * helpers in this file locate them 16 (SSE2) or 32 (AVX2) bytes at a time
+ * and fall back to a plain scalar loop on other platforms. The instruction
+ * set is selected at compile time based on the compiler's target flags.
+ *
+ * Copyright (C) 2026 by Rainer Gerhards and Adiscon GmbH
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INCLUDED_STRSCAN_H
+#define INCLUDED_STRSCAN_H
+
+#include <stddef.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define RS_STRSCAN_AVX2 1
+#endif
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+    #define RS_STRSCAN_SSE2 1
+#endif
+
+/**
+ * @brief Check if a byte must be escaped inside a JSON string value.
+ *
+ * This covers control characters, the double quote, the backslash and
+ * the forward slash, which rsyslog traditionally escapes as well.
+ */
+static inline int rsStrScanIsJSONEscape(const unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\' || c == '/';
+}
+
+/**
+ * @brief Scalar reference implementation of rsStrScanJSONEscape().
+ *
+ * Exposed so that callers processing short tails and the unit tests can
+ * use exactly the same predicate as the vectorized code.
+ */
+static inline size_t rsStrScanJSONEscapeScalar(const unsigned char *const buf, const size_t len) {
+    size_t i;
+    for (i = 0; i < len && !rsStrScanIsJSONEscape(buf[i]); ++i);
+    return i;
+}
+
+/**
+ * @brief Scalar reference implementation of rsStrScanAny2().
+ */
+static inline size_t rsStrScanAny2Scalar(const unsigned char *const buf,
+                                         const size_t len,
+                                         const unsigned char c1,
+                                         const unsigned char c2) {
+    size_t i;
+    for (i = 0; i < len && buf[i] != c1 && buf[i] != c2; ++i);
+    return i;
+}
+
+/**
+ * @brief Find the first byte of @p buf that needs JSON escaping.
+ *
+ * @param buf buffer to scan, NUL bytes are treated as regular (escapable) data
+ * @param len number of bytes in @p buf
+ * @return offset of the first byte to escape, or @p len if there is none
+ */
+static inline size_t rsStrScanJSONEscape(const unsigned char *const buf, const size_t len) {
+    size_t i = 0;
+#ifdef RS_STRSCAN_AVX2
+    {
+        const __m256i ctl = _mm256_set1_epi8(0x1f);
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i bslash = _mm256_set1_epi8('\\');
+        const __m256i slash = _mm256_set1_epi8('/');
+        for (; i + 32 <= len; i += 32) {
+            const __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+            __m256i m = _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctl), v);
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, quote));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, bslash));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, slash));
+            const unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+            if (mask != 0) return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+#ifdef RS_STRSCAN_SSE2
+    {
+        const __m128i ctl = _mm_set1_epi8(0x1f);
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i bslash = _mm_set1_epi8('\\');
+        const __m128i slash = _mm_set1_epi8('/');
+        for (; i + 16 <= len; i += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+            __m128i m = _mm_cmpeq_epi8(_mm_min_epu8(v, ctl), v);
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, quote));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, bslash));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, slash));
+            const unsigned mask = (unsigned)_mm_movemask_epi8(m);
+            if (mask != 0) return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+    return i + rsStrScanJSONEscapeScalar(buf + i, len - i);
+}
+
+/**
+ * @brief Find the first occurrence of either @p c1 or @p c2 in @p buf.
+ *
+ * Pass the same character twice to search for a single one.
+ *
+ * @return offset of the first match, or @p len if there is none
+ */
+static inline size_t rsStrScanAny2(const unsigned char *const buf,
+                                   const size_t len,
+                                   const unsigned char c1,
+                                   const unsigned char c2) {
+    size_t i = 0;
+#ifdef RS_STRSCAN_AVX2
+    {
+        const __m256i v1 = _mm256_set1_epi8((char)c1);
+        const __m256i v2 = _mm256_set1_epi8((char)c2);
+        for (; i + 32 <= len; i += 32) {
+            const __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+            const __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, v1), _mm256_cmpeq_epi8(v, v2));
+            const unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+            if (mask != 0) return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+#ifdef RS_STRSCAN_SSE2
+    {
+        const __m128i v1 = _mm_set1_epi8((char)c1);
+        const __m128i v2 = _mm_set1_epi8((char)c2);
+        for (; i + 16 <= len; i += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+            const __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, v1), _mm_cmpeq_epi8(v, v2));
+            const unsigned mask = (unsigned)_mm_movemask_epi8(m);
+            if (mask != 0) return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+    return i + rsStrScanAny2Scalar(buf + i, len - i, c1, c2);
+}
+
+#endif /* #ifndef INCLUDED_STRSCAN_H */
@@ -110,7 +110,8 @@ typedef enum {
     ACT_STRING_PASSING = 0,
     ACT_ARRAY_PASSING = 1,
     ACT_MSG_PASSING = 2,
-    ACT_JSON_PASSING = 3
+    ACT_JSON_PASSING = 3,
+    ACT_IOV_PASSING = 4
 } paramPassing_t;
 
 #endif /* #ifndef SYSLOGD_TYPES_INCLUDED */
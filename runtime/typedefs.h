@@ -130,6 +130,7 @@ typedef struct tcpLstnParams_s tcpLstnParams_t;
 typedef struct tcpLstnPortList_s tcpLstnPortList_t;  // TODO: rename?
 typedef struct strmLstnPortList_s strmLstnPortList_t;  // TODO: rename?
 typedef struct actWrkrIParams actWrkrIParams_t;
+typedef struct actAsyncTx_s actAsyncTx_t;
 typedef struct dynstats_bucket_s dynstats_bucket_t;
 typedef struct dynstats_buckets_s dynstats_buckets_t;
 typedef struct perctile_buckets_s perctile_buckets_t;
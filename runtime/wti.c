@@ -49,6 +49,7 @@
 #include "action.h"
 #include "atomic.h"
 #include "rsconf.h"
+#include "msg.h"
 
 /* static data */
 DEFobjStaticHelpers;
@@ -265,6 +266,234 @@ finalize_it:
 }
 
 
+void wtiTplCacheBegin(wti_t *const pWti) {
+    wtiNoteMsgModified(pWti);
+    pWti->tplCache.bActive = 1;
+}
+
+
+void wtiTplCacheEnd(wti_t *const pWti) {
+    wtiNoteMsgModified(pWti);
+    pWti->tplCache.bActive = 0;
+}
+
+
+const actWrkrIParams_t *wtiTplCacheLookup(wti_t *const pWti, const smsg_t *const pMsg, const struct template *const pTpl) {
+    if (!pWti->tplCache.bActive) return NULL;
+    for (int i = 0; i < WTI_TPL_CACHE_SIZE; ++i) {
+        const wtiTplCacheEntry_t *const entry = &pWti->tplCache.entries[i];
+        if (entry->pMsg == pMsg && entry->pTpl == pTpl) return &entry->rendered;
+    }
+    return NULL;
+}
+
+
+void wtiTplCacheStore(wti_t *const pWti,
+                      const smsg_t *const pMsg,
+                      const struct template *const pTpl,
+                      const actWrkrIParams_t *const rendered) {
+    wtiTplCacheEntry_t *entry;
+    uchar *newbuf;
+
+    if (!pWti->tplCache.bActive) return;
+    entry = &pWti->tplCache.entries[pWti->tplCache.next];
+    pWti->tplCache.next = (pWti->tplCache.next + 1) % WTI_TPL_CACHE_SIZE;
+    entry->pMsg = NULL;
+    if (entry->rendered.lenBuf < rendered->lenStr + 1) {
+        if ((newbuf = realloc(entry->rendered.param, rendered->lenStr + 1)) == NULL) {
+            return; /* just do not cache this one */
+        }
+        entry->rendered.param = newbuf;
+        entry->rendered.lenBuf = rendered->lenStr + 1;
+    }
+    memcpy(entry->rendered.param, rendered->param, rendered->lenStr + 1);
+    entry->rendered.lenStr = rendered->lenStr;
+    entry->pTpl = pTpl;
+    entry->pMsg = pMsg;
+}
+
+
+void wtiPropCacheBegin(wti_t *const pWti) {
+    wtiNoteMsgModified(pWti);
+    pWti->propCache.bActive = 1;
+}
+
+
+void wtiPropCacheEnd(wti_t *const pWti) {
+    for (int i = 0; i < WTI_PROP_CACHE_SIZE; ++i) {
+        wtiPropCacheEntry_t *const entry = &pWti->propCache.entries[i];
+        entry->pMsg = NULL;
+        free(entry->val);
+        entry->val = NULL;
+    }
+    pWti->propCache.bActive = 0;
+}
+
+
+static int wtiPropCacheMatches(const wtiPropCacheEntry_t *const entry,
+                               const smsg_t *const pMsg,
+                               const msgPropDescr_t *const pProp) {
+    if (entry->pMsg != pMsg || entry->id != pProp->id) return 0;
+    if (entry->name == NULL) return 1;
+    return entry->nameLen == pProp->nameLen && !memcmp(entry->name, pProp->name, pProp->nameLen);
+}
+
+
+const uchar *wtiPropCacheLookup(wti_t *const pWti,
+                                const smsg_t *const pMsg,
+                                const msgPropDescr_t *const pProp,
+                                rs_size_t *const pLen) {
+    if (pWti == NULL || !pWti->propCache.bActive) return NULL;
+    for (int i = 0; i < WTI_PROP_CACHE_SIZE; ++i) {
+        const wtiPropCacheEntry_t *const entry = &pWti->propCache.entries[i];
+        if (wtiPropCacheMatches(entry, pMsg, pProp)) {
+            *pLen = entry->len;
+            return entry->val;
+        }
+    }
+    return NULL;
+}
+
+
+void wtiPropCacheStore(wti_t *const pWti,
+                       const smsg_t *const pMsg,
+                       const msgPropDescr_t *const pProp,
+                       uchar *const val,
+                       const rs_size_t len) {
+    wtiPropCacheEntry_t *entry;
+
+    /* global variables are shared by all workers and may change between two reads */
+    if (pWti == NULL || !pWti->propCache.bActive || pProp->id == PROP_GLOBAL_VAR) {
+        free(val);
+        return;
+    }
+    entry = &pWti->propCache.entries[pWti->propCache.next];
+    pWti->propCache.next = (pWti->propCache.next + 1) % WTI_PROP_CACHE_SIZE;
+    free(entry->val);
+    entry->val = val;
+    entry->len = len;
+    entry->id = pProp->id;
+    if (pProp->id == PROP_CEE || pProp->id == PROP_LOCAL_VAR) {
+        entry->name = pProp->name;
+        entry->nameLen = pProp->nameLen;
+    } else {
+        entry->name = NULL;
+    }
+    entry->pMsg = pMsg;
+}
+
+
+uchar *wtiMsgGetProp(wti_t *const pWti,
+                     smsg_t *const pMsg,
+                     msgPropDescr_t *const pProp,
+                     rs_size_t *const pLen,
+                     unsigned short *const pbMustBeFreed) {
+    const uchar *cached;
+    uchar *val;
+
+    if (pProp->id == PROP_CEE || pProp->id == PROP_LOCAL_VAR || pProp->id == PROP_GLOBAL_VAR) {
+        return MsgGetProp(pMsg, NULL, pProp, pLen, pbMustBeFreed, NULL);
+    }
+    if ((cached = wtiPropCacheLookup(pWti, pMsg, pProp, pLen)) != NULL) {
+        *pbMustBeFreed = 0;
+        return (uchar *)cached;
+    }
+    *pbMustBeFreed = 0;
+    val = MsgGetProp(pMsg, NULL, pProp, pLen, pbMustBeFreed, NULL);
+    if (*pbMustBeFreed && pWti != NULL && pWti->propCache.bActive) {
+        wtiPropCacheStore(pWti, pMsg, pProp, val, *pLen);
+        *pbMustBeFreed = 0;
+    }
+    return val;
+}
+
+
+void wtiFuncCacheBegin(wti_t *const pWti) {
+    wtiNoteMsgModified(pWti);
+    pWti->funcCache.bActive = 1;
+}
+
+
+void wtiFuncCacheEnd(wti_t *const pWti) {
+    for (int i = 0; i < WTI_FUNC_CACHE_SIZE; ++i) {
+        wtiFuncCacheEntry_t *const entry = &pWti->funcCache.entries[i];
+        entry->pMsg = NULL;
+        if (entry->estr != NULL) {
+            es_deleteStr(entry->estr);
+            entry->estr = NULL;
+        }
+    }
+    pWti->funcCache.bActive = 0;
+}
+
+
+const wtiFuncCacheEntry_t *wtiFuncCacheLookup(wti_t *const pWti, const smsg_t *const pMsg, const int memoId) {
+    if (!pWti->funcCache.bActive) return NULL;
+    for (int i = 0; i < WTI_FUNC_CACHE_SIZE; ++i) {
+        const wtiFuncCacheEntry_t *const entry = &pWti->funcCache.entries[i];
+        if (entry->pMsg == pMsg && entry->memoId == memoId) return entry;
+    }
+    return NULL;
+}
+
+
+void wtiFuncCacheStore(wti_t *const pWti,
+                       const smsg_t *const pMsg,
+                       const int memoId,
+                       const char datatype,
+                       const long long n,
+                       const es_str_t *const estr) {
+    wtiFuncCacheEntry_t *entry;
+
+    if (!pWti->funcCache.bActive) return;
+    entry = &pWti->funcCache.entries[pWti->funcCache.next];
+    pWti->funcCache.next = (pWti->funcCache.next + 1) % WTI_FUNC_CACHE_SIZE;
+    entry->pMsg = NULL;
+    if (entry->estr != NULL) {
+        es_deleteStr(entry->estr);
+        entry->estr = NULL;
+    }
+    if (datatype == 'S' && (entry->estr = es_strdup((es_str_t *)estr)) == NULL) {
+        return; /* just do not cache this one */
+    }
+    entry->datatype = datatype;
+    entry->n = n;
+    entry->memoId = memoId;
+    entry->script_errno = wtiGetScriptErrno(pWti);
+    entry->pMsg = pMsg;
+}
+
+
+void wtiScratchRelease(wti_t *const pWti, const size_t mark) {
+    size_t newSize;
+    uchar *newBuf;
+
+    if (pWti == NULL) return;
+    pWti->scratch.used = mark;
+    if (mark != 0 || pWti->scratch.demand <= pWti->scratch.size || pWti->scratch.size == WTI_SCRATCH_MAX) return;
+    /* nothing is in use, so the arena can be moved */
+    newSize = (pWti->scratch.size == 0) ? 1024 : pWti->scratch.size;
+    while (newSize < pWti->scratch.demand && newSize < WTI_SCRATCH_MAX) newSize *= 2;
+    if (newSize > WTI_SCRATCH_MAX) newSize = WTI_SCRATCH_MAX;
+    if ((newBuf = realloc(pWti->scratch.buf, newSize)) != NULL) {
+        pWti->scratch.buf = newBuf;
+        pWti->scratch.size = newSize;
+    }
+}
+
+
+redfaCache_t **wtiRedfaCache(wti_t *const pWti, const int idx) {
+    if (idx >= pWti->redfa.nCaches) {
+        redfaCache_t **const newCaches = realloc(pWti->redfa.caches, sizeof(redfaCache_t *) * (idx + 1));
+        if (newCaches == NULL) return NULL;
+        memset(newCaches + pWti->redfa.nCaches, 0, sizeof(redfaCache_t *) * (idx + 1 - pWti->redfa.nCaches));
+        pWti->redfa.caches = newCaches;
+        pWti->redfa.nCaches = idx + 1;
+    }
+    return &pWti->redfa.caches[idx];
+}
+
+
 /* Destructor */
 BEGINobjDestruct(wti) /* be sure to specify the object type also in END and CODESTART macros! */
     CODESTARTobjDestruct(wti);
@@ -279,6 +508,20 @@ BEGINobjDestruct(wti) /* be sure to specify the object type also in END and CODE
     /* actual destruction */
     batchFree(&pThis->batch);
     free(pThis->actWrkrInfo);
+    for (int i = 0; i < WTI_TPL_CACHE_SIZE; ++i) {
+        free(pThis->tplCache.entries[i].rendered.param);
+    }
+    for (int i = 0; i < WTI_PROP_CACHE_SIZE; ++i) {
+        free(pThis->propCache.entries[i].val);
+    }
+    for (int i = 0; i < WTI_FUNC_CACHE_SIZE; ++i) {
+        if (pThis->funcCache.entries[i].estr != NULL) es_deleteStr(pThis->funcCache.entries[i].estr);
+    }
+    free(pThis->scratch.buf);
+    for (int i = 0; i < pThis->redfa.nCaches; ++i) {
+        redfaCacheDestruct(&pThis->redfa.caches[i]);
+    }
+    free(pThis->redfa.caches);
     pthread_cond_destroy(&pThis->pcondBusy);
     DESTROY_ATOMIC_HELPER_MUT(pThis->mutIsRunning);
     free(pThis->pszDbgHdr);
@@ -373,9 +616,21 @@ int ATTR_NONNULL() wtiWaitNonEmpty(wti_t *const pThis, const struct timespec tim
  */
 static void ATTR_NONNULL() doIdleProcessing(wti_t *const pThis, wtp_t *const pWtp, int *const pbInactivityTOOccurred) {
     struct timespec t;
+    const uint64_t tStart = pThis->timing.bEnabled ? wtiTimingNow() : 0;
 
     DBGPRINTF("%s: worker IDLE, waiting for work.\n", wtiGetDbgHdr(pThis));
 
+    if (pThis->linger.bActive) {
+        /* some actions hold back their commit, so we must wake up in time */
+        if (d_pthread_cond_timedwait(&pThis->pcondBusy, pWtp->pmutUsr, &pThis->linger.deadline) != 0) {
+            d_pthread_mutex_unlock(pWtp->pmutUsr);
+            actionFlushLingering(pThis, 0);
+            d_pthread_mutex_lock(pWtp->pmutUsr);
+        }
+        wtiTimingStop(&pThis->timing.idle, tStart);
+        return;
+    }
+
     if (pThis->bAlwaysRunning) {
         /* never shut down any started worker */
         d_pthread_cond_wait(&pThis->pcondBusy, pWtp->pmutUsr);
@@ -386,10 +641,50 @@ static void ATTR_NONNULL() doIdleProcessing(wti_t *const pThis, wtp_t *const pWt
             *pbInactivityTOOccurred = 1; /* indicate we had a timeout */
         }
     }
+    wtiTimingStop(&pThis->timing.idle, tStart);
     DBGOPRINT((obj_t *)pThis, "worker awoke from idle processing\n");
 }
 
 
+/* free the action worker instances this worker has created. Must be
+ * called by the worker itself when it terminates.
+ */
+void ATTR_NONNULL() wtiFreeActWrkrs(wti_t *const pThis) {
+    action_t *pAction;
+    actWrkrInfo_t *wrkrInfo;
+    int i, j, k;
+
+    DBGPRINTF("DDDD: wti %p: worker cleanup action instances\n", pThis);
+    for (i = 0; i < runConf->actions.iActionNbr; ++i) {
+        wrkrInfo = &(pThis->actWrkrInfo[i]);
+        dbgprintf("wti %p, action %d, ptr %p\n", pThis, i, wrkrInfo->actWrkrData);
+        if (wrkrInfo->actWrkrData != NULL) {
+            pAction = wrkrInfo->pAction;
+            actionRemoveWorker(pAction, wrkrInfo->actWrkrData);
+            pAction->pMod->mod.om.freeWrkrInstance(wrkrInfo->actWrkrData);
+            if (pAction->isTransactional) {
+                /* free iparam "cache" - we need to go through to max! */
+                for (j = 0; j < wrkrInfo->p.tx.maxIParams; ++j) {
+                    for (k = 0; k < pAction->iNumTpls; ++k) {
+                        free(actParam(wrkrInfo->p.tx.iparams, pAction->iNumTpls, j, k).param);
+                    }
+                }
+                free(wrkrInfo->p.tx.iparams);
+                wrkrInfo->p.tx.iparams = NULL;
+                wrkrInfo->p.tx.currIParam = 0;
+                wrkrInfo->p.tx.maxIParams = 0;
+                free(wrkrInfo->p.tx.rcvdAt);
+                wrkrInfo->p.tx.rcvdAt = NULL;
+                wrkrInfo->p.tx.maxRcvdAt = 0;
+            } else {
+                releaseDoActionParams(pAction, pThis, 1);
+            }
+            wrkrInfo->actWrkrData = NULL; /* re-init for next activation */
+        }
+    }
+}
+
+
 /* generic worker thread framework. Note that we prohibit cancellation
  * during almost all times, because it can have very undesired side effects.
  * However, we may need to cancel a thread if the consumer blocks for too
@@ -399,12 +694,9 @@ static void ATTR_NONNULL() doIdleProcessing(wti_t *const pThis, wtp_t *const pWt
 PRAGMA_DIAGNOSTIC_PUSH
 PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
     wtp_t *__restrict__ const pWtp = pThis->pWtp; /* our worker thread pool -- shortcut */
-    action_t *__restrict__ pAction;
     rsRetVal localRet;
     rsRetVal terminateRet;
-    actWrkrInfo_t *__restrict__ wrkrInfo;
     int iCancelStateSave;
-    int i, j, k;
     DEFiRet;
 
     dbgSetThrdName(pThis->pszDbgHdr);
@@ -471,31 +763,8 @@ PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
 
     d_pthread_mutex_unlock(pWtp->pmutUsr);
 
-    DBGPRINTF("DDDD: wti %p: worker cleanup action instances\n", pThis);
-    for (i = 0; i < runConf->actions.iActionNbr; ++i) {
-        wrkrInfo = &(pThis->actWrkrInfo[i]);
-        dbgprintf("wti %p, action %d, ptr %p\n", pThis, i, wrkrInfo->actWrkrData);
-        if (wrkrInfo->actWrkrData != NULL) {
-            pAction = wrkrInfo->pAction;
-            actionRemoveWorker(pAction, wrkrInfo->actWrkrData);
-            pAction->pMod->mod.om.freeWrkrInstance(wrkrInfo->actWrkrData);
-            if (pAction->isTransactional) {
-                /* free iparam "cache" - we need to go through to max! */
-                for (j = 0; j < wrkrInfo->p.tx.maxIParams; ++j) {
-                    for (k = 0; k < pAction->iNumTpls; ++k) {
-                        free(actParam(wrkrInfo->p.tx.iparams, pAction->iNumTpls, j, k).param);
-                    }
-                }
-                free(wrkrInfo->p.tx.iparams);
-                wrkrInfo->p.tx.iparams = NULL;
-                wrkrInfo->p.tx.currIParam = 0;
-                wrkrInfo->p.tx.maxIParams = 0;
-            } else {
-                releaseDoActionParams(pAction, pThis, 1);
-            }
-            wrkrInfo->actWrkrData = NULL; /* re-init for next activation */
-        }
-    }
+    actionFlushLingering(pThis, 1);
+    wtiFreeActWrkrs(pThis);
 
     /* indicate termination */
     pthread_cleanup_pop(0); /* remove cleanup handler */
@@ -23,11 +23,14 @@
 #define WTI_H_INCLUDED
 
 #include <pthread.h>
+#include <time.h>
 #include <stdlib.h>
+#include <libestr.h>
 #include "wtp.h"
 #include "obj.h"
 #include "batch.h"
 #include "action.h"
+#include "redfa.h"
 
 
 #define ACT_STATE_RDY 0 /* action ready, waiting for new transaction */
@@ -52,6 +55,12 @@ typedef struct actWrkrInfo {
                     immediate failure following */
     int iNbrResRtry; /* number of retries since last suspend */
     sbool bHadAutoCommit; /* did an auto-commit happen during doAction()? */
+    struct {
+        sbool bActive; /* commit of the buffered messages is held back */
+        int nCounted; /* messages already added to bytes */
+        size_t bytes; /* size of the rendered messages held back */
+        struct timespec deadline; /* when the commit must be done at the latest */
+    } linger; /* see action.linger.* */
     struct {
         unsigned actState : 3;
     } flags;
@@ -60,6 +69,8 @@ typedef struct actWrkrInfo {
             actWrkrIParams_t *iparams; /* dynamically sized array for transactional outputs */
             int currIParam;
             int maxIParams; /* current max */
+            int64_t *rcvdAt; /* reception times (ms) of the buffered msgs, for action.latency.* */
+            int maxRcvdAt;
         } tx;
         struct {
             actWrkrIParams_t actParams[CONF_OMOD_NUMSTRINGS_MAXSIZE];
@@ -67,6 +78,84 @@ typedef struct actWrkrInfo {
     } p; /* short name for "parameters" */
 } actWrkrInfo_t;
 
+/**
+ * @brief Number of template renderings a worker keeps for the current batch.
+ *
+ * Fan-out configurations usually reference a shared template from a handful
+ * of actions, so a small round-robin table is sufficient.
+ */
+#define WTI_TPL_CACHE_SIZE 8
+
+struct template;
+
+/**
+ * @struct wtiTplCacheEntry_s
+ * @brief A template rendering that other actions may reuse.
+ *
+ * An entry is only valid while its worker processes the batch the message
+ * belongs to; see wtiTplCacheBegin() and wtiNoteMsgModified().
+ */
+typedef struct wtiTplCacheEntry_s {
+    const smsg_t *pMsg; /**< message that was rendered, NULL if entry is unused */
+    const struct template *pTpl; /**< template that was rendered */
+    actWrkrIParams_t rendered; /**< rendered string, buffer is owned by the cache */
+} wtiTplCacheEntry_t;
+
+/**
+ * @brief Number of property values a worker keeps for the current batch.
+ *
+ * Only values that MsgGetProp() or the JSON lookup had to allocate are
+ * cached, which are few per message.
+ */
+#define WTI_PROP_CACHE_SIZE 16
+
+/**
+ * @struct wtiPropCacheEntry_s
+ * @brief A property value that later script statements may reuse.
+ *
+ * Invalidated the same way as the template cache. The buffer is kept until
+ * the entry is reused, so that callers holding a pointer to it are not
+ * affected by an invalidation.
+ */
+typedef struct wtiPropCacheEntry_s {
+    const smsg_t *pMsg; /**< message the value belongs to, NULL if entry is unused */
+    propid_t id; /**< property id */
+    const uchar *name; /**< path for JSON properties, owned by the property descriptor */
+    int nameLen;
+    uchar *val; /**< NUL-terminated value, owned by the cache */
+    rs_size_t len;
+} wtiPropCacheEntry_t;
+
+/**
+ * @brief Number of function results a worker keeps for the current message.
+ *
+ * Only calls the optimizer found to be repeated in the config are cached,
+ * see cnfstmtCollectMemoCalls().
+ */
+#define WTI_FUNC_CACHE_SIZE 16
+
+/**
+ * @struct wtiFuncCacheEntry_s
+ * @brief The result of a pure RainerScript function call.
+ *
+ * Invalidated the same way as the template cache.
+ */
+typedef struct wtiFuncCacheEntry_s {
+    const smsg_t *pMsg; /**< message the result belongs to, NULL if entry is unused */
+    int memoId; /**< identifies the call, shared by all identical calls */
+    uint8_t script_errno; /**< script_error() after the call */
+    char datatype; /**< 'N' or 'S' */
+    long long n;
+    es_str_t *estr; /**< owned by the cache */
+} wtiFuncCacheEntry_t;
+
+/**
+ * @brief Upper bound for the size of a worker's scratch arena.
+ *
+ * Larger temporaries are allocated on the heap as before.
+ */
+#define WTI_SCRATCH_MAX (64 * 1024)
+
 /* the worker thread instance class */
 struct wti_s {
     BEGINobjInstance
@@ -91,6 +180,45 @@ struct wti_s {
                                     * also be added as a user-selectable option (not implemented yet)
                                     */
         } execState; /* state for the execution engine */
+        struct {
+            sbool bActive; /* only set while a ruleset batch is being processed */
+            int next; /* round-robin replacement slot */
+            wtiTplCacheEntry_t entries[WTI_TPL_CACHE_SIZE];
+        } tplCache; /* per-batch template render cache */
+        struct {
+            sbool bActive; /* only set while a ruleset batch is being processed */
+            int next; /* round-robin replacement slot */
+            wtiPropCacheEntry_t entries[WTI_PROP_CACHE_SIZE];
+        } propCache; /* per-batch property value cache */
+        struct {
+            sbool bActive; /* only set while a ruleset batch is being processed */
+            int next; /* round-robin replacement slot */
+            wtiFuncCacheEntry_t entries[WTI_FUNC_CACHE_SIZE];
+        } funcCache; /* per-batch function result cache */
+        struct {
+            uchar *buf;
+            size_t size;
+            size_t used;
+            size_t demand; /* largest size needed so far, buffer grows to it once it is empty */
+        } scratch; /* arena for temporary strings of script evaluation, see wtiScratchAlloc() */
+        struct {
+            redfaCache_t **caches; /* indexed by automaton number */
+            int nCaches;
+        } redfa; /* this worker's state of the combined regex automata */
+        struct {
+            sbool bActive; /* an action of this worker holds back a commit */
+            sbool bInhibit; /* commit immediately, e.g. while flushing */
+            struct timespec deadline; /* earliest deadline of all actions */
+        } linger; /* see actionFlushLingering() */
+        struct {
+            sbool bEnabled; /* the worker's queue has queue.timing on */
+            sbool bActive; /* the current batch is timed */
+            int nBatches; /* batches since the last timed one */
+            uint64_t tPhase; /* when the current phase began */
+            uint64_t idle; /* us waited for work, not yet added to the queue counters */
+            uint64_t render; /* us spent rendering templates in the current batch */
+            uint64_t output; /* us spent in output modules in the current batch */
+        } timing; /* see queue.timing */
 };
 
 
@@ -99,6 +227,7 @@ rsRetVal wtiConstruct(wti_t **ppThis);
 rsRetVal wtiConstructFinalize(wti_t *const pThis);
 rsRetVal wtiDestruct(wti_t **ppThis);
 rsRetVal wtiWorker(wti_t *const pThis);
+void ATTR_NONNULL() wtiFreeActWrkrs(wti_t *const pThis);
 rsRetVal wtiSetDbgHdr(wti_t *const pThis, uchar *pszMsg, size_t lenMsg);
 uchar *ATTR_NONNULL() wtiGetDbgHdr(const wti_t *const pThis);
 rsRetVal wtiCancelThrd(wti_t *const pThis, const uchar *const cancelobj);
@@ -142,4 +271,173 @@ static inline void __attribute__((unused)) wtiResetExecState(wti_t *const pWti,
 
 
 rsRetVal wtiNewIParam(wti_t *const pWti, action_t *const pAction, actWrkrIParams_t **piparams);
+
+/** Enable the template render cache for the batch that is about to be processed. */
+void wtiTplCacheBegin(wti_t *const pWti);
+
+/** Drop all cached renderings and disable the cache until the next wtiTplCacheBegin(). */
+void wtiTplCacheEnd(wti_t *const pWti);
+
+/**
+ * Find a rendering of @p pTpl for @p pMsg produced earlier in this batch.
+ *
+ * @return the cached rendering or NULL if there is none. The returned
+ *         buffer is owned by the cache and must be copied by the caller.
+ */
+const actWrkrIParams_t *wtiTplCacheLookup(wti_t *const pWti, const smsg_t *const pMsg, const struct template *const pTpl);
+
+/**
+ * Keep a copy of @p rendered for reuse by later actions of the same batch.
+ * Failing to cache is not an error, so nothing is returned.
+ */
+void wtiTplCacheStore(wti_t *const pWti,
+                      const smsg_t *const pMsg,
+                      const struct template *const pTpl,
+                      const actWrkrIParams_t *const rendered);
+
+/** Enable the property value cache for the batch that is about to be processed. */
+void wtiPropCacheBegin(wti_t *const pWti);
+
+/** Drop all cached property values and disable the cache until the next wtiPropCacheBegin(). */
+void wtiPropCacheEnd(wti_t *const pWti);
+
+/**
+ * Find a value of @p pProp for @p pMsg stored earlier in this batch.
+ *
+ * @return the cached NUL-terminated value or NULL if there is none. The
+ *         buffer is owned by the cache. It stays valid until the next
+ *         wtiPropCacheStore() on this worker, even if the message is
+ *         modified in between.
+ */
+const uchar *wtiPropCacheLookup(wti_t *const pWti,
+                                const smsg_t *const pMsg,
+                                const msgPropDescr_t *const pProp,
+                                rs_size_t *const pLen);
+
+/**
+ * Hand an allocated property value over to the cache. @p val must be
+ * NUL-terminated and is freed by the cache (immediately, if the cache is
+ * not active).
+ */
+void wtiPropCacheStore(wti_t *const pWti,
+                       const smsg_t *const pMsg,
+                       const msgPropDescr_t *const pProp,
+                       uchar *const val,
+                       const rs_size_t len);
+
+/**
+ * MsgGetProp() via the property cache. Semantics are the same, except that
+ * values which needed to be allocated are kept in the cache instead of
+ * being handed to the caller; *pbMustBeFreed tells which case applies.
+ * JSON properties are passed through uncached, as script evaluation needs
+ * them in their native representation.
+ */
+uchar *wtiMsgGetProp(wti_t *const pWti,
+                     smsg_t *const pMsg,
+                     msgPropDescr_t *const pProp,
+                     rs_size_t *const pLen,
+                     unsigned short *const pbMustBeFreed);
+
+/** Enable the function result cache for the batch that is about to be processed. */
+void wtiFuncCacheBegin(wti_t *const pWti);
+
+/** Drop all cached function results and disable the cache until the next wtiFuncCacheBegin(). */
+void wtiFuncCacheEnd(wti_t *const pWti);
+
+/**
+ * Find the result of call @p memoId for @p pMsg stored earlier in this batch.
+ *
+ * @return the entry or NULL if there is none. The entry's string is owned
+ *         by the cache and must be copied by the caller.
+ */
+const wtiFuncCacheEntry_t *wtiFuncCacheLookup(wti_t *const pWti, const smsg_t *const pMsg, const int memoId);
+
+/**
+ * Remember the result of call @p memoId for @p pMsg. Only number and string
+ * results can be stored; @p estr is copied, so the caller keeps ownership.
+ * Failing to cache is not an error, so nothing is returned.
+ */
+void wtiFuncCacheStore(wti_t *const pWti,
+                       const smsg_t *const pMsg,
+                       const int memoId,
+                       const char datatype,
+                       const long long n,
+                       const es_str_t *const estr);
+
+/**
+ * Allocate @p len bytes of temporary memory from the worker's scratch arena.
+ *
+ * The memory stays valid until wtiScratchRelease() is called with a mark
+ * obtained before the allocation. It must not be freed.
+ *
+ * @return the memory or NULL if the arena is too small. The caller must
+ *         then use the heap. The arena grows to the needed size on the next
+ *         full release, so this happens only during warm-up.
+ */
+static inline uchar *ATTR_UNUSED wtiScratchAlloc(wti_t *const pWti, const size_t len) {
+    uchar *p;
+    if (pWti == NULL) return NULL;
+    if (pWti->scratch.used + len > pWti->scratch.size) {
+        if (pWti->scratch.used + len > pWti->scratch.demand) pWti->scratch.demand = pWti->scratch.used + len;
+        return NULL;
+    }
+    p = pWti->scratch.buf + pWti->scratch.used;
+    pWti->scratch.used += (len + 7) & ~(size_t)7;
+    return p;
+}
+
+/** The current fill level of the scratch arena, to be passed to wtiScratchRelease(). */
+static inline size_t ATTR_UNUSED wtiScratchMark(const wti_t *const pWti) {
+    return (pWti == NULL) ? 0 : pWti->scratch.used;
+}
+
+/**
+ * Free all scratch memory allocated after @p mark was obtained. Marks
+ * must be released in reverse order.
+ */
+void wtiScratchRelease(wti_t *const pWti, const size_t mark);
+
+/**
+ * This worker's cache slot for combined regex automaton @p idx, to be
+ * passed to redfaMatch(). Slots are created on first use.
+ *
+ * @return the slot or NULL if out of memory
+ */
+redfaCache_t **wtiRedfaCache(wti_t *const pWti, const int idx);
+
+/**
+ * Tell the worker that script execution modified the current message.
+ *
+ * Must be called whenever message content may change after templates were
+ * rendered or properties fetched (set/unset, foreach iterator, parse_json(),
+ * message modification modules) so that no stale data is reused.
+ */
+static inline void ATTR_UNUSED ATTR_NONNULL() wtiNoteMsgModified(wti_t *const pWti) {
+    for (int i = 0; i < WTI_TPL_CACHE_SIZE; ++i) {
+        pWti->tplCache.entries[i].pMsg = NULL;
+    }
+    for (int i = 0; i < WTI_PROP_CACHE_SIZE; ++i) {
+        pWti->propCache.entries[i].pMsg = NULL;
+    }
+    for (int i = 0; i < WTI_FUNC_CACHE_SIZE; ++i) {
+        pWti->funcCache.entries[i].pMsg = NULL;
+    }
+}
+
+/** Monotonic clock in microseconds, for queue.timing. */
+static inline uint64_t ATTR_UNUSED wtiTimingNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/** Begin timing a phase of the current batch; returns 0 if the batch is not timed. */
+static inline uint64_t ATTR_UNUSED ATTR_NONNULL() wtiTimingStart(const wti_t *const pWti) {
+    return pWti->timing.bActive ? wtiTimingNow() : 0;
+}
+
+/** Add the time since @p tStart, as returned by wtiTimingStart(), to @p pPhase. */
+static inline void ATTR_UNUSED ATTR_NONNULL() wtiTimingStop(uint64_t *const pPhase, const uint64_t tStart) {
+    if (tStart != 0) *pPhase += wtiTimingNow() - tStart;
+}
 #endif /* #ifndef WTI_H_INCLUDED */
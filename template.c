@@ -48,6 +48,8 @@
 #include "msg.h"
 #include "parserif.h"
 #include "unicode-helper.h"
+#include "strscan.h"
+#include "jsonwriter.h"
 
 /* states for lazily built JSON tree used in list templates with jsonf mode */
 #define TPL_JSON_TREE_NOT_BUILT 0
@@ -76,8 +78,10 @@ static rsRetVal tplJsonAddValueNode(
     struct tplJsonNode *parent, struct templateEntry *pTpe, const uchar *name, size_t nameLen, int *pUnsupported);
 static rsRetVal tplJsonBuildTree(struct template *pTpl);
 static rsRetVal tplJsonRender(struct template *pTpl, smsg_t *pMsg, actWrkrIParams_t *iparam, struct syslogTime *ttNow);
-static rsRetVal tplJsonRenderChildren(
-    const struct tplJsonNode *parent, smsg_t *pMsg, struct syslogTime *ttNow, es_str_t **ppDst, int *pNeedComma);
+static rsRetVal tplJsonRenderChildren(const struct tplJsonNode *parent,
+                                      smsg_t *pMsg,
+                                      struct syslogTime *ttNow,
+                                      jsonWriter_t *w);
 
 /** Returns true when at least one field lacks explicit secure path handling. */
 static int tplNeedsDynafileSecureDefault(const struct template *const pTpl) {
@@ -110,10 +114,35 @@ static void tplApplyDynafileSecureDefault(struct template *const pTpl) {
 }
 
 
+/**
+ * Checks if the rendering of a template depends on message content only.
+ *
+ * Time-dependent system properties and global variables may change between
+ * two actions processing the same message, so templates referencing them
+ * must never be served from the worker render cache.
+ */
+static int tplIsRenderCacheable(const struct template *const pTpl) {
+    const struct templateEntry *pTpe;
+
+    if (pTpl->bHaveSubtree && pTpl->subtree.id == PROP_GLOBAL_VAR) return 0;
+    for (pTpe = pTpl->pEntryRoot; pTpe != NULL; pTpe = pTpe->pNext) {
+        if (pTpe->eEntryType != FIELD) continue;
+        const propid_t id = pTpe->data.field.msgProp.id;
+        if (id == PROP_GLOBAL_VAR) return 0;
+        if (id >= PROP_SYS_NOW && id < PROP_CEE && id != PROP_UUID) return 0;
+    }
+    return 1;
+}
+
+
 /** Records a template use and enforces compatibility.defaults.secure policy. */
 void tplNoteUse(struct template *const pTpl, const int bDynafile) {
     assert(pTpl != NULL);
 
+    if (pTpl->nActionRefs++ == 0) {
+        pTpl->bRenderCacheable = tplIsRenderCacheable(pTpl);
+    }
+
     if (bDynafile) {
         pTpl->bUsedAsDynafile = 1;
     } else {
@@ -155,12 +184,18 @@ void tplNoteUse(struct template *const pTpl, const int bDynafile) {
         pTpl->bWarnedDynafileSecureDefault = 1;
     }
 }
-static rsRetVal tplJsonRenderNode(
-    const struct tplJsonNode *node, smsg_t *pMsg, struct syslogTime *ttNow, es_str_t **ppOut, int *pHasOutput);
-static rsRetVal tplJsonRenderValue(
-    const struct tplJsonNode *node, smsg_t *pMsg, struct syslogTime *ttNow, es_str_t **ppOut, int *pHasOutput);
-static rsRetVal tplJsonRenderObject(
-    const struct tplJsonNode *node, smsg_t *pMsg, struct syslogTime *ttNow, es_str_t **ppOut, int *pHasOutput);
+static rsRetVal tplJsonRenderNode(const struct tplJsonNode *node,
+                                smsg_t *pMsg,
+                                struct syslogTime *ttNow,
+                                jsonWriter_t *w);
+static rsRetVal tplJsonRenderValue(const struct tplJsonNode *node,
+                                 smsg_t *pMsg,
+                                 struct syslogTime *ttNow,
+                                 jsonWriter_t *w);
+static rsRetVal tplJsonRenderObject(const struct tplJsonNode *node,
+                                  smsg_t *pMsg,
+                                  struct syslogTime *ttNow,
+                                  jsonWriter_t *w);
 static void tplWarnDuplicateJsonKeys(struct template *pTpl);
 
 /**
@@ -423,70 +458,45 @@ finalize_it:
  * \retval RS_RET_OK on success or an error code from subordinate lookups.
  */
 static rsRetVal tplJsonRender(struct template *pTpl, smsg_t *pMsg, actWrkrIParams_t *iparam, struct syslogTime *ttNow) {
-    es_str_t *out = NULL;
-    char *rendered = NULL;
-    int needComma = 0;
+    jsonWriter_t w;
     DEFiRet;
 
     if (pTpl->pJsonRoot == NULL) RETiRet;
 
-    CHKmalloc(out = es_newStr(128));
-    es_addChar(&out, '{');
-    CHKiRet(tplJsonRenderChildren(pTpl->pJsonRoot, pMsg, ttNow, &out, &needComma));
-    es_addBufConstcstr(&out, "}\n");
-
-    const int len = es_strlen(out);
-    if ((size_t)len + 1 > (size_t)iparam->lenBuf) {
-        CHKiRet(ExtendBuf(iparam, (size_t)len + 1));
-    }
-    CHKmalloc(rendered = es_str2cstr(out, NULL));
-    memcpy(iparam->param, rendered, (size_t)len);
-    iparam->param[len] = '\0';
-    iparam->lenStr = len;
+    jsonWriterInit(&w, iparam, 0, ", ");
+    CHKiRet(jsonWriterBeginObject(&w));
+    CHKiRet(tplJsonRenderChildren(pTpl->pJsonRoot, pMsg, ttNow, &w));
+    CHKiRet(jsonWriterEndObject(&w));
+    CHKiRet(jsonWriterAppend(&w, "\n", 1));
+    CHKiRet(jsonWriterFinish(&w));
 
 finalize_it:
-    if (rendered != NULL) free(rendered);
-    if (out != NULL) es_deleteStr(out);
     RETiRet;
 }
 
 /**
- * \brief Render all children of a JSON node, inserting commas as needed.
+ * \brief Render all children of a JSON node.
  *
- * Recursively descends into the tree and appends emitted fragments to the
- * destination string buffer.
+ * Recursively descends into the tree; the writer inserts the member
+ * separators as needed.
  *
  * \param parent     Node whose children should be rendered.
  * \param pMsg       Message that provides runtime values.
  * \param ttNow      Timestamp context for property formatting.
- * \param ppDst      Destination string buffer reference.
- * \param pNeedComma Tracks whether a comma should precede the next child.
+ * \param w          Writer positioned inside the parent object.
  */
-static rsRetVal tplJsonRenderChildren(
-    const struct tplJsonNode *parent, smsg_t *pMsg, struct syslogTime *ttNow, es_str_t **ppDst, int *pNeedComma) {
-    const struct tplJsonNode *child = parent->firstChild;
-    es_str_t *childStr = NULL;
-    int childHasOutput = 0;
+static rsRetVal tplJsonRenderChildren(const struct tplJsonNode *parent,
+                                      smsg_t *pMsg,
+                                      struct syslogTime *ttNow,
+                                      jsonWriter_t *w) {
+    const struct tplJsonNode *child;
     DEFiRet;
 
-    while (child != NULL) {
-        childStr = NULL;
-        childHasOutput = 0;
-        CHKiRet(tplJsonRenderNode(child, pMsg, ttNow, &childStr, &childHasOutput));
-        if (childHasOutput) {
-            if (*pNeedComma) es_addBufConstcstr(ppDst, ", ");
-            es_addStr(ppDst, childStr);
-            *pNeedComma = 1;
-        }
-        if (childStr != NULL) {
-            es_deleteStr(childStr);
-            childStr = NULL;
-        }
-        child = child->nextSibling;
+    for (child = parent->firstChild; child != NULL; child = child->nextSibling) {
+        CHKiRet(tplJsonRenderNode(child, pMsg, ttNow, w));
     }
 
 finalize_it:
-    if (childStr != NULL) es_deleteStr(childStr);
     RETiRet;
 }
 
@@ -499,43 +509,43 @@ finalize_it:
  * \param node       Node to render.
  * \param pMsg       Message providing data.
  * \param ttNow      Timestamp context.
- * \param ppOut      Output string produced for this node.
- * \param pHasOutput Flag indicating whether a value was emitted.
+ * \param w          Writer receiving the output.
  */
-static rsRetVal tplJsonRenderNode(
-    const struct tplJsonNode *node, smsg_t *pMsg, struct syslogTime *ttNow, es_str_t **ppOut, int *pHasOutput) {
+static rsRetVal tplJsonRenderNode(const struct tplJsonNode *node,
+                                  smsg_t *pMsg,
+                                  struct syslogTime *ttNow,
+                                  jsonWriter_t *w) {
     if (node->type == tplJsonNodeValue) {
-        return tplJsonRenderValue(node, pMsg, ttNow, ppOut, pHasOutput);
+        return tplJsonRenderValue(node, pMsg, ttNow, w);
     }
-    return tplJsonRenderObject(node, pMsg, ttNow, ppOut, pHasOutput);
+    return tplJsonRenderObject(node, pMsg, ttNow, w);
 }
 
 /**
- * \brief Render a scalar template entry into a JSON name/value fragment.
+ * \brief Render a scalar template entry as JSON name/value pair.
  *
  * Handles both constant and property-backed entries, including trimming any
- * legacy jsonf field prefixes and skipping empty expansions.
+ * legacy jsonf field prefixes and skipping empty expansions. The value is
+ * already JSON-encoded by the property layer and thus written verbatim.
  *
  * \param node       Value node describing the template entry.
  * \param pMsg       Message context for property lookups.
  * \param ttNow      Timestamp context.
- * \param ppOut      Newly allocated string with the rendered fragment.
- * \param pHasOutput Set to 1 if the fragment contains data.
+ * \param w          Writer receiving the output; nothing is written for
+ *                   empty values.
  */
-static rsRetVal tplJsonRenderValue(
-    const struct tplJsonNode *node, smsg_t *pMsg, struct syslogTime *ttNow, es_str_t **ppOut, int *pHasOutput) {
+static rsRetVal tplJsonRenderValue(const struct tplJsonNode *node,
+                                   smsg_t *pMsg,
+                                   struct syslogTime *ttNow,
+                                   jsonWriter_t *w) {
     uchar *pVal = NULL;
     rs_size_t lenVal = 0;
     unsigned short bMustBeFreed = 0;
-    es_str_t *out = NULL;
     const uchar *valuePtr;
     size_t valueLen;
     const uchar *colon;
     DEFiRet;
 
-    *ppOut = NULL;
-    *pHasOutput = 0;
-
     if (node->pTpe == NULL || node->name == NULL || node->nameLen == 0) RETiRet;
 
     if (node->pTpe->eEntryType == CONSTANT) {
@@ -591,91 +601,50 @@ static rsRetVal tplJsonRenderValue(
     if (valueLen == 0) {
         FINALIZE;
     }
-    const size_t requiredLen = node->nameLen + valueLen + 4;
-    if (requiredLen > (size_t)INT_MAX) {
-        parser_errmsg("error: jsonf value to be rendered is too large");
-        ABORT_FINALIZE(RS_RET_ERR);
-    }
-    CHKmalloc(out = es_newStr((int)requiredLen));
-    es_addChar(&out, '"');
-    es_addBuf(&out, (const char *)node->name, node->nameLen);
-    es_addBufConstcstr(&out, "\":");
-    es_addBuf(&out, (const char *)valuePtr, valueLen);
-
-    *ppOut = out;
-    out = NULL;
-    *pHasOutput = 1;
+    /* field names are emitted as configured, like the legacy renderer did */
+    CHKiRet(jsonWriterKeyRaw(w, node->name, node->nameLen));
+    CHKiRet(jsonWriterRaw(w, valuePtr, valueLen));
 
 finalize_it:
     if (bMustBeFreed && pVal != NULL) free(pVal);
-    if (out != NULL) es_deleteStr(out);
     RETiRet;
 }
 
 /**
  * \brief Render an object node and all nested children into JSON.
  *
- * Skips empty objects to preserve legacy behaviour while ensuring commas
- * and braces are placed consistently.
+ * Skips empty objects to preserve legacy behaviour: the object is written
+ * speculatively and rolled back if none of its children emitted a field.
  *
  * \param node       Object node to render.
  * \param pMsg       Message supplying data for descendants.
  * \param ttNow      Timestamp context.
- * \param ppOut      Output string containing the rendered object.
- * \param pHasOutput Flag set when the object emitted any fields.
+ * \param w          Writer receiving the output.
  */
-static rsRetVal tplJsonRenderObject(
-    const struct tplJsonNode *node, smsg_t *pMsg, struct syslogTime *ttNow, es_str_t **ppOut, int *pHasOutput) {
-    es_str_t *out = NULL;
-    es_str_t *childStr = NULL;
-    int needComma = 0;
-    const struct tplJsonNode *child;
+static rsRetVal tplJsonRenderObject(const struct tplJsonNode *node,
+                                    smsg_t *pMsg,
+                                    struct syslogTime *ttNow,
+                                    jsonWriter_t *w) {
+    jsonWriterMark_t mark;
+    size_t lenEmpty;
     DEFiRet;
 
-    *ppOut = NULL;
-    *pHasOutput = 0;
-
     if (node->name == NULL || node->nameLen == 0) RETiRet;
 
-    const size_t requiredLen = node->nameLen + 5;
-    if (requiredLen > (size_t)INT_MAX) {
-        parser_errmsg("error: jsonf object key to be rendered is too large");
-        ABORT_FINALIZE(RS_RET_ERR);
-    }
-    CHKmalloc(out = es_newStr((int)requiredLen));
-    es_addChar(&out, '"');
-    es_addBuf(&out, (const char *)node->name, node->nameLen);
-    es_addBufConstcstr(&out, "\": {");
-
-    child = node->firstChild;
-    while (child != NULL) {
-        childStr = NULL;
-        int childHasOutput = 0;
-        CHKiRet(tplJsonRenderNode(child, pMsg, ttNow, &childStr, &childHasOutput));
-        if (childHasOutput) {
-            if (needComma) es_addBufConstcstr(&out, ", ");
-            es_addStr(&out, childStr);
-            needComma = 1;
-        }
-        if (childStr != NULL) {
-            es_deleteStr(childStr);
-            childStr = NULL;
-        }
-        child = child->nextSibling;
-    }
+    jsonWriterMark(w, &mark);
+    CHKiRet(jsonWriterKeyRaw(w, node->name, node->nameLen));
+    CHKiRet(jsonWriterAppend(w, " ", 1));
+    CHKiRet(jsonWriterBeginObject(w));
+    lenEmpty = w->len;
+    CHKiRet(tplJsonRenderChildren(node, pMsg, ttNow, w));
 
-    if (!needComma) {
+    if (w->len == lenEmpty) {
+        jsonWriterRollback(w, &mark);
         FINALIZE;
     }
-
-    es_addChar(&out, '}');
-    *ppOut = out;
-    out = NULL;
-    *pHasOutput = 1;
+    CHKiRet(jsonWriterEndObject(w));
 
 finalize_it:
-    if (childStr != NULL) es_deleteStr(childStr);
-    if (out != NULL) es_deleteStr(out);
     RETiRet;
 }
 
@@ -790,6 +759,259 @@ finalize_it:
 }
 
 
+/* Specialized template renderers ("compiled templates").
+ *
+ * Hand-written strgen modules are fast because they know the properties
+ * they need up front: they obtain all values, size the buffer once and
+ * then copy. tplCompileAll() gives list and string templates the same
+ * structure by selecting a kernel for each entry at config load. Kernels
+ * for plain message properties call the msg accessors directly instead of
+ * going through the generic MsgGetProp() dispatch.
+ */
+#define TPL_COMPILED_MAX_OPS 64
+
+typedef uchar *(*tplKernel_t)(struct templateEntry *const pTpe,
+                              smsg_t *const pMsg,
+                              rs_size_t *const pLen,
+                              unsigned short *const pbMustBeFreed,
+                              struct syslogTime *const ttNow);
+
+struct tplCompiledOp {
+    tplKernel_t kernel;
+    struct templateEntry *pTpe;
+};
+
+static uchar *tplKernConstant(struct templateEntry *const pTpe,
+                              smsg_t __attribute__((unused)) *const pMsg,
+                              rs_size_t *const pLen,
+                              unsigned short *const pbMustBeFreed,
+                              struct syslogTime __attribute__((unused)) *const ttNow) {
+    *pbMustBeFreed = 0;
+    *pLen = pTpe->data.constant.iLenConstant;
+    return pTpe->data.constant.pConstant;
+}
+
+static uchar *tplKernMsg(struct templateEntry __attribute__((unused)) *const pTpe,
+                         smsg_t *const pMsg,
+                         rs_size_t *const pLen,
+                         unsigned short *const pbMustBeFreed,
+                         struct syslogTime __attribute__((unused)) *const ttNow) {
+    *pbMustBeFreed = 0;
+    *pLen = getMSGLen(pMsg);
+    return getMSG(pMsg);
+}
+
+static uchar *tplKernHostname(struct templateEntry __attribute__((unused)) *const pTpe,
+                              smsg_t *const pMsg,
+                              rs_size_t *const pLen,
+                              unsigned short *const pbMustBeFreed,
+                              struct syslogTime __attribute__((unused)) *const ttNow) {
+    *pbMustBeFreed = 0;
+    *pLen = getHOSTNAMELen(pMsg);
+    return (uchar *)getHOSTNAME(pMsg);
+}
+
+static uchar *tplKernSyslogtag(struct templateEntry __attribute__((unused)) *const pTpe,
+                               smsg_t *const pMsg,
+                               rs_size_t *const pLen,
+                               unsigned short *const pbMustBeFreed,
+                               struct syslogTime __attribute__((unused)) *const ttNow) {
+    uchar *pRes;
+    int len;
+    *pbMustBeFreed = 0;
+    getTAG(pMsg, &pRes, &len, LOCK_MUTEX);
+    *pLen = len;
+    return pRes;
+}
+
+static uchar *tplKernRawmsg(struct templateEntry __attribute__((unused)) *const pTpe,
+                            smsg_t *const pMsg,
+                            rs_size_t *const pLen,
+                            unsigned short *const pbMustBeFreed,
+                            struct syslogTime __attribute__((unused)) *const ttNow) {
+    uchar *pRes;
+    int len;
+    *pbMustBeFreed = 0;
+    getRawMsg(pMsg, &pRes, &len);
+    *pLen = len;
+    return pRes;
+}
+
+static uchar *tplKernTimestamp(struct templateEntry *const pTpe,
+                               smsg_t *const pMsg,
+                               rs_size_t *const pLen,
+                               unsigned short *const pbMustBeFreed,
+                               struct syslogTime __attribute__((unused)) *const ttNow) {
+    uchar *const pRes = (uchar *)getTimeReported(pMsg, pTpe->data.field.eDateFormat);
+    *pbMustBeFreed = 0;
+    *pLen = ustrlen(pRes);
+    return pRes;
+}
+
+static uchar *tplKernGeneric(struct templateEntry *const pTpe,
+                             smsg_t *const pMsg,
+                             rs_size_t *const pLen,
+                             unsigned short *const pbMustBeFreed,
+                             struct syslogTime *const ttNow) {
+    return MsgGetProp(pMsg, pTpe, &pTpe->data.field.msgProp, pLen, pbMustBeFreed, ttNow);
+}
+
+
+/* select the kernel for a single template entry */
+static tplKernel_t tplSelectKernel(const struct templateEntry *const pTpe) {
+    if (pTpe->eEntryType == CONSTANT) return tplKernConstant;
+    if (pTpe->bComplexProcessing) return tplKernGeneric;
+    switch (pTpe->data.field.msgProp.id) {
+        case PROP_MSG:
+            return tplKernMsg;
+        case PROP_HOSTNAME:
+            return tplKernHostname;
+        case PROP_SYSLOGTAG:
+            return tplKernSyslogtag;
+        case PROP_RAWMSG:
+            return tplKernRawmsg;
+        case PROP_TIMESTAMP:
+            return pTpe->data.field.options.bDateInUTC ? tplKernGeneric : tplKernTimestamp;
+        default:
+            return tplKernGeneric;
+    }
+}
+
+
+/* generate the specialized renderer for one template, if it qualifies */
+static rsRetVal tplCompile(struct template *const pTpl) {
+    struct templateEntry *pTpe;
+    struct tplCompiledOp *pOps = NULL;
+    int i;
+    DEFiRet;
+
+    if (pTpl->pStrgen != NULL || pTpl->bHaveSubtree || pTpl->optFormatEscape != NO_ESCAPE ||
+        pTpl->tpenElements == 0 || pTpl->tpenElements > TPL_COMPILED_MAX_OPS) {
+        FINALIZE; /* handled by the generic code */
+    }
+
+    CHKmalloc(pOps = calloc(pTpl->tpenElements, sizeof(struct tplCompiledOp)));
+    for (i = 0, pTpe = pTpl->pEntryRoot; pTpe != NULL && i < pTpl->tpenElements; pTpe = pTpe->pNext, ++i) {
+        if (pTpe->eEntryType != CONSTANT && pTpe->eEntryType != FIELD) {
+            free(pOps);
+            FINALIZE;
+        }
+        pOps[i].kernel = tplSelectKernel(pTpe);
+        pOps[i].pTpe = pTpe;
+    }
+    free(pTpl->pCompiled);
+    pTpl->pCompiled = pOps;
+    pTpl->nCompiled = i;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/**
+ * Generate specialized renderers for all eligible templates of @p conf.
+ *
+ * Must be called after all actions are created, because action setup may
+ * still change template entries (e.g. dynafile securepath defaults).
+ * Failure to compile a template is not an error, it then simply uses the
+ * generic rendering code.
+ */
+void tplCompileAll(rsconf_t *conf) {
+    struct template *pTpl;
+
+    if (!conf->globals.bTemplateCompile) return;
+    for (pTpl = conf->templates.root; pTpl != NULL; pTpl = pTpl->pNext) {
+        if (tplCompile(pTpl) == RS_RET_OK && pTpl->pCompiled != NULL) {
+            DBGPRINTF("template '%s' uses compiled renderer\n", pTpl->pszName);
+        }
+    }
+}
+
+
+/* render a compiled template: obtain all values first, then size the
+ * buffer exactly once and copy.
+ */
+static rsRetVal tplRenderCompiled(const struct template *__restrict__ const pTpl,
+                                  smsg_t *__restrict__ const pMsg,
+                                  actWrkrIParams_t *__restrict__ const iparam,
+                                  struct syslogTime *const ttNow) {
+    uchar *vals[TPL_COMPILED_MAX_OPS];
+    rs_size_t lens[TPL_COMPILED_MAX_OPS];
+    unsigned short mustFree[TPL_COMPILED_MAX_OPS];
+    const int nOps = pTpl->nCompiled;
+    size_t lenTotal = 0;
+    size_t iBuf = 0;
+    int i;
+    DEFiRet;
+
+    for (i = 0; i < nOps; ++i) {
+        const struct tplCompiledOp *const op = &pTpl->pCompiled[i];
+        vals[i] = op->kernel(op->pTpe, pMsg, &lens[i], &mustFree[i], ttNow);
+        lenTotal += (size_t)lens[i];
+    }
+
+    if (lenTotal >= iparam->lenBuf) CHKiRet(ExtendBuf(iparam, lenTotal + 1));
+    for (i = 0; i < nOps; ++i) {
+        memcpy(iparam->param + iBuf, vals[i], lens[i]);
+        iBuf += lens[i];
+    }
+    iparam->param[iBuf] = '\0';
+    iparam->lenStr = iBuf;
+
+finalize_it:
+    for (i = 0; i < nOps; ++i) {
+        if (mustFree[i]) free(vals[i]);
+    }
+    RETiRet;
+}
+
+
+/**
+ * Find the first character that needs escaping in @p mode.
+ *
+ * @return offset of that character or @p len if the value can be used as is
+ */
+static size_t tplEscapeScan(const uchar *const pVal, const size_t len, const int mode) {
+    switch (mode) {
+        case STDSQL_ESCAPE:
+            return rsStrScanAny2(pVal, len, '\'', '\'');
+        case SQL_ESCAPE:
+            return rsStrScanAny2(pVal, len, '\'', '\\');
+        case JSON_ESCAPE:
+            return rsStrScanAny2(pVal, len, '"', '\\');
+        default:
+            return len;
+    }
+}
+
+
+/**
+ * Write the escaped form of @p pVal to @p dst.
+ *
+ * @p dst must provide room for at least 2 * @p len bytes. @p offs is the
+ * result of a prior tplEscapeScan(); the part before it is copied as is.
+ *
+ * @return number of bytes written (no terminating NUL is added)
+ */
+static size_t tplEscapeInto(uchar *const dst, const uchar *pVal, size_t len, size_t offs, const int mode) {
+    const uchar escChar = (mode == STDSQL_ESCAPE) ? '\'' : '\\';
+    uchar *w = dst;
+
+    while (1) {
+        memcpy(w, pVal, offs);
+        w += offs;
+        pVal += offs;
+        len -= offs;
+        if (len == 0) break;
+        *w++ = escChar;
+        *w++ = *pVal++;
+        --len;
+        offs = tplEscapeScan(pVal, len, mode);
+    }
+    return (size_t)(w - dst);
+}
+
+
 /* This functions converts a template into a string.
  *
  * The function takes a pointer to a template and a pointer to a msg object
@@ -810,6 +1032,7 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
     unsigned short bMustBeFreed = 0;
     uchar *pVal;
     rs_size_t iLenVal = 0;
+    size_t escOffs;
     int need_comma = 0;
 
     if (pTpl->pStrgen != NULL) {
@@ -817,6 +1040,11 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
         FINALIZE;
     }
 
+    if (pTpl->pCompiled != NULL) {
+        CHKiRet(tplRenderCompiled(pTpl, pMsg, iparam, ttNow));
+        FINALIZE;
+    }
+
     if (pTpl->bHaveSubtree) {
         /* only a single CEE subtree must be provided */
         /* note: we could optimize the code below, however, this is
@@ -858,6 +1086,7 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
         *iparam->param = '{';
     }
     while (pTpe != NULL) {
+        escOffs = SIZE_MAX; /* no escaping required */
         if (pTpe->eEntryType == CONSTANT) {
             pVal = (uchar *)pTpe->data.constant.pConstant;
             iLenVal = pTpe->data.constant.iLenConstant;
@@ -869,13 +1098,14 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
              * rgerhards, 2005-09-22: the option values below look somewhat misplaced,
              * but they are handled in this way because of legacy (don't break any
              * existing thing).
+             * The escaped value is written straight into the output buffer below,
+             * so we only need to find out if there is anything to escape here.
              */
-            if (pTpl->optFormatEscape == SQL_ESCAPE)
-                doEscape(&pVal, &iLenVal, &bMustBeFreed, SQL_ESCAPE);
-            else if (pTpl->optFormatEscape == JSON_ESCAPE)
-                doEscape(&pVal, &iLenVal, &bMustBeFreed, JSON_ESCAPE);
-            else if (pTpl->optFormatEscape == STDSQL_ESCAPE)
-                doEscape(&pVal, &iLenVal, &bMustBeFreed, STDSQL_ESCAPE);
+            if (iLenVal > 0 && (pTpl->optFormatEscape == SQL_ESCAPE || pTpl->optFormatEscape == JSON_ESCAPE ||
+                                pTpl->optFormatEscape == STDSQL_ESCAPE)) {
+                escOffs = tplEscapeScan(pVal, (size_t)iLenVal, pTpl->optFormatEscape);
+                if (escOffs == (size_t)iLenVal) escOffs = SIZE_MAX;
+            }
         } else {
             DBGPRINTF("TplToString: invalid entry type %d\n", pTpe->eEntryType);
             pVal = (uchar *)"*LOGIC ERROR*";
@@ -888,7 +1118,8 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
         size_t requiredLen = closingLen;
         if (iLenVal > 0) {
             if (need_comma) requiredLen += 2;
-            requiredLen += (size_t)iLenVal;
+            /* worst case: every character needs to be escaped */
+            requiredLen += (escOffs == SIZE_MAX) ? (size_t)iLenVal : 2 * (size_t)iLenVal;
         }
         if (requiredLen > 0 && (iBuf + requiredLen) >= iparam->lenBuf)
             CHKiRet(ExtendBuf(iparam, iBuf + requiredLen + 1));
@@ -899,8 +1130,12 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
                 iBuf += 2;
             }
 
-            memcpy(iparam->param + iBuf, pVal, iLenVal);
-            iBuf += iLenVal;
+            if (escOffs == SIZE_MAX) {
+                memcpy(iparam->param + iBuf, pVal, iLenVal);
+                iBuf += iLenVal;
+            } else {
+                iBuf += tplEscapeInto(iparam->param + iBuf, pVal, (size_t)iLenVal, escOffs, pTpl->optFormatEscape);
+            }
             if (isJsonFlat) {
                 need_comma = 1;
             }
@@ -940,6 +1175,121 @@ finalize_it:
 }
 
 
+/**
+ * Release buffers owned by @p pIov and mark it empty. Arrays are kept for reuse.
+ */
+void tplIovReset(tplIov_t *const pIov) {
+    for (int i = 0; i < pIov->nOwned; ++i) {
+        free(pIov->owned[i]);
+    }
+    pIov->nOwned = 0;
+    pIov->nIov = 0;
+    pIov->lenTotal = 0;
+}
+
+
+/**
+ * Free all resources of @p pIov. The object itself is not freed.
+ */
+void tplIovDestruct(tplIov_t *const pIov) {
+    tplIovReset(pIov);
+    free(pIov->iov);
+    free(pIov->owned);
+    free(pIov->flat.param);
+    memset(pIov, 0, sizeof(*pIov));
+}
+
+
+/* add a segment to the iovec; ownership of an allocated buffer is taken over
+ * even in the error case, so the caller never needs to free it.
+ */
+static rsRetVal tplIovAdd(tplIov_t *const pIov, uchar *const pVal, const size_t len, const int bOwned) {
+    void *newmem;
+    DEFiRet;
+
+    if (bOwned) {
+        if (pIov->nOwned == pIov->maxOwned) {
+            const int newMax = (pIov->maxOwned == 0) ? 8 : 2 * pIov->maxOwned;
+            if ((newmem = realloc(pIov->owned, newMax * sizeof(uchar *))) == NULL) {
+                free(pVal);
+                ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+            }
+            pIov->owned = newmem;
+            pIov->maxOwned = newMax;
+        }
+        pIov->owned[pIov->nOwned++] = pVal;
+    }
+    if (len == 0) FINALIZE;
+    /* the array is sized for the template in tplToIov(), so no check needed */
+    pIov->iov[pIov->nIov].iov_base = pVal;
+    pIov->iov[pIov->nIov].iov_len = len;
+    ++pIov->nIov;
+    pIov->lenTotal += len;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/**
+ * @brief Render a template as a list of segments for writev()/sendmsg().
+ *
+ * In contrast to tplToString(), property values are not copied into a
+ * flat buffer. Constants are referenced from the template and most
+ * properties directly from the message, so outputs can hand the message
+ * over to the kernel without any intermediate copy.
+ *
+ * Templates that need a fully materialized string (strgen, subtree,
+ * escaping or JSON options) are rendered via tplToString() into an
+ * internal buffer and returned as a single segment.
+ *
+ * @param[in]     pTpl  template to render
+ * @param[in]     pMsg  message to render, must not be modified while the result is in use
+ * @param[in,out] pIov  reusable render object, previous content is released
+ * @param[in]     ttNow timestamp for time-related properties
+ */
+rsRetVal tplToIov(struct template *__restrict__ const pTpl,
+                  smsg_t *__restrict__ const pMsg,
+                  tplIov_t *__restrict__ const pIov,
+                  struct syslogTime *const ttNow) {
+    struct templateEntry *__restrict__ pTpe;
+    unsigned short bMustBeFreed;
+    uchar *pVal;
+    rs_size_t iLenVal;
+    void *newmem;
+    DEFiRet;
+
+    tplIovReset(pIov);
+
+    if (pIov->maxIov < pTpl->tpenElements || pIov->maxIov == 0) {
+        const int newMax = (pTpl->tpenElements < 1) ? 1 : pTpl->tpenElements;
+        CHKmalloc(newmem = realloc(pIov->iov, newMax * sizeof(struct iovec)));
+        pIov->iov = newmem;
+        pIov->maxIov = newMax;
+    }
+
+    if (pTpl->pStrgen != NULL || pTpl->bHaveSubtree || pTpl->optFormatEscape != NO_ESCAPE ||
+        pTpl->tpenElements > TPL_IOV_MAX_SEGMENTS) {
+        CHKiRet(tplToString(pTpl, pMsg, &pIov->flat, ttNow));
+        CHKiRet(tplIovAdd(pIov, pIov->flat.param, pIov->flat.lenStr, 0));
+        FINALIZE;
+    }
+
+    for (pTpe = pTpl->pEntryRoot; pTpe != NULL; pTpe = pTpe->pNext) {
+        if (pTpe->eEntryType == CONSTANT) {
+            CHKiRet(tplIovAdd(pIov, pTpe->data.constant.pConstant, pTpe->data.constant.iLenConstant, 0));
+        } else if (pTpe->eEntryType == FIELD) {
+            bMustBeFreed = 0;
+            pVal = (uchar *)MsgGetProp(pMsg, pTpe, &pTpe->data.field.msgProp, &iLenVal, &bMustBeFreed, ttNow);
+            CHKiRet(tplIovAdd(pIov, pVal, (iLenVal > 0) ? (size_t)iLenVal : 0, bMustBeFreed));
+        }
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
 /* This functions converts a template into a json object.
  * For further general details, see the very similar funtion
  * tpltoString().
@@ -1003,122 +1353,6 @@ finalize_it:
 }
 
 
-/* Helper to doEscape. This is called if doEscape
- * runs out of memory allocating the escaped string.
- * Then we are in trouble. We can
- * NOT simply return the unmodified string because this
- * may cause SQL injection. But we also can not simply
- * abort the run, this would be a DoS. I think an appropriate
- * measure is to remove the dangerous \' characters (SQL). We
- * replace them by \", which will break the message and
- * signatures eventually present - but this is the
- * best thing we can do now (or does anybody
- * have a better idea?). rgerhards 2004-11-23
- * added support for escape mode (see doEscape for details).
- * if mode = SQL_ESCAPE, then backslashes are changed to slashes.
- * rgerhards 2005-09-22
- */
-static void doEmergencyEscape(register uchar *p, int mode) {
-    while (*p) {
-        if ((mode == SQL_ESCAPE || mode == STDSQL_ESCAPE) && *p == '\'') {
-            *p = '"';
-        } else if (mode == JSON_ESCAPE) {
-            if (*p == '"') {
-                *p = '\'';
-            } else if (*p == '\\') {
-                *p = '/';
-            }
-        } else if ((mode == SQL_ESCAPE) && *p == '\\') {
-            *p = '/';
-        }
-        ++p;
-    }
-}
-
-
-/* SQL-Escape a string. Single quotes are found and
- * replaced by two of them. A new buffer is allocated
- * for the provided string and the provided buffer is
- * freed. The length is updated. Parameter pbMustBeFreed
- * is set to 1 if a new buffer is allocated. Otherwise,
- * it is left untouched.
- * --
- * We just discovered a security issue. MySQL is so
- * "smart" to not only support the standard SQL mechanism
- * for escaping quotes, but to also provide its own (using
- * c-type syntax with backslashes). As such, it is actually
- * possible to do sql injection via rsyslogd. The cure is now
- * to escape backslashes, too. As we have found on the web, some
- * other databases seem to be similar "smart" (why do we have standards
- * at all if they are violated without any need???). Even better, MySQL's
- * smartness depends on config settings. So we add a new option to this
- * function that allows the caller to select if they want to standard or
- * "smart" encoding ;)
- * --
- * Parameter "mode" is STDSQL_ESCAPE, SQL_ESCAPE "smart" SQL engines, or
- * JSON_ESCAPE for everyone requiring escaped JSON (e.g. ElasticSearch).
- * 2005-09-22 rgerhards
- */
-rsRetVal doEscape(uchar **pp, rs_size_t *pLen, unsigned short *pbMustBeFreed, int mode) {
-    DEFiRet;
-    uchar *p = NULL;
-    int iLen;
-    cstr_t *pStrB = NULL;
-    uchar *pszGenerated;
-
-    assert(pp != NULL);
-    assert(*pp != NULL);
-    assert(pLen != NULL);
-    assert(pbMustBeFreed != NULL);
-
-    /* first check if we need to do anything at all... */
-    if (mode == STDSQL_ESCAPE)
-        for (p = *pp; *p && *p != '\''; ++p);
-    else if (mode == SQL_ESCAPE)
-        for (p = *pp; *p && *p != '\'' && *p != '\\'; ++p);
-    else if (mode == JSON_ESCAPE)
-        for (p = *pp; *p && (*p == '"' || *p == '\\'); ++p);
-    /* when we get out of the loop, we are either at the
-     * string terminator or the first character to escape */
-    if (p && *p == '\0') FINALIZE; /* nothing to do in this case! */
-
-    p = *pp;
-    iLen = *pLen;
-    CHKiRet(cstrConstruct(&pStrB));
-
-    while (*p) {
-        if ((mode == SQL_ESCAPE || mode == STDSQL_ESCAPE) && *p == '\'') {
-            CHKiRet(cstrAppendChar(pStrB, (mode == STDSQL_ESCAPE) ? '\'' : '\\'));
-            iLen++; /* reflect the extra character */
-        } else if ((mode == SQL_ESCAPE) && *p == '\\') {
-            CHKiRet(cstrAppendChar(pStrB, '\\'));
-            iLen++; /* reflect the extra character */
-        } else if ((mode == JSON_ESCAPE) && (*p == '"' || *p == '\\')) {
-            CHKiRet(cstrAppendChar(pStrB, '\\'));
-            iLen++; /* reflect the extra character */
-        }
-        CHKiRet(cstrAppendChar(pStrB, *p));
-        ++p;
-    }
-    cstrFinalize(pStrB);
-    CHKiRet(cstrConvSzStrAndDestruct(&pStrB, &pszGenerated, 0));
-
-    if (*pbMustBeFreed) free(*pp); /* discard previous value */
-
-    *pp = pszGenerated;
-    *pLen = iLen;
-    *pbMustBeFreed = 1;
-
-finalize_it:
-    if (iRet != RS_RET_OK) {
-        doEmergencyEscape(*pp, mode);
-        if (pStrB != NULL) cstrDestruct(&pStrB);
-    }
-
-    RETiRet;
-}
-
-
 /* Constructs a template entry object. Returns pointer to it
  * or NULL (if it fails). Pointer to associated template list entry
  * must be provided.
@@ -2906,6 +3140,7 @@ void tplDeleteAll(rsconf_t *conf) {
         free(pTplDel->pszName);
         if (pTplDel->bHaveSubtree) msgPropDescrDestruct(&pTplDel->subtree);
         tplJsonNodeFree(pTplDel->pJsonRoot);
+        free(pTplDel->pCompiled);
         free(pTplDel);
     }
 }
@@ -2957,6 +3192,7 @@ void tplDeleteNew(rsconf_t *conf) {
         free(pTplDel->pszName);
         if (pTplDel->bHaveSubtree) msgPropDescrDestruct(&pTplDel->subtree);
         tplJsonNodeFree(pTplDel->pJsonRoot);
+        free(pTplDel->pCompiled);
         free(pTplDel);
     }
 }
@@ -30,6 +30,7 @@
 #ifndef TEMPLATE_H_INCLUDED
     #define TEMPLATE_H_INCLUDED 1
 
+    #include <sys/uio.h>
     #include <json.h>
     #include <libestr.h>
     #include "regexp.h"
@@ -66,6 +67,10 @@ struct template {
     unsigned bWarnedDynafileMixedUse : 1; /**< mixed-use warning was already emitted */
     unsigned bWarnedDynafileSecureDefault : 1; /**< warn-mode notice was already emitted */
     unsigned bAppliedDynafileSecureDefault : 1; /**< strict-mode default was already applied */
+    unsigned bRenderCacheable : 1; /**< rendering depends on message content only, see tplNoteUse() */
+    unsigned nActionRefs; /**< number of action template slots referencing this template */
+    struct tplCompiledOp *pCompiled; /**< specialized per-entry renderers, see tplCompileAll() */
+    int nCompiled; /**< number of entries in pCompiled */
 };
 
 enum EntryTypes { UNDEFINED = 0, CONSTANT = 1, FIELD = 2 };
@@ -179,6 +184,29 @@ struct templateEntry {
 };
 
 
+/** Templates with more entries than this are rendered by tplToIov() as one segment. */
+    #define TPL_IOV_MAX_SEGMENTS 256
+
+/**
+ * @struct tplIov_s
+ * @brief Scatter/gather rendering of a template, see tplToIov().
+ *
+ * Segments point to template constants, to message-owned property
+ * values or to buffers owned by this object. They are only valid until
+ * the message is modified or the next tplIovReset() call. The object is
+ * meant to be reused for many messages so that its arrays are recycled.
+ */
+typedef struct tplIov_s {
+    struct iovec *iov; /**< rendered segments */
+    int nIov; /**< number of segments in use */
+    int maxIov; /**< allocated size of iov */
+    size_t lenTotal; /**< sum of all segment lengths */
+    uchar **owned; /**< property buffers that must be freed on reset */
+    int nOwned;
+    int maxOwned;
+    actWrkrIParams_t flat; /**< buffer for templates that can not be split into segments */
+} tplIov_t;
+
 /* interfaces */
 BEGINinterface(tpl) /* name must also be changed in ENDinterface macro! */
 ENDinterface(tpl)
@@ -198,17 +226,23 @@ void tplLastStaticInit(rsconf_t *conf, struct template *tpl);
 rsRetVal ExtendBuf(actWrkrIParams_t *const iparam, const size_t iMinSize);
 int tplRequiresDateCall(struct template *pTpl);
 void tplNoteUse(struct template *pTpl, int bDynafile);
+void tplCompileAll(rsconf_t *conf);
 /* note: if a compiler warning for undefined type tells you to look at this
  * code line below, the actual cause is that you currently MUST include template.h
  * BEFORE msg.h, even if your code file does not actually need it.
  * rgerhards, 2007-08-06
  */
 rsRetVal tplToJSON(struct template *pTpl, smsg_t *pMsg, struct json_object **, struct syslogTime *ttNow);
-rsRetVal doEscape(uchar **pp, rs_size_t *pLen, unsigned short *pbMustBeFreed, int escapeMode);
 rsRetVal tplToString(struct template *__restrict__ const pTpl,
                      smsg_t *__restrict__ const pMsg,
                      actWrkrIParams_t *__restrict__ const iparam,
                      struct syslogTime *const ttNow);
+rsRetVal tplToIov(struct template *__restrict__ const pTpl,
+                  smsg_t *__restrict__ const pMsg,
+                  tplIov_t *__restrict__ const pIov,
+                  struct syslogTime *const ttNow);
+void tplIovReset(tplIov_t *const pIov);
+void tplIovDestruct(tplIov_t *const pIov);
 
 rsRetVal templateInit(void);
 rsRetVal tplProcessCnf(struct cnfobj *o);
@@ -0,0 +1,38 @@
+#!/bin/bash
+# check asynchronous commits (submitTransaction): all messages must arrive
+# even if some parts fail, and no more than action.async.maxInFlight parts
+# may be outstanding at any time.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=2000
+generate_conf
+add_conf '
+module(load="../plugins/omtesting/.libs/omtestingasync")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then
+	action(type="omtestingasync" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+	       statsfile="'$RSYSLOG_DYNNAME'.stats" delay="10" failevery="7"
+	       queue.type="linkedList" queue.dequeueBatchSize="64"
+	       action.async.maxInFlight="3" action.async.batchSize="4")
+'
+startup
+injectmsg 0 $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+# failed parts are retried synchronously, so nothing may be lost
+seq_check
+
+# the stats file is written when the action is destroyed
+cat $RSYSLOG_DYNNAME.stats
+failed=$(sed -n 's/.*failed=\([0-9]*\).*/\1/p' $RSYSLOG_DYNNAME.stats)
+maxinflight=$(sed -n 's/.*maxinflight=\([0-9]*\).*/\1/p' $RSYSLOG_DYNNAME.stats)
+if [ -z "$failed" ] || [ "$failed" -eq 0 ]; then
+	echo "FAIL: no part failed, partial failure not exercised"
+	error_exit 1
+fi
+if [ -z "$maxinflight" ] || [ "$maxinflight" -lt 2 ] || [ "$maxinflight" -gt 3 ]; then
+	echo "FAIL: maxinflight=$maxinflight, expected 2 or 3 (action.async.maxInFlight=3)"
+	error_exit 1
+fi
+exit_test
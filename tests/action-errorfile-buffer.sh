@@ -0,0 +1,40 @@
+#!/bin/bash
+# check the buffered action.errorfile writer: records that fit into
+# action.errorfile.bufferSize are written, larger ones are dropped and
+# counted in errorfile.dropped
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=100
+export STATSFILE="$RSYSLOG_DYNNAME.stats"
+# makes the error records of odd messages larger than the buffer
+PAD=$(printf 'x%.0s' $(seq 400))
+generate_conf
+add_conf '
+module(load="../plugins/omtesting/.libs/omtestingasync")
+module(load="../plugins/impstats/.libs/impstats" log.file="'$STATSFILE'" interval="1" bracketing="on")
+template(name="outfmt" type="string" string="%msg:F,58:2%%$.pad%")
+
+if $msg contains "msgnum:" then {
+	if cnum(field($msg, 58, 2)) % 2 == 1 then
+		set $.pad = "'$PAD'";
+	action(name="reject" type="omtestingasync" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+	       reject="on" action.errorfile="'$RSYSLOG2_OUT_LOG'" action.errorfile.bufferSize="256")
+}
+'
+startup
+injectmsg
+wait_queueempty
+wait_for_stats_flush $STATSFILE
+shutdown_when_empty
+wait_shutdown
+
+# the first record goes to an empty buffer, so it is always written
+custom_content_check '"template0": "00000000"' $RSYSLOG2_OUT_LOG
+custom_assert_content_missing 'xxxxxxxx' $RSYSLOG2_OUT_LOG
+dropped=$(grep -o 'errorfile.dropped=[0-9]*' $STATSFILE | tail -1 | cut -d= -f2)
+if [ -z "$dropped" ] || [ "$dropped" -lt $((NUMMESSAGES / 2)) ]; then
+	echo "FAIL: errorfile.dropped=$dropped, expected at least $((NUMMESSAGES / 2))"
+	cat $STATSFILE
+	error_exit 1
+fi
+exit_test
@@ -0,0 +1,27 @@
+#!/bin/bash
+# check that an action.group is not formed if its first action filters
+# messages, as the filter would otherwise apply to all actions of the group
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+export SEQ_CHECK_FILE=$RSYSLOG_DYNNAME.out2.log
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+action(type="omfile" file=`echo $RSYSLOG_OUT_LOG`)
+if $msg contains "msgnum:" then {
+	action(name="leader" type="omfile" file=`echo $RSYSLOG_DYNNAME.out1.log` template="outfmt"
+	       queue.type="linkedList" action.execOnlyEveryNthTime="2" action.group="fanout")
+	action(type="omfile" file=`echo $RSYSLOG_DYNNAME.out2.log` template="outfmt"
+	       action.group="fanout")
+}
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+content_check "the first action 'leader' of action.group 'fanout' may not use"
+# the second action is not grouped and thus gets all messages
+seq_check
+exit_test
@@ -0,0 +1,25 @@
+#!/bin/bash
+# check that all actions of an action.group receive all messages
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+export SEQ_CHECK_FILE=$RSYSLOG_DYNNAME.out2.log
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then {
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt"
+	       queue.type="linkedList" action.group="fanout")
+	action(type="omfile" file=`echo $RSYSLOG_DYNNAME.out2.log` template="outfmt"
+	       action.group="fanout")
+}
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check
+unset SEQ_CHECK_FILE
+seq_check
+exit_test
@@ -0,0 +1,32 @@
+#!/bin/bash
+# check the action.latency.* histogram counters
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+ruleset(name="stats") {
+	action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+module(load="../plugins/impstats/.libs/impstats" interval="1" resetCounters="on" ruleset="stats")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then
+	action(name="out" type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt"
+	       action.latency.buckets=["10", "1000", "3600000"])
+'
+startup
+wait_for_stats_flush ${RSYSLOG_DYNNAME}.out.stats.log
+injectmsg
+wait_queueempty
+rst_msleep 1100 # wait for stats flush
+shutdown_when_empty
+wait_shutdown
+seq_check
+# each message must be counted once, and all fall below the last bound
+first_column_sum_check 's/.*count=\([0-9]*\).*/\1/g' 'out.latency:' "${RSYSLOG_DYNNAME}.out.stats.log" $NUMMESSAGES
+first_column_sum_check 's/.*le.3600000=\([0-9]*\).*/\1/g' 'out.latency:' "${RSYSLOG_DYNNAME}.out.stats.log" \
+	$NUMMESSAGES
+custom_content_check 'out.latency: origin=core.action le.10=' "${RSYSLOG_DYNNAME}.out.stats.log"
+exit_test
@@ -0,0 +1,28 @@
+#!/bin/bash
+# check that a suspended action resumes with action.resumeBackoff="exponential"
+# and that no message is lost while the worker waits for the next resume attempt
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+:msg, contains, "msgnum:" {
+	action(name="forwarder" type="omfwd" template="outfmt"
+		target="127.0.0.1" port="'$TCPFLOOD_PORT'" protocol="tcp"
+		action.resumeRetryCount="-1" action.resumeInterval="1"
+		action.resumeIntervalMax="4" action.resumeBackoff="exponential")
+}
+'
+startup
+injectmsg
+./msleep 3000 # target is down, the action must be retrying now
+./minitcpsrv -t127.0.0.1 -p$TCPFLOOD_PORT -f $RSYSLOG_OUT_LOG &
+BGPROCESS=$!
+echo background minitcpsrv process id is $BGPROCESS
+wait_file_lines $RSYSLOG_OUT_LOG $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
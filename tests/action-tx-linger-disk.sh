@@ -0,0 +1,30 @@
+#!/bin/bash
+# check that action.linger.* is rejected for disk-assisted action queues,
+# which could no longer save the messages held back, and that direct
+# actions do not linger while run by a disk-assisted main queue
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=100
+generate_conf
+add_conf '
+main_queue(queue.type="linkedList" queue.filename="mainq" queue.saveOnShutdown="on")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+action(type="omfile" file=`echo $RSYSLOG_OUT_LOG`
+       queue.type="linkedList" queue.filename="linger" queue.saveOnShutdown="on"
+       action.linger.timeout="200")
+
+if $msg contains "msgnum:" then
+	action(type="omfile" file=`echo $RSYSLOG2_OUT_LOG` template="outfmt"
+	       action.linger.timeout="600000")
+'
+startup
+injectmsg
+# with lingering, nothing would be written before shutdown
+wait_file_lines $RSYSLOG2_OUT_LOG $NUMMESSAGES 30
+shutdown_when_empty
+wait_shutdown
+content_check 'action.linger.timeout can not be used with a disk or disk-assisted action queue'
+export SEQ_CHECK_FILE=$RSYSLOG2_OUT_LOG
+seq_check
+exit_test
@@ -0,0 +1,24 @@
+#!/bin/bash
+# check that action.linger.* holds back commits without losing messages
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=5000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt"
+	       queue.type="linkedList" queue.dequeueBatchSize="8"
+	       action.linger.timeout="200" action.linger.messages="1000")
+'
+startup
+injectmsg 0 $((NUMMESSAGES - 1))
+# the last messages are held back until the linger timeout expires
+wait_file_lines $RSYSLOG_OUT_LOG $NUMMESSAGES
+# and are flushed on shutdown
+injectmsg $NUMMESSAGES 1
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $NUMMESSAGES
+exit_test
@@ -0,0 +1,31 @@
+#!/bin/bash
+# Checks omstdout output when templates are passed as iovec segments,
+# including owned property buffers and templates that need a flat string.
+# This is part of the rsyslog testbench, licensed under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+module(load="../plugins/omstdout/.libs/omstdout")
+
+template(name="segments" type="list") {
+	constant(value="[")
+	property(name="msg" field.delimiter="58" field.number="2")
+	constant(value="|")
+	property(name="msg" field.delimiter="58" field.number="1" caseconversion="upper")
+	constant(value="]")
+}
+template(name="escaped" type="string" string="%msg:F,58:2%,\"\n" option.json="on")
+
+if $msg contains "msgnum:" then {
+	action(type="omstdout" template="segments")
+	action(type="omstdout" template="escaped")
+}
+'
+startup > $RSYSLOG_OUT_LOG
+injectmsg 0 2
+shutdown_when_empty
+wait_shutdown
+content_check '[00000000| MSGNUM]'
+content_check '[00000001| MSGNUM]'
+content_check '00000001,"'
+exit_test
@@ -0,0 +1,39 @@
+#!/bin/bash
+# check the queue.timing counters of the main and an action queue
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+main_queue(queue.timing="on")
+ruleset(name="stats") {
+	action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+module(load="../plugins/impstats/.libs/impstats" interval="1" ruleset="stats")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then
+	action(name="out" type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt"
+	       queue.type="linkedList" queue.timing="on" queue.timing.samplingInterval="2")
+'
+startup
+injectmsg
+wait_queueempty
+rst_msleep 1100 # wait for stats flush
+shutdown_when_empty
+wait_shutdown
+seq_check
+if ! grep -q 'main Q: origin=core.queue .* timing.idle=[0-9]* timing.dequeue=[0-9]* timing.rules=' \
+		"${RSYSLOG_DYNNAME}.out.stats.log"; then
+	echo "FAIL: timing counters of main queue missing"
+	cat "${RSYSLOG_DYNNAME}.out.stats.log"
+	error_exit 1
+fi
+# the action queue spent time in omfile
+if ! grep -q 'out queue: origin=core.queue .* timing.output=[1-9]' "${RSYSLOG_DYNNAME}.out.stats.log"; then
+	echo "FAIL: timing counters of action queue missing or zero"
+	cat "${RSYSLOG_DYNNAME}.out.stats.log"
+	error_exit 1
+fi
+exit_test
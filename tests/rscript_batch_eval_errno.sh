@@ -0,0 +1,28 @@
+#!/bin/bash
+# check that script_error() sees the state of its own message with
+# statement-major batch execution (script.batchEval)
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+global(script.batchEval="on")
+main_queue(queue.dequeueBatchSize="512")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then {
+	set $.n = cnum(field($msg, 58, 2));
+	set $.json = "{\"a\": 1}";
+	if $.n % 2 == 1 then
+		set $.json = "not json";
+	set $.ret = parse_json($.json, "\$!parsed");
+	if script_error() == 0 then
+		action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 2)) -i2
+exit_test
@@ -0,0 +1,24 @@
+#!/bin/bash
+# check that if conditions give the same results when compiled into
+# register programs (global option script.compile)
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+global(script.compile="on")
+template(name="outfmt" type="string" string="%$!n%\n")
+
+set $!n = field($msg, 58, 2);
+if $msg contains "msgnum" and not ($msg contains_i "NOMATCH")
+   and $msg contains ["xyz", "msgnum:"] and $!n % 2 == 0
+   and $!n + 0 <= 999 and -$!n < 1 and $syslogtag != "" and
+   ($msg startswith "this does not match" or $!n >= 0) then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 2)) -i2
+exit_test
@@ -0,0 +1,24 @@
+#!/bin/bash
+# check that string functions and concatenation inside compiled if
+# conditions (global option script.compile) give the interpreter's results
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+global(script.compile="on")
+template(name="outfmt" type="string" string="%$!n%\n")
+
+set $!n = field($msg, 58, 2);
+if ltrim(tolower(field($msg, ":", 1))) == "msgnum" and toupper(ltrim($msg)) startswith "MSGNUM:"
+   and rtrim("x  ") & "y" == "xy" and strlen(field($msg, 58, 2)) == 8
+   and cnum(field($msg, 58, 2)) % 2 == 0 and field($msg, 58, 9) == "***FIELD NOT FOUND***"
+   and cstr(cnum(field($msg, 58, 2)) + 1) != "0" then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 2)) -i2
+exit_test
@@ -0,0 +1,23 @@
+#!/bin/bash
+# check contains/startswith/endswith against arrays large enough to be
+# evaluated via the multi-pattern matcher
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains ["no-1", "no-2", "no-3", "no-4", "msgnum:"]
+   and $msg contains_i ["NO-5", "NO-6", "NO-7", "MSGNUM:000"]
+   and not ($msg contains ["no-8", "no-9", "no-10", "no-11", "no-12"])
+   and $msg endswith ["0:", "2:", "4:", "6:", "8:"]
+   and $msg startswith_i [" NO", "X", " MSGNUM", "MSGNUM", "Z"] then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 2)) -i2
+exit_test
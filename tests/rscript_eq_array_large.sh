@@ -0,0 +1,23 @@
+#!/bin/bash
+# check == and != against arrays large enough to be looked up via
+# the hash set built by the optimizer
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+# all even message numbers, plus some that are never sent
+EVEN_ARRAY="$(seq -f '"%08g"' 0 2 $((NUMMESSAGES * 3)) | paste -sd, -)"
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if field($msg, 58, 2) == ['$EVEN_ARRAY']
+   and field($msg, 58, 2) != ["00000001", "00000003", "00000005", "00000007",
+                              "00000009", "00000011", "00000013", "00000015"] then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 2)) -i2
+exit_test
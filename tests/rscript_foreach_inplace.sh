@@ -0,0 +1,35 @@
+#!/bin/bash
+# check that foreach iterates over the collection as it was when the loop
+# started, whether it iterates in place or needs a copy
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%$.out% %$.coll%\n")
+
+if $msg contains "msgnum:" then {
+	set $.ret = parse_json('\''{"a": [1, 2, 3], "o": {"k": "v"}}'\'', "\$.coll");
+	set $.out = "";
+	# read-only body, iterates in place
+	foreach ($.i in $.coll!a) do {
+		set $.out = $.out & $.i;
+	}
+	# the body modifies the loop variable and the collection
+	foreach ($.i in $.coll!a) do {
+		set $.i = "x";
+		unset $.coll!a;
+		set $.out = $.out & $.i;
+	}
+	foreach ($.e in $.coll!o) do {
+		set $.e!value = "w";
+		set $.out = $.out & $.e!key & $.e!value;
+	}
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+startup
+injectmsg 0 1
+shutdown_when_empty
+wait_shutdown
+content_check '123xxxkw { "o": { "k": "v" } }'
+exit_test
@@ -0,0 +1,31 @@
+#!/bin/bash
+# check that repeated function calls are memoized per message (script.memoize)
+# and that a modification of the message invalidates the results
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+global(script.memoize="on")
+template(name="outfmt" type="string" string="%$.n%\n")
+
+if $msg contains "msgnum:" then {
+	set $.v = "a";
+	set $.r = toupper($.v);
+	set $.v = "b";
+	set $.s = toupper($.v);
+	if cnum(field($msg, 58, 2)) % 2 == 0 and $.r == "A" and $.s == "B" then {
+		if cnum(field($msg, 58, 2)) % 4 == 0 then
+			set $.n = cnum(field($msg, 58, 2));
+		else
+			set $.n = cnum(field($msg, 58, 2)) + 0;
+		action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+	}
+}
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 2)) -i2
+exit_test
@@ -0,0 +1,56 @@
+#!/bin/bash
+# check that if/else-if chains and runs of property filters comparing one
+# property against constants, which the optimizer turns into a switch,
+# keep their semantics
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="chain" type="string" string="chain %$.case% %programname%\n")
+template(name="filt" type="string" string="filt %programname%\n")
+
+if $programname == "app1" then
+	set $.case = "1";
+else if $programname == ["app2", "app3"] then
+	set $.case = "2";
+else if $programname == "app4" or $programname == "app1" then
+	set $.case = "4";
+else if "app5" == $programname then
+	set $.case = "5";
+else if $programname == "app6" then
+	set $.case = "6";
+else
+	set $.case = "default";
+action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="chain")
+
+:programname, isequal, "app1" action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="filt")
+:programname, isequal, "app2" action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="filt")
+:programname, isequal, "app4" action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="filt")
+:programname, isequal, "app6" action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="filt")
+:programname, isequal, "app7" action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="filt")
+'
+startup
+injectmsg_literal '<13>1 2003-03-01T01:00:00.000Z host app1 - - - m
+<13>1 2003-03-01T01:00:00.000Z host app2 - - - m
+<13>1 2003-03-01T01:00:00.000Z host app3 - - - m
+<13>1 2003-03-01T01:00:00.000Z host app4 - - - m
+<13>1 2003-03-01T01:00:00.000Z host app5 - - - m
+<13>1 2003-03-01T01:00:00.000Z host app6 - - - m
+<13>1 2003-03-01T01:00:00.000Z host app7 - - - m
+<13>1 2003-03-01T01:00:00.000Z host app - - - m'
+shutdown_when_empty
+wait_shutdown
+export EXPECTED='chain 1 app1
+filt app1
+chain 2 app2
+chain 2 app3
+chain 4 app4
+filt app4
+chain 5 app5
+chain 6 app6
+filt app6
+chain default app7
+filt app7
+chain default app'
+cmp_exact
+exit_test
@@ -0,0 +1,29 @@
+#!/bin/bash
+# check that batches executed in chunks by the batch pool
+# (script.parallel.workers) process all messages and keep their order
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+generate_conf
+add_conf '
+global(script.parallel.workers="3" script.parallel.chunkSize="16")
+main_queue(queue.dequeueBatchSize="512")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then {
+	set $.n = cnum(field($msg, 58, 2));
+	if $.n % 2 == 0 then
+		action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 2)) -i2
+# with a single queue worker, the action must see the messages in order
+if ! sort -n -c $RSYSLOG_OUT_LOG; then
+	echo "FAIL: messages written out of order"
+	error_exit 1
+fi
+exit_test
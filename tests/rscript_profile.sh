@@ -0,0 +1,42 @@
+#!/bin/bash
+# check the execution profiler (script.profile) and its SIGUSR2 dump
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+global(script.profile="on" script.profile.file=`echo $RSYSLOG_DYNNAME.profile`)
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then {
+	set $.n = cnum(field($msg, 58, 2));
+	if $.n % 2 == 0
+	then
+		action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+startup
+injectmsg
+wait_queueempty
+kill -USR2 $(cat $RSYSLOG_PIDBASE.pid)
+wait_file_exists $RSYSLOG_DYNNAME.profile
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 2)) -i2
+cat $RSYSLOG_DYNNAME.profile
+
+# the inner if must be reported with the line it starts on
+line=$(grep -n '\$.n % 2 == 0' ${TESTCONF_NM}.conf | cut -d: -f1)
+if ! grep -q "^[0-9]* $NUMMESSAGES $((NUMMESSAGES / 2)) .*\.conf:$line if\$" $RSYSLOG_DYNNAME.profile; then
+	echo "FAIL: profile of inner if (line $line) missing or wrong"
+	error_exit 1
+fi
+if ! grep -q "^[0-9]* $((NUMMESSAGES / 2)) 0 .*\.conf:[0-9]* action " $RSYSLOG_DYNNAME.profile; then
+	echo "FAIL: profile of action missing or wrong"
+	error_exit 1
+fi
+if ! grep -q "ruleset RSYSLOG_DefaultRuleset\$" $RSYSLOG_DYNNAME.profile; then
+	echo "FAIL: profile of default ruleset missing"
+	error_exit 1
+fi
+exit_test
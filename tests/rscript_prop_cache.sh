@@ -0,0 +1,28 @@
+#!/bin/bash
+# check that property values reused between statements of the same message
+# are refreshed when the message is modified
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%$.r%\n")
+
+set $!v = "a";
+if $!v == "a" and $timereported contains "01:00:00" then
+	set $.r = "1";
+if $!v == "a" then
+	set $!v = "b";
+if $!v == "b" and $timereported contains "01:00:00" then
+	set $.r = $.r & "2";
+unset $!v;
+if $!v == "" then
+	set $.r = $.r & "3";
+action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+startup
+injectmsg_literal '<13>1 2003-03-01T01:00:00.000Z host app - - - m'
+shutdown_when_empty
+wait_shutdown
+export EXPECTED='123'
+cmp_exact
+exit_test
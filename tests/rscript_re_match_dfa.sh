@@ -0,0 +1,44 @@
+#!/bin/bash
+# check re_match(), re_extract() and regex property filters with the
+# combined regex automaton (script.regexEngine="dfa"), including regexes
+# that it does not support and which fall back to regexec()
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+global(script.regexEngine="dfa")
+template(name="outfmt" type="string" string="%$.tags%\n")
+
+set $.tags = "";
+if re_match($msg, "^ ?login (failed|denied)") then
+	set $.tags = $.tags & "auth,";
+if re_match($msg, "[0-9]{1,3}(\\.[0-9]{1,3}){3}") then
+	set $.tags = $.tags & "ip,";
+if re_match_i($msg, "ERROR") then
+	set $.tags = $.tags & "err,";
+if re_match($msg, "(a)\\1") then
+	set $.tags = $.tags & "aa,";
+set $.tags = $.tags & re_extract($msg, "user=([a-z]+)", 0, 1, "none") & ",";
+:msg, ereregex, "(foo|bar)+z" {
+	set $.tags = $.tags & "fb,";
+}
+:msg, regex, "xx*yz$" {
+	set $.tags = $.tags & "bre,";
+}
+action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+startup
+injectmsg_literal '<13>1 2003-03-01T01:00:00.000Z host app - - - login failed for user=bob from 10.1.2.3
+<13>1 2003-03-01T01:00:00.000Z host app - - - Error: disk aa full
+<13>1 2003-03-01T01:00:00.000Z host app - - - note foo barz
+<13>1 2003-03-01T01:00:00.000Z host app - - - end xxyz
+<13>1 2003-03-01T01:00:00.000Z host app - - - login denied user=alice'
+shutdown_when_empty
+wait_shutdown
+export EXPECTED='auth,ip,bob,
+err,aa,none,
+none,fb,
+none,bre,
+auth,alice,'
+cmp_exact
+exit_test
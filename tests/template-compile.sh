@@ -0,0 +1,33 @@
+#!/bin/bash
+# Checks that a compiled list template renders exactly like the
+# equivalent hand-written strgen module.
+# This is part of the rsyslog testbench, licensed under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=100
+generate_conf
+add_conf '
+global(template.compile="on")
+
+template(name="strgen" type="plugin" plugin="RSYSLOG_TraditionalFileFormat")
+template(name="compiled" type="list") {
+	property(name="timestamp")
+	constant(value=" ")
+	property(name="hostname")
+	constant(value=" ")
+	property(name="syslogtag")
+	property(name="msg" spifno1stsp="on")
+	property(name="msg" droplastlf="on")
+	constant(value="\n")
+}
+
+if $msg contains "msgnum:" then {
+	action(type="omfile" template="strgen" file="'$RSYSLOG_OUT_LOG'")
+	action(type="omfile" template="compiled" file="'$RSYSLOG2_OUT_LOG'")
+}
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+cmp_exact_file $RSYSLOG_OUT_LOG $RSYSLOG2_OUT_LOG
+exit_test
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Checks option.json escaping for values consisting only of characters that
+# need escaping as well as for long values that are scanned in blocks.
+# This is part of the rsyslog testbench, licensed under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+set $!special = "\"\\\"";
+set $!long = "0123456789abcdefghijklmnopqrstuvwxyz0123456789\"abcdefghijklmnopqrstuvwxyz\\end";
+
+template(name="json" type="list" option.json="on") {
+	property(name="$!special")
+	constant(value=" ")
+	property(name="$!long")
+	constant(value="\n")
+}
+
+:msg, contains, "msgnum:" action(type="omfile" template="json" file="'$RSYSLOG_OUT_LOG'")
+'
+startup
+injectmsg 0 1
+shutdown_when_empty
+wait_shutdown
+export EXPECTED='\"\\\" 0123456789abcdefghijklmnopqrstuvwxyz0123456789\"abcdefghijklmnopqrstuvwxyz\\end'
+cmp_exact
+exit_test
@@ -0,0 +1,31 @@
+#!/bin/bash
+# Checks that actions sharing a template see message modifications done
+# between them even though renderings are reused within a batch.
+# This is part of the rsyslog testbench, licensed under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export RSYSLOG_OUT3_LOG="${RSYSLOG_DYNNAME}_3.out.log"
+generate_conf
+add_conf '
+template(name="shared" type="string" string="%msg:F,58:2%,%$!v%\n")
+
+if $msg contains "msgnum:" then {
+	set $!v = "first";
+	action(type="omfile" template="shared" file="'$RSYSLOG_OUT_LOG'")
+	action(type="omfile" template="shared" file="'$RSYSLOG2_OUT_LOG'")
+	set $!v = "second";
+	action(type="omfile" template="shared" file="'$RSYSLOG_OUT3_LOG'")
+}
+'
+startup
+injectmsg 0 2
+shutdown_when_empty
+wait_shutdown
+export EXPECTED='00000000,first
+00000001,first'
+cmp_exact $RSYSLOG_OUT_LOG
+cmp_exact $RSYSLOG2_OUT_LOG
+export EXPECTED='00000000,second
+00000001,second'
+cmp_exact $RSYSLOG_OUT3_LOG
+rm -f $RSYSLOG_OUT3_LOG
+exit_test
@@ -0,0 +1,160 @@
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "rsyslog.h"
+#include "acmatch.h"
+#include "../../runtime/acmatch.c"
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                                \
+        }                                                                            \
+    } while (0)
+
+#define MAX_PATTERNS 64
+#define MAX_LEN 24
+
+static acmatch_t *build(enum acmatchMode mode, int bCaseless, const char *const *pats, int nPats) {
+    acmatch_t *m = NULL;
+    int i;
+    if (acmatchConstruct(&m, mode, bCaseless) != RS_RET_OK) return NULL;
+    for (i = 0; i < nPats; ++i) {
+        if (acmatchAddPattern(m, (const uchar *)pats[i], strlen(pats[i])) != RS_RET_OK) {
+            acmatchDestruct(&m);
+            return NULL;
+        }
+    }
+    if (acmatchFinalize(m) != RS_RET_OK) acmatchDestruct(&m);
+    return m;
+}
+
+static int matches(acmatch_t *m, const char *s) {
+    return acmatchMatch(m, (const uchar *)s, strlen(s));
+}
+
+static int test_contains(void) {
+    static const char *const pats[] = {"he", "she", "his", "hers", "usher"};
+    acmatch_t *m;
+
+    CHECK((m = build(ACMATCH_CONTAINS, 0, pats, 5)) != NULL);
+    CHECK(matches(m, "ushers"));
+    CHECK(matches(m, "xxhisxx"));
+    CHECK(matches(m, "ahe"));
+    CHECK(!matches(m, "hxsxhr"));
+    CHECK(!matches(m, ""));
+    CHECK(!matches(m, "HE"));
+    acmatchDestruct(&m);
+    CHECK(m == NULL);
+
+    CHECK((m = build(ACMATCH_CONTAINS, 1, pats, 5)) != NULL);
+    CHECK(matches(m, "A HIS B"));
+    acmatchDestruct(&m);
+    return 0;
+}
+
+static int test_prefix_suffix(void) {
+    static const char *const pats[] = {"abc", "ab", "xyz"};
+    acmatch_t *m;
+
+    CHECK((m = build(ACMATCH_PREFIX, 0, pats, 3)) != NULL);
+    CHECK(matches(m, "abd"));
+    CHECK(matches(m, "xyz"));
+    CHECK(!matches(m, "a"));
+    CHECK(!matches(m, "zabc"));
+    acmatchDestruct(&m);
+
+    CHECK((m = build(ACMATCH_SUFFIX, 1, pats, 3)) != NULL);
+    CHECK(matches(m, "zzAB"));
+    CHECK(matches(m, "xyz"));
+    CHECK(!matches(m, "abz"));
+    CHECK(!matches(m, "b"));
+    acmatchDestruct(&m);
+    return 0;
+}
+
+static int test_empty_pattern(void) {
+    static const char *const pats[] = {"foo", ""};
+    acmatch_t *m;
+
+    CHECK((m = build(ACMATCH_CONTAINS, 0, pats, 2)) != NULL);
+    CHECK(matches(m, ""));
+    CHECK(matches(m, "bar"));
+    acmatchDestruct(&m);
+    return 0;
+}
+
+/* naive reference implementation */
+static int naive(enum acmatchMode mode, char **pats, int nPats, const char *s) {
+    const size_t len = strlen(s);
+    int i;
+    for (i = 0; i < nPats; ++i) {
+        const size_t lp = strlen(pats[i]);
+        if (lp > len) continue;
+        if (mode == ACMATCH_PREFIX && memcmp(s, pats[i], lp) == 0) return 1;
+        if (mode == ACMATCH_SUFFIX && memcmp(s + len - lp, pats[i], lp) == 0) return 1;
+        if (mode == ACMATCH_CONTAINS && strstr(s, pats[i]) != NULL) return 1;
+    }
+    return 0;
+}
+
+static void randstr(unsigned *seed, char *buf, int maxLen) {
+    const int len = 1 + rand_r(seed) % maxLen;
+    int i;
+    for (i = 0; i < len; ++i) buf[i] = (char)('a' + rand_r(seed) % 4);
+    buf[len] = '\0';
+}
+
+static int test_matches_naive_on_random_data(void) {
+    char storage[MAX_PATTERNS][MAX_LEN + 1];
+    char *pats[MAX_PATTERNS];
+    char input[4 * MAX_LEN + 1];
+    unsigned seed = 4711;
+    int round, i, mode;
+
+    for (round = 0; round < 200; ++round) {
+        const int nPats = 1 + rand_r(&seed) % MAX_PATTERNS;
+        for (i = 0; i < nPats; ++i) {
+            randstr(&seed, storage[i], 2 + round % 6);
+            pats[i] = storage[i];
+        }
+        for (mode = ACMATCH_CONTAINS; mode <= ACMATCH_SUFFIX; ++mode) {
+            acmatch_t *m;
+            CHECK((m = build((enum acmatchMode)mode, 0, (const char *const *)pats, nPats)) != NULL);
+            for (i = 0; i < 50; ++i) {
+                randstr(&seed, input, 4 * MAX_LEN);
+                CHECK(matches(m, input) == naive((enum acmatchMode)mode, pats, nPats, input));
+            }
+            acmatchDestruct(&m);
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    struct {
+        const char *name;
+        int (*fn)(void);
+    } tests[] = {
+        {"contains", test_contains},
+        {"prefix_suffix", test_prefix_suffix},
+        {"empty_pattern", test_empty_pattern},
+        {"matches_naive_on_random_data", test_matches_naive_on_random_data},
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        if (tests[i].fn() != 0) {
+            fprintf(stderr, "FAILED: %s\n", tests[i].name);
+            return 1;
+        }
+    }
+
+    printf("acmatch tests passed (%zu cases)\n", sizeof(tests) / sizeof(tests[0]));
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rsyslog.h"
+#include "jsonwriter.h"
+#include "../../runtime/jsonwriter.c"
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                                \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_OUT(buf, expected)                                       \
+    do {                                                               \
+        CHECK((buf).lenStr == strlen(expected));                       \
+        CHECK(memcmp((buf).param, (expected), strlen(expected)) == 0); \
+        CHECK((buf).param[(buf).lenStr] == '\0');                      \
+    } while (0)
+
+static int test_nesting_and_separators(void) {
+    actWrkrIParams_t buf = {NULL, 0, 0};
+    jsonWriter_t w;
+
+    jsonWriterInit(&w, &buf, 0, NULL);
+    CHECK(jsonWriterBeginObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterKey(&w, (const uchar *)"a", 1) == RS_RET_OK);
+    CHECK(jsonWriterRaw(&w, (const uchar *)"1", 1) == RS_RET_OK);
+    CHECK(jsonWriterKey(&w, (const uchar *)"b", 1) == RS_RET_OK);
+    CHECK(jsonWriterBeginArray(&w) == RS_RET_OK);
+    CHECK(jsonWriterString(&w, (const uchar *)"x", 1) == RS_RET_OK);
+    CHECK(jsonWriterBeginObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterEndObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterRaw(&w, (const uchar *)"true", 4) == RS_RET_OK);
+    CHECK(jsonWriterEndArray(&w) == RS_RET_OK);
+    CHECK(jsonWriterEndObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterFinish(&w) == RS_RET_OK);
+    CHECK_OUT(buf, "{\"a\":1,\"b\":[\"x\",{},true]}");
+    CHECK(w.depth == 0);
+    free(buf.param);
+    return 0;
+}
+
+static int test_escaping(void) {
+    static const uchar val[] = "q\"b\\s/n\nt\tc\x01z";
+    actWrkrIParams_t buf = {NULL, 0, 0};
+    jsonWriter_t w;
+
+    jsonWriterInit(&w, &buf, 0, NULL);
+    CHECK(jsonWriterString(&w, val, sizeof(val) - 1) == RS_RET_OK);
+    CHECK(jsonWriterFinish(&w) == RS_RET_OK);
+    CHECK_OUT(buf, "\"q\\\"b\\\\s\\/n\\nt\\tc\\u0001z\"");
+    free(buf.param);
+    return 0;
+}
+
+static int test_raw_key(void) {
+    actWrkrIParams_t buf = {NULL, 0, 0};
+    jsonWriter_t w;
+
+    jsonWriterInit(&w, &buf, 0, NULL);
+    CHECK(jsonWriterBeginObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterKeyRaw(&w, (const uchar *)"a/b", 3) == RS_RET_OK);
+    CHECK(jsonWriterRaw(&w, (const uchar *)"1", 1) == RS_RET_OK);
+    CHECK(jsonWriterKey(&w, (const uchar *)"a/b", 3) == RS_RET_OK);
+    CHECK(jsonWriterRaw(&w, (const uchar *)"2", 1) == RS_RET_OK);
+    CHECK(jsonWriterEndObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterFinish(&w) == RS_RET_OK);
+    CHECK_OUT(buf, "{\"a/b\":1,\"a\\/b\":2}");
+    free(buf.param);
+    return 0;
+}
+
+static int test_rollback_and_custom_separator(void) {
+    actWrkrIParams_t buf = {NULL, 0, 0};
+    jsonWriterMark_t mark;
+    jsonWriter_t w;
+
+    jsonWriterInit(&w, &buf, 0, ", ");
+    CHECK(jsonWriterBeginObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterKey(&w, (const uchar *)"a", 1) == RS_RET_OK);
+    CHECK(jsonWriterRaw(&w, (const uchar *)"1", 1) == RS_RET_OK);
+    jsonWriterMark(&w, &mark);
+    CHECK(jsonWriterKey(&w, (const uchar *)"empty", 5) == RS_RET_OK);
+    CHECK(jsonWriterBeginObject(&w) == RS_RET_OK);
+    jsonWriterRollback(&w, &mark);
+    CHECK(jsonWriterKey(&w, (const uchar *)"c", 1) == RS_RET_OK);
+    CHECK(jsonWriterString(&w, (const uchar *)"v", 1) == RS_RET_OK);
+    CHECK(jsonWriterEndObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterAppend(&w, "\n", 1) == RS_RET_OK);
+    CHECK(jsonWriterFinish(&w) == RS_RET_OK);
+    CHECK_OUT(buf, "{\"a\":1, \"c\":\"v\"}\n");
+    free(buf.param);
+    return 0;
+}
+
+static int test_growth_and_offset(void) {
+    actWrkrIParams_t buf = {NULL, 0, 0};
+    jsonWriter_t w;
+    uchar big[5000];
+    size_t i;
+
+    CHECK((buf.param = malloc(4)) != NULL);
+    buf.lenBuf = 4;
+    memcpy(buf.param, "ab", 2);
+    memset(big, 'x', sizeof(big));
+    big[4321] = '"';
+    jsonWriterInit(&w, &buf, 2, NULL);
+    CHECK(jsonWriterString(&w, big, sizeof(big)) == RS_RET_OK);
+    CHECK(jsonWriterFinish(&w) == RS_RET_OK);
+    CHECK(buf.lenStr == 2 + 2 + sizeof(big) + 1);
+    CHECK(memcmp(buf.param, "ab\"", 3) == 0);
+    for (i = 0; i < 4321; ++i) CHECK(buf.param[3 + i] == 'x');
+    CHECK(buf.param[3 + 4321] == '\\' && buf.param[3 + 4322] == '"');
+    free(buf.param);
+    return 0;
+}
+
+static int test_misuse_is_rejected(void) {
+    actWrkrIParams_t buf = {NULL, 0, 0};
+    jsonWriter_t w;
+
+    jsonWriterInit(&w, &buf, 0, NULL);
+    CHECK(jsonWriterEndObject(&w) == RS_RET_INVALID_VALUE);
+    CHECK(jsonWriterBeginObject(&w) == RS_RET_OK);
+    CHECK(jsonWriterKey(&w, (const uchar *)"k", 1) == RS_RET_OK);
+    CHECK(jsonWriterKey(&w, (const uchar *)"k", 1) == RS_RET_INVALID_VALUE);
+    CHECK(jsonWriterEndObject(&w) == RS_RET_INVALID_VALUE);
+    free(buf.param);
+    return 0;
+}
+
+int main(void) {
+    struct {
+        const char *name;
+        int (*fn)(void);
+    } tests[] = {
+        {"nesting_and_separators", test_nesting_and_separators},
+        {"escaping", test_escaping},
+        {"raw_key", test_raw_key},
+        {"rollback_and_custom_separator", test_rollback_and_custom_separator},
+        {"growth_and_offset", test_growth_and_offset},
+        {"misuse_is_rejected", test_misuse_is_rejected},
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        if (tests[i].fn() != 0) {
+            fprintf(stderr, "FAILED: %s\n", tests[i].name);
+            return 1;
+        }
+    }
+
+    printf("jsonwriter tests passed (%zu cases)\n", sizeof(tests) / sizeof(tests[0]));
+    return 0;
+}
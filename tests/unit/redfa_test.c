@@ -0,0 +1,200 @@
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+
+#include "rsyslog.h"
+#include "redfa.h"
+#include "../../runtime/redfa.c"
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                                \
+        }                                                                            \
+    } while (0)
+
+#define MAX_LEN 40
+
+typedef struct {
+    const char *regex;
+    int flags;
+} pattern_t;
+
+/* all of these must be supported */
+static const pattern_t supported[] = {
+    {"abc", REDFA_EXTENDED},
+    {"^abc", REDFA_EXTENDED},
+    {"abc$", REDFA_EXTENDED},
+    {"^$", REDFA_EXTENDED},
+    {"a.c", REDFA_EXTENDED},
+    {"a*b+c?", REDFA_EXTENDED},
+    {"(ab|cd)+e", REDFA_EXTENDED},
+    {"^(a|b)*c$", REDFA_EXTENDED},
+    {"^a|b$|cc", REDFA_EXTENDED},
+    {"a{2}", REDFA_EXTENDED},
+    {"b{1,3}c", REDFA_EXTENDED},
+    {"(ab){2,}", REDFA_EXTENDED},
+    {"a{0,2}d", REDFA_EXTENDED},
+    {"[abc]d", REDFA_EXTENDED},
+    {"[^a-c]", REDFA_EXTENDED},
+    {"[]a]b", REDFA_EXTENDED},
+    {"[a-]x", REDFA_EXTENDED},
+    {"[[:digit:]]+", REDFA_EXTENDED},
+    {"^[[:alpha:]_][[:alnum:]_]*$", REDFA_EXTENDED},
+    {"x\\.y", REDFA_EXTENDED},
+    {"(a*)*b", REDFA_EXTENDED},
+    {"((a|b)c?)+d", REDFA_EXTENDED},
+    {"a.{10}b", REDFA_EXTENDED},
+    {"ABC", REDFA_EXTENDED | REDFA_ICASE},
+    {"[^B]d", REDFA_EXTENDED | REDFA_ICASE},
+    {"a\\(b\\)*c", 0},
+    {"^ab*$", 0},
+    {"a+b", 0},
+    {"a\\{2,3\\}", 0},
+    {"a|b", 0},
+    {"a^b$c", 0},
+    {"(a)", 0},
+};
+
+/* all of these must be rejected */
+static const pattern_t unsupported[] = {
+    {"", REDFA_EXTENDED}, {"a|", REDFA_EXTENDED}, {"()", REDFA_EXTENDED}, {"a**", REDFA_EXTENDED},
+    {"*a", REDFA_EXTENDED}, {"a^b", REDFA_EXTENDED}, {"a$b", REDFA_EXTENDED}, {"(a", REDFA_EXTENDED},
+    {"a)", REDFA_EXTENDED}, {"\\w", REDFA_EXTENDED}, {"(a)\\1", REDFA_EXTENDED}, {"a{1", REDFA_EXTENDED},
+    {"a{3,2}", REDFA_EXTENDED}, {"[z-a]", REDFA_EXTENDED}, {"[[=a=]]", REDFA_EXTENDED}, {"[a", REDFA_EXTENDED},
+    {"[[:foo:]]", REDFA_EXTENDED}, {"a{256}", REDFA_EXTENDED}, {"\\<a", REDFA_EXTENDED}, {"*a", 0}, {"a\\|b", 0},
+    {"a\\+", 0}, {"\\(^a\\)", 0}, {"\\(a\\)\\1", 0},
+};
+
+static const char *const inputs[] = {
+    "", "a", "abc", "xabcx", "ABC", "aabbcc", "ababe", "cde", "ccc", "aac", "bbbc", "ababab", "d", "ad", "aad",
+    "]b", "-x", "12", "_a1", "1a", "x.y", "xzy", "b", "acbd", "a^b$c", "(a)", "a+b", "aaab", "a|b", "axxxxxxxxxxb",
+    "Bd", "bd",
+};
+
+static int posixMatch(const char *const regex, const int flags, const char *const s) {
+    regex_t re;
+    int r;
+    if (regcomp(&re, regex, ((flags & REDFA_EXTENDED) ? REG_EXTENDED : 0) | ((flags & REDFA_ICASE) ? REG_ICASE : 0) |
+                                REG_NOSUB) != 0)
+        return -1;
+    r = regexec(&re, s, 0, NULL, 0) == 0;
+    regfree(&re);
+    return r;
+}
+
+static int test_syntax(void) {
+    redfa_t *dfa;
+    size_t i;
+    int id;
+
+    CHECK(redfaConstruct(&dfa) == RS_RET_OK);
+    for (i = 0; i < sizeof(supported) / sizeof(supported[0]); ++i) {
+        if (redfaAddPattern(dfa, (const uchar *)supported[i].regex, supported[i].flags, &id) != RS_RET_OK) {
+            fprintf(stderr, "pattern '%s' not supported\n", supported[i].regex);
+            return 1;
+        }
+        CHECK(id == (int)i);
+    }
+    for (i = 0; i < sizeof(unsupported) / sizeof(unsupported[0]); ++i) {
+        if (redfaAddPattern(dfa, (const uchar *)unsupported[i].regex, unsupported[i].flags, &id) !=
+            RS_RET_NOT_IMPLEMENTED) {
+            fprintf(stderr, "pattern '%s' should be rejected\n", unsupported[i].regex);
+            return 1;
+        }
+    }
+    CHECK(redfaNumPatterns(dfa) == (int)(sizeof(supported) / sizeof(supported[0])));
+    redfaDestruct(&dfa);
+    CHECK(dfa == NULL);
+    return 0;
+}
+
+/* all supported patterns in one automaton must agree with regexec() */
+static int test_matches_posix(void) {
+    redfa_t *dfa;
+    redfaCache_t *cache = NULL;
+    size_t i, k;
+    int id;
+
+    CHECK(redfaConstruct(&dfa) == RS_RET_OK);
+    for (i = 0; i < sizeof(supported) / sizeof(supported[0]); ++i)
+        CHECK(redfaAddPattern(dfa, (const uchar *)supported[i].regex, supported[i].flags, &id) == RS_RET_OK);
+    CHECK(redfaFinalize(dfa) == RS_RET_OK);
+    for (k = 0; k < sizeof(inputs) / sizeof(inputs[0]); ++k) {
+        for (i = 0; i < sizeof(supported) / sizeof(supported[0]); ++i) {
+            const int expected = posixMatch(supported[i].regex, supported[i].flags, inputs[k]);
+            const int got = redfaMatch(dfa, &cache, (const uchar *)inputs[k], strlen(inputs[k]), (int)i);
+            if (got != expected) {
+                fprintf(stderr, "'%s' on '%s': got %d, expected %d\n", supported[i].regex, inputs[k], got,
+                        expected);
+                return 1;
+            }
+        }
+    }
+    redfaCacheDestruct(&cache);
+    CHECK(cache == NULL);
+    redfaDestruct(&dfa);
+    return 0;
+}
+
+static void randstr(unsigned *seed, char *buf, int maxLen) {
+    const int len = rand_r(seed) % (maxLen + 1);
+    int i;
+    for (i = 0; i < len; ++i) buf[i] = "abcdA.1"[rand_r(seed) % 7];
+    buf[len] = '\0';
+}
+
+/* long random strings; this also forces cache flushes */
+static int test_random_data(void) {
+    redfa_t *dfa;
+    redfaCache_t *cache = NULL;
+    char input[MAX_LEN + 1];
+    unsigned seed = 4711;
+    int round;
+    size_t i;
+    int id;
+
+    CHECK(redfaConstruct(&dfa) == RS_RET_OK);
+    for (i = 0; i < sizeof(supported) / sizeof(supported[0]); ++i)
+        CHECK(redfaAddPattern(dfa, (const uchar *)supported[i].regex, supported[i].flags, &id) == RS_RET_OK);
+    CHECK(redfaFinalize(dfa) == RS_RET_OK);
+    for (round = 0; round < 5000; ++round) {
+        randstr(&seed, input, MAX_LEN);
+        for (i = 0; i < sizeof(supported) / sizeof(supported[0]); ++i) {
+            const int expected = posixMatch(supported[i].regex, supported[i].flags, input);
+            if (redfaMatch(dfa, &cache, (const uchar *)input, strlen(input), (int)i) != expected) {
+                fprintf(stderr, "'%s' on '%s': expected %d\n", supported[i].regex, input, expected);
+                return 1;
+            }
+        }
+    }
+    redfaCacheDestruct(&cache);
+    redfaDestruct(&dfa);
+    return 0;
+}
+
+int main(void) {
+    struct {
+        const char *name;
+        int (*fn)(void);
+    } tests[] = {
+        {"syntax", test_syntax},
+        {"matches_posix", test_matches_posix},
+        {"random_data", test_random_data},
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        if (tests[i].fn() != 0) {
+            fprintf(stderr, "FAILED: %s\n", tests[i].name);
+            return 1;
+        }
+    }
+
+    printf("redfa tests passed (%zu cases)\n", sizeof(tests) / sizeof(tests[0]));
+    return 0;
+}
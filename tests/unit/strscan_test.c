@@ -0,0 +1,104 @@
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "strscan.h"
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                                \
+        }                                                                            \
+    } while (0)
+
+#define BUF_SIZE 200
+
+static int test_json_empty_and_clean(void) {
+    const unsigned char *clean = (const unsigned char *)"abcdefghijklmnopqrstuvwxyz 0123456789 ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const size_t len = strlen((const char *)clean);
+
+    CHECK(rsStrScanJSONEscape(clean, 0) == 0);
+    CHECK(rsStrScanJSONEscape(clean, len) == len);
+    CHECK(rsStrScanAny2(clean, len, '\'', '\\') == len);
+    return 0;
+}
+
+static int test_json_each_position(void) {
+    static const unsigned char specials[] = {'"', '\\', '/', '\0', '\n', 0x1f};
+    unsigned char buf[BUF_SIZE];
+    size_t pos;
+    size_t k;
+
+    for (k = 0; k < sizeof(specials); ++k) {
+        for (pos = 0; pos < BUF_SIZE; ++pos) {
+            memset(buf, 'x', sizeof(buf));
+            buf[pos] = specials[k];
+            CHECK(rsStrScanJSONEscape(buf, sizeof(buf)) == pos);
+            CHECK(rsStrScanJSONEscape(buf, pos) == pos);
+        }
+    }
+    /* bytes >= 0x80 and 0x7f must not be reported */
+    memset(buf, 0xc3, sizeof(buf));
+    buf[77] = 0x7f;
+    CHECK(rsStrScanJSONEscape(buf, sizeof(buf)) == sizeof(buf));
+    return 0;
+}
+
+static int test_any2_each_position(void) {
+    unsigned char buf[BUF_SIZE];
+    size_t pos;
+
+    for (pos = 0; pos < BUF_SIZE; ++pos) {
+        memset(buf, 'y', sizeof(buf));
+        buf[pos] = '\'';
+        CHECK(rsStrScanAny2(buf, sizeof(buf), '\'', '\'') == pos);
+        CHECK(rsStrScanAny2(buf, sizeof(buf), '\\', '\'') == pos);
+        CHECK(rsStrScanAny2(buf, sizeof(buf), '\\', '"') == sizeof(buf));
+    }
+    return 0;
+}
+
+static int test_matches_scalar_on_random_data(void) {
+    unsigned char buf[BUF_SIZE];
+    unsigned seed = 42;
+    int round;
+    size_t i;
+
+    for (round = 0; round < 2000; ++round) {
+        const size_t len = (size_t)(rand_r(&seed) % BUF_SIZE);
+        for (i = 0; i < len; ++i) {
+            /* mostly printable data with an occasional special character */
+            const unsigned r = (unsigned)rand_r(&seed);
+            buf[i] = (r % 61 == 0) ? (unsigned char)(r >> 8) : (unsigned char)('a' + r % 26);
+        }
+        CHECK(rsStrScanJSONEscape(buf, len) == rsStrScanJSONEscapeScalar(buf, len));
+        CHECK(rsStrScanAny2(buf, len, '\'', '\\') == rsStrScanAny2Scalar(buf, len, '\'', '\\'));
+    }
+    return 0;
+}
+
+int main(void) {
+    struct {
+        const char *name;
+        int (*fn)(void);
+    } tests[] = {
+        {"json_empty_and_clean", test_json_empty_and_clean},
+        {"json_each_position", test_json_each_position},
+        {"any2_each_position", test_any2_each_position},
+        {"matches_scalar_on_random_data", test_matches_scalar_on_random_data},
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        if (tests[i].fn() != 0) {
+            fprintf(stderr, "FAILED: %s\n", tests[i].name);
+            return 1;
+        }
+    }
+
+    printf("strscan tests passed (%zu cases)\n", sizeof(tests) / sizeof(tests[0]));
+    return 0;
+}
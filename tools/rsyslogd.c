@@ -186,6 +186,7 @@ static pthread_mutex_t mutChildDied;
 static int bChildDied = 0;
 static pthread_mutex_t mutHadHUP;
 static int bHadHUP;
+static volatile sig_atomic_t bHadProfileDumpReq = 0; /* SIGUSR2 received, see script.profile */
 static int doFork = 1; /* fork - run in daemon mode - read-only after startup */
 int bFinished = 0; /* used by termination signal handler, read-only except there
                     * is either 0 or the number of the signal that requested the
@@ -1388,6 +1389,11 @@ static void hdlr_sighup(void) {
     pthread_kill(mainthread, SIGTTIN);
 }
 
+static void hdlr_sigusr2(void) {
+    bHadProfileDumpReq = 1;
+    pthread_kill(mainthread, SIGTTIN);
+}
+
 static void hdlr_sigchld(void) {
     pthread_mutex_lock(&mutChildDied);
     bChildDied = 1;
@@ -1890,6 +1896,9 @@ static void initAll(int argc, char **argv) {
     hdlr_enable(SIGTERM, rsyslogdDoDie);
     hdlr_enable(SIGCHLD, hdlr_sigchld);
     hdlr_enable(SIGHUP, hdlr_sighup);
+    if (loadConf->globals.bScriptProfile) {
+        hdlr_enable(SIGUSR2, hdlr_sigusr2);
+    }
 
     if (rsconfNeedDropPriv(loadConf)) {
         /* need to write pid file early as we may loose permissions */
@@ -2076,6 +2085,19 @@ static void doHUP(void) {
     errmsgDoHUP();
 }
 
+/* Called by the main loop after SIGUSR2 was received. Writes the
+ * execution profiles (see script.profile) to the configured file.
+ */
+static void doProfileDump(void) {
+    if (runConf->globals.scriptProfileFile == NULL) {
+        LogError(0, RS_RET_ERR,
+                 "script.profile: SIGUSR2 received, but script.profile.file is not set - "
+                 "profile not written");
+        return;
+    }
+    scriptprofDump(runConf->scriptprofs, (char *)runConf->globals.scriptProfileFile);
+}
+
 /**
  * @brief Signal Handler for termination (SIGTERM, SIGINT).
  *
@@ -2339,6 +2361,7 @@ static void mainloop(void) {
     sigaddset(&sigblockset, SIGTERM);
     sigaddset(&sigblockset, SIGCHLD);
     sigaddset(&sigblockset, SIGHUP);
+    sigaddset(&sigblockset, SIGUSR2);
     next_janitor_run_ms = mainloopMonotonicMs() + ((uint64_t)runConf->globals.janitorInterval * 60ULL * 1000ULL);
 
     do {
@@ -2372,6 +2395,11 @@ static void mainloop(void) {
             pthread_mutex_unlock(&mutHadHUP);
         }
 
+        if (bHadProfileDumpReq) {
+            bHadProfileDumpReq = 0;
+            doProfileDump();
+        }
+
         processImInternal();
 
         if (bFinished) break; /* exit as quickly as possible */